@@ -2,18 +2,20 @@
 #define CONFIG_H
 
 #include <cstddef>
+#include <cstdint>
 #include <IPAddress.h>
 
 // ============================
 // Firmware info
 // ============================
 #define FIRMWARE_VERSION "1.2.3-Refactored"
+#define SHAKER_CHANNEL_COUNT 1  // Independent agitation channels driven by this board
 
 // ============================
 // Motor Configuration
 // ============================
-extern const float MAX_RPM;
-extern const double SPR_MEAS;
+extern const float MAX_RPM;    // Default; the calibration stored in /config.bin overrides it
+extern const double SPR_MEAS;  // Default measured steps per revolution; also overridable
 
 // ============================
 // WiFi Configuration
@@ -25,4 +27,50 @@ extern const IPAddress AP_GATEWAY;
 extern const IPAddress AP_SUBNET;
 extern const int WIFI_CONNECT_TIMEOUT_MS;
 
+// ============================
+// Web Server Admission Control
+// ============================
+extern const uint32_t HTTP_RPM_RATE_PER_S;      // Sustained /rpm requests per second and client
+extern const uint32_t HTTP_RPM_BURST;           // Burst of /rpm requests allowed per client
+extern const int HTTP_MAX_CONCURRENT_REQUESTS;  // Requests in flight before answering 429
+
+// ============================
+// Modbus TCP
+// ============================
+extern const uint16_t MODBUS_TCP_PORT;  // Standard Modbus TCP port is 502
+extern const uint8_t MODBUS_SLAVE_UID;  // Unit identifier answered by the slave
+
+// ============================
+// Serial console
+// ============================
+extern const bool SERIAL_SCPI_ENABLED;     // SCPI-like commands on the USB serial port
+extern const uint32_t SERIAL_SCPI_POLL_MS; // Longest wait for input when no receive event arrives
+
+// ============================
+// Diagnostics
+// ============================
+extern const uint32_t TASK_PROFILER_PERIOD_MS;         // Sampling window of /debug/tasks
+extern const uint32_t TASK_PROFILER_SERIAL_PERIOD_MS;  // Serial task report interval (0 = off)
+extern const bool TRACE_ENABLED_AT_BOOT;             // Record /debug/trace events from boot
+extern const uint8_t CONTROL_STALL_RESTART_S;          // motor_task silent this long: the supervisor restarts (0 = never)
+extern const uint32_t SPEED_STATS_LOG_PERIOD_MS;       // Serial speed-stability report while running (0 = off)
+extern const uint32_t JITTER_PROBE_PERIOD_MS;          // Period of the /debug/jitter probe task, as a control loop
+
+// ============================
+// Power-loss resume
+// ============================
+extern const bool POWER_LOSS_RESUME;       // Restart a run that was interrupted by a power loss
+extern const uint32_t RUN_JOURNAL_PERIOD_S; // Run time journaled at least this often while running
+
+// ============================
+// Stopping
+// ============================
+extern const float STOP_DECEL_RPM_PER_S;  // Ramp of a graceful stop
+extern const uint32_t STOP_MAX_TIME_MS;   // A graceful stop never takes longer; the ramp steepens to fit
+
+// ============================
+// Emergency stop
+// ============================
+extern const bool ESTOP_INPUT_ENABLED;  // E-stop contact wired to ESTOP_PIN (needs the external pull-up); the software trigger is always on
+
 #endif // CONFIG_H
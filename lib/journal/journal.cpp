@@ -0,0 +1,108 @@
+#include "journal.h"
+#include "motor_control.h"
+#include "telemetry.h"
+#include "task_monitor.h"
+#include <esp_partition.h>
+#include <esp_system.h>
+
+/**
+ * @brief RunJournal storage backed by the "journal" data partition.
+ */
+struct PartitionFlash {
+  const esp_partition_t* partition = NULL;
+
+  size_t size() const { return partition ? partition->size : 0; }
+
+  bool read(size_t offset, void* dst, size_t len) const {
+    return esp_partition_read(partition, offset, dst, len) == ESP_OK;
+  }
+
+  bool write(size_t offset, const void* src, size_t len) {
+    return esp_partition_write(partition, offset, src, len) == ESP_OK;
+  }
+
+  bool erase(size_t offset, size_t len) {
+    return esp_partition_erase_range(partition, offset, len) == ESP_OK;
+  }
+};
+
+static PartitionFlash g_flash;
+static RunJournal<PartitionFlash> g_journal(g_flash);
+static RunJournalPolicy g_policy(RUN_JOURNAL_PERIOD_S);
+static volatile bool g_resumed = false;
+static volatile uint32_t g_runSeconds = 0;
+
+/**
+ * @brief Replays the journal, resumes an interrupted run and starts journalTask.
+ */
+void journal_setup() {
+  g_flash.partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "journal");
+  if (!g_flash.partition) {
+    Serial.print("[journal] no journal partition; power-loss resume disabled\n");
+    return;
+  }
+
+  RunState last;
+  if (g_journal.begin() && g_journal.latest(last) && last.running) {
+    esp_reset_reason_t reason = esp_reset_reason();
+    ResetCause cause = (reason == ESP_RST_POWERON || reason == ESP_RST_BROWNOUT) ? RESET_POWER_LOSS : RESET_OTHER;
+    if (run_journal_should_resume(last, cause, POWER_LOSS_RESUME)) {
+      // Counting continues from the journal.
+      g_policy.resume(last);
+      g_resumed = true;
+      // From standstill, so motor_task ramps up with A_CMD as for any start.
+      motor_post_setpoint(last.rpm, CMD_SOURCE_SUPERVISOR, micros());
+      Serial.printf("[journal] power lost during a run; resuming %.1f rpm (step %u, %lu s run)\n",
+                    (double)last.rpm, (unsigned)last.step, (unsigned long)last.elapsedS);
+    } else {
+      // Not resumed: journal the stop now, so a later power loss does not resume it either.
+      RunState stopped = last;
+      stopped.running = false;
+      stopped.rpm = 0.0f;
+      g_policy.resume(stopped);
+      if (!g_journal.append(stopped)) Serial.print("[journal] write failed\n");
+      Serial.printf("[journal] run at %.1f rpm interrupted by reset reason %d; %s\n", (double)last.rpm, (int)reason,
+                    cause != RESET_POWER_LOSS ? "not a power loss, stays stopped" : "resume disabled");
+    }
+  }
+
+  task_start(TASK_JOURNAL, journal_task);
+}
+
+bool journal_resumed() {
+  return g_resumed;
+}
+
+uint32_t journal_run_seconds() {
+  return g_runSeconds;
+}
+
+/**
+ * @brief Samples the applied setpoint once per second and appends records when the policy asks.
+ */
+void journal_task(void *parameter) {
+  if (g_resumed) {
+    // Until motor_task takes the resumed setpoint, the snapshot still reads as stopped.
+    MotorStateSnapshot motor;
+    uint32_t start = millis();
+    while (millis() - start < 5000 && !(g_motorState.read(motor) && motor.targetRpm >= 1.0f)) {
+      vTaskDelay(pdMS_TO_TICKS(50));
+    }
+  }
+
+  TickType_t wake = xTaskGetTickCount();
+  while (true) {
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(1000));
+    MotorStateSnapshot motor;
+    if (!g_motorState.read(motor)) continue;
+    // Patterns are not resumed after a power loss: while one runs, the journal
+    // records the motor as stopped so a reboot does not start it at a stale speed.
+    if (g_policy.update(motor.patternActive ? 0.0f : motor.targetRpm, 1)) {
+      uint32_t t0 = micros();
+      bool ok = g_journal.append(g_policy.state());
+      g_metrics.journalWrite.observe(micros() - t0);
+      if (!ok) Serial.print("[journal] write failed\n");
+    }
+    g_runSeconds = g_policy.state().running ? g_policy.state().elapsedS : 0;
+  }
+}
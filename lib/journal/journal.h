@@ -0,0 +1,41 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "config.h"
+#include <Arduino.h>
+#include "run_journal.h"
+
+/**
+ * @file journal.h
+ * @brief Diario del estado de marcha para reanudar tras un corte de luz.
+ *
+ * `journalTask` anota en la partición `journal` (flash sin sistema de
+ * ficheros, ver `partitions.csv`) registros de 16 bytes con la consigna, el
+ * paso del programa y el tiempo de marcha: al arrancar, parar o cambiar la
+ * consigna, y cada `RUN_JOURNAL_PERIOD_S` durante la marcha. Al arrancar,
+ * `journal_setup()` lee el último registro; si el equipo se apagó en marcha
+ * y `POWER_LOSS_RESUME` está activo, vuelve a pedir la misma consigna y el
+ * motor la alcanza con su rampa normal.
+ */
+
+/**
+ * @brief Lee el diario y, si procede, reanuda la marcha. Crea `journalTask`.
+ */
+void journal_setup();
+
+/**
+ * @brief Si este arranque reanudó una marcha interrumpida.
+ */
+bool journal_resumed();
+
+/**
+ * @brief Segundos de la marcha en curso (0 parado), contando los anteriores al corte.
+ */
+uint32_t journal_run_seconds();
+
+/**
+ * @brief Tarea que sigue la consigna aplicada y escribe el diario.
+ */
+void journal_task(void *parameter);
+
+#endif // JOURNAL_H
@@ -0,0 +1,107 @@
+#include "modbus_slave.h"
+#include "motor_control.h"
+#include "modbus_map.h"
+#include "supervisor.h"
+#include "settings.h"
+#include "task_monitor.h"
+#include <esp_netif.h>
+#include <mbcontroller.h>
+
+// ============================
+// Registros
+// ============================
+const uint32_t MODBUS_REFRESH_MS = 10;
+
+// Read and written by the esp-modbus task under its register lock; modbus_task
+// takes the same lock (mbc_slave_lock) to touch them.
+static uint16_t g_inputRegs[MB_INPUT_REGISTER_COUNT];
+static uint16_t g_holdingRegs[MB_HOLDING_REGISTER_COUNT];
+static void* g_modbusHandle = NULL;
+
+/**
+ * @brief Registers one storage area with the stack.
+ */
+static bool set_area(mb_param_type_t type, void* address, size_t bytes) {
+  mb_register_area_descriptor_t area;
+  area.start_offset = 0;
+  area.type = type;
+  area.address = address;
+  area.size = bytes;
+  return mbc_slave_set_descriptor(area) == ESP_OK;
+}
+
+/**
+ * @brief Starts the Modbus TCP slave and its service task.
+ */
+bool modbus_setup() {
+  if (mbc_slave_init_tcp(&g_modbusHandle) != ESP_OK) {
+    Serial.print("[modbus] init failed\n");
+    return false;
+  }
+
+  mb_communication_info_t comm = {};
+  comm.ip_mode = MB_MODE_TCP;
+  comm.slave_uid = MODBUS_SLAVE_UID;
+  comm.ip_port = MODBUS_TCP_PORT;
+  comm.ip_addr_type = MB_IPV4;
+  comm.ip_addr = NULL; // listen on INADDR_ANY: masters reach us on the STA and the AP address
+  // esp-modbus only checks that a netif is given; the slave never binds to it.
+  comm.ip_netif_ptr = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+  if (!comm.ip_netif_ptr) comm.ip_netif_ptr = esp_netif_get_handle_from_ifkey("WIFI_AP_DEF");
+
+  bool ok = mbc_slave_setup(&comm) == ESP_OK &&
+            set_area(MB_PARAM_INPUT, g_inputRegs, sizeof(g_inputRegs)) &&
+            set_area(MB_PARAM_HOLDING, g_holdingRegs, sizeof(g_holdingRegs)) &&
+            mbc_slave_start() == ESP_OK;
+  if (!ok) {
+    Serial.print("[modbus] setup failed\n");
+    mbc_slave_destroy();
+    return false;
+  }
+
+  task_start(TASK_MODBUS, modbus_task);
+  Serial.printf("[modbus] TCP slave on port %u, uid %u\n", (unsigned)MODBUS_TCP_PORT, (unsigned)MODBUS_SLAVE_UID);
+  return true;
+}
+
+/**
+ * @brief Keeps the input registers in sync and applies holding writes.
+ *
+ * Masters are answered by the esp-modbus task straight from the register
+ * arrays, so a read never waits for rpmMutex. A new image is copied in
+ * under the stack's register lock, so a read of STEPS_HI/STEPS_LO never
+ * mixes two snapshots; the lock is held only for the copy.
+ */
+void modbus_task(void *parameter) {
+  uint32_t shownVersion = 0;
+  supervisor_register(SUPERVISED_MODBUS);
+  while (true) {
+    supervisor_check_in(SUPERVISED_MODBUS);
+    mb_param_info_t info;
+    if (mbc_slave_get_param_info(&info, MODBUS_REFRESH_MS) == ESP_OK &&
+        (info.type & MB_EVENT_HOLDING_REG_WR)) {
+      uint32_t ingressUs = micros();
+      uint16_t holding[MB_HOLDING_REGISTER_COUNT];
+      bool locked = mbc_slave_lock(g_modbusHandle) == ESP_OK;  // a command is never dropped
+      memcpy(holding, g_holdingRegs, sizeof(holding));
+      if (locked) mbc_slave_unlock(g_modbusHandle);
+      if (holding[MB_HR_RUN] == MB_RUN_START) {
+        motor_post_setpoint(modbus_decode_command(holding, settings_get().maxRpm), CMD_SOURCE_PROTOCOL, ingressUs);
+      } else {
+        motor_stop(modbus_decode_stop_mode(holding), CMD_SOURCE_PROTOCOL, ingressUs);
+      }
+    }
+
+    uint32_t version = g_motorState.version();
+    MotorStateSnapshot motor;
+    if (version != shownVersion && g_motorState.read(motor)) {
+      uint16_t regs[MB_INPUT_REGISTER_COUNT];
+      modbus_encode_inputs(motor, version, regs);
+      if (mbc_slave_lock(g_modbusHandle) == ESP_OK) {
+        memcpy(g_inputRegs, regs, sizeof(regs));
+        mbc_slave_unlock(g_modbusHandle);
+        shownVersion = version;
+      }
+    }
+  }
+}
@@ -0,0 +1,47 @@
+#ifndef MODBUS_SLAVE_H
+#define MODBUS_SLAVE_H
+
+#include "config.h"
+#include <Arduino.h>
+
+/**
+ * @file modbus_slave.h
+ * @brief Esclavo Modbus TCP para integración con SCADA.
+ *
+ * Usa el stack `esp-modbus`. Los registros se sirven desde RAM, sin tomar
+ * `rpmMutex`, a partir de la instantánea `g_motorState` que publica
+ * `motor_task`; cada imagen nueva se copia bajo el cerrojo de registros del
+ * stack (`mbc_slave_lock`), así que una lectura nunca mezcla dos instantáneas. El mapa de registros está en `lib/shared_logic/modbus_map.h`:
+ *
+ * | Tipo      | Dir. | Contenido                                  |
+ * |-----------|------|--------------------------------------------|
+ * | Input     | 0    | Consigna aplicada (RPM x 10)               |
+ * | Input     | 1    | Velocidad medida (RPM x 10)                |
+ * | Input     | 2    | Estado de marcha (0 parado, 1 en marcha)   |
+ * | Input     | 3-4  | Contador de pasos (palabra alta, baja)     |
+ * | Input     | 5    | Banderas de error (`MotorErrorFlag`)       |
+ * | Input     | 6    | Versión de la instantánea (16 bits bajos)  |
+ * | Holding   | 0    | Consigna solicitada (RPM x 10)             |
+ * | Holding   | 1    | Marcha (1), parada con rampa (0) o parada  |
+ * |           |      | dura (2); otro valor para con rampa        |
+ */
+
+/**
+ * @brief Inicia el stack Modbus TCP y la tarea que lo atiende.
+ *
+ * @return `true` si el esclavo quedó escuchando en `MODBUS_TCP_PORT`.
+ */
+bool modbus_setup();
+
+/**
+ * @brief Tarea de FreeRTOS del esclavo Modbus.
+ *
+ * Refresca los registros de entrada cuando cambia la instantánea del motor
+ * y convierte las escrituras de registros holding en consignas para
+ * `motor_post_setpoint`.
+ *
+ * @param parameter Puntero a los parámetros de la tarea (no se usa).
+ */
+void modbus_task(void *parameter);
+
+#endif // MODBUS_SLAVE_H
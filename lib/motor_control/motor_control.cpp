@@ -1,12 +1,22 @@
 #include "motor_control.h"
 #include "ui_manager.h" // Needed for g_resetRpmEstimator and uiForceRedraw
+#include "telemetry.h"
+#include "supervisor.h"
+#include "motor_cycle.h"
+#include "task_plan.h"
+#include <esp_timer.h>
+#include <driver/gpio.h>
+#include <hal/cpu_hal.h>
+#include <soc/gpio_sig_map.h>
+#include <soc/gpio_struct.h>
 
 // ============================
 // Pines
 // ============================
 #define DIR_PIN 27
 #define STEP_PIN 26
-#define ENABLE_PIN 25
+#define ENABLE_PIN 25  // active low (FastAccelStepper default)
+#define ESTOP_PIN 34   // input only, external pull-up; the NC contact holds it low, a stop lets it rise
 
 // ============================
 // Motor / Calibración
@@ -24,17 +34,134 @@ FastAccelStepper *stepper = NULL;
 float targetRpm  = 0.0f;
 float currentRpm = 0.0f;
 extern SemaphoreHandle_t rpmMutex;
+SetpointMailbox g_setpointMailbox;
+SeqLock<MotorStateSnapshot> g_motorState;
 
 // ============================
-// Rampa de aceleración
+// Patrones de velocidad
 // ============================
-const double A_CMD   = SPR_CMD / 6.0; // Acceleration for the ramp
+/**
+ * @brief Latest uploaded pattern; a new seq tells motor_task to (re)start it.
+ */
+struct PatternRequest {
+  SpeedPattern pattern;
+  uint32_t seq;
+};
+static SeqLock<PatternRequest> g_patternRequest;  // written only by the AsyncTCP task
+static uint32_t g_patternSeq = 0;
+static TaskHandle_t g_motorTaskHandle = NULL;
+static esp_timer_handle_t g_patternTimer = NULL;
+
+/**
+ * @brief Wakes motor_task at a square-pattern edge (esp_timer task context).
+ */
+static void pattern_edge_cb(void *) {
+  if (g_motorTaskHandle) xTaskNotifyGive(g_motorTaskHandle);
+}
+
+// ============================
+// Parada de emergencia
+// ============================
+static EStopLatch g_estop;
+static portMUX_TYPE g_estopMux = portMUX_INITIALIZER_UNLOCKED;
+
+static volatile uint32_t g_stepOutSel = UINT32_MAX; // STEP's routing to the pulse peripheral, once gated
+
+static_assert(ENABLE_PIN < 32 && STEP_PIN < 32, "estop_outputs_off() writes the low GPIO bank");
+
+/**
+ * @brief Disables the driver and gates STEP with register writes, bypassing FastAccelStepper.
+ *
+ * STEP is taken from the pulse peripheral through the GPIO matrix and held
+ * low, so no pulse leaves the board even before motor_task empties the
+ * queue. motor_task routes it back once the stop is acknowledged.
+ */
+static inline void IRAM_ATTR estop_outputs_off() {
+  GPIO.out_w1ts = (1u << ENABLE_PIN);
+  GPIO.out_w1tc = (1u << STEP_PIN);
+  uint32_t sel = GPIO.func_out_sel_cfg[STEP_PIN].val;
+  if ((sel & 0x1FFu) != SIG_GPIO_OUT_IDX) g_stepOutSel = sel;
+  GPIO.func_out_sel_cfg[STEP_PIN].func_sel = SIG_GPIO_OUT_IDX;
+}
+
+/**
+ * @brief Cuts the driver outputs, then latches the stop and wakes motor_task.
+ *
+ * The outputs go off first; the latency recorded is from @p t0Cycles to
+ * that write. Callable from the ISR and from tasks. Everything it reaches is
+ * in IRAM or DRAM: the register writes, EStopLatch::trip() (inlined), the
+ * spinlock and the FreeRTOS notify, which IDF 4.4 keeps in IRAM.
+ */
+static void IRAM_ATTR estop_engage(uint8_t source, uint32_t t0Cycles, bool fromIsr) {
+  estop_outputs_off();
+  uint32_t cycles = cpu_hal_get_cycle_count() - t0Cycles;
+  BaseType_t woken = pdFALSE;
+  if (fromIsr) {
+    portENTER_CRITICAL_ISR(&g_estopMux);
+    g_estop.trip(source, cycles);
+    portEXIT_CRITICAL_ISR(&g_estopMux);
+    if (g_motorTaskHandle) vTaskNotifyGiveFromISR(g_motorTaskHandle, &woken);
+    portYIELD_FROM_ISR(woken);
+  } else {
+    portENTER_CRITICAL(&g_estopMux);
+    g_estop.trip(source, cycles);
+    portEXIT_CRITICAL(&g_estopMux);
+    if (g_motorTaskHandle) xTaskNotifyGive(g_motorTaskHandle);
+  }
+}
+
+/**
+ * @brief E-stop input edge, straight from the IRAM GPIO service on core 1.
+ */
+static void IRAM_ATTR estop_isr(void *) {
+  estop_engage(ESTOP_SOURCE_INPUT, cpu_hal_get_cycle_count(), true);
+}
+
+/**
+ * @brief Routes STEP back to the pulse peripheral once the stop is acknowledged (motor_task only).
+ *
+ * Runs after motor_task has emptied the step queue, so nothing pending
+ * reaches the driver.
+ */
+static void estop_step_release() {
+  if (g_stepOutSel == UINT32_MAX) return;
+  portENTER_CRITICAL(&g_estopMux);
+  if (!g_estop.latched()) {
+    GPIO.func_out_sel_cfg[STEP_PIN].val = g_stepOutSel;
+    g_stepOutSel = UINT32_MAX;
+  }
+  portEXIT_CRITICAL(&g_estopMux);
+}
+
+/**
+ * @brief Whether the E-stop input is in its stop state right now.
+ */
+static bool estop_input_asserted() {
+  return ESTOP_INPUT_ENABLED && digitalRead(ESTOP_PIN) == HIGH;
+}
+
+// ============================
+// Aritmética del lazo
+// ============================
+// float runs on the FPU; Q16_16 is the integer-only alternative (see motion_math.h).
+typedef float ControlScalar;
+static_assert(TICKS_PER_S == STEPPER_TICKS_PER_S, "step period tables assume FastAccelStepper's tick rate");
+
+/**
+ * @brief Deceleration of a graceful stop from the current speed, bounded by STOP_MAX_TIME_MS.
+ */
+static uint32_t graceful_stop_decel() {
+  uint32_t configured = (uint32_t)(rpm_to_sps(STOP_DECEL_RPM_PER_S) + 0.5f);
+  int32_t speed = stepper ? stepper->getCurrentSpeedInMilliHz() : 0;
+  return stop_decel_sps2(speed < 0 ? (uint32_t)-speed : (uint32_t)speed, configured, STOP_MAX_TIME_MS);
+}
 
 /**
  * @brief Initializes the motor, stepper driver, and pins.
  */
 void motor_setup() {
-  engine.init();
+  // The step queue task goes on the control core, next to motor_task.
+  engine.init(TASK_PLAN[TASK_STEPPER].core);
   stepper = engine.stepperConnectToPin(STEP_PIN);
   if (stepper) {
     stepper->setDirectionPin(DIR_PIN);
@@ -42,6 +169,18 @@ void motor_setup() {
     stepper->setAutoEnable(true);
     stepper->setAcceleration(20000); // High acceleration to not limit the ramp
   }
+  if (ESTOP_INPUT_ENABLED) {
+    // IDF's GPIO service rather than attachInterrupt(), whose dispatcher is in
+    // flash: with ESP_INTR_FLAG_IRAM the stop also fires while a flash write
+    // has the cache off. Installed from bootHw, so it is serviced on core 1.
+    esp_err_t err = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) Serial.printf("[estop] isr service: %d\n", (int)err);
+    pinMode(ESTOP_PIN, INPUT);
+    gpio_set_intr_type((gpio_num_t)ESTOP_PIN, GPIO_INTR_POSEDGE);
+    gpio_isr_handler_add((gpio_num_t)ESTOP_PIN, estop_isr, NULL);
+    // Pressed or wire broken at power-up: start latched.
+    if (estop_input_asserted()) estop_engage(ESTOP_SOURCE_INPUT, cpu_hal_get_cycle_count(), false);
+  }
 }
 
 /**
@@ -50,49 +189,222 @@ void motor_setup() {
  * @param parameter Task parameter (not used).
  */
 void motor_task(void *parameter) {
+  PatternGenerator pattern;
+  uint32_t patternSeq = 0;
+  CommandLatencyTracker latency(g_metrics.commands);
+  MotorCycleConfig cycleConfig = {(uint32_t)(rpm_to_sps(STOP_DECEL_RPM_PER_S) + 0.5f), STOP_MAX_TIME_MS};
+  MotorCycle<ControlScalar> cycle(latency, cycleConfig);
+  g_motorTaskHandle = xTaskGetCurrentTaskHandle();
+  esp_timer_create_args_t timerArgs = {};
+  timerArgs.callback = pattern_edge_cb;
+  timerArgs.name = "patternEdge";
+  esp_timer_create(&timerArgs, &g_patternTimer);
+  supervisor_register(SUPERVISED_MOTOR);
   while (true) {
-    double sp_rpm;
-    if (xSemaphoreTake(rpmMutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-      sp_rpm = (double)targetRpm;
-      xSemaphoreGive(rpmMutex);
+    supervisor_check_in(SUPERVISED_MOTOR);
+    trace_clock_sync();
+    trace_event(TRACE_PHASE_BEGIN, "motor_cycle");
+    uint16_t errorFlags = stepper ? 0 : MOTOR_ERR_NO_DRIVER;
+    // Apply the latest coalesced setpoint; older ones were overwritten.
+    SetpointCommand cmd;
+    bool haveCommand = g_setpointMailbox.take(cmd);
+    PatternRequest request;
+    if (g_patternRequest.read(request) && request.seq != patternSeq) {
+      patternSeq = request.seq;
+      pattern.start(request.pattern, esp_timer_get_time());
+      haveCommand = false; // the upload supersedes a setpoint taken in the same cycle
+    } else if (haveCommand) {
+      pattern.stop(); // any setpoint or stop takes over from the pattern
     }
-
-    if (stepper) {
-      if (sp_rpm < 1.0) {
-        if (stepper->isRunningContinuously()) {
-          stepper->stopMove();
-          stepper->disableOutputs();
-        }
-      } else {
-        double targetSPS = rpm2sps(sp_rpm);
-        stepper->setAcceleration((float)A_CMD);
-        stepper->setSpeedInHz((float)targetSPS);
-        if (!stepper->isRunningContinuously()) {
-          stepper->enableOutputs();
-          stepper->runForward();
-        } else {
-          stepper->applySpeedAcceleration();
-        }
-      }
+    if (g_estop.takePending()) {
+      // The outputs are already off; this empties the step queue. Gate again:
+      // a software trip racing estop_step_release() may have been undone.
+      estop_outputs_off();
+      if (stepper) stepper->forceStop();
+      g_resetRpmEstimator = true;
+      TRACE_INSTANT("estop", g_estop.status().source);
+    }
+    bool estopLatched = g_estop.latched();
+    if (estopLatched) {
+      // Nothing restarts the motor until the stop is acknowledged.
+      haveCommand = false;
+      pattern.stop();
+      errorFlags |= MOTOR_ERR_ESTOP;
+    } else {
+      estop_step_release();
     }
-    vTaskDelay(pdMS_TO_TICKS(50));
+    // The setpoint follows the hardware timer, not this loop: a late cycle
+    // applies a change late but never shifts the schedule.
+    bool patternDriving = pattern.active();
+    float patternRpm = 0.0f;
+    uint32_t patternCycle = 0;
+    if (patternDriving) {
+      uint64_t nowUs = esp_timer_get_time();
+      patternRpm = pattern.rpmAt(nowUs);
+      patternCycle = pattern.cycle(nowUs);
+      esp_timer_stop(g_patternTimer);
+      uint64_t edgeUs = pattern.nextEdgeUs(nowUs);
+      if (edgeUs) esp_timer_start_once(g_patternTimer, edgeUs - nowUs);
+      if (pattern.finished(nowUs)) pattern.stop(); // rpmAt() was 0: the motor stops
+    }
+    if (haveCommand) TRACE_INSTANT("setpoint_applied", cmd.stop ? 0 : (uint32_t)cmd.rpm);
+
+    // Setpoint under rpmMutex, then the stepper outside it: see motor_cycle.h.
+    bool locked = rpm_mutex_take(pdMS_TO_TICKS(5));
+    cycle.resolve(haveCommand ? &cmd : NULL, patternDriving ? &patternRpm : NULL, estopLatched,
+                  locked ? &targetRpm : NULL, locked ? &currentRpm : NULL);
+    if (locked) xSemaphoreGive(rpmMutex);
+    MotorCycleResult result = cycle.drive(stepper, millis(), micros());
+    if (result.stopOverrun) g_metrics.stopOverruns.inc();
+    // A trip since the check above may have been undone by enableOutputs().
+    if (result.outputsEnabled && g_estop.latched()) estop_outputs_off();
+    errorFlags |= result.errorFlags;
+
+    MotorStateSnapshot state = {};
+    state.targetRpm = result.setpointRpm;
+    state.currentRpm = result.measuredRpm;
+    state.stepCount = stepper ? (uint32_t)stepper->getCurrentPosition() : 0;
+    state.updatedMs = millis();
+    state.errorFlags = errorFlags;
+    state.runState = (stepper && stepper->isRunningContinuously()) ? MOTOR_RUNNING : MOTOR_STOPPED;
+    state.patternActive = pattern.active() ? 1 : 0;
+    state.patternCycle = patternCycle;
+    g_motorState.publish(state);
+    trace_event(TRACE_PHASE_END, "motor_cycle");
+
+    // 50 ms cycle; a square-pattern edge wakes the task early.
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(50));
   }
 }
 
+/**
+ * @brief Queues a new setpoint for motor_task without taking rpmMutex.
+ *
+ * @param rpm Requested speed; values <= 1 RPM stop the motor.
+ * @param source Origin of the command.
+ * @param ingressUs micros() when the command entered the firmware.
+ */
+void motor_post_setpoint(float rpm, CommandSource source, uint32_t ingressUs) {
+  g_setpointMailbox.post(rpm, source, ingressUs);
+}
+
+/**
+ * @brief Hands a speed pattern to motor_task, which starts it on its next cycle.
+ *
+ * Called from the AsyncTCP task only (single writer of g_patternRequest),
+ * with a pattern that already passed pattern_valid().
+ */
+void motor_start_pattern(const SpeedPattern &pattern) {
+  PatternRequest request = {};
+  request.pattern = pattern;
+  request.seq = ++g_patternSeq;
+  g_patternRequest.publish(request);
+  if (g_motorTaskHandle) xTaskNotifyGive(g_motorTaskHandle);
+}
+
+/**
+ * @brief Last pattern handed to motor_start_pattern(); false if none was.
+ */
+bool motor_last_pattern(SpeedPattern &out) {
+  PatternRequest request;
+  if (!g_patternRequest.read(request) || request.seq == 0) return false;
+  out = request.pattern;
+  return true;
+}
+
+/**
+ * @brief Stops the motor in the given mode and lets motor_task time it.
+ *
+ * A hard stop acts on the stepper from the calling task; a graceful one is
+ * queued and motor_task runs the ramp.
+ *
+ * @param mode Graceful or hard.
+ * @param source Origin of the stop.
+ * @param ingressUs micros() when the stop entered the firmware.
+ */
+void motor_stop(StopMode mode, CommandSource source, uint32_t ingressUs) {
+  if (mode == STOP_MODE_HARD) {
+    stop_motor_hard(source == CMD_SOURCE_ENCODER);
+    g_metrics.commands[source].applied.observe(micros() - ingressUs);
+  }
+  g_setpointMailbox.post(0.0f, source, ingressUs, mode == STOP_MODE_HARD);
+}
+
+/**
+ * @brief Brings the motor to a controlled stop without waiting for motor_task or rpmMutex.
+ *
+ * Used by the deadline supervisor when motor_task stalls. FastAccelStepper
+ * ramps down on its own, along the stop ramp; the queued stop keeps
+ * motor_task from restarting the motor if it resumes, and disables the
+ * outputs then.
+ */
+void motor_safe_stop() {
+  if (stepper) {
+    stepper->setAcceleration(graceful_stop_decel());
+    stepper->applySpeedAcceleration();
+    stepper->stopMove();
+  }
+  g_setpointMailbox.post(0.0f, CMD_SOURCE_SUPERVISOR, micros());
+}
+
+/**
+ * @brief Software E-stop: same path as the input, from the calling task.
+ */
+void motor_estop_trigger() {
+  estop_engage(ESTOP_SOURCE_SOFTWARE, cpu_hal_get_cycle_count(), false);
+}
+
+/**
+ * @brief Clears the E-stop latch unless the input is still asserted.
+ *
+ * The motor stays stopped; it needs a new setpoint to run.
+ */
+bool motor_estop_acknowledge() {
+  bool inputAsserted = estop_input_asserted();
+  portENTER_CRITICAL(&g_estopMux);
+  bool cleared = g_estop.acknowledge(inputAsserted);
+  portEXIT_CRITICAL(&g_estopMux);
+  return cleared;
+}
+
+/**
+ * @brief E-stop latch state and measured latencies, in CPU cycles.
+ */
+EStopStatus motor_estop_status() {
+  portENTER_CRITICAL(&g_estopMux);
+  EStopStatus status = g_estop.status();
+  portEXIT_CRITICAL(&g_estopMux);
+  return status;
+}
+
+/**
+ * @brief Takes rpmMutex, counting contention and timeouts for /metrics.
+ *
+ * @param timeout Maximum wait in ticks.
+ * @return True if the mutex was taken.
+ */
+bool rpm_mutex_take(TickType_t timeout) {
+  if (xSemaphoreTake(rpmMutex, 0) == pdTRUE) return true;
+  g_metrics.rpmMutexContended.inc();
+  if (timeout > 0 && xSemaphoreTake(rpmMutex, timeout) == pdTRUE) return true;
+  g_metrics.rpmMutexTimeouts.inc();
+  return false;
+}
+
 /**
  * @brief Stops the motor immediately and resets the RPM.
  *
  * @param from_ui True if the stop was triggered from the UI.
  */
 void stop_motor_hard(bool from_ui) {
-  if (xSemaphoreTake(rpmMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+  if (rpm_mutex_take(pdMS_TO_TICKS(10))) {
     targetRpm = 0.0f;
     currentRpm = 0.0f;
     xSemaphoreGive(rpmMutex);
   }
 
   if (stepper) {
-    stepper->stopMove();
+    stepper->forceStop();
     stepper->disableOutputs();
   }
 
@@ -5,6 +5,11 @@
 #include <Arduino.h>
 #include <FastAccelStepper.h>
 #include "shared_logic.h"
+#include "setpoint_mailbox.h"
+#include "motor_state.h"
+#include "speed_pattern.h"
+#include "estop.h"
+#include "stop_ramp.h"
 
 /**
  * @file motor_control.h
@@ -27,7 +32,121 @@ void motor_setup();
 void motor_task(void *parameter);
 
 /**
- * @brief Detiene el motor de forma inmediata.
+ * @brief Buzón con la última consigna pendiente para `motor_task`.
+ */
+extern SetpointMailbox g_setpointMailbox;
+
+/**
+ * @brief Último estado publicado por `motor_task` (consigna, velocidad, pasos, errores).
+ *
+ * Se actualiza en cada ciclo de la tarea y se lee sin bloqueo desde `/status`,
+ * el servidor Modbus y el anuncio mDNS, sin tomar `rpmMutex`.
+ */
+extern SeqLock<MotorStateSnapshot> g_motorState;
+
+/**
+ * @brief Publica una nueva consigna de velocidad sin bloquear.
+ *
+ * La consigna se deja en un buzón de un solo elemento (el último escritor gana)
+ * y `motor_task` la aplica en su siguiente ciclo. Pensada para ser llamada
+ * desde la tarea de AsyncTCP, que nunca debe esperar por `rpmMutex`.
+ *
+ * @param rpm Velocidad deseada; valores <= 1 RPM detienen el motor.
+ * @param source Origen de la orden (web, encoder o protocolo).
+ * @param ingressUs `micros()` del momento en que la orden entró al firmware;
+ *                  `motor_task` mide desde ahí hasta aplicarla y hasta alcanzar la velocidad.
+ */
+void motor_post_setpoint(float rpm, CommandSource source, uint32_t ingressUs);
+
+/**
+ * @brief Detiene el motor en el modo indicado y registra la latencia de la parada.
+ *
+ * - `STOP_MODE_GRACEFUL`: deja la parada en el buzón y `motor_task` desacelera
+ *   con la rampa de parada (`STOP_DECEL_RPM_PER_S`, más pronunciada si hace
+ *   falta para no pasar de `STOP_MAX_TIME_MS`) y desactiva el driver al quedar
+ *   parado. Si el motor sigue girando pasado ese plazo, lo detiene en seco.
+ * - `STOP_MODE_HARD`: actúa sobre el motor de inmediato (como `stop_motor_hard`)
+ *   y deja la parada en el buzón, ya marcada como aplicada.
+ *
+ * En ambos casos `motor_task` mide cuánto tarda el motor en quedar detenido.
+ *
+ * @param mode Modo de parada; no hay modo por defecto.
+ * @param source Origen de la parada.
+ * @param ingressUs `micros()` del momento en que la orden entró al firmware.
+ */
+void motor_stop(StopMode mode, CommandSource source, uint32_t ingressUs);
+
+/**
+ * @brief Carga un patrón de velocidad que `motor_task` ejecuta por su cuenta.
+ *
+ * La consigna sigue al patrón sin más tráfico de red: la calcula `motor_task`
+ * a partir de `esp_timer_get_time()` y un temporizador de un disparo lo
+ * despierta en cada flanco de un patrón cuadrado, así que la fase no deriva
+ * aunque el patrón dure horas. Cualquier consigna o parada posterior lo
+ * termina; al completar `cycles` periodos el motor se detiene.
+ *
+ * @param pattern Patrón a ejecutar desde ahora, ya comprobado con `pattern_valid()`.
+ */
+void motor_start_pattern(const SpeedPattern &pattern);
+
+/**
+ * @brief Último patrón cargado con `motor_start_pattern()`.
+ *
+ * @return `false` si no se ha cargado ninguno desde el arranque.
+ */
+bool motor_last_pattern(SpeedPattern &out);
+
+/**
+ * @brief Parada controlada sin depender de `motor_task` ni de `rpmMutex`.
+ *
+ * La usa el supervisor de plazos cuando la tarea de control deja de responder:
+ * el motor desacelera con la rampa de parada y la parada queda en el buzón
+ * para que `motor_task` no lo vuelva a arrancar si se recupera.
+ */
+void motor_safe_stop();
+
+/**
+ * @brief Parada de emergencia por software.
+ *
+ * Sigue el mismo camino que la entrada de parada de emergencia (`ESTOP_PIN`):
+ * desactiva las salidas del driver con una escritura directa al registro de
+ * GPIO, sin `rpmMutex` ni FastAccelStepper, y enclava la parada. `motor_task`
+ * vacía después la cola de pasos y no vuelve a mover el motor hasta que la
+ * parada se reconoce con `motor_estop_acknowledge()`.
+ */
+void motor_estop_trigger();
+
+/**
+ * @brief Reconoce la parada de emergencia.
+ *
+ * @return `false` si la entrada sigue en estado de parada; el enclavamiento se mantiene.
+ *         El motor queda parado hasta recibir una consigna nueva.
+ */
+bool motor_estop_acknowledge();
+
+/**
+ * @brief Estado del enclavamiento y latencia medida (ciclos de CPU desde la
+ *        entrada a la ISR o a `motor_estop_trigger()` hasta las salidas desactivadas).
+ */
+EStopStatus motor_estop_status();
+
+/**
+ * @brief Toma `rpmMutex` contabilizando la contención y los vencimientos.
+ *
+ * Sustituye a `xSemaphoreTake(rpmMutex, timeout)`; la liberación sigue siendo
+ * `xSemaphoreGive(rpmMutex)`.
+ *
+ * @param timeout Espera máxima en ticks.
+ * @return `true` si se obtuvo el mutex.
+ */
+bool rpm_mutex_take(TickType_t timeout);
+
+/**
+ * @brief Detiene el motor de forma inmediata (parada dura).
+ *
+ * Detiene el generador de pasos y desactiva el driver sin rampa: el plato
+ * queda libre. Reservada para emergencias; las paradas normales usan
+ * `motor_stop(STOP_MODE_GRACEFUL, ...)`.
  *
  * @param from_ui `true` si la parada fue iniciada desde la interfaz de usuario física,
  *                lo que fuerza un redibujado de la pantalla.
@@ -0,0 +1,71 @@
+#include "serial_console.h"
+#include "motor_control.h"
+#include "settings.h"
+#include "task_monitor.h"
+#include "scpi.h"
+
+// ============================
+// Dispositivo para el intérprete
+// ============================
+static char g_identity[48];
+static TaskHandle_t g_consoleTask = NULL;
+
+/**
+ * @brief Binds scpi_execute() to the motor API; one per batch of input.
+ */
+struct FirmwareScpiDevice {
+  uint32_t ingressUs;  ///< micros() when the batch was read, for the command latency metrics.
+
+  const char *identity() const { return g_identity; }
+  float maxRpm() const { return settings_get().maxRpm; }
+  void setSpeed(float rpm) { motor_post_setpoint(rpm, CMD_SOURCE_SERIAL, ingressUs); }
+  void stop(StopMode mode) { motor_stop(mode, CMD_SOURCE_SERIAL, ingressUs); }
+  bool state(MotorStateSnapshot &out) const { return g_motorState.read(out); }
+  void estopTrip() { motor_estop_trigger(); }
+  bool estopAcknowledge() { return motor_estop_acknowledge(); }
+  bool estopLatched() const { return motor_estop_status().latched; }
+};
+
+/**
+ * @brief Starts the console task.
+ */
+void serial_console_setup() {
+  if (!SERIAL_SCPI_ENABLED) return;
+  String suffix = String((uint32_t)ESP.getEfuseMac(), HEX).substring(4);
+  snprintf(g_identity, sizeof(g_identity), "BioShaker,%s,%s", suffix.c_str(), FIRMWARE_VERSION);
+  if (!task_start(TASK_SERIAL, serial_console_task, NULL, &g_consoleTask)) return;
+  // Runs in the UART event task: only wakes the console up.
+  Serial.onReceive([]() { xTaskNotifyGive(g_consoleTask); });
+}
+
+/**
+ * @brief Tags every line of @p text and writes the block at once.
+ */
+void serial_log(const char *tag, const char *text) {
+  std::string block;
+  scpi_log_lines(tag, text, block);
+  Serial.write((const uint8_t *)block.data(), block.size());
+}
+
+/**
+ * @brief Answers every complete line as soon as it arrives, without blocking on the port.
+ */
+void serial_console_task(void *parameter) {
+  ScpiSession<FirmwareScpiDevice> session;
+  std::string replies;
+  uint8_t buf[64];
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SERIAL_SCPI_POLL_MS));
+    FirmwareScpiDevice device = {(uint32_t)micros()};
+    int available;
+    while ((available = Serial.available()) > 0) {
+      size_t n = Serial.read(buf, (size_t)available < sizeof(buf) ? (size_t)available : sizeof(buf));
+      session.feed((const char *)buf, n, device, replies);
+    }
+    if (!replies.empty()) {
+      // Pipelined lines are answered in one write, in the order they came.
+      Serial.write((const uint8_t *)replies.data(), replies.size());
+      replies.clear();
+    }
+  }
+}
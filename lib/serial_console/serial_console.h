@@ -0,0 +1,48 @@
+#ifndef SERIAL_CONSOLE_H
+#define SERIAL_CONSOLE_H
+
+#include "config.h"
+#include <Arduino.h>
+
+/**
+ * @file serial_console.h
+ * @brief Consola de órdenes tipo SCPI por el puerto serie USB, para robots de laboratorio.
+ *
+ * Órdenes de una línea (`SPEED 250`, `SPEED?`, `STOP`, `STAT?`, `*IDN?`,
+ * `ESTOP`...; la lista completa y el formato de las respuestas están en
+ * `lib/shared_logic/scpi.h`). Cada línea recibe exactamente una línea de
+ * respuesta y en orden, así que el equipo anfitrión puede enviar varias
+ * órdenes seguidas sin esperar (modo en tubería) y emparejar las respuestas
+ * por posición.
+ *
+ * La tarea `serialScpi` (núcleo 0, prioridad baja) nunca se bloquea en el
+ * puerto: despierta con el evento de recepción de la UART (o cada
+ * `SERIAL_SCPI_POLL_MS`), consume lo que haya, responde todas las líneas
+ * completas con una sola escritura y vuelve a dormir. Las órdenes entran por
+ * las mismas vías que las de Modbus (`motor_post_setpoint`, `motor_stop`),
+ * con su propio origen, `CMD_SOURCE_SERIAL`.
+ */
+
+/**
+ * @brief Crea la tarea de la consola si `SERIAL_SCPI_ENABLED`.
+ *
+ * Llamar después de `Serial.begin()` y de `settings_setup()`.
+ */
+void serial_console_setup();
+
+/**
+ * @brief Tarea de FreeRTOS de la consola.
+ *
+ * @param parameter Puntero a los parámetros de la tarea (no se usa).
+ */
+void serial_console_task(void *parameter);
+
+/**
+ * @brief Imprime @p text por Serial con cada línea precedida de `[<tag>] `, en una sola escritura.
+ *
+ * Para los informes de varias líneas: la UART serializa cada escritura, así
+ * que el informe no puede partir una respuesta de la consola.
+ */
+void serial_log(const char *tag, const char *text);
+
+#endif // SERIAL_CONSOLE_H
@@ -0,0 +1,235 @@
+#include "settings.h"
+#include "motor_control.h"
+#include "task_monitor.h"
+#include <ArduinoJson.h>
+#include <FS.h>
+#include <LittleFS.h>
+
+// ============================
+// Claves del fichero
+// ============================
+// Never reuse a key: a member whose type or meaning changes gets a new one.
+enum SettingsKey : uint16_t {
+  KEY_LANGUAGE = 1,
+  KEY_LAST_TARGET_RPM = 2,
+  KEY_MAX_RPM = 3,
+  KEY_MEAS_STEPS_PER_REV = 4,
+  KEY_WIFI_SSID = 5,
+  KEY_WIFI_PASSWORD = 6,
+  KEY_WIFI_BSSID = 7,
+  KEY_WIFI_CHANNEL = 8,
+};
+
+static const ConfigField FIELDS[] = {
+  CONFIG_FIELD(KEY_LANGUAGE, DeviceSettings, language),
+  CONFIG_FIELD(KEY_LAST_TARGET_RPM, DeviceSettings, lastTargetRpm),
+  CONFIG_FIELD(KEY_MAX_RPM, DeviceSettings, maxRpm),
+  CONFIG_FIELD(KEY_MEAS_STEPS_PER_REV, DeviceSettings, measStepsPerRev),
+  CONFIG_FIELD(KEY_WIFI_SSID, DeviceSettings, wifiSsid),
+  CONFIG_FIELD(KEY_WIFI_PASSWORD, DeviceSettings, wifiPassword),
+  CONFIG_FIELD(KEY_WIFI_BSSID, DeviceSettings, wifiBssid),
+  CONFIG_FIELD(KEY_WIFI_CHANNEL, DeviceSettings, wifiChannel),
+};
+static const size_t FIELD_COUNT = sizeof(FIELDS) / sizeof(FIELDS[0]);
+
+static const char* const CONFIG_PATH = "/config.bin";
+static const char* const CONFIG_TMP_PATH = "/config.tmp";
+static const char* const LEGACY_WIFI_PATH = "/wifiConfig.json";
+static const size_t CONFIG_FILE_MAX = 256;
+
+// ============================
+// Estado
+// ============================
+static DeviceSettings default_settings() {
+  DeviceSettings s = {};
+  s.maxRpm = MAX_RPM;
+  s.measStepsPerRev = SPR_MEAS;
+  return s;
+}
+
+static ConfigStore<DeviceSettings> g_store(default_settings(), SETTINGS_COMMIT_QUIET_MS,
+                                           SETTINGS_COMMIT_MAX_DELAY_MS);
+// Writer side of g_store; readers on this core cannot preempt a publish.
+static portMUX_TYPE g_storeMux = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t g_commitMutex;
+static bool g_legacyPending = false;
+
+/**
+ * @brief Reads and checks one copy of the configuration file.
+ */
+static bool read_config_file(const char* path, DeviceSettings& out) {
+  File f = LittleFS.open(path, "r");
+  if (!f) return false;
+  uint8_t buf[CONFIG_FILE_MAX];
+  size_t n = f.read(buf, sizeof(buf));
+  f.close();
+  if (!config_decode(buf, n, FIELDS, FIELD_COUNT, out)) return false;
+  out.wifiSsid[sizeof(out.wifiSsid) - 1] = '\0';
+  out.wifiPassword[sizeof(out.wifiPassword) - 1] = '\0';
+  return true;
+}
+
+/**
+ * @brief Imports the credentials written by earlier firmware to /wifiConfig.json.
+ */
+static bool read_legacy_wifi(DeviceSettings& out) {
+  File f = LittleFS.open(LEGACY_WIFI_PATH, "r");
+  if (!f) return false;
+  StaticJsonDocument<256> doc;
+  DeserializationError err = deserializeJson(doc, f);
+  f.close();
+  if (err) return false;
+
+  strlcpy(out.wifiSsid, doc["ssid"] | "", sizeof(out.wifiSsid));
+  strlcpy(out.wifiPassword, doc["password"] | "", sizeof(out.wifiPassword));
+  unsigned int b[6];
+  if (sscanf(doc["bssid"] | "", "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) == 6) {
+    for (int i = 0; i < 6; ++i) out.wifiBssid[i] = (uint8_t)b[i];
+    out.wifiChannel = doc["channel"] | 0;
+  }
+  return true;
+}
+
+/**
+ * @brief Writes the file next to the current one and renames it over it.
+ *
+ * A power loss leaves either the old file or the new one; a torn temporary
+ * file fails its CRC and is ignored at boot.
+ */
+static bool write_config_file(const DeviceSettings& s) {
+  uint8_t buf[CONFIG_FILE_MAX];
+  size_t n = config_encode(s, FIELDS, FIELD_COUNT, buf, sizeof(buf));
+  if (n == 0) return false;
+  File f = LittleFS.open(CONFIG_TMP_PATH, "w");
+  if (!f) return false;
+  size_t written = f.write(buf, n);
+  f.close();
+  if (written != n) {
+    LittleFS.remove(CONFIG_TMP_PATH);
+    return false;
+  }
+  return LittleFS.rename(CONFIG_TMP_PATH, CONFIG_PATH);
+}
+
+/**
+ * @brief Writes the pending changes if there are any (or if @p force) and records the outcome.
+ */
+static bool commit(bool force) {
+  xSemaphoreTake(g_commitMutex, portMAX_DELAY);
+  portENTER_CRITICAL(&g_storeMux);
+  bool due = force ? g_store.dirty() : g_store.commitDue(millis());
+  DeviceSettings snapshot = g_store.value();
+  uint32_t version = g_store.version();
+  portEXIT_CRITICAL(&g_storeMux);
+
+  bool ok = true;
+  if (due) {
+    ok = write_config_file(snapshot);
+    portENTER_CRITICAL(&g_storeMux);
+    g_store.committed(version, ok, millis());
+    portEXIT_CRITICAL(&g_storeMux);
+    if (!ok) {
+      Serial.print("[cfg] write failed; will retry\n");
+    } else if (g_legacyPending) {
+      LittleFS.remove(LEGACY_WIFI_PATH);
+      g_legacyPending = false;
+    }
+  }
+  xSemaphoreGive(g_commitMutex);
+  return ok;
+}
+
+/**
+ * @brief Applies @p change to the RAM copy and schedules a commit.
+ */
+template <typename F>
+static void update(F change) {
+  portENTER_CRITICAL(&g_storeMux);
+  DeviceSettings s = g_store.value();
+  change(s);
+  g_store.set(s, millis());
+  portEXIT_CRITICAL(&g_storeMux);
+}
+
+// ============================
+// API
+// ============================
+
+/**
+ * @brief Loads /config.bin once (or migrates /wifiConfig.json) and starts the commit task.
+ */
+void settings_setup() {
+  g_commitMutex = xSemaphoreCreateMutex();
+
+  DeviceSettings s = default_settings();
+  if (read_config_file(CONFIG_PATH, s)) {
+    g_store.load(s);
+  } else if (read_config_file(CONFIG_TMP_PATH, s)) {
+    // Power was lost between writing the new file and renaming it.
+    g_store.load(s);
+    LittleFS.rename(CONFIG_TMP_PATH, CONFIG_PATH);
+  } else if (read_legacy_wifi(s)) {
+    g_legacyPending = true;
+    update([&s](DeviceSettings& cur) { cur = s; });
+    Serial.print("[cfg] imported /wifiConfig.json\n");
+  }
+
+  task_start(TASK_SETTINGS, settings_task);
+}
+
+DeviceSettings settings_get() {
+  return g_store.get();
+}
+
+void settings_set_language(uint8_t language) {
+  update([language](DeviceSettings& s) { s.language = language; });
+}
+
+void settings_set_last_target_rpm(float rpm) {
+  update([rpm](DeviceSettings& s) { s.lastTargetRpm = rpm; });
+}
+
+void settings_set_calibration(float maxRpm, double measStepsPerRev) {
+  update([maxRpm, measStepsPerRev](DeviceSettings& s) {
+    if (maxRpm > 0) s.maxRpm = maxRpm;
+    if (measStepsPerRev > 0) s.measStepsPerRev = measStepsPerRev;
+  });
+}
+
+void settings_set_wifi(const char* ssid, const char* password, const uint8_t* bssid, int32_t channel) {
+  update([ssid, password, bssid, channel](DeviceSettings& s) {
+    strlcpy(s.wifiSsid, ssid, sizeof(s.wifiSsid));
+    strlcpy(s.wifiPassword, password, sizeof(s.wifiPassword));
+    if (bssid && channel > 0) {
+      memcpy(s.wifiBssid, bssid, sizeof(s.wifiBssid));
+      s.wifiChannel = channel;
+    } else {
+      memset(s.wifiBssid, 0, sizeof(s.wifiBssid));
+      s.wifiChannel = 0;
+    }
+  });
+}
+
+bool settings_flush() {
+  return commit(true);
+}
+
+uint32_t settings_commits() {
+  return g_store.commits();
+}
+
+/**
+ * @brief Follows the applied setpoint and writes coalesced changes to flash.
+ */
+void settings_task(void *parameter) {
+  while (true) {
+    vTaskDelay(pdMS_TO_TICKS(SETTINGS_TASK_PERIOD_MS));
+    MotorStateSnapshot motor;
+    // Only running setpoints: a stop must not erase the speed to offer next time.
+    // A pattern changes the setpoint continuously; following it would only wear the flash.
+    if (g_motorState.read(motor) && !motor.patternActive && motor.targetRpm >= 1.0f) {
+      settings_set_last_target_rpm(motor.targetRpm);
+    }
+    commit(false);
+  }
+}
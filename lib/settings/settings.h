@@ -0,0 +1,89 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include "config.h"
+#include <Arduino.h>
+#include "config_store.h"
+
+/**
+ * @file settings.h
+ * @brief Configuración persistente del equipo con caché en RAM.
+ *
+ * Se lee una sola vez al arrancar desde `/config.bin` (LittleFS). Después
+ * las lecturas salen de la RAM sin bloqueo y sin tocar el sistema de
+ * ficheros; los cambios se agrupan y la tarea `settingsTask` los escribe de
+ * una vez (fichero temporal + renombrado atómico, con CRC) cuando dejan de
+ * llegar durante `SETTINGS_COMMIT_QUIET_MS`, o como mucho
+ * `SETTINGS_COMMIT_MAX_DELAY_MS` después del primero.
+ *
+ * Si no existe `/config.bin` se importan las credenciales de
+ * `/wifiConfig.json` (firmware anterior); ese fichero se borra tras la
+ * primera escritura correcta.
+ */
+
+/**
+ * @brief Valores persistidos. Cada miembro se guarda con su clave en `settings.cpp`.
+ */
+struct DeviceSettings {
+  uint8_t language;          ///< 0: español, 1: inglés.
+  float lastTargetRpm;       ///< Última consigna de marcha (>= 1 RPM) aplicada por `motor_task`.
+  float maxRpm;              ///< Calibración: consigna máxima aceptada.
+  double measStepsPerRev;    ///< Calibración: pasos medidos por vuelta (estimador de RPM).
+  char wifiSsid[33];
+  char wifiPassword[65];
+  uint8_t wifiBssid[6];      ///< Último AP al que se asoció (conexión rápida).
+  int32_t wifiChannel;       ///< 0 = desconocido, sin conexión rápida.
+};
+
+const uint32_t SETTINGS_COMMIT_QUIET_MS = 2000;
+const uint32_t SETTINGS_COMMIT_MAX_DELAY_MS = 30000;
+const uint32_t SETTINGS_TASK_PERIOD_MS = 250;
+
+/**
+ * @brief Carga la configuración desde LittleFS y crea `settingsTask`.
+ *
+ * Llamar una vez, con LittleFS ya montado. Antes de llamarla, `settings_get()`
+ * devuelve los valores por defecto.
+ */
+void settings_setup();
+
+/**
+ * @brief Copia de la configuración actual; sin bloqueo, desde cualquier tarea.
+ */
+DeviceSettings settings_get();
+
+/** @brief Idioma de la interfaz. */
+void settings_set_language(uint8_t language);
+
+/** @brief Última consigna de marcha; `settingsTask` la toma de `g_motorState`. */
+void settings_set_last_target_rpm(float rpm);
+
+/** @brief Calibración del motor; valores no positivos se ignoran. */
+void settings_set_calibration(float maxRpm, double measStepsPerRev);
+
+/**
+ * @brief Credenciales WiFi y, si se conoce, el AP y canal de la última asociación.
+ *
+ * @param bssid NULL o `channel` <= 0 para olvidar el AP (sin conexión rápida).
+ */
+void settings_set_wifi(const char* ssid, const char* password, const uint8_t* bssid, int32_t channel);
+
+/**
+ * @brief Escribe ya los cambios pendientes.
+ *
+ * Para cambios que el usuario espera ver guardados al instante (credenciales).
+ * No llamar desde tareas de control: espera a la escritura en flash.
+ *
+ * @return True si no quedó nada pendiente.
+ */
+bool settings_flush();
+
+/** @brief Escrituras correctas de `/config.bin` desde el arranque. */
+uint32_t settings_commits();
+
+/**
+ * @brief Tarea que sigue la consigna aplicada y escribe los cambios agrupados.
+ */
+void settings_task(void *parameter);
+
+#endif // SETTINGS_H
@@ -0,0 +1,136 @@
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+// ============================
+// Línea de tiempo del arranque
+// ============================
+
+/**
+ * @brief One named instant or phase of the boot sequence.
+ */
+struct BootMark {
+    const char *name;  ///< Phase name (string literal, not copied).
+    uint32_t us;       ///< Time since reset in microseconds (end of the phase).
+    uint32_t startUs;  ///< Start of the phase; equal to us for an instant.
+};
+
+/**
+ * @brief Fixed-size record of boot milestones and phases.
+ *
+ * mark() and span() may be called from any task, so phases that run
+ * concurrently on different tasks are recorded with their own start and end.
+ * Slots are claimed atomically and extra entries are dropped once the table
+ * is full.
+ */
+class BootTimeline {
+public:
+    static constexpr size_t MAX_MARKS = 24;
+
+    /**
+     * @brief Records that @p name was reached at @p us.
+     *
+     * @param name Phase name; must outlive the timeline (use a literal).
+     * @param us Time since reset in microseconds (micros() on the device).
+     */
+    void mark(const char *name, uint32_t us) { span(name, us, us); }
+
+    /**
+     * @brief Records that phase @p name ran from @p startUs to @p endUs.
+     */
+    void span(const char *name, uint32_t startUs, uint32_t endUs) {
+        size_t i = _count.load(std::memory_order_relaxed);
+        do {
+            if (i >= MAX_MARKS) return;
+        } while (!_count.compare_exchange_weak(i, i + 1, std::memory_order_acq_rel));
+        _marks[i].name = name;
+        _marks[i].us = endUs;
+        _marks[i].startUs = startUs;
+        _ready[i].store(true, std::memory_order_release);
+    }
+
+    size_t count() const {
+        size_t n = _count.load(std::memory_order_acquire);
+        return n > MAX_MARKS ? MAX_MARKS : n;
+    }
+
+    /**
+     * @brief Returns the i-th mark, or NULL if it is not fully written yet.
+     */
+    const BootMark *at(size_t i) const {
+        if (i >= count() || !_ready[i].load(std::memory_order_acquire)) return nullptr;
+        return &_marks[i];
+    }
+
+    /**
+     * @brief Time of the first mark called @p name.
+     *
+     * @return Microseconds since reset, or UINT32_MAX if it was never reached.
+     */
+    uint32_t timeOf(const char *name) const {
+        for (size_t i = 0; i < count(); ++i) {
+            const BootMark *m = at(i);
+            if (m && strcmp(m->name, name) == 0) return m->us;
+        }
+        return UINT32_MAX;
+    }
+
+    /**
+     * @brief Sum of the durations of all phases; more than the boot time when phases overlapped.
+     */
+    uint32_t phaseSumUs() const {
+        uint32_t total = 0;
+        for (size_t i = 0; i < count(); ++i) {
+            const BootMark *m = at(i);
+            if (m) total += m->us - m->startUs;
+        }
+        return total;
+    }
+
+    /**
+     * @brief Writes one line per entry into @p out.
+     *
+     * Instants read "name +ms (delta from the previous instant)"; phases read
+     * "name +ms [start +ms, took ms]".
+     *
+     * @return Number of characters written, excluding the terminator.
+     */
+    size_t format(char *out, size_t len) const {
+        if (len == 0) return 0;
+        size_t used = 0;
+        out[0] = '\0';
+        uint32_t prev = 0;
+        for (size_t i = 0; i < count(); ++i) {
+            const BootMark *m = at(i);
+            if (!m) continue;
+            int n;
+            if (m->startUs == m->us) {
+                n = snprintf(out + used, len - used, "%-16s +%lu.%03lu ms (%+ld us)\n", m->name,
+                             (unsigned long)(m->us / 1000), (unsigned long)(m->us % 1000),
+                             (long)(int32_t)(m->us - prev));
+                prev = m->us;
+            } else {
+                uint32_t took = m->us - m->startUs;
+                n = snprintf(out + used, len - used, "%-16s +%lu.%03lu ms [start +%lu.%03lu, took %lu.%03lu ms]\n",
+                             m->name, (unsigned long)(m->us / 1000), (unsigned long)(m->us % 1000),
+                             (unsigned long)(m->startUs / 1000), (unsigned long)(m->startUs % 1000),
+                             (unsigned long)(took / 1000), (unsigned long)(took % 1000));
+            }
+            if (n < 0 || (size_t)n >= len - used) break;
+            used += (size_t)n;
+        }
+        return used;
+    }
+
+private:
+    BootMark _marks[MAX_MARKS] = {};
+    std::atomic<bool> _ready[MAX_MARKS] = {};
+    std::atomic<size_t> _count{0};
+};
+
+#endif // BOOT_TIMELINE_H
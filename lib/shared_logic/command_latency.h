@@ -0,0 +1,80 @@
+#ifndef COMMAND_LATENCY_H
+#define COMMAND_LATENCY_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "metrics.h"
+#include "setpoint_mailbox.h"
+
+// ============================
+// Latencia de extremo a extremo de las órdenes
+// ============================
+
+/**
+ * @brief Latencies of the commands of one source.
+ */
+struct CommandLatencyStats {
+    LatencyHistogram applied;                          ///< Ingress to handed to the stepper.
+    LatencyHistogram reached{LatencyHistogram::RAMP};  ///< Ingress to the stepper running at the new speed.
+    Counter superseded;                                ///< Replaced before its speed was reached.
+};
+
+/**
+ * @brief Follows the newest command from ingress until the stepper reaches its speed.
+ *
+ * Only motor_task calls applied() and poll(); the histograms are atomic, so
+ * /metrics and producers that act on the stepper themselves (hard stops) may
+ * touch them from other tasks. "Reached" is checked once per motor cycle, so
+ * it is late by at most one cycle.
+ */
+class CommandLatencyTracker {
+public:
+    static constexpr uint32_t TOLERANCE_MILLI_HZ = 1000;  ///< Plus 1 % of the target.
+
+    explicit CommandLatencyTracker(CommandLatencyStats *stats) : _stats(stats) {}
+
+    /**
+     * @brief A command was handed to the stepper.
+     *
+     * @param cmd Command taken from the mailbox.
+     * @param nowUs micros() after the stepper was given the new speed.
+     * @param targetMilliHz Step rate the stepper is now heading to (0 for a stop).
+     */
+    void applied(const SetpointCommand &cmd, uint32_t nowUs, uint32_t targetMilliHz) {
+        CommandSource source = cmd.source < CMD_SOURCE_COUNT ? cmd.source : CMD_SOURCE_HTTP;
+        if (!cmd.applied) _stats[source].applied.observe(nowUs - cmd.ingressUs);
+        if (_pending) _stats[_source].superseded.inc();
+        _pending = true;
+        _source = source;
+        _ingressUs = cmd.ingressUs;
+        _targetMilliHz = targetMilliHz;
+    }
+
+    /**
+     * @brief Checks whether the pending command's speed has been reached.
+     *
+     * @param speedMilliHz Current step rate reported by the stepper (sign ignored).
+     * @return true if a command completed on this call.
+     */
+    bool poll(int32_t speedMilliHz, uint32_t nowUs) {
+        if (!_pending) return false;
+        uint32_t speed = speedMilliHz < 0 ? (uint32_t)(-(int64_t)speedMilliHz) : (uint32_t)speedMilliHz;
+        uint32_t diff = speed > _targetMilliHz ? speed - _targetMilliHz : _targetMilliHz - speed;
+        if (diff > TOLERANCE_MILLI_HZ + _targetMilliHz / 100) return false;
+        _stats[_source].reached.observe(nowUs - _ingressUs);
+        _pending = false;
+        return true;
+    }
+
+    bool pending() const { return _pending; }
+
+private:
+    CommandLatencyStats *_stats;  ///< CMD_SOURCE_COUNT entries.
+    bool _pending = false;
+    CommandSource _source = CMD_SOURCE_HTTP;
+    uint32_t _ingressUs = 0;
+    uint32_t _targetMilliHz = 0;
+};
+
+#endif // COMMAND_LATENCY_H
@@ -0,0 +1,221 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "motor_state.h"
+
+// ============================
+// Formato del fichero de configuración
+// ============================
+
+/**
+ * @brief Where one persisted member lives inside the configuration struct.
+ *
+ * Keys are versioned: a key is never reused, and a member whose type or
+ * meaning changes gets a new key. Files written by older firmware then load
+ * with the new member at its default, and keys a newer firmware wrote are
+ * skipped.
+ */
+struct ConfigField {
+    uint16_t key;
+    uint16_t offset;
+    uint16_t size;
+};
+
+#define CONFIG_FIELD(key, Type, member) \
+    ConfigField { (uint16_t)(key), (uint16_t)offsetof(Type, member), (uint16_t)sizeof(((Type *)0)->member) }
+
+const uint32_t CONFIG_FILE_MAGIC = 0x46435342;  // "BSCF"
+const uint16_t CONFIG_FILE_FORMAT = 1;
+
+/**
+ * @brief File header; followed by `length` bytes of records (key, size, value).
+ */
+struct ConfigFileHeader {
+    uint32_t magic;
+    uint16_t format;
+    uint16_t length;
+    uint32_t crc;  ///< CRC-32 of the records.
+};
+
+/** @brief Standard CRC-32 (IEEE 802.3, reflected, as in zlib). */
+inline uint32_t config_crc32(const uint8_t *data, size_t len) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; ++i) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; ++b) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+    return ~crc;
+}
+
+/**
+ * @brief Serializes the listed members of @p value.
+ *
+ * @return Bytes written to @p out, or 0 if they do not fit.
+ */
+template <typename T>
+size_t config_encode(const T &value, const ConfigField *fields, size_t count, uint8_t *out, size_t len) {
+    size_t used = sizeof(ConfigFileHeader);
+    if (len < used) return 0;
+    const uint8_t *base = (const uint8_t *)&value;
+    for (size_t i = 0; i < count; ++i) {
+        const ConfigField &f = fields[i];
+        if (used + 4 + f.size > len || used + 4 + f.size - sizeof(ConfigFileHeader) > UINT16_MAX) return 0;
+        memcpy(out + used, &f.key, 2);
+        memcpy(out + used + 2, &f.size, 2);
+        memcpy(out + used + 4, base + f.offset, f.size);
+        used += 4 + f.size;
+    }
+    ConfigFileHeader h;
+    h.magic = CONFIG_FILE_MAGIC;
+    h.format = CONFIG_FILE_FORMAT;
+    h.length = (uint16_t)(used - sizeof(h));
+    h.crc = config_crc32(out + sizeof(h), h.length);
+    memcpy(out, &h, sizeof(h));
+    return used;
+}
+
+/**
+ * @brief Loads a file written by config_encode() over @p value.
+ *
+ * @p value should hold the defaults: members whose key is missing, or whose
+ * stored size no longer matches, keep them.
+ *
+ * @return false, leaving @p value untouched, if the data is truncated or fails the CRC.
+ */
+template <typename T>
+bool config_decode(const uint8_t *data, size_t len, const ConfigField *fields, size_t count, T &value) {
+    ConfigFileHeader h;
+    if (len < sizeof(h)) return false;
+    memcpy(&h, data, sizeof(h));
+    if (h.magic != CONFIG_FILE_MAGIC || h.format > CONFIG_FILE_FORMAT) return false;
+    if (sizeof(h) + h.length > len) return false;
+    const uint8_t *records = data + sizeof(h);
+    if (config_crc32(records, h.length) != h.crc) return false;
+
+    T loaded = value;
+    uint8_t *base = (uint8_t *)&loaded;
+    size_t pos = 0;
+    while (pos + 4 <= h.length) {
+        uint16_t key, size;
+        memcpy(&key, records + pos, 2);
+        memcpy(&size, records + pos + 2, 2);
+        pos += 4;
+        if (pos + size > h.length) return false;
+        for (size_t i = 0; i < count; ++i) {
+            if (fields[i].key == key && fields[i].size == size) {
+                memcpy(base + fields[i].offset, records + pos, size);
+                break;
+            }
+        }
+        pos += size;
+    }
+    value = loaded;
+    return true;
+}
+
+// ============================
+// Caché en RAM con escritura diferida
+// ============================
+
+/**
+ * @brief RAM copy of a configuration struct with lock-free reads and coalesced commits.
+ *
+ * get() may be called from any task and never touches the filesystem. The
+ * writer-side calls (load, value, set, commitDue, committed) must be
+ * serialized by the caller, and a set() must not be preempted by a reader
+ * on the same core (the device wraps them in a critical section), so a
+ * reader never waits for more than one short copy.
+ *
+ * A change is committed once no other change arrived for quietMs, or at
+ * the latest maxDelayMs after the first uncommitted one, so a burst of
+ * edits costs a single flash write.
+ */
+template <typename T>
+class ConfigStore {
+public:
+    explicit ConfigStore(const T &defaults, uint32_t quietMs = 2000, uint32_t maxDelayMs = 30000)
+        : _value(defaults), _quietMs(quietMs), _maxDelayMs(maxDelayMs) {
+        _live.publish(_value);
+    }
+
+    /** @brief Replaces the value with what was read from flash; nothing to commit. */
+    void load(const T &value) {
+        _value = value;
+        _live.publish(_value);
+        _dirty = false;
+    }
+
+    /** @brief Current value, for the writer. */
+    const T &value() const { return _value; }
+
+    /** @brief Latest value; lock-free, from any task. */
+    T get() const {
+        T out;
+        while (!_live.read(out)) {
+        }
+        return out;
+    }
+
+    /**
+     * @brief Replaces the value and schedules a commit.
+     *
+     * @return false if @p next equals the current value (nothing scheduled).
+     */
+    bool set(const T &next, uint32_t nowMs) {
+        if (memcmp(&next, &_value, sizeof(T)) == 0) return false;
+        _value = next;
+        _live.publish(_value);
+        if (!_dirty) _dirtySinceMs = nowMs;
+        _dirty = true;
+        _lastChangeMs = nowMs;
+        return true;
+    }
+
+    bool dirty() const { return _dirty; }
+
+    /** @brief Whether the pending changes should be written now. */
+    bool commitDue(uint32_t nowMs) const {
+        return _dirty && (nowMs - _lastChangeMs >= _quietMs || nowMs - _dirtySinceMs >= _maxDelayMs);
+    }
+
+    /** @brief Identifies the value being committed; pass it back to committed(). */
+    uint32_t version() const { return _live.version(); }
+
+    /**
+     * @brief Reports the outcome of writing the value seen at @p version.
+     *
+     * Changes made while the file was being written stay pending. A failed
+     * write is retried after another quiet period.
+     */
+    void committed(uint32_t version, bool ok, uint32_t nowMs) {
+        if (!ok) {
+            _failures++;
+            _lastChangeMs = nowMs;
+            _dirtySinceMs = nowMs;
+            return;
+        }
+        _commits++;
+        if (version == _live.version()) _dirty = false;
+        else _dirtySinceMs = nowMs;
+    }
+
+    uint32_t commits() const { return _commits; }
+    uint32_t failures() const { return _failures; }
+
+private:
+    T _value;
+    SeqLock<T> _live;
+    uint32_t _quietMs;
+    uint32_t _maxDelayMs;
+    bool _dirty = false;
+    uint32_t _dirtySinceMs = 0;
+    uint32_t _lastChangeMs = 0;
+    uint32_t _commits = 0;
+    uint32_t _failures = 0;
+};
+
+#endif // CONFIG_STORE_H
@@ -0,0 +1,140 @@
+#ifndef DEADLINE_SUPERVISOR_H
+#define DEADLINE_SUPERVISOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// ============================
+// Supervisor de plazos
+// ============================
+
+/**
+ * @brief Tracks periodic tasks that must check in before a deadline.
+ *
+ * Each task registers once and calls checkIn() every cycle; the supervisor
+ * task calls poll() periodically. A stall is counted exactly once whichever
+ * side notices it first: poll() while the task is still silent, or
+ * checkIn() when a late cycle finally ends. Both sides name the cycle by the
+ * time it started (the previous check-in) and swap it into countedCycle;
+ * only the side that changes that value counts. All fields are atomics, so
+ * tasks on either core may check in while the supervisor polls.
+ *
+ * Times are milliseconds on a wrapping uint32_t clock (millis()).
+ *
+ * @tparam N Maximum number of supervised tasks.
+ */
+template <size_t N>
+class DeadlineSupervisor {
+public:
+    static constexpr int INVALID = -1;
+
+    /**
+     * @brief Adds a task. Safe to call from several tasks at boot.
+     *
+     * @param name String literal shown in logs; not copied.
+     * @param deadlineMs Longest allowed time between check-ins.
+     * @param critical true for the control path (its stall triggers the safe stop).
+     * @return Handle for checkIn(), or INVALID when the table is full.
+     */
+    int add(const char *name, uint32_t deadlineMs, bool critical, uint32_t nowMs) {
+        size_t i = _count.load(std::memory_order_relaxed);
+        do {
+            if (i >= N) return INVALID;
+        } while (!_count.compare_exchange_weak(i, i + 1, std::memory_order_acq_rel));
+        Slot &s = _slots[i];
+        s.name = name;
+        s.deadlineMs = deadlineMs;
+        s.critical = critical;
+        s.lastMs.store(nowMs, std::memory_order_relaxed);
+        s.countedCycle.store(nowMs - 1, std::memory_order_relaxed);
+        s.active.store(true, std::memory_order_release);
+        return (int)i;
+    }
+
+    /**
+     * @brief Records that task @p id finished a cycle.
+     *
+     * @return Length of the cycle that just ended, in milliseconds.
+     */
+    uint32_t checkIn(int id, uint32_t nowMs) {
+        if (!valid(id)) return 0;
+        Slot &s = _slots[id];
+        uint32_t start = s.lastMs.exchange(nowMs, std::memory_order_acq_rel);
+        uint32_t gap = nowMs - start;
+        if (gap > s.worstGapMs.load(std::memory_order_relaxed)) s.worstGapMs.store(gap, std::memory_order_relaxed);
+        if (gap > s.deadlineMs) countOnce(s, start);
+        return gap;
+    }
+
+    /**
+     * @brief Finds tasks that are silent past their deadline.
+     *
+     * @param out Receives the handles of tasks that newly stalled on this call.
+     * @param max Capacity of @p out.
+     * @return Number of handles written.
+     */
+    size_t poll(uint32_t nowMs, int *out, size_t max) {
+        size_t found = 0;
+        size_t count = size();
+        for (size_t i = 0; i < count; ++i) {
+            Slot &s = _slots[i];
+            if (!s.active.load(std::memory_order_acquire)) continue;
+            uint32_t start = s.lastMs.load(std::memory_order_acquire);
+            // Signed: the task may have checked in after the caller read the clock.
+            if ((int32_t)(nowMs - start) <= (int32_t)s.deadlineMs) continue;
+            if (countOnce(s, start) && found < max) out[found++] = (int)i;
+        }
+        return found;
+    }
+
+    /** @brief Whether task @p id is silent past its deadline, as last seen by poll(). */
+    bool stalled(int id) const {
+        if (!valid(id)) return false;
+        const Slot &s = _slots[id];
+        return s.countedCycle.load(std::memory_order_acquire) == s.lastMs.load(std::memory_order_acquire);
+    }
+
+    /** @brief Milliseconds since task @p id last checked in. */
+    uint32_t silenceMs(int id, uint32_t nowMs) const {
+        return valid(id) ? nowMs - _slots[id].lastMs.load(std::memory_order_acquire) : 0;
+    }
+
+    size_t size() const {
+        size_t n = _count.load(std::memory_order_acquire);
+        return n < N ? n : N;
+    }
+
+    const char *name(int id) const { return valid(id) ? _slots[id].name : ""; }
+    uint32_t deadlineMs(int id) const { return valid(id) ? _slots[id].deadlineMs : 0; }
+    bool critical(int id) const { return valid(id) && _slots[id].critical; }
+    uint32_t misses(int id) const { return valid(id) ? _slots[id].misses.load(std::memory_order_relaxed) : 0; }
+    uint32_t worstGapMs(int id) const {
+        return valid(id) ? _slots[id].worstGapMs.load(std::memory_order_relaxed) : 0;
+    }
+
+private:
+    struct Slot {
+        const char *name = "";
+        uint32_t deadlineMs = 0;
+        bool critical = false;
+        std::atomic<bool> active{false};
+        std::atomic<uint32_t> lastMs{0};
+        std::atomic<uint32_t> worstGapMs{0};
+        std::atomic<uint32_t> misses{0};
+        std::atomic<uint32_t> countedCycle{0};  ///< Start time of the last cycle counted as a miss.
+    };
+
+    static bool countOnce(Slot &s, uint32_t cycleStart) {
+        if (s.countedCycle.exchange(cycleStart, std::memory_order_acq_rel) == cycleStart) return false;
+        s.misses.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool valid(int id) const { return id >= 0 && (size_t)id < N && _slots[id].active.load(std::memory_order_acquire); }
+
+    Slot _slots[N];
+    std::atomic<size_t> _count{0};
+};
+
+#endif // DEADLINE_SUPERVISOR_H
@@ -0,0 +1,105 @@
+#ifndef ESTOP_H
+#define ESTOP_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "isr_inline.h"
+
+// ============================
+// Parada de emergencia
+// ============================
+
+enum EStopSource : uint8_t {
+    ESTOP_SOURCE_NONE = 0,
+    ESTOP_SOURCE_INPUT = 1,     ///< The E-stop GPIO.
+    ESTOP_SOURCE_SOFTWARE = 2   ///< motor_estop_trigger(): web, Modbus or the serial console.
+};
+
+/** @brief Name of @p source for /estop; "" if unknown. */
+inline const char *estop_source_name(uint8_t source) {
+    static const char *const names[] = {"none", "input", "software"};
+    return source <= ESTOP_SOURCE_SOFTWARE ? names[source] : "";
+}
+
+/**
+ * @brief Copy of the latch for reporting.
+ */
+struct EStopStatus {
+    bool latched;
+    uint8_t source;              ///< EStopSource of the trip that latched it.
+    uint32_t trips;              ///< Trips since boot, including those while already latched.
+    uint32_t lastLatencyCycles;  ///< Trip entry to driver outputs disabled, last trip.
+    uint32_t maxLatencyCycles;   ///< Same, worst since boot.
+};
+
+/**
+ * @brief Emergency-stop latch: set by a trip, cleared only by an acknowledgement.
+ *
+ * trip() runs in the GPIO interrupt after the driver outputs are already
+ * disabled, so it only does bookkeeping: plain atomic loads and stores, no
+ * locks and no allocation, inlined into the IRAM handler (see isr_inline.h).
+ * Concurrent trips (the ISR on one core, a software trigger on the other)
+ * must be serialized by the caller.
+ */
+class EStopLatch {
+public:
+    /**
+     * @param source EStopSource.
+     * @param latencyCycles CPU cycles from the trip entry to outputs disabled.
+     * @return true if this trip latched the stop (it was not latched already).
+     */
+    ISR_INLINE bool trip(uint8_t source, uint32_t latencyCycles) {
+        _trips.store(_trips.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        _lastLatency.store(latencyCycles, std::memory_order_relaxed);
+        if (latencyCycles > _maxLatency.load(std::memory_order_relaxed)) {
+            _maxLatency.store(latencyCycles, std::memory_order_relaxed);
+        }
+        if (_latched.load(std::memory_order_relaxed)) return false;
+        _source.store(source, std::memory_order_relaxed);
+        _pending.store(true, std::memory_order_relaxed);
+        _latched.store(true, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Clears the latch.
+     *
+     * @param inputAsserted Whether the E-stop input is still in its stop state;
+     *                      a stop that is still pressed cannot be acknowledged.
+     * @return false if it stays latched.
+     */
+    bool acknowledge(bool inputAsserted) {
+        if (inputAsserted) return false;
+        _source.store(ESTOP_SOURCE_NONE, std::memory_order_relaxed);
+        _latched.store(false, std::memory_order_release);
+        return true;
+    }
+
+    bool latched() const { return _latched.load(std::memory_order_acquire); }
+
+    /**
+     * @brief True once per latching trip, for the task that finishes the stop.
+     */
+    bool takePending() { return _pending.exchange(false, std::memory_order_acq_rel); }
+
+    EStopStatus status() const {
+        EStopStatus s;
+        s.latched = latched();
+        s.source = _source.load(std::memory_order_relaxed);
+        s.trips = _trips.load(std::memory_order_relaxed);
+        s.lastLatencyCycles = _lastLatency.load(std::memory_order_relaxed);
+        s.maxLatencyCycles = _maxLatency.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    std::atomic<bool> _latched{false};
+    std::atomic<bool> _pending{false};
+    std::atomic<uint8_t> _source{ESTOP_SOURCE_NONE};
+    std::atomic<uint32_t> _trips{0};
+    std::atomic<uint32_t> _lastLatency{0};
+    std::atomic<uint32_t> _maxLatency{0};
+};
+
+#endif // ESTOP_H
@@ -0,0 +1,15 @@
+#ifndef ISR_INLINE_H
+#define ISR_INLINE_H
+
+// ============================
+// Código llamado desde interrupciones IRAM
+// ============================
+//
+// The GPIO interrupt service is installed with ESP_INTR_FLAG_IRAM, so its
+// handlers also run while a flash write has the cache disabled. Whatever
+// they call must not live in flash: ISR_INLINE forces these helpers into the
+// IRAM_ATTR handler that calls them. Their data must be in DRAM (globals and
+// members, not const tables, which the linker puts in flash).
+#define ISR_INLINE inline __attribute__((always_inline))
+
+#endif // ISR_INLINE_H
@@ -0,0 +1,135 @@
+#ifndef JITTER_STATS_H
+#define JITTER_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "task_plan.h"
+
+// ============================
+// Jitter de una tarea periódica
+// ============================
+
+/**
+ * @brief Distribution of how late a periodic task wakes, in microseconds.
+ *
+ * Fixed buckets (1-2-5 steps up to 10 ms, then overflow) so add() is cheap
+ * and allocation-free inside the probe loop; quantiles are bucket upper
+ * bounds, which is enough to tell 20 us from 2 ms.
+ */
+class JitterStats {
+public:
+    static constexpr size_t BOUNDS = 13;
+    static constexpr uint32_t BOUND_US[BOUNDS] = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000};
+
+    /** @param us |actual period - nominal period| of one cycle. */
+    void add(uint32_t us) {
+        size_t b = 0;
+        while (b < BOUNDS && us > BOUND_US[b]) ++b;
+        _buckets[b]++;
+        if (_count == 0 || us < _minUs) _minUs = us;
+        if (us > _maxUs) _maxUs = us;
+        _sumUs += us;
+        _count++;
+    }
+
+    uint32_t count() const { return _count; }
+    uint32_t minUs() const { return _minUs; }
+    uint32_t maxUs() const { return _maxUs; }
+    float meanUs() const { return _count ? (float)((double)_sumUs / _count) : 0.0f; }
+
+    /**
+     * @brief Smallest bucket bound that covers a fraction @p q of the samples.
+     *
+     * @return 0 without samples; maxUs() when the quantile falls in the overflow bucket.
+     */
+    uint32_t quantileUs(float q) const {
+        if (_count == 0) return 0;
+        uint64_t need = (uint64_t)(q * _count + 0.999f);
+        if (need == 0) need = 1;
+        uint64_t seen = 0;
+        for (size_t b = 0; b < BOUNDS; ++b) {
+            seen += _buckets[b];
+            if (seen >= need) return BOUND_US[b] < _maxUs ? BOUND_US[b] : _maxUs;
+        }
+        return _maxUs;
+    }
+
+private:
+    uint32_t _buckets[BOUNDS + 1] = {};
+    uint32_t _count = 0;
+    uint32_t _minUs = 0;
+    uint32_t _maxUs = 0;
+    uint64_t _sumUs = 0;
+};
+
+/**
+ * @brief Jitter measured for one placement of the probe task.
+ */
+struct JitterResult {
+    ProbePlacement placement;
+    JitterStats stats;
+};
+
+/**
+ * @brief State of the jitter measurement. Immutable once published.
+ */
+struct JitterReport {
+    bool running = false;
+    uint32_t periodMs = 0;
+    uint32_t secondsPerPlacement = 0;
+    std::vector<JitterResult> results;  ///< Placements measured so far, in JITTER_PLACEMENTS order.
+    std::string json;
+    std::string text;
+};
+
+/**
+ * @brief Renders {"running":..,"period_ms":..,"seconds":..,"results":[..]}.
+ */
+inline void jitter_render_json(JitterReport &r) {
+    char buf[192];
+    std::string &out = r.json;
+    snprintf(buf, sizeof(buf), "{\"running\":%s,\"period_ms\":%lu,\"seconds\":%lu,\"results\":[",
+             r.running ? "true" : "false", (unsigned long)r.periodMs, (unsigned long)r.secondsPerPlacement);
+    out = buf;
+    for (size_t i = 0; i < r.results.size(); ++i) {
+        const JitterResult &j = r.results[i];
+        snprintf(buf, sizeof(buf),
+                 "%s{\"placement\":\"%s\",\"core\":%d,\"prio\":%u,\"samples\":%lu,\"mean_us\":%.1f,"
+                 "\"p99_us\":%lu,\"max_us\":%lu}",
+                 i ? "," : "", j.placement.label, (int)j.placement.core, (unsigned)j.placement.priority,
+                 (unsigned long)j.stats.count(), (double)j.stats.meanUs(),
+                 (unsigned long)j.stats.quantileUs(0.99f), (unsigned long)j.stats.maxUs());
+        out += buf;
+    }
+    out += "]}";
+}
+
+/**
+ * @brief Renders a fixed-width table for the serial console.
+ */
+inline void jitter_render_text(JitterReport &r) {
+    char buf[96];
+    std::string &out = r.text;
+    snprintf(buf, sizeof(buf), "period %lu ms, %lu s per placement%s\n", (unsigned long)r.periodMs,
+             (unsigned long)r.secondsPerPlacement, r.running ? " (running)" : "");
+    out = buf;
+    out += "placement core prio samples  mean_us  p99_us  max_us\n";
+    for (const JitterResult &j : r.results) {
+        char core[5];
+        if (j.placement.core == ANY_CORE) {
+            snprintf(core, sizeof(core), "-");
+        } else {
+            snprintf(core, sizeof(core), "%d", (int)j.placement.core);
+        }
+        snprintf(buf, sizeof(buf), "%-9.9s %4s %4u %7lu %8.1f %7lu %7lu\n", j.placement.label, core,
+                 (unsigned)j.placement.priority, (unsigned long)j.stats.count(), (double)j.stats.meanUs(),
+                 (unsigned long)j.stats.quantileUs(0.99f), (unsigned long)j.stats.maxUs());
+        out += buf;
+    }
+}
+
+#endif // JITTER_STATS_H
@@ -0,0 +1,33 @@
+#ifndef LCD_FORMAT_H
+#define LCD_FORMAT_H
+
+#include <cstddef>
+#include <cstdio>
+
+// ============================
+// Formato de líneas de la LCD
+// ============================
+
+const size_t LCD_COLS = 16;
+
+/**
+ * @brief Left-aligns @p text in a full LCD line, so a shorter line erases the previous one.
+ *
+ * @param out LCD_COLS + 1 bytes; longer text is cut.
+ */
+inline void lcd_pad_line(char *out, const char *text) {
+    snprintf(out, LCD_COLS + 1, "%-16.16s", text);
+}
+
+/**
+ * @brief Second line of the main screen: "A:<measured> T:<setpoint>".
+ *
+ * @param out LCD_COLS + 1 bytes.
+ */
+inline void lcd_format_rpm_line(char *out, float current, float target) {
+    char text[LCD_COLS + 1];
+    snprintf(text, sizeof(text), "A:%3.0f T:%3.0f", (double)current, (double)target);
+    lcd_pad_line(out, text);
+}
+
+#endif // LCD_FORMAT_H
@@ -0,0 +1,347 @@
+#ifndef MDNS_WIRE_H
+#define MDNS_WIRE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ============================
+// Formato de mensajes mDNS / DNS-SD (RFC 6762 / 6763)
+// ============================
+//
+// Only what BioShaker discovery needs: PTR queries for one service type and
+// the PTR/SRV/TXT/A records a responder sends back. Used by the host-side
+// discovery tool and by the native tests; the firmware itself advertises
+// through the espressif mdns component.
+
+const uint16_t MDNS_PORT = 5353;
+const uint16_t DNS_TYPE_A = 1;
+const uint16_t DNS_TYPE_PTR = 12;
+const uint16_t DNS_TYPE_TXT = 16;
+const uint16_t DNS_TYPE_SRV = 33;
+const uint16_t DNS_CLASS_IN = 1;
+const uint16_t MDNS_CLASS_QU = 0x8000;     ///< "Unicast response requested" bit in a question.
+const uint16_t MDNS_CLASS_FLUSH = 0x8000;  ///< Cache-flush bit in a record.
+
+/**
+ * @brief One advertised service instance, assembled from PTR, SRV, TXT and A records.
+ */
+struct MdnsServiceRecord {
+    std::string instance;  ///< Full instance name, e.g. "BioShaker-1A2B._bioshaker._tcp.local".
+    std::string host;      ///< SRV target, e.g. "bioshaker-1a2b.local".
+    uint16_t port = 0;
+    uint32_t ipv4 = 0;     ///< Host byte order; 0 if no A record was seen.
+    std::vector<std::pair<std::string, std::string>> txt;
+
+    /**
+     * @brief Returns the TXT value for @p key, or an empty string.
+     */
+    std::string txtValue(const std::string &key) const {
+        for (const auto &kv : txt) {
+            if (kv.first == key) return kv.second;
+        }
+        return std::string();
+    }
+};
+
+namespace mdns_wire {
+
+inline bool put16(uint8_t *buf, size_t len, size_t &pos, uint16_t v) {
+    if (pos + 2 > len) return false;
+    buf[pos++] = (uint8_t)(v >> 8);
+    buf[pos++] = (uint8_t)v;
+    return true;
+}
+
+inline bool put32(uint8_t *buf, size_t len, size_t &pos, uint32_t v) {
+    return put16(buf, len, pos, (uint16_t)(v >> 16)) && put16(buf, len, pos, (uint16_t)v);
+}
+
+inline uint16_t get16(const uint8_t *p) { return (uint16_t)((p[0] << 8) | p[1]); }
+
+inline uint32_t get32(const uint8_t *p) { return ((uint32_t)get16(p) << 16) | get16(p + 2); }
+
+/**
+ * @brief Writes a dotted name as DNS labels (no compression).
+ *
+ * Labels are split on ".", so an instance label may contain spaces but
+ * not dots.
+ */
+inline bool putName(uint8_t *buf, size_t len, size_t &pos, const std::string &name) {
+    size_t start = 0;
+    while (start < name.size()) {
+        size_t dot = name.find('.', start);
+        if (dot == std::string::npos) dot = name.size();
+        size_t labelLen = dot - start;
+        if (labelLen == 0 || labelLen > 63 || pos + 1 + labelLen > len) return false;
+        buf[pos++] = (uint8_t)labelLen;
+        memcpy(buf + pos, name.data() + start, labelLen);
+        pos += labelLen;
+        start = dot + 1;
+    }
+    if (pos + 1 > len) return false;
+    buf[pos++] = 0;
+    return true;
+}
+
+/**
+ * @brief Reads a possibly compressed name starting at @p pos.
+ *
+ * @param pos In: offset of the name. Out: offset just after it in the
+ *            original (uncompressed) position.
+ */
+inline bool getName(const uint8_t *msg, size_t len, size_t &pos, std::string &out) {
+    out.clear();
+    size_t p = pos;
+    bool jumped = false;
+    int hops = 0;
+    while (true) {
+        if (p >= len) return false;
+        uint8_t l = msg[p];
+        if ((l & 0xC0) == 0xC0) {
+            if (p + 1 >= len || ++hops > 16) return false;
+            size_t target = ((size_t)(l & 0x3F) << 8) | msg[p + 1];
+            if (!jumped) pos = p + 2;
+            jumped = true;
+            p = target;
+            continue;
+        }
+        if (l & 0xC0) return false;
+        p++;
+        if (l == 0) break;
+        if (p + l > len) return false;
+        if (!out.empty()) out += '.';
+        out.append((const char *)msg + p, l);
+        p += l;
+    }
+    if (!jumped) pos = p;
+    return true;
+}
+
+inline bool sameName(const std::string &a, const std::string &b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        char x = a[i], y = b[i];
+        if (x >= 'A' && x <= 'Z') x = (char)(x - 'A' + 'a');
+        if (y >= 'A' && y <= 'Z') y = (char)(y - 'A' + 'a');
+        if (x != y) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Appends one resource record header + rdata produced by @p writeRdata.
+ */
+template <typename F>
+bool putRecord(uint8_t *buf, size_t len, size_t &pos, const std::string &name, uint16_t type,
+               uint16_t rrclass, uint32_t ttl, F writeRdata) {
+    if (!putName(buf, len, pos, name) || !put16(buf, len, pos, type) || !put16(buf, len, pos, rrclass) ||
+        !put32(buf, len, pos, ttl)) {
+        return false;
+    }
+    size_t rdlenPos = pos;
+    if (!put16(buf, len, pos, 0)) return false;
+    size_t rdStart = pos;
+    if (!writeRdata(pos)) return false;
+    size_t rdlen = pos - rdStart;
+    buf[rdlenPos] = (uint8_t)(rdlen >> 8);
+    buf[rdlenPos + 1] = (uint8_t)rdlen;
+    return true;
+}
+
+}  // namespace mdns_wire
+
+/**
+ * @brief Builds a one-question PTR query for @p service (e.g. "_bioshaker._tcp.local").
+ *
+ * @param unicastResponse Sets the QU bit so responders answer to the sender's port.
+ * @return Message length, or 0 if @p len is too small.
+ */
+inline size_t mdns_build_ptr_query(uint8_t *buf, size_t len, const std::string &service, bool unicastResponse) {
+    using namespace mdns_wire;
+    size_t pos = 0;
+    bool ok = put16(buf, len, pos, 0) && put16(buf, len, pos, 0) && put16(buf, len, pos, 1) &&
+              put16(buf, len, pos, 0) && put16(buf, len, pos, 0) && put16(buf, len, pos, 0) &&
+              putName(buf, len, pos, service) && put16(buf, len, pos, DNS_TYPE_PTR) &&
+              put16(buf, len, pos, (uint16_t)(DNS_CLASS_IN | (unicastResponse ? MDNS_CLASS_QU : 0)));
+    return ok ? pos : 0;
+}
+
+/**
+ * @brief Extracts the first question of a query.
+ *
+ * @return true if @p msg is a query with at least one well-formed question.
+ */
+inline bool mdns_parse_query(const uint8_t *msg, size_t len, std::string &qname, uint16_t &qtype,
+                             bool &unicastResponse) {
+    using namespace mdns_wire;
+    if (len < 12 || (get16(msg + 2) & 0x8000) || get16(msg + 4) == 0) return false;
+    size_t pos = 12;
+    if (!getName(msg, len, pos, qname) || pos + 4 > len) return false;
+    qtype = get16(msg + pos);
+    unicastResponse = (get16(msg + pos + 2) & MDNS_CLASS_QU) != 0;
+    return true;
+}
+
+/**
+ * @brief Builds the answer a DNS-SD responder sends for a PTR query.
+ *
+ * Answer: PTR service -> instance. Additional: SRV, TXT and A for the instance.
+ *
+ * @return Message length, or 0 if @p len is too small.
+ */
+inline size_t mdns_build_service_response(uint8_t *buf, size_t len, const std::string &service,
+                                          const MdnsServiceRecord &rec, uint32_t ttl = 120) {
+    using namespace mdns_wire;
+    size_t pos = 0;
+    bool ok = put16(buf, len, pos, 0) && put16(buf, len, pos, 0x8400) && put16(buf, len, pos, 0) &&
+              put16(buf, len, pos, 1) && put16(buf, len, pos, 0) && put16(buf, len, pos, rec.ipv4 ? 3 : 2);
+    ok = ok && putRecord(buf, len, pos, service, DNS_TYPE_PTR, DNS_CLASS_IN, ttl,
+                         [&](size_t &p) { return putName(buf, len, p, rec.instance); });
+    ok = ok && putRecord(buf, len, pos, rec.instance, DNS_TYPE_SRV, DNS_CLASS_IN | MDNS_CLASS_FLUSH, ttl,
+                         [&](size_t &p) {
+                             return put16(buf, len, p, 0) && put16(buf, len, p, 0) &&
+                                    put16(buf, len, p, rec.port) && putName(buf, len, p, rec.host);
+                         });
+    ok = ok && putRecord(buf, len, pos, rec.instance, DNS_TYPE_TXT, DNS_CLASS_IN | MDNS_CLASS_FLUSH, ttl,
+                         [&](size_t &p) {
+                             for (const auto &kv : rec.txt) {
+                                 size_t n = kv.first.size() + 1 + kv.second.size();
+                                 if (n > 255 || p + 1 + n > len) return false;
+                                 buf[p++] = (uint8_t)n;
+                                 memcpy(buf + p, kv.first.data(), kv.first.size());
+                                 p += kv.first.size();
+                                 buf[p++] = '=';
+                                 memcpy(buf + p, kv.second.data(), kv.second.size());
+                                 p += kv.second.size();
+                             }
+                             if (rec.txt.empty()) {
+                                 if (p + 1 > len) return false;
+                                 buf[p++] = 0;
+                             }
+                             return true;
+                         });
+    if (rec.ipv4) {
+        ok = ok && putRecord(buf, len, pos, rec.host, DNS_TYPE_A, DNS_CLASS_IN | MDNS_CLASS_FLUSH, ttl,
+                             [&](size_t &p) { return put32(buf, len, p, rec.ipv4); });
+    }
+    return ok ? pos : 0;
+}
+
+/**
+ * @brief Collects service instances of one type from any number of responses.
+ *
+ * Records may arrive in any order and split across packets (e.g. the A
+ * record in a later answer); results() joins them by instance and host name.
+ */
+class MdnsBrowser {
+public:
+    explicit MdnsBrowser(const std::string &service) : _service(service) {}
+
+    /**
+     * @brief Parses one received message.
+     *
+     * @return false if the message is malformed (it is then ignored).
+     */
+    bool ingest(const uint8_t *msg, size_t len) {
+        using namespace mdns_wire;
+        if (len < 12 || !(get16(msg + 2) & 0x8000)) return false;
+        size_t qd = get16(msg + 4);
+        size_t rr = (size_t)get16(msg + 6) + get16(msg + 8) + get16(msg + 10);
+        size_t pos = 12;
+        std::string name;
+        for (size_t i = 0; i < qd; ++i) {
+            if (!getName(msg, len, pos, name) || pos + 4 > len) return false;
+            pos += 4;
+        }
+        for (size_t i = 0; i < rr; ++i) {
+            if (!getName(msg, len, pos, name) || pos + 10 > len) return false;
+            uint16_t type = get16(msg + pos);
+            uint16_t rdlen = get16(msg + pos + 8);
+            pos += 10;
+            if (pos + rdlen > len) return false;
+            size_t rd = pos;
+            pos += rdlen;
+            if (!parseRecord(msg, len, name, type, rd, rdlen)) return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Instances seen so far, with SRV/TXT/A data merged in.
+     */
+    std::vector<MdnsServiceRecord> results() const {
+        std::vector<MdnsServiceRecord> out;
+        for (const auto &entry : _instances) {
+            MdnsServiceRecord rec = entry.second;
+            auto addr = _addresses.find(lower(rec.host));
+            if (addr != _addresses.end()) rec.ipv4 = addr->second;
+            out.push_back(rec);
+        }
+        return out;
+    }
+
+private:
+    static std::string lower(const std::string &s) {
+        std::string r = s;
+        for (char &c : r) {
+            if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+        }
+        return r;
+    }
+
+    bool isInstanceOfService(const std::string &instance) const {
+        return instance.size() > _service.size() + 1 &&
+               mdns_wire::sameName(instance.substr(instance.size() - _service.size()), _service) &&
+               instance[instance.size() - _service.size() - 1] == '.';
+    }
+
+    bool parseRecord(const uint8_t *msg, size_t len, const std::string &name, uint16_t type, size_t rd,
+                     uint16_t rdlen) {
+        using namespace mdns_wire;
+        if (type == DNS_TYPE_PTR && sameName(name, _service)) {
+            size_t p = rd;
+            std::string instance;
+            if (!getName(msg, len, p, instance)) return false;
+            _instances[lower(instance)].instance = instance;
+        } else if (type == DNS_TYPE_SRV && isInstanceOfService(name)) {
+            if (rdlen < 7) return false;
+            size_t p = rd + 6;
+            MdnsServiceRecord &rec = _instances[lower(name)];
+            rec.instance = name;
+            rec.port = get16(msg + rd + 4);
+            if (!getName(msg, len, p, rec.host)) return false;
+        } else if (type == DNS_TYPE_TXT && isInstanceOfService(name)) {
+            MdnsServiceRecord &rec = _instances[lower(name)];
+            rec.instance = name;
+            rec.txt.clear();
+            size_t p = rd;
+            while (p < rd + rdlen) {
+                uint8_t n = msg[p++];
+                if (p + n > rd + rdlen) return false;
+                std::string item((const char *)msg + p, n);
+                p += n;
+                if (item.empty()) continue;
+                size_t eq = item.find('=');
+                if (eq == std::string::npos) {
+                    rec.txt.emplace_back(item, std::string());
+                } else {
+                    rec.txt.emplace_back(item.substr(0, eq), item.substr(eq + 1));
+                }
+            }
+        } else if (type == DNS_TYPE_A && rdlen == 4) {
+            _addresses[lower(name)] = get32(msg + rd);
+        }
+        return true;
+    }
+
+    std::string _service;
+    std::map<std::string, MdnsServiceRecord> _instances;
+    std::map<std::string, uint32_t> _addresses;
+};
+
+#endif // MDNS_WIRE_H
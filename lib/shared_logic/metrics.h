@@ -0,0 +1,279 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+// ============================
+// Contadores e histogramas
+// ============================
+
+/**
+ * @brief Monotonic event counter, safe to bump from any task.
+ */
+class Counter {
+public:
+    void inc(uint32_t n = 1) { _value.fetch_add(n, std::memory_order_relaxed); }
+
+    uint32_t value() const { return _value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint32_t> _value{0};
+};
+
+/**
+ * @brief Latency histogram with 12 fixed buckets plus overflow.
+ *
+ * The default layout spans 100 us to 1 s (handler and queueing delays);
+ * RAMP spans 10 ms to 60 s, for waits that include a motor acceleration
+ * ramp. observe() is two relaxed atomic adds; buckets are not cumulative in
+ * memory, the exposition makes them cumulative.
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t BUCKETS = 12;
+
+    enum Layout : uint8_t { FAST, RAMP };
+
+    explicit LatencyHistogram(Layout layout = FAST) : _layout(layout) {}
+
+    /** @brief Upper bound of bucket @p i in microseconds. */
+    uint32_t bound(size_t i) const {
+        static const uint32_t bounds[2][BUCKETS] = {
+            {100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 1000000},
+            {10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000, 30000000,
+             60000000}};
+        return bounds[_layout][i];
+    }
+
+    void observe(uint32_t us) {
+        size_t i = 0;
+        while (i < BUCKETS && us > bound(i)) ++i;
+        _counts[i].fetch_add(1, std::memory_order_relaxed);
+        _sumUs.fetch_add(us, std::memory_order_relaxed);
+    }
+
+    /** @brief Samples in bucket @p i only; i == BUCKETS is the overflow bucket. */
+    uint32_t bucketCount(size_t i) const { return _counts[i].load(std::memory_order_relaxed); }
+
+    uint64_t sumUs() const { return _sumUs.load(std::memory_order_relaxed); }
+
+    uint32_t count() const {
+        uint32_t n = 0;
+        for (size_t i = 0; i <= BUCKETS; ++i) n += bucketCount(i);
+        return n;
+    }
+
+    /**
+     * @brief Upper bound of the bucket holding quantile @p q (0..1).
+     *
+     * Never under-estimates: the true quantile is at most the returned value.
+     * Returns 0 with no samples and UINT32_MAX if it falls in the overflow bucket.
+     */
+    uint32_t quantileUs(double q) const {
+        uint32_t total = count();
+        if (total == 0) return 0;
+        double rank = q * total;
+        uint32_t cumulative = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            cumulative += bucketCount(i);
+            if (cumulative >= rank) return bound(i);
+        }
+        return UINT32_MAX;
+    }
+
+private:
+    std::atomic<uint32_t> _counts[BUCKETS + 1] = {};
+    std::atomic<uint64_t> _sumUs{0};
+    Layout _layout;
+};
+
+// ============================
+// Registro de métricas
+// ============================
+
+enum MetricType : uint8_t { METRIC_COUNTER, METRIC_GAUGE, METRIC_HISTOGRAM };
+
+/**
+ * @brief One series of the exposition.
+ *
+ * Series of the same family (same name, different labels) must be
+ * registered one after another so HELP/TYPE are written once.
+ */
+struct MetricEntry {
+    const char *name;
+    const char *help;
+    const char *labels;  ///< Already formatted, e.g. route="/rpm"; "" for none.
+    MetricType type;
+    double (*read)(const void *ctx);  ///< Counters and gauges.
+    const void *ctx;
+    const LatencyHistogram *histogram;
+};
+
+/**
+ * @brief Fixed-capacity table of metrics, filled once at boot.
+ */
+template <size_t N>
+class MetricsRegistry {
+public:
+    bool addGauge(const char *name, const char *help, double (*read)(const void *), const void *ctx = nullptr,
+                  const char *labels = "") {
+        return add({name, help, labels, METRIC_GAUGE, read, ctx, nullptr});
+    }
+
+    bool addCounter(const char *name, const char *help, double (*read)(const void *), const void *ctx = nullptr,
+                    const char *labels = "") {
+        return add({name, help, labels, METRIC_COUNTER, read, ctx, nullptr});
+    }
+
+    bool addCounter(const char *name, const char *help, const Counter *counter, const char *labels = "") {
+        return addCounter(name, help, &readCounter, counter, labels);
+    }
+
+    bool addHistogram(const char *name, const char *help, const LatencyHistogram *histogram,
+                      const char *labels = "") {
+        return add({name, help, labels, METRIC_HISTOGRAM, nullptr, nullptr, histogram});
+    }
+
+    size_t size() const { return _count; }
+
+    /** @brief Series refused because the table was full; they are missing from the exposition. */
+    size_t dropped() const { return _dropped; }
+
+    const MetricEntry &at(size_t i) const { return _entries[i]; }
+
+private:
+    static double readCounter(const void *ctx) { return ((const Counter *)ctx)->value(); }
+
+    bool add(const MetricEntry &entry) {
+        if (_count >= N) {
+            _dropped++;
+            return false;
+        }
+        _entries[_count++] = entry;
+        return true;
+    }
+
+    MetricEntry _entries[N];
+    size_t _count = 0;
+    size_t _dropped = 0;
+};
+
+// ============================
+// Exposición en formato texto
+// ============================
+
+/**
+ * @brief Renders a registry in the Prometheus text format, a few bytes at a time.
+ *
+ * fill() writes as many whole or partial lines as fit and remembers where it
+ * stopped, so a chunked HTTP response can stream the exposition through the
+ * server's own buffer. Only one line (LINE_MAX bytes) is ever held here.
+ */
+template <size_t N>
+class PromStream {
+public:
+    static constexpr size_t LINE_MAX = 192;
+
+    explicit PromStream(const MetricsRegistry<N> &registry) : _registry(registry) {}
+
+    /**
+     * @brief Copies the next bytes of the exposition into @p out.
+     *
+     * @return Bytes written; 0 once everything has been produced.
+     */
+    size_t fill(uint8_t *out, size_t len) {
+        size_t used = 0;
+        while (used < len) {
+            if (_linePos == _lineLen) {
+                if (!nextLine()) break;
+                _linePos = 0;
+            }
+            size_t n = _lineLen - _linePos;
+            if (n > len - used) n = len - used;
+            memcpy(out + used, _line + _linePos, n);
+            _linePos += n;
+            used += n;
+        }
+        return used;
+    }
+
+private:
+    bool nextLine() {
+        while (_entry < _registry.size()) {
+            const MetricEntry &e = _registry.at(_entry);
+            if (_sub == 0) {
+                _sub = 2;
+                if (_entry == 0 || strcmp(_registry.at(_entry - 1).name, e.name) != 0) {
+                    _sub = 1;
+                    return format("# HELP %s %s\n", e.name, e.help);
+                }
+            }
+            if (_sub == 1) {
+                _sub = 2;
+                static const char *const types[] = {"counter", "gauge", "histogram"};
+                return format("# TYPE %s %s\n", e.name, types[e.type]);
+            }
+            if (sample(e, _sub - 2)) {
+                _sub++;
+                return true;
+            }
+            _entry++;
+            _sub = 0;
+        }
+        return false;
+    }
+
+    bool sample(const MetricEntry &e, size_t i) {
+        const char *open = e.labels[0] ? "{" : "";
+        const char *close = e.labels[0] ? "}" : "";
+        if (e.type != METRIC_HISTOGRAM) {
+            if (i > 0) return false;
+            return format("%s%s%s%s %.10g\n", e.name, open, e.labels, close, e.read(e.ctx));
+        }
+
+        const size_t B = LatencyHistogram::BUCKETS;
+        if (i == 0) {
+            // Copy once so every line of this series agrees with the others.
+            for (size_t b = 0; b <= B; ++b) _buckets[b] = e.histogram->bucketCount(b);
+            _sumUs = e.histogram->sumUs();
+            _cumulative = 0;
+        }
+        const char *sep = e.labels[0] ? "," : "";
+        if (i < B) {
+            _cumulative += _buckets[i];
+            return format("%s_bucket{%s%sle=\"%g\"} %lu\n", e.name, e.labels, sep,
+                          e.histogram->bound(i) / 1e6, (unsigned long)_cumulative);
+        }
+        if (i == B) {
+            _cumulative += _buckets[B];
+            return format("%s_bucket{%s%sle=\"+Inf\"} %lu\n", e.name, e.labels, sep, (unsigned long)_cumulative);
+        }
+        if (i == B + 1) return format("%s_sum%s%s%s %.6f\n", e.name, open, e.labels, close, _sumUs / 1e6);
+        if (i == B + 2) return format("%s_count%s%s%s %lu\n", e.name, open, e.labels, close, (unsigned long)_cumulative);
+        return false;
+    }
+
+    template <typename... Args>
+    bool format(const char *fmt, Args... args) {
+        int n = snprintf(_line, sizeof(_line), fmt, args...);
+        if (n < 0) n = 0;
+        _lineLen = (size_t)n < sizeof(_line) ? (size_t)n : sizeof(_line) - 1;
+        return true;
+    }
+
+    const MetricsRegistry<N> &_registry;
+    size_t _entry = 0;
+    size_t _sub = 0;
+    char _line[LINE_MAX];
+    size_t _lineLen = 0;
+    size_t _linePos = 0;
+    uint32_t _buckets[LatencyHistogram::BUCKETS + 1];
+    uint32_t _cumulative = 0;
+    uint64_t _sumUs = 0;
+};
+
+#endif // METRICS_H
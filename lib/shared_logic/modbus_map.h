@@ -0,0 +1,95 @@
+#ifndef MODBUS_MAP_H
+#define MODBUS_MAP_H
+
+#include <cstdint>
+
+#include "motor_state.h"
+#include "stop_ramp.h"
+
+// ============================
+// Mapa de registros Modbus
+// ============================
+//
+// Speeds are carried as RPM x 10 in one unsigned register. 32-bit values are
+// split high word first (big-endian word order, as most SCADA tools expect).
+
+/**
+ * @brief Input registers (function 04), read-only, refreshed from MotorStateSnapshot.
+ */
+enum ModbusInputRegister : uint16_t {
+    MB_IR_SETPOINT_X10 = 0,  ///< Setpoint being applied, RPM x 10.
+    MB_IR_ACTUAL_X10 = 1,    ///< Measured speed, RPM x 10.
+    MB_IR_RUN_STATE = 2,     ///< MotorRunState.
+    MB_IR_STEPS_HI = 3,      ///< Step count, high word.
+    MB_IR_STEPS_LO = 4,      ///< Step count, low word.
+    MB_IR_ERROR_FLAGS = 5,   ///< MotorErrorFlag bits.
+    MB_IR_VERSION = 6,       ///< Low 16 bits of the snapshot version; changes on every refresh.
+    MB_INPUT_REGISTER_COUNT
+};
+
+/**
+ * @brief Holding registers (functions 03/06/16), written by the master.
+ *
+ * They hold the last command written, not the live setpoint (read
+ * MB_IR_SETPOINT_X10 for that), so a refresh never races a master's write.
+ */
+enum ModbusHoldingRegister : uint16_t {
+    MB_HR_SETPOINT_X10 = 0,  ///< Requested speed, RPM x 10.
+    MB_HR_RUN = 1,           ///< ModbusRunCommand.
+    MB_HOLDING_REGISTER_COUNT
+};
+
+/**
+ * @brief Values of MB_HR_RUN. Unknown values stop gracefully.
+ */
+enum ModbusRunCommand : uint16_t {
+    MB_RUN_STOP = 0,       ///< Graceful stop along the stop ramp.
+    MB_RUN_START = 1,      ///< Run at MB_HR_SETPOINT_X10.
+    MB_RUN_HARD_STOP = 2   ///< Hard stop: no ramp, driver disabled at once.
+};
+
+/**
+ * @brief Converts RPM to the x10 register encoding, saturating at the register range.
+ */
+inline uint16_t modbus_rpm_to_reg(float rpm) {
+    if (!(rpm > 0.0f)) return 0;
+    float scaled = rpm * 10.0f + 0.5f;
+    return scaled >= 65535.0f ? 65535 : (uint16_t)scaled;
+}
+
+/**
+ * @brief Fills the input register image from a motor snapshot.
+ *
+ * @param regs Array of MB_INPUT_REGISTER_COUNT registers.
+ */
+inline void modbus_encode_inputs(const MotorStateSnapshot &state, uint32_t version, uint16_t *regs) {
+    regs[MB_IR_SETPOINT_X10] = modbus_rpm_to_reg(state.targetRpm);
+    regs[MB_IR_ACTUAL_X10] = modbus_rpm_to_reg(state.currentRpm);
+    regs[MB_IR_RUN_STATE] = state.runState;
+    regs[MB_IR_STEPS_HI] = (uint16_t)(state.stepCount >> 16);
+    regs[MB_IR_STEPS_LO] = (uint16_t)state.stepCount;
+    regs[MB_IR_ERROR_FLAGS] = state.errorFlags;
+    regs[MB_IR_VERSION] = (uint16_t)version;
+}
+
+/**
+ * @brief Turns the holding registers into a speed command.
+ *
+ * @param regs Array of MB_HOLDING_REGISTER_COUNT registers.
+ * @param maxRpm Upper clamp for the requested speed.
+ * @return Speed to post to motor_task; 0 means stop (see modbus_decode_stop_mode()).
+ */
+inline float modbus_decode_command(const uint16_t *regs, float maxRpm) {
+    if (regs[MB_HR_RUN] != MB_RUN_START) return 0.0f;
+    float rpm = regs[MB_HR_SETPOINT_X10] / 10.0f;
+    return rpm > maxRpm ? maxRpm : rpm;
+}
+
+/**
+ * @brief How to stop when MB_HR_RUN is not MB_RUN_START.
+ */
+inline StopMode modbus_decode_stop_mode(const uint16_t *regs) {
+    return regs[MB_HR_RUN] == MB_RUN_HARD_STOP ? STOP_MODE_HARD : STOP_MODE_GRACEFUL;
+}
+
+#endif // MODBUS_MAP_H
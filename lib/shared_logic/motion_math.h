@@ -0,0 +1,117 @@
+#ifndef MOTION_MATH_H
+#define MOTION_MATH_H
+
+#include <cstdint>
+
+#include "shared_logic.h"
+
+// ============================
+// Aritmética del lazo de control
+// ============================
+//
+// The ESP32 FPU is single precision: every double operation is a software
+// call. The control path therefore works on float or on Q16.16 fixed point;
+// the double functions in shared_logic.h stay as the reference. Constants
+// are converted at compile time, so a conversion is one multiply.
+
+/**
+ * @brief Signed Q16.16 fixed-point number.
+ *
+ * Range [-32768, 32768) with a resolution of 1/65536. Arithmetic saturates
+ * at the ends of the range instead of wrapping.
+ */
+struct Q16_16 {
+    static constexpr int FRAC_BITS = 16;
+    static constexpr int32_t ONE = 1 << FRAC_BITS;
+
+    int32_t raw;
+
+    static constexpr Q16_16 fromRaw(int32_t raw) { return Q16_16{raw}; }
+
+    /** @brief Nearest representable value; meant for constants folded at compile time. */
+    static constexpr Q16_16 fromDouble(double v) {
+        return fromRaw(v * ONE >= 2147483647.0    ? INT32_MAX
+                       : v * ONE <= -2147483648.0 ? INT32_MIN
+                                                  : (int32_t)(v * ONE + (v < 0 ? -0.5 : 0.5)));
+    }
+
+    static Q16_16 fromFloat(float v) {
+        float scaled = v * (float)ONE;
+        if (scaled >= 2147483520.0f) return fromRaw(INT32_MAX);  // largest float below 2^31
+        if (scaled <= -2147483648.0f) return fromRaw(INT32_MIN);
+        return fromRaw((int32_t)(scaled + (v < 0 ? -0.5f : 0.5f)));
+    }
+
+    constexpr double toDouble() const { return (double)raw / ONE; }
+    float toFloat() const { return (float)raw * (1.0f / ONE); }
+
+    static constexpr int32_t saturate(int64_t v) {
+        return v > INT32_MAX ? INT32_MAX : v < INT32_MIN ? INT32_MIN : (int32_t)v;
+    }
+};
+
+constexpr Q16_16 operator+(Q16_16 a, Q16_16 b) { return Q16_16::fromRaw(Q16_16::saturate((int64_t)a.raw + b.raw)); }
+constexpr Q16_16 operator-(Q16_16 a, Q16_16 b) { return Q16_16::fromRaw(Q16_16::saturate((int64_t)a.raw - b.raw)); }
+/** @brief Product rounded to nearest (half up). */
+constexpr Q16_16 operator*(Q16_16 a, Q16_16 b) {
+    return Q16_16::fromRaw(
+        Q16_16::saturate(((int64_t)a.raw * b.raw + (1 << (Q16_16::FRAC_BITS - 1))) >> Q16_16::FRAC_BITS));
+}
+constexpr bool operator<(Q16_16 a, Q16_16 b) { return a.raw < b.raw; }
+constexpr bool operator==(Q16_16 a, Q16_16 b) { return a.raw == b.raw; }
+
+/**
+ * @brief Per-type operations of the control math.
+ *
+ * @tparam T float or Q16_16.
+ */
+template <typename T>
+struct MotionScalar;
+
+template <>
+struct MotionScalar<float> {
+    static constexpr float constant(double v) { return (float)v; }
+    static float fromFloat(float v) { return v; }
+    static float toFloat(float v) { return v; }
+    /** @brief v * 1000 rounded; negative values give 0. */
+    static uint32_t toMilli(float v) {
+        float m = v * 1000.0f;
+        if (m <= 0.0f) return 0;
+        return m >= 4294967040.0f ? UINT32_MAX : (uint32_t)(m + 0.5f);  // largest float below 2^32
+    }
+};
+
+template <>
+struct MotionScalar<Q16_16> {
+    static constexpr Q16_16 constant(double v) { return Q16_16::fromDouble(v); }
+    static Q16_16 fromFloat(float v) { return Q16_16::fromFloat(v); }
+    static float toFloat(Q16_16 v) { return v.toFloat(); }
+    static uint32_t toMilli(Q16_16 v) {
+        if (v.raw <= 0) return 0;
+        return (uint32_t)(((int64_t)v.raw * 1000 + (Q16_16::ONE / 2)) >> Q16_16::FRAC_BITS);
+    }
+};
+
+/**
+ * @brief rpm2sps() in the control-path type.
+ *
+ * Q16_16 saturates above 32768 SPS (614 RPM at SPR_CMD).
+ */
+template <typename T>
+inline T rpm_to_sps(T rpm) {
+    static constexpr T STEPS_PER_RPM = MotionScalar<T>::constant(SPR_CMD / 60.0);
+    return rpm * STEPS_PER_RPM;
+}
+
+/** @brief Speed in mHz, as FastAccelStepper reports it; rounded, 0 for negative speeds. */
+template <typename T>
+inline uint32_t sps_to_milli_hz(T sps) {
+    return MotionScalar<T>::toMilli(sps);
+}
+
+/** @brief A_CMD as an integer, the form FastAccelStepper::setAcceleration() takes. */
+constexpr int32_t ramp_accel_sps2() {
+    return (int32_t)(A_CMD + 0.5);
+}
+
+#endif // MOTION_MATH_H
@@ -0,0 +1,162 @@
+#ifndef MOTOR_CYCLE_H
+#define MOTOR_CYCLE_H
+
+#include <cstdint>
+
+#include "command_latency.h"
+#include "motion_math.h"
+#include "motor_state.h"
+#include "setpoint_mailbox.h"
+#include "step_dither.h"
+#include "step_tables.h"
+#include "stop_ramp.h"
+
+// ============================
+// Ciclo de control del motor
+// ============================
+//
+// One motor_task cycle without the RTOS: pick the setpoint from the mailbox
+// command, the speed pattern and the E-stop, drive the stepper towards it
+// and follow the command latency. motor_task runs it with rpmMutex and
+// FastAccelStepper; the native tests run the same code with SimStepper and
+// a lock that may time out.
+
+/**
+ * @brief Stop ramp settings, in the units the stepper takes.
+ */
+struct MotorCycleConfig {
+    uint32_t stopDecelSps2;  ///< Configured stop ramp, STOP_DECEL_RPM_PER_S in steps/s^2.
+    uint32_t stopMaxTimeMs;  ///< STOP_MAX_TIME_MS.
+};
+
+/**
+ * @brief What one cycle did, for the published snapshot and the metrics.
+ */
+struct MotorCycleResult {
+    float setpointRpm;        ///< Setpoint driven this cycle.
+    float measuredRpm;        ///< currentRpm as read under the lock; last cycle's value otherwise.
+    uint16_t errorFlags;      ///< MOTOR_ERR_LOCK_TIMEOUT if the shared setpoint could not be locked.
+    bool stopOverrun;         ///< A graceful stop missed its bound and was forced.
+    bool outputsEnabled;      ///< enableOutputs() was called: a trip since then must turn them off again.
+    bool commandReached;      ///< The pending command's speed was reached this cycle.
+};
+
+/**
+ * @brief State motor_task keeps from one cycle to the next, and the cycle itself.
+ *
+ * Every cycle calls resolve() and then drive(). Stops always set the
+ * setpoint to 0, including hard stops already applied by their producer;
+ * `applied` only means the stepper is already stopped, so no ramp runs.
+ *
+ * @tparam Scalar float or Q16_16 for the rpm to step-rate conversion (see motion_math.h).
+ */
+template <typename Scalar>
+class MotorCycle {
+public:
+    MotorCycle(CommandLatencyTracker &latency, const MotorCycleConfig &config) : _latency(latency), _config(config) {}
+
+    /**
+     * @brief Applies the command, the pattern and the E-stop to the shared setpoint.
+     *
+     * Call with rpmMutex held and targetRpm/currentRpm, or with both null
+     * when the lock timed out. A command taken while unlocked still drives
+     * this cycle (a stop stops) and is written to targetRpm on the next
+     * locked cycle unless a newer command replaces it.
+     *
+     * @param cmd Command taken from the mailbox this cycle, or null.
+     * @param patternRpm Pattern setpoint while a pattern drives the motor, or null.
+     * @param estopLatched The E-stop holds the setpoint at 0.
+     */
+    void resolve(const SetpointCommand *cmd, const float *patternRpm, bool estopLatched, float *targetRpm,
+                 const float *currentRpm) {
+        _took = cmd != nullptr;
+        if (cmd) {
+            _cmd = *cmd;
+            _unwritten = true;
+            _unwrittenRpm = cmd->stop ? 0.0f : cmd->rpm;
+        }
+        _errorFlags = 0;
+        if (targetRpm && currentRpm) {
+            if (_unwritten) *targetRpm = _unwrittenRpm;
+            _unwritten = false;
+            if (patternRpm) *targetRpm = *patternRpm;
+            if (estopLatched) *targetRpm = 0.0f;  // also undoes encoder turns, which write targetRpm directly
+            _setpointRpm = *targetRpm;
+            _measuredRpm = *currentRpm;
+        } else {
+            _errorFlags = MOTOR_ERR_LOCK_TIMEOUT;  // keep last cycle's values
+            if (_unwritten) _setpointRpm = _unwrittenRpm;
+            if (patternRpm) _setpointRpm = *patternRpm;
+            if (estopLatched) _setpointRpm = 0.0f;
+        }
+    }
+
+    /**
+     * @brief Drives the stepper towards the resolved setpoint and follows the command latency.
+     *
+     * @param stepper The driver, or null when none is connected.
+     */
+    template <typename Stepper>
+    MotorCycleResult drive(Stepper *stepper, uint32_t nowMs, uint32_t nowUs) {
+        MotorCycleResult result = {};
+        result.setpointRpm = _setpointRpm;
+        result.measuredRpm = _measuredRpm;
+        result.errorFlags = _errorFlags;
+        bool appliedStop = _took && _cmd.stop && _cmd.applied;
+
+        uint32_t targetMilliHz = 0;
+        if (stepper) {
+            if (_setpointRpm < 1.0f) {
+                _dither.next(0, 0, 0);
+                if (appliedStop) {
+                    // Its producer already stopped the stepper; a cycle racing it may have restarted it.
+                    _stop.cancel();
+                    if (stepper->isRunning()) stepper->forceStop();
+                    stepper->disableOutputs();
+                } else if (!_stop.active() && stepper->isRunning()) {
+                    // Decelerate along the stop ramp; outputs go off only at standstill.
+                    int32_t speed = stepper->getCurrentSpeedInMilliHz();
+                    uint32_t decel = stop_decel_sps2(speed < 0 ? (uint32_t)-speed : (uint32_t)speed,
+                                                     _config.stopDecelSps2, _config.stopMaxTimeMs);
+                    _stop.begin(*stepper, decel, _config.stopMaxTimeMs, nowMs);
+                }
+                result.stopOverrun = _stop.poll(*stepper, nowMs) == STOP_POLL_FORCED;
+            } else {
+                Scalar targetSps = rpm_to_sps(MotionScalar<Scalar>::fromFloat(_setpointRpm));
+                targetMilliHz = sps_to_milli_hz(targetSps);
+                stepper->setAcceleration(ramp_accel_sps2());
+                uint32_t periodFrac = rpm_to_ticks_frac(Q16_16::fromFloat(_setpointRpm));
+                stepper->setSpeedInTicks(_dither.next(periodFrac, stepper->getCurrentPosition(), nowUs));
+                if (_stop.active() || !stepper->isRunningContinuously()) {
+                    _stop.cancel();  // a new setpoint during a stop turns it around
+                    stepper->enableOutputs();
+                    stepper->runForward();
+                    result.outputsEnabled = true;
+                } else {
+                    stepper->applySpeedAcceleration();
+                }
+            }
+        }
+
+        // Ingress -> stepper given the speed -> stepper running at it.
+        if (_took) _latency.applied(_cmd, nowUs, _cmd.stop ? 0 : targetMilliHz);
+        result.commandReached = _latency.poll(stepper ? stepper->getCurrentSpeedInMilliHz() : 0, nowUs);
+        _took = false;
+        return result;
+    }
+
+private:
+    CommandLatencyTracker &_latency;
+    MotorCycleConfig _config;
+    StepPeriodDither _dither;
+    GracefulStop _stop;
+    SetpointCommand _cmd = {};
+    bool _took = false;
+    bool _unwritten = false;     ///< A command not yet written to targetRpm (the lock timed out).
+    float _unwrittenRpm = 0.0f;
+    float _setpointRpm = 0.0f;
+    float _measuredRpm = 0.0f;
+    uint16_t _errorFlags = 0;
+};
+
+#endif // MOTOR_CYCLE_H
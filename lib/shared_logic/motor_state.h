@@ -0,0 +1,114 @@
+#ifndef MOTOR_STATE_H
+#define MOTOR_STATE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// ============================
+// Seqlock de un solo escritor
+// ============================
+
+/**
+ * @brief Publishes a small trivially copyable value to many readers without locks.
+ *
+ * One writer bumps the sequence to an odd value, stores the payload and bumps
+ * it again; a reader that sees the same even sequence before and after its
+ * copy got a consistent value. The payload is kept in atomic words so the
+ * concurrent copy is well defined.
+ *
+ * Readers never block the writer. They retry a bounded number of times, so a
+ * reader that preempted the writer mid-update fails instead of spinning.
+ */
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock payload must be trivially copyable");
+
+public:
+    static constexpr int DEFAULT_READ_ATTEMPTS = 8;
+
+    SeqLock() {
+        T empty{};
+        publish(empty);
+    }
+
+    /**
+     * @brief Stores a new value. Only one task may call this.
+     */
+    void publish(const T &value) {
+        uint32_t words[WORDS] = {};
+        memcpy(words, &value, sizeof(T));
+        uint32_t seq = _seq.load(std::memory_order_relaxed);
+        _seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; ++i) _words[i].store(words[i], std::memory_order_relaxed);
+        _seq.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copies the latest consistent value into @p out.
+     *
+     * @return false if every attempt overlapped a write; @p out is then untouched.
+     */
+    bool read(T &out, int attempts = DEFAULT_READ_ATTEMPTS) const {
+        uint32_t words[WORDS];
+        for (int a = 0; a < attempts; ++a) {
+            uint32_t before = _seq.load(std::memory_order_acquire);
+            if (before & 1u) continue;
+            for (size_t i = 0; i < WORDS; ++i) words[i] = _words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (_seq.load(std::memory_order_relaxed) == before) {
+                memcpy(&out, words, sizeof(T));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Number of completed publishes (changes whenever the value does).
+     */
+    uint32_t version() const { return _seq.load(std::memory_order_acquire) >> 1; }
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> _seq{0};
+    std::atomic<uint32_t> _words[WORDS];
+};
+
+// ============================
+// Estado publicado del motor
+// ============================
+
+enum MotorRunState : uint8_t {
+    MOTOR_STOPPED = 0,
+    MOTOR_RUNNING = 1
+};
+
+/**
+ * @brief Error bits reported in MotorStateSnapshot::errorFlags.
+ */
+enum MotorErrorFlag : uint16_t {
+    MOTOR_ERR_NO_DRIVER = 1u << 0,     ///< The stepper driver could not be attached.
+    MOTOR_ERR_LOCK_TIMEOUT = 1u << 1,  ///< motor_task could not take rpmMutex this cycle.
+    MOTOR_ERR_ESTOP = 1u << 2          ///< The emergency stop is latched.
+};
+
+/**
+ * @brief What motor_task publishes every cycle for the web UI, Modbus and mDNS.
+ */
+struct MotorStateSnapshot {
+    float targetRpm;
+    float currentRpm;
+    uint32_t stepCount;   ///< Driver position, wraps at 2^32 steps.
+    uint32_t updatedMs;   ///< millis() of the publish.
+    uint16_t errorFlags;  ///< MotorErrorFlag bits.
+    uint8_t runState;     ///< MotorRunState.
+    uint8_t patternActive;  ///< 1 while a speed pattern drives targetRpm.
+    uint32_t patternCycle;  ///< Zero-based period of the running pattern.
+};
+
+#endif // MOTOR_STATE_H
@@ -0,0 +1,65 @@
+#ifndef QUADRATURE_H
+#define QUADRATURE_H
+
+#include <cstdint>
+
+#include "isr_inline.h"
+
+// ============================
+// Decodificador del encoder
+// ============================
+
+/**
+ * @brief Turns the two quadrature lines of the rotary encoder into detents.
+ *
+ * Fed from the pin-change interrupt of either line. The Gray-coded pair is
+ * converted to a position 0..3 with arithmetic, not a lookup table, so it
+ * stays usable from an IRAM handler. A jump of two positions (a missed edge)
+ * is ignored.
+ */
+class QuadratureDecoder {
+public:
+    /**
+     * @param stepsPerDetent Quadrature steps between two detents (4 on the panel encoder).
+     */
+    explicit QuadratureDecoder(uint8_t stepsPerDetent = 4) : _stepsPerDetent(stepsPerDetent) {}
+
+    /** @brief Sets the resting state of the lines, read once before enabling the interrupts. */
+    ISR_INLINE void reset(bool a, bool b) {
+        _last = position(a, b);
+        _steps = 0;
+    }
+
+    /**
+     * @return +1 or -1 when this edge completes a detent (+1 when A leads B), 0 otherwise.
+     */
+    ISR_INLINE int8_t update(bool a, bool b) {
+        uint8_t pos = position(a, b);
+        uint8_t delta = (uint8_t)(pos - _last) & 3u;
+        _last = pos;
+        if (delta == 1) {
+            _steps++;
+        } else if (delta == 3) {
+            _steps--;
+        }
+        if (_steps >= _stepsPerDetent) {
+            _steps = 0;
+            return 1;
+        }
+        if (_steps <= -_stepsPerDetent) {
+            _steps = 0;
+            return -1;
+        }
+        return 0;
+    }
+
+private:
+    /** @brief Gray code AB to its position in the cycle 00, 10, 11, 01 (A leading). */
+    static ISR_INLINE uint8_t position(bool a, bool b) { return (uint8_t)((b ? 2u : 0u) | ((a != b) ? 1u : 0u)); }
+
+    int8_t _steps = 0;
+    uint8_t _last = 0;
+    int8_t _stepsPerDetent;
+};
+
+#endif // QUADRATURE_H
@@ -0,0 +1,171 @@
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// ============================
+// Limitador por cubeta de tokens
+// ============================
+
+/**
+ * @brief Token bucket with integer milli-token accounting.
+ *
+ * Time is passed in by the caller (milliseconds, wrapping uint32_t as returned
+ * by millis()), so the same code runs on the ESP32 and in native tests.
+ */
+class TokenBucket {
+public:
+    /**
+     * @brief Reconfigures the bucket and refills it completely.
+     *
+     * @param ratePerSecond Sustained tokens per second.
+     * @param burst Maximum number of tokens that can accumulate.
+     * @param nowMs Current time in milliseconds.
+     */
+    void configure(uint32_t ratePerSecond, uint32_t burst, uint32_t nowMs) {
+        _ratePerSecond = ratePerSecond;
+        _capacity = burst * 1000u;
+        _milliTokens = _capacity;
+        _lastMs = nowMs;
+    }
+
+    /**
+     * @brief Tries to take one token.
+     *
+     * @param nowMs Current time in milliseconds.
+     * @param retryAfterMs If not null and the bucket is empty, receives the
+     *                     time until the next token becomes available.
+     * @return true if a token was taken, false if the caller must back off.
+     */
+    bool tryConsume(uint32_t nowMs, uint32_t *retryAfterMs = nullptr) {
+        refill(nowMs);
+        if (_milliTokens >= 1000u) {
+            _milliTokens -= 1000u;
+            return true;
+        }
+        if (retryAfterMs) {
+            *retryAfterMs = _ratePerSecond == 0
+                ? UINT32_MAX
+                : (1000u - _milliTokens + _ratePerSecond - 1) / _ratePerSecond;
+        }
+        return false;
+    }
+
+private:
+    void refill(uint32_t nowMs) {
+        uint32_t elapsed = nowMs - _lastMs;
+        _lastMs = nowMs;
+        // One token per second is 1 milli-token per millisecond.
+        uint64_t added = (uint64_t)elapsed * _ratePerSecond;
+        uint64_t next = (uint64_t)_milliTokens + added;
+        _milliTokens = next > _capacity ? _capacity : (uint32_t)next;
+    }
+
+    uint32_t _ratePerSecond = 0;
+    uint32_t _capacity = 0;
+    uint32_t _milliTokens = 0;
+    uint32_t _lastMs = 0;
+};
+
+/**
+ * @brief Per-client token buckets stored in a fixed-size table.
+ *
+ * Clients are identified by their IPv4 address. When the table is full the
+ * least recently seen client is evicted, so memory stays bounded regardless
+ * of how many addresses hit the server. Not thread-safe: every
+ * ESPAsyncWebServer handler runs on the AsyncTCP task, which is the only user.
+ *
+ * @tparam N Number of clients tracked simultaneously.
+ */
+template <size_t N>
+class ClientRateLimiter {
+public:
+    void configure(uint32_t ratePerSecond, uint32_t burst) {
+        _ratePerSecond = ratePerSecond;
+        _burst = burst;
+        for (size_t i = 0; i < N; ++i) _slots[i].used = false;
+    }
+
+    /**
+     * @brief Accounts one request from @p clientIp.
+     *
+     * @param clientIp Client IPv4 address.
+     * @param nowMs Current time in milliseconds.
+     * @param retryAfterMs Receives the suggested back-off when rejected.
+     * @return true if the request is admitted.
+     */
+    bool allow(uint32_t clientIp, uint32_t nowMs, uint32_t *retryAfterMs = nullptr) {
+        Slot &slot = slotFor(clientIp, nowMs);
+        slot.lastSeenMs = nowMs;
+        return slot.bucket.tryConsume(nowMs, retryAfterMs);
+    }
+
+private:
+    struct Slot {
+        bool used = false;
+        uint32_t ip = 0;
+        uint32_t lastSeenMs = 0;
+        TokenBucket bucket;
+    };
+
+    Slot &slotFor(uint32_t ip, uint32_t nowMs) {
+        Slot *oldest = &_slots[0];
+        for (size_t i = 0; i < N; ++i) {
+            Slot &s = _slots[i];
+            if (s.used && s.ip == ip) return s;
+            if (!s.used) {
+                oldest = &s;
+            } else if (oldest->used && (nowMs - s.lastSeenMs) > (nowMs - oldest->lastSeenMs)) {
+                oldest = &s;
+            }
+        }
+        oldest->used = true;
+        oldest->ip = ip;
+        oldest->lastSeenMs = nowMs;
+        oldest->bucket.configure(_ratePerSecond, _burst, nowMs);
+        return *oldest;
+    }
+
+    Slot _slots[N];
+    uint32_t _ratePerSecond = 0;
+    uint32_t _burst = 0;
+};
+
+// ============================
+// Control de admisión
+// ============================
+
+/**
+ * @brief Caps the number of requests in flight at the same time.
+ */
+class ConcurrencyGate {
+public:
+    explicit ConcurrencyGate(int limit = 4) : _limit(limit) {}
+
+    void setLimit(int limit) { _limit = limit; }
+
+    /**
+     * @brief Reserves a slot; every successful call must be paired with leave().
+     */
+    bool tryEnter() {
+        int cur = _inFlight.load(std::memory_order_relaxed);
+        while (cur < _limit) {
+            if (_inFlight.compare_exchange_weak(cur, cur + 1, std::memory_order_acq_rel)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void leave() { _inFlight.fetch_sub(1, std::memory_order_acq_rel); }
+
+    int inFlight() const { return _inFlight.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int> _inFlight{0};
+    int _limit;
+};
+
+#endif // RATE_LIMITER_H
@@ -0,0 +1,231 @@
+#ifndef RUN_JOURNAL_H
+#define RUN_JOURNAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "config_store.h"
+
+// ============================
+// Diario del estado de marcha
+// ============================
+
+const size_t RUN_JOURNAL_SECTOR_SIZE = 4096;
+
+/**
+ * @brief Run state worth restoring after a power loss.
+ */
+struct RunState {
+    bool running;
+    float rpm;          ///< Setpoint in force.
+    uint8_t step;       ///< Step of the running program; 0 for a constant-speed run.
+    uint32_t elapsedS;  ///< Time spent running since the run was started.
+};
+
+/**
+ * @brief One journal entry as stored in flash.
+ */
+struct RunJournalRecord {
+    uint32_t seq;       ///< Increases by one per record; the highest valid one is the latest.
+    uint32_t elapsedS;
+    uint16_t rpmX10;
+    uint8_t step;
+    uint8_t running;
+    uint32_t crc;       ///< CRC-32 of the bytes above.
+};
+
+static_assert(sizeof(RunJournalRecord) == 16, "journal records must stay 16 bytes");
+
+/**
+ * @brief Append-only journal of fixed-size records in a raw flash region.
+ *
+ * The region is a ring of erase sectors. A record is one 16-byte program
+ * into erased flash, with no filesystem metadata to update; the only slow
+ * operation is erasing a sector, once every RUN_JOURNAL_SECTOR_SIZE / 16
+ * records, when the ring reaches it. A record torn by a power loss fails its
+ * CRC and is skipped at replay, and the slot it occupied is never reused
+ * before the sector is erased.
+ *
+ * @tparam Flash Provides size(), read(offset, dst, len), write(offset, src, len)
+ *               and erase(offset, len) with NOR semantics (writes clear bits,
+ *               erase sets them); the size must be at least two sectors.
+ */
+template <typename Flash>
+class RunJournal {
+public:
+    static constexpr size_t RECORD_SIZE = sizeof(RunJournalRecord);
+    static constexpr size_t SLOTS_PER_SECTOR = RUN_JOURNAL_SECTOR_SIZE / RECORD_SIZE;
+
+    explicit RunJournal(Flash &flash) : _flash(flash) {}
+
+    /**
+     * @brief Scans the region for the latest record and positions the writer after it.
+     *
+     * @return true if a valid record was found (see latest()).
+     */
+    bool begin() {
+        _slots = (_flash.size() / RUN_JOURNAL_SECTOR_SIZE) * SLOTS_PER_SECTOR;
+        _haveLatest = false;
+        size_t latestSlot = 0;
+        for (size_t i = 0; i < _slots; ++i) {
+            RunJournalRecord r;
+            if (!readSlot(i, r) || !valid(r)) continue;
+            if (!_haveLatest || (int32_t)(r.seq - _latest.seq) > 0) {
+                _latest = r;
+                latestSlot = i;
+                _haveLatest = true;
+            }
+        }
+        _seq = _haveLatest ? _latest.seq + 1 : 1;
+        _next = _haveLatest ? (latestSlot + 1) % _slots : 0;
+        // Skip slots a torn write left dirty; the next sector start erases anyway.
+        while (_next % SLOTS_PER_SECTOR != 0 && !erased(_next)) _next = (_next + 1) % _slots;
+        return _haveLatest;
+    }
+
+    /** @brief Latest recorded state; false if the journal is empty. */
+    bool latest(RunState &out) const {
+        if (!_haveLatest) return false;
+        out.running = _latest.running != 0;
+        out.rpm = _latest.rpmX10 / 10.0f;
+        out.step = _latest.step;
+        out.elapsedS = _latest.elapsedS;
+        return true;
+    }
+
+    /**
+     * @brief Appends @p state.
+     *
+     * Erases the sector first when the ring enters it (this drops the oldest
+     * records; the newest stay in the previous sector).
+     */
+    bool append(const RunState &state) {
+        if (_slots < 2 * SLOTS_PER_SECTOR) return false;
+        if (_next % SLOTS_PER_SECTOR == 0 && !eraseSector(_next)) return false;
+
+        RunJournalRecord r = {};
+        r.seq = _seq;
+        r.elapsedS = state.elapsedS;
+        float x10 = state.rpm * 10.0f + 0.5f;
+        r.rpmX10 = x10 <= 0.0f ? 0 : x10 >= 65535.0f ? 65535 : (uint16_t)x10;
+        r.step = state.step;
+        r.running = state.running ? 1 : 0;
+        r.crc = crcOf(r);
+        bool ok = _flash.write(_next * RECORD_SIZE, &r, RECORD_SIZE);
+        // A failed program leaves the slot unusable either way.
+        _next = (_next + 1) % _slots;
+        if (!ok) return false;
+        _seq++;
+        _latest = r;
+        _haveLatest = true;
+        _appended++;
+        return true;
+    }
+
+    uint32_t appended() const { return _appended; }
+    uint32_t erases() const { return _erases; }
+
+private:
+    static uint32_t crcOf(const RunJournalRecord &r) {
+        return config_crc32((const uint8_t *)&r, offsetof(RunJournalRecord, crc));
+    }
+
+    static bool valid(const RunJournalRecord &r) { return r.running <= 1 && r.crc == crcOf(r); }
+
+    bool readSlot(size_t slot, RunJournalRecord &r) const {
+        return _flash.read(slot * RECORD_SIZE, &r, RECORD_SIZE);
+    }
+
+    bool erased(size_t slot) const {
+        uint8_t bytes[RECORD_SIZE];
+        if (!_flash.read(slot * RECORD_SIZE, bytes, RECORD_SIZE)) return false;
+        for (size_t i = 0; i < RECORD_SIZE; ++i) {
+            if (bytes[i] != 0xFF) return false;
+        }
+        return true;
+    }
+
+    bool eraseSector(size_t slot) {
+        if (!_flash.erase(slot * RECORD_SIZE, RUN_JOURNAL_SECTOR_SIZE)) return false;
+        _erases++;
+        return true;
+    }
+
+    Flash &_flash;
+    size_t _slots = 0;
+    size_t _next = 0;
+    uint32_t _seq = 1;
+    RunJournalRecord _latest = {};
+    bool _haveLatest = false;
+    uint32_t _appended = 0;
+    uint32_t _erases = 0;
+};
+
+/**
+ * @brief Decides when the journal needs a new record.
+ *
+ * Fed once per second with the applied setpoint. Starting, stopping or
+ * changing the setpoint is recorded at once; while running, the elapsed
+ * time is refreshed every periodS, which bounds how much run time a power
+ * loss can lose and how often flash is written.
+ */
+class RunJournalPolicy {
+public:
+    explicit RunJournalPolicy(uint32_t periodS) : _periodS(periodS) {}
+
+    /** @brief Continues a run restored from the journal. */
+    void resume(const RunState &state) {
+        _state = state;
+        _lastWriteS = state.elapsedS;
+    }
+
+    /**
+     * @param rpm Setpoint applied by motor_task (below 1 RPM is stopped).
+     * @param dtS Seconds since the previous call.
+     * @return true if @p state() should be appended now.
+     */
+    bool update(float rpm, uint32_t dtS) {
+        bool running = rpm >= 1.0f;
+        bool write = false;
+        if (running != _state.running) {
+            write = true;
+            if (running) _state.elapsedS = 0;  // a new run
+        } else if (running && rpm != _state.rpm) {
+            write = true;
+        }
+        if (running && _state.running) _state.elapsedS += dtS;
+        _state.running = running;
+        _state.rpm = running ? rpm : 0.0f;
+        if (running && _state.elapsedS - _lastWriteS >= _periodS) write = true;
+        if (write) _lastWriteS = _state.elapsedS;
+        return write;
+    }
+
+    const RunState &state() const { return _state; }
+
+private:
+    uint32_t _periodS;
+    RunState _state = {};
+    uint32_t _lastWriteS = 0;
+};
+
+/**
+ * @brief Last reset, reduced to what the resume decision needs.
+ */
+enum ResetCause : uint8_t {
+    RESET_POWER_LOSS,  ///< Power-on or brownout: the supply went away.
+    RESET_OTHER        ///< Panic, watchdog, software restart...: the firmware stopped itself.
+};
+
+/**
+ * @brief Whether the run found in the journal is resumed.
+ *
+ * Only a power loss resumes. A run cut short by a panic or a watchdog could
+ * hit the same fault again, so it stays stopped and is journaled as such.
+ */
+inline bool run_journal_should_resume(const RunState &last, ResetCause cause, bool resumeEnabled) {
+    return last.running && resumeEnabled && cause == RESET_POWER_LOSS;
+}
+
+#endif // RUN_JOURNAL_H
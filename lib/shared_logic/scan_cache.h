@@ -0,0 +1,203 @@
+#ifndef SCAN_CACHE_H
+#define SCAN_CACHE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ============================
+// Resultados de escaneo WiFi
+// ============================
+
+/**
+ * @brief Authentication family of a scanned network, independent of the driver enum.
+ */
+enum ScanAuth : uint8_t {
+    SCAN_AUTH_OPEN,
+    SCAN_AUTH_WEP,
+    SCAN_AUTH_WPA,
+    SCAN_AUTH_WPA2,
+    SCAN_AUTH_WPA_WPA2,
+    SCAN_AUTH_WPA2_ENTERPRISE,
+    SCAN_AUTH_WPA3,
+    SCAN_AUTH_OTHER
+};
+
+/**
+ * @brief Name used for @p auth in the JSON API.
+ */
+inline const char *scan_auth_name(uint8_t auth) {
+    static const char *const names[] = {"open", "wep", "wpa", "wpa2", "wpa/wpa2", "wpa2-ent", "wpa3", "other"};
+    return auth < sizeof(names) / sizeof(names[0]) ? names[auth] : "other";
+}
+
+/**
+ * @brief One network in the cache (the strongest BSS seen for that SSID).
+ */
+struct ScanEntry {
+    char ssid[33];
+    int8_t rssi;
+    uint8_t channel;
+    uint8_t auth;
+    uint32_t seenMs;
+};
+
+/**
+ * @brief Immutable result of a scan, shared by every consumer.
+ *
+ * Entries are sorted by RSSI (strongest first) and the JSON served by
+ * /scan-results is rendered once when the snapshot is built, so readers
+ * neither lock nor copy.
+ */
+struct ScanSnapshot {
+    std::vector<ScanEntry> entries;
+    std::string json;
+    uint32_t builtMs = 0;
+};
+
+/**
+ * @brief Deduplicating scan cache with per-entry time to live.
+ *
+ * Only the scan service task touches it; consumers get ScanSnapshot objects.
+ */
+class ScanCache {
+public:
+    /**
+     * @param capacity Maximum number of distinct SSIDs kept.
+     * @param ttlMs Entries not seen for this long are dropped.
+     */
+    explicit ScanCache(size_t capacity = 32, uint32_t ttlMs = 60000)
+        : _capacity(capacity), _ttlMs(ttlMs) {
+        _entries.reserve(capacity);
+    }
+
+    /**
+     * @brief Merges one scan result. Hidden networks (empty SSID) are ignored.
+     *
+     * If the SSID is already known the entry is refreshed, keeping the
+     * strongest BSS of this round. When the cache is full the weakest
+     * entry is replaced if the new one is stronger.
+     */
+    void add(const char *ssid, int8_t rssi, uint8_t channel, uint8_t auth, uint32_t nowMs) {
+        if (!ssid || ssid[0] == '\0') return;
+        for (ScanEntry &e : _entries) {
+            if (strncmp(e.ssid, ssid, sizeof(e.ssid)) == 0) {
+                if (e.seenMs != nowMs || rssi > e.rssi) {
+                    e.rssi = rssi;
+                    e.channel = channel;
+                    e.auth = auth;
+                }
+                e.seenMs = nowMs;
+                return;
+            }
+        }
+        ScanEntry entry;
+        snprintf(entry.ssid, sizeof(entry.ssid), "%s", ssid);
+        entry.rssi = rssi;
+        entry.channel = channel;
+        entry.auth = auth;
+        entry.seenMs = nowMs;
+        if (_entries.size() < _capacity) {
+            _entries.push_back(entry);
+            return;
+        }
+        auto weakest = std::min_element(_entries.begin(), _entries.end(),
+                                        [](const ScanEntry &a, const ScanEntry &b) { return a.rssi < b.rssi; });
+        if (weakest->rssi < rssi) *weakest = entry;
+    }
+
+    /**
+     * @brief Drops entries older than the TTL.
+     */
+    void expire(uint32_t nowMs) {
+        _entries.erase(std::remove_if(_entries.begin(), _entries.end(),
+                                      [&](const ScanEntry &e) { return nowMs - e.seenMs > _ttlMs; }),
+                       _entries.end());
+    }
+
+    size_t size() const { return _entries.size(); }
+
+    /**
+     * @brief Builds an immutable snapshot of the current cache.
+     */
+    std::shared_ptr<const ScanSnapshot> snapshot(uint32_t nowMs) const {
+        std::shared_ptr<ScanSnapshot> snap = std::make_shared<ScanSnapshot>();
+        snap->entries = _entries;
+        std::sort(snap->entries.begin(), snap->entries.end(),
+                  [](const ScanEntry &a, const ScanEntry &b) { return a.rssi > b.rssi; });
+        snap->builtMs = nowMs;
+        render_json(snap->entries, snap->json);
+        return snap;
+    }
+
+    /**
+     * @brief Renders entries as [{"ssid":..,"rssi":..,"channel":..,"auth":..},...].
+     */
+    static void render_json(const std::vector<ScanEntry> &entries, std::string &out) {
+        out.clear();
+        out.reserve(16 + entries.size() * 72);
+        out += '[';
+        char num[48];
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const ScanEntry &e = entries[i];
+            if (i) out += ',';
+            out += "{\"ssid\":\"";
+            append_escaped(out, e.ssid);
+            snprintf(num, sizeof(num), "\",\"rssi\":%d,\"channel\":%u,\"auth\":\"", (int)e.rssi, (unsigned)e.channel);
+            out += num;
+            out += scan_auth_name(e.auth);
+            out += "\"}";
+        }
+        out += ']';
+    }
+
+private:
+    static void append_escaped(std::string &out, const char *s) {
+        for (; *s; ++s) {
+            unsigned char c = (unsigned char)*s;
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += (char)c;
+            } else if (c < 0x20) {
+                char esc[8];
+                snprintf(esc, sizeof(esc), "\\u%04x", c);
+                out += esc;
+            } else {
+                out += (char)c;
+            }
+        }
+    }
+
+    std::vector<ScanEntry> _entries;
+    size_t _capacity;
+    uint32_t _ttlMs;
+};
+
+// ============================
+// Publicación de instantáneas
+// ============================
+
+/**
+ * @brief Holds the latest immutable snapshot of type T.
+ *
+ * The producer swaps in a new object; readers take a reference-counted
+ * handle that stays valid for as long as they keep it, even if a newer
+ * snapshot is published meanwhile.
+ */
+template <typename T>
+class SnapshotSlot {
+public:
+    void publish(std::shared_ptr<const T> snap) { std::atomic_store(&_current, std::move(snap)); }
+
+    std::shared_ptr<const T> get() const { return std::atomic_load(&_current); }
+
+private:
+    std::shared_ptr<const T> _current;
+};
+
+#endif // SCAN_CACHE_H
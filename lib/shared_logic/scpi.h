@@ -0,0 +1,274 @@
+#ifndef SCPI_H
+#define SCPI_H
+
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "motor_state.h"
+#include "stop_ramp.h"
+
+// ============================
+// Consola SCPI
+// ============================
+//
+// Line-oriented, SCPI-like commands for lab automation over the USB serial
+// port. Every input line gets exactly one reply line, in order, so a host
+// can pipeline: send many lines without waiting and match the replies by
+// position. Commands that return nothing in SCPI answer "OK" here for that
+// reason. Several commands may share a line separated by ';'; their replies
+// share the reply line, separated by ';' too.
+//
+//   *IDN?                 BioShaker,<id>,<firmware>
+//   SPEED <rpm>           Setpoint, 0..maxRpm
+//   SPEED?                Setpoint being applied
+//   STOP [GRACEFUL|HARD]  Stop along the stop ramp (default) or at once
+//   STAT?                 <rpm>,<setpoint>,<run state>,<error flags>
+//   ESTOP                 Trip the emergency stop
+//   ESTOP:ACK             Acknowledge it; refused while the input is asserted
+//   ESTOP?                1 while latched
+//
+// Errors answer ERR <code>,"<message>" with the SCPI error numbers.
+// Keywords are case-insensitive. The port also carries the firmware's
+// logs: every log line starts with '[', which no reply does, and each log,
+// multi-line reports included, goes out in a single write (scpi_log_lines()),
+// so it never lands inside a reply line. A host skips the '[' lines.
+
+const size_t SCPI_MAX_LINE = 128;  ///< Longer lines are dropped and answered SCPI_ERR_OVERRUN.
+
+enum ScpiError : int16_t {
+    SCPI_OK = 0,
+    SCPI_ERR_EXECUTION = -200,
+    SCPI_ERR_MISSING_PARAMETER = -109,
+    SCPI_ERR_UNDEFINED_HEADER = -113,
+    SCPI_ERR_SETTINGS_CONFLICT = -221,
+    SCPI_ERR_OUT_OF_RANGE = -222,
+    SCPI_ERR_ILLEGAL_VALUE = -224,
+    SCPI_ERR_OVERRUN = -363
+};
+
+/** @brief SCPI message for @p error. */
+inline const char *scpi_error_message(int16_t error) {
+    switch (error) {
+    case SCPI_ERR_MISSING_PARAMETER: return "Missing parameter";
+    case SCPI_ERR_UNDEFINED_HEADER: return "Undefined header";
+    case SCPI_ERR_SETTINGS_CONFLICT: return "Settings conflict";
+    case SCPI_ERR_OUT_OF_RANGE: return "Data out of range";
+    case SCPI_ERR_ILLEGAL_VALUE: return "Illegal parameter value";
+    case SCPI_ERR_OVERRUN: return "Input buffer overrun";
+    default: return "Execution error";
+    }
+}
+
+/**
+ * @brief Collects bytes into lines; "\n", "\r" and "\r\n" all end a line.
+ *
+ * Fixed buffer, no allocation: the serial task feeds it straight from the
+ * UART buffer.
+ */
+class ScpiLineReader {
+public:
+    /**
+     * @return true when @p c completed a line; read it with line() before the next put().
+     */
+    bool put(char c) {
+        if (c == '\n' && _afterCr) {
+            _afterCr = false;
+            return false;  // second half of "\r\n"
+        }
+        _afterCr = c == '\r';
+        if (_complete) {
+            _len = 0;
+            _overrun = false;
+            _complete = false;
+        }
+        if (c == '\r' || c == '\n') {
+            _line[_len] = '\0';
+            _complete = true;
+            return true;
+        }
+        if (_len < SCPI_MAX_LINE) {
+            _line[_len++] = c;
+        } else {
+            _overrun = true;
+        }
+        return false;
+    }
+
+    const char *line() const { return _line; }
+
+    /** @brief Whether the last completed line was longer than SCPI_MAX_LINE (it was cut). */
+    bool overrun() const { return _overrun; }
+
+private:
+    char _line[SCPI_MAX_LINE + 1] = {};
+    size_t _len = 0;
+    bool _overrun = false;
+    bool _complete = false;
+    bool _afterCr = false;
+};
+
+namespace scpi_detail {
+
+inline const char *skip_spaces(const char *p) {
+    while (*p == ' ' || *p == '\t') ++p;
+    return p;
+}
+
+/** @brief Case-insensitive match of [p, p + n) against @p keyword. */
+inline bool keyword_is(const char *p, size_t n, const char *keyword) {
+    if (strlen(keyword) != n) return false;
+    for (size_t i = 0; i < n; ++i) {
+        if (toupper((unsigned char)p[i]) != keyword[i]) return false;
+    }
+    return true;
+}
+
+inline void append_error(std::string &out, int16_t error) {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "ERR %d,\"%s\"", (int)error, scpi_error_message(error));
+    out += buf;
+}
+
+/**
+ * @brief Runs one command, [p, end) with no ';', and appends its reply to @p out.
+ */
+template <typename Device>
+void execute_one(const char *p, const char *end, Device &dev, std::string &out) {
+    p = skip_spaces(p);
+    while (end > p && (end[-1] == ' ' || end[-1] == '\t')) --end;
+    const char *header = p;
+    while (p < end && *p != ' ' && *p != '\t') ++p;
+    size_t headerLen = (size_t)(p - header);
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    std::string arg(p, end);
+
+    if (keyword_is(header, headerLen, "*IDN?")) {
+        out += dev.identity();
+    } else if (keyword_is(header, headerLen, "SPEED")) {
+        if (arg.empty()) return append_error(out, SCPI_ERR_MISSING_PARAMETER);
+        char *tail = nullptr;
+        float rpm = strtof(arg.c_str(), &tail);
+        if (tail == arg.c_str() || *tail != '\0') return append_error(out, SCPI_ERR_ILLEGAL_VALUE);
+        if (!(rpm >= 0.0f) || rpm > dev.maxRpm()) return append_error(out, SCPI_ERR_OUT_OF_RANGE);
+        if (dev.estopLatched()) return append_error(out, SCPI_ERR_SETTINGS_CONFLICT);
+        dev.setSpeed(rpm);
+        out += "OK";
+    } else if (keyword_is(header, headerLen, "SPEED?")) {
+        MotorStateSnapshot state;
+        if (!dev.state(state)) return append_error(out, SCPI_ERR_EXECUTION);
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%.1f", (double)state.targetRpm);
+        out += buf;
+    } else if (keyword_is(header, headerLen, "STAT?")) {
+        MotorStateSnapshot state;
+        if (!dev.state(state)) return append_error(out, SCPI_ERR_EXECUTION);
+        char buf[48];
+        snprintf(buf, sizeof(buf), "%.1f,%.1f,%u,%u", (double)state.currentRpm, (double)state.targetRpm,
+                 (unsigned)state.runState, (unsigned)state.errorFlags);
+        out += buf;
+    } else if (keyword_is(header, headerLen, "STOP")) {
+        StopMode mode = STOP_MODE_GRACEFUL;
+        if (!arg.empty()) {
+            for (char &c : arg) c = (char)tolower((unsigned char)c);
+            if (!stop_mode_parse(arg.c_str(), mode)) return append_error(out, SCPI_ERR_ILLEGAL_VALUE);
+        }
+        dev.stop(mode);
+        out += "OK";
+    } else if (keyword_is(header, headerLen, "ESTOP")) {
+        dev.estopTrip();
+        out += "OK";
+    } else if (keyword_is(header, headerLen, "ESTOP:ACK")) {
+        if (!dev.estopAcknowledge()) return append_error(out, SCPI_ERR_SETTINGS_CONFLICT);
+        out += "OK";
+    } else if (keyword_is(header, headerLen, "ESTOP?")) {
+        out += dev.estopLatched() ? "1" : "0";
+    } else {
+        append_error(out, SCPI_ERR_UNDEFINED_HEADER);
+    }
+}
+
+}  // namespace scpi_detail
+
+/**
+ * @brief Runs every command of @p line and appends the reply line, "\n" included.
+ *
+ * @param dev Anything with identity(), maxRpm(), setSpeed(rpm), stop(StopMode),
+ *            state(MotorStateSnapshot&), estopTrip(), estopAcknowledge() and
+ *            estopLatched(): the firmware's motor API, or a fake in the tests.
+ */
+template <typename Device>
+void scpi_execute(const char *line, Device &dev, std::string &out) {
+    const char *p = line;
+    bool first = true;
+    while (true) {
+        const char *sep = strchr(p, ';');
+        const char *end = sep ? sep : p + strlen(p);
+        if (!first) out += ';';
+        scpi_detail::execute_one(p, end, dev, out);
+        first = false;
+        if (!sep) break;
+        p = sep + 1;
+    }
+    out += '\n';
+}
+
+/**
+ * @brief Appends @p text to @p out with every line prefixed "[<tag>] ".
+ *
+ * Blank lines are prefixed too, and the last line gets a "\n" if it has
+ * none. Written to the port in one write, the block cannot split a reply.
+ */
+inline void scpi_log_lines(const char *tag, const char *text, std::string &out) {
+    const char *p = text;
+    while (*p) {
+        const char *nl = strchr(p, '\n');
+        const char *end = nl ? nl : p + strlen(p);
+        out += '[';
+        out += tag;
+        out += "] ";
+        out.append(p, end);
+        out += '\n';
+        p = nl ? nl + 1 : end;
+    }
+}
+
+/**
+ * @brief Byte stream in, reply stream out: the whole serial protocol without the port.
+ */
+template <typename Device>
+class ScpiSession {
+public:
+    /**
+     * @brief Consumes @p n bytes and appends a reply line for every line they complete.
+     *
+     * Blank lines are ignored and get no reply.
+     *
+     * @return Lines answered.
+     */
+    size_t feed(const char *data, size_t n, Device &dev, std::string &out) {
+        size_t lines = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (!_reader.put(data[i])) continue;
+            if (_reader.overrun()) {
+                scpi_detail::append_error(out, SCPI_ERR_OVERRUN);
+                out += '\n';
+            } else if (*scpi_detail::skip_spaces(_reader.line()) != '\0') {
+                scpi_execute(_reader.line(), dev, out);
+            } else {
+                continue;
+            }
+            ++lines;
+        }
+        return lines;
+    }
+
+private:
+    ScpiLineReader _reader;
+};
+
+#endif // SCPI_H
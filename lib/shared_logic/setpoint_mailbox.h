@@ -0,0 +1,101 @@
+#ifndef SETPOINT_MAILBOX_H
+#define SETPOINT_MAILBOX_H
+
+#include <atomic>
+#include <cstdint>
+
+// ============================
+// Buzón de consigna (último escritor gana)
+// ============================
+
+/**
+ * @brief Where a command entered the firmware.
+ */
+enum CommandSource : uint8_t {
+    CMD_SOURCE_HTTP,        ///< Web API (/rpm, /stop).
+    CMD_SOURCE_ENCODER,     ///< Rotary encoder and its button.
+    CMD_SOURCE_PROTOCOL,    ///< Modbus TCP.
+    CMD_SOURCE_SERIAL,      ///< SCPI console on the USB serial port.
+    CMD_SOURCE_SUPERVISOR,  ///< Issued by the firmware itself (safe stop, power-loss resume).
+    CMD_SOURCE_COUNT
+};
+
+/**
+ * @brief Setpoint command handed from the network side to motor_task.
+ */
+struct SetpointCommand {
+    float rpm;               ///< Requested speed in RPM.
+    bool stop;               ///< true if the motor must be stopped instead.
+    bool applied;            ///< The producer already acted on the stepper; only track it.
+    CommandSource source;
+    uint32_t ingressUs;      ///< micros() when the command entered the firmware.
+};
+
+/**
+ * @brief Single-slot, lock-free mailbox that coalesces setpoint writes.
+ *
+ * Producers (web handlers, UI) overwrite whatever is pending; the consumer
+ * (motor_task) takes at most one command per cycle. The whole command is
+ * packed into one 32-bit word so both sides are a single atomic operation
+ * and nobody ever waits on rpmMutex to hand over a setpoint. The ingress
+ * stamp travels beside it, one per source: each source has a single
+ * producer task, so a stamp is only ever replaced by a newer command of the
+ * same source.
+ */
+class SetpointMailbox {
+public:
+    /**
+     * @brief Publishes a new setpoint, replacing any command not yet taken.
+     *
+     * @param rpm Requested speed; values <= 1 RPM are treated as a stop.
+     * @param source Origin of the command.
+     * @param ingressUs micros() when the command entered the firmware.
+     * @param applied true if the producer already acted on the stepper.
+     */
+    void post(float rpm, CommandSource source = CMD_SOURCE_HTTP, uint32_t ingressUs = 0, bool applied = false) {
+        bool stop = rpm <= 1.0f;
+        if (rpm < 0.0f) rpm = 0.0f;
+        uint32_t centi = (uint32_t)(rpm * 100.0f + 0.5f);
+        if (centi > RPM_MASK) centi = RPM_MASK;
+        if (source >= CMD_SOURCE_COUNT) source = CMD_SOURCE_HTTP;
+        _ingressUs[source].store(ingressUs, std::memory_order_relaxed);
+        _slot.store(PENDING | (stop ? STOP : 0u) | (applied ? APPLIED : 0u) | ((uint32_t)source << SOURCE_SHIFT) |
+                        centi,
+                    std::memory_order_release);
+    }
+
+    /**
+     * @brief Takes the pending command, if any.
+     *
+     * @param out Receives the command.
+     * @return true if a command was pending.
+     */
+    bool take(SetpointCommand &out) {
+        uint32_t v = _slot.exchange(0u, std::memory_order_acq_rel);
+        if (!(v & PENDING)) return false;
+        out.rpm = (float)(v & RPM_MASK) / 100.0f;
+        out.stop = (v & STOP) != 0;
+        out.applied = (v & APPLIED) != 0;
+        out.source = (CommandSource)((v >> SOURCE_SHIFT) & SOURCE_MASK);
+        out.ingressUs = _ingressUs[out.source].load(std::memory_order_relaxed);
+        return true;
+    }
+
+    bool pending() const { return (_slot.load(std::memory_order_acquire) & PENDING) != 0; }
+
+private:
+    static constexpr uint32_t PENDING = 1u << 31;
+    static constexpr uint32_t STOP = 1u << 30;
+    static constexpr uint32_t APPLIED = 1u << 29;
+    static constexpr uint32_t SOURCE_SHIFT = 24;
+    static constexpr uint32_t SOURCE_MASK = 7u;
+    static constexpr uint32_t RPM_MASK = (1u << 24) - 1;
+    static_assert(CMD_SOURCE_COUNT <= SOURCE_MASK + 1, "widen SOURCE_MASK for the new CommandSource");
+    static_assert(((SOURCE_MASK << SOURCE_SHIFT) & (PENDING | STOP | APPLIED | RPM_MASK)) == 0,
+                  "SOURCE_MASK overlaps the other fields");
+
+    std::atomic<uint32_t> _slot{0};
+    std::atomic<uint32_t> _ingressUs[CMD_SOURCE_COUNT] = {};
+};
+
+#endif // SETPOINT_MAILBOX_H
@@ -1,10 +1,13 @@
 #ifndef SHARED_LOGIC_H
 #define SHARED_LOGIC_H
 
+#include <cstdint>
+
 // ============================
 // Constantes Compartidas
 // ============================
-const double SPR_CMD = 3200; // Steps per revolution for RPM to SPS conversion
+constexpr double SPR_CMD = 3200; // Steps per revolution for RPM to SPS conversion
+constexpr double A_CMD = SPR_CMD / 6.0; // Acceleration for the ramp (steps/s^2)
 
 /**
  * @brief Converts RPM (Revolutions Per Minute) to SPS (Steps Per Second).
@@ -16,4 +19,41 @@ inline double rpm2sps(double rpm) {
     return (rpm / 60.0) * SPR_CMD;
 }
 
+/**
+ * @brief Estimates the speed from successive stepper positions.
+ *
+ * Each update covers one window; the displayed value is an exponential
+ * moving average of the per-window estimates.
+ */
+class RpmEstimator {
+public:
+    static constexpr float SMOOTHING = 0.35f;  ///< Weight of the newest window.
+
+    /** @brief Restarts from @p position with a zero average. */
+    void reset(int32_t position) {
+        _last = position;
+        _smoothed = 0.0f;
+    }
+
+    /**
+     * @param position Current stepper position (wraps like the driver's counter).
+     * @param stepsPerRev Measured steps per output revolution.
+     * @param windowMs Time the window is taken to cover.
+     * @return Unfiltered RPM over the window.
+     */
+    float update(int32_t position, double stepsPerRev, uint32_t windowMs) {
+        int32_t steps = (int32_t)((uint32_t)position - (uint32_t)_last);
+        float rpm = (steps / (float)stepsPerRev) * (60000.0f / windowMs);
+        _last = position;
+        _smoothed = SMOOTHING * rpm + (1.0f - SMOOTHING) * _smoothed;
+        return rpm;
+    }
+
+    float smoothed() const { return _smoothed; }
+
+private:
+    int32_t _last = 0;
+    float _smoothed = 0.0f;
+};
+
 #endif // SHARED_LOGIC_H
@@ -0,0 +1,125 @@
+#ifndef SPEED_PATTERN_H
+#define SPEED_PATTERN_H
+
+#include <cmath>
+#include <cstdint>
+
+// ============================
+// Patrones de agitación
+// ============================
+
+enum PatternShape : uint8_t {
+    PATTERN_SQUARE = 0,    ///< highRpm for onMs, then lowRpm; on/off with lowRpm = 0.
+    PATTERN_TRIANGLE = 1,  ///< lowRpm up to highRpm at mid-period and back, linearly.
+    PATTERN_SINE = 2,      ///< lowRpm to highRpm and back, sinusoidally.
+    PATTERN_SHAPE_COUNT
+};
+
+/**
+ * @brief A periodic speed modulation. Plain data, safe to publish through a SeqLock.
+ */
+struct SpeedPattern {
+    uint8_t shape;      ///< PatternShape.
+    float highRpm;
+    float lowRpm;       ///< Below 1 RPM the motor stops during that part.
+    uint32_t periodMs;
+    uint32_t onMs;      ///< Square only: time at highRpm in each period.
+    uint32_t cycles;    ///< Periods to run; 0 runs until stopped.
+};
+
+const uint32_t PATTERN_MIN_PERIOD_MS = 200;
+
+/** @brief Name of @p shape in the web API; "" if unknown. */
+inline const char *pattern_shape_name(uint8_t shape) {
+    static const char *const names[PATTERN_SHAPE_COUNT] = {"square", "triangle", "sine"};
+    return shape < PATTERN_SHAPE_COUNT ? names[shape] : "";
+}
+
+/**
+ * @brief Checks a pattern before it is accepted.
+ *
+ * @param maxRpm Highest setpoint the device accepts.
+ */
+inline bool pattern_valid(const SpeedPattern &p, float maxRpm) {
+    if (p.shape >= PATTERN_SHAPE_COUNT || p.periodMs < PATTERN_MIN_PERIOD_MS) return false;
+    if (!(p.lowRpm >= 0.0f) || !(p.highRpm >= p.lowRpm) || p.highRpm > maxRpm) return false;
+    return p.shape != PATTERN_SQUARE || (p.onMs > 0 && p.onMs < p.periodMs);
+}
+
+/**
+ * @brief Evaluates a pattern against a free-running microsecond clock.
+ *
+ * The setpoint is a function of the time since start() only, never of how
+ * often or how late it is evaluated, so a late control cycle shifts when a
+ * change is applied but not the schedule: after hours the edges are still
+ * at start + k * period.
+ */
+class PatternGenerator {
+public:
+    void start(const SpeedPattern &pattern, uint64_t nowUs) {
+        _pattern = pattern;
+        _startUs = nowUs;
+        _active = true;
+    }
+
+    void stop() { _active = false; }
+
+    bool active() const { return _active; }
+    const SpeedPattern &pattern() const { return _pattern; }
+
+    /** @brief Whether all the requested cycles have run by @p nowUs. */
+    bool finished(uint64_t nowUs) const {
+        return _active && _pattern.cycles != 0 && elapsed(nowUs) >= (uint64_t)_pattern.cycles * periodUs();
+    }
+
+    /** @brief Zero-based period that @p nowUs falls in. */
+    uint32_t cycle(uint64_t nowUs) const { return _active ? (uint32_t)(elapsed(nowUs) / periodUs()) : 0; }
+
+    /** @brief Setpoint at @p nowUs; 0 when inactive or finished. */
+    float rpmAt(uint64_t nowUs) const {
+        if (!_active || finished(nowUs)) return 0.0f;
+        uint64_t period = periodUs();
+        uint64_t phaseUs = elapsed(nowUs) % period;
+        float span = _pattern.highRpm - _pattern.lowRpm;
+        switch (_pattern.shape) {
+        case PATTERN_SQUARE:
+            return phaseUs < (uint64_t)_pattern.onMs * 1000 ? _pattern.highRpm : _pattern.lowRpm;
+        case PATTERN_TRIANGLE: {
+            float x = (float)phaseUs / (float)period;  // 0..1
+            return _pattern.lowRpm + span * (x < 0.5f ? 2.0f * x : 2.0f - 2.0f * x);
+        }
+        case PATTERN_SINE: {
+            float x = (float)phaseUs / (float)period;
+            return _pattern.lowRpm + span * 0.5f * (1.0f - cosf(6.2831853f * x));
+        }
+        default:
+            return 0.0f;
+        }
+    }
+
+    /**
+     * @brief Next time the setpoint jumps after @p nowUs, for a one-shot timer.
+     *
+     * @return The next square edge (or the end of the last cycle); 0 for
+     *         shapes that change continuously or when inactive.
+     */
+    uint64_t nextEdgeUs(uint64_t nowUs) const {
+        if (!_active || finished(nowUs) || _pattern.shape != PATTERN_SQUARE) return 0;
+        uint64_t period = periodUs();
+        uint64_t base = _startUs + elapsed(nowUs) / period * period;
+        uint64_t end = _pattern.cycles ? _startUs + (uint64_t)_pattern.cycles * period : 0;
+        uint64_t fall = base + (uint64_t)_pattern.onMs * 1000;
+        uint64_t edge = nowUs < fall ? fall : base + period;
+        return end && edge > end ? end : edge;
+    }
+
+private:
+    uint64_t periodUs() const { return (uint64_t)_pattern.periodMs * 1000; }
+    uint64_t elapsed(uint64_t nowUs) const { return nowUs > _startUs ? nowUs - _startUs : 0; }
+
+    SpeedPattern _pattern = {};
+    uint64_t _startUs = 0;
+    bool _active = false;
+};
+
+#endif // SPEED_PATTERN_H
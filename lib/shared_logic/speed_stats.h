@@ -0,0 +1,202 @@
+#ifndef SPEED_STATS_H
+#define SPEED_STATS_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// ============================
+// Estabilidad de velocidad
+// ============================
+
+/**
+ * @brief Block lengths (in samples) at which the Allan deviation is reported.
+ *
+ * With the 300 ms RPM estimator these are tau = 0.3 s, 3 s, 30 s, 5 min and 50 min.
+ */
+const size_t SPEED_ADEV_TAUS = 5;
+const uint32_t SPEED_ADEV_FACTORS[SPEED_ADEV_TAUS] = {1, 10, 100, 1000, 10000};
+
+/**
+ * @brief Non-overlapping Allan variance of a sample stream, in O(1) memory.
+ *
+ * Samples are averaged in blocks of m; the variance is half the mean squared
+ * difference between consecutive block averages.
+ */
+class AllanAccumulator {
+public:
+    void reset() { *this = AllanAccumulator(); }
+
+    void add(double y, uint32_t m) {
+        _blockSum += y;
+        if (++_blockCount < m) return;
+        double avg = _blockSum / m;
+        if (_havePrevious) {
+            double d = avg - _previous;
+            _sumSq += d * d;
+            _pairs++;
+        }
+        _previous = avg;
+        _havePrevious = true;
+        _blockSum = 0.0;
+        _blockCount = 0;
+    }
+
+    /** @brief Number of block-average differences accumulated so far. */
+    uint32_t pairs() const { return _pairs; }
+
+    /** @return The Allan deviation, or 0 before the first pair. */
+    double deviation() const { return _pairs ? sqrt(_sumSq / (2.0 * _pairs)) : 0.0; }
+
+private:
+    double _blockSum = 0.0;
+    uint32_t _blockCount = 0;
+    double _previous = 0.0;
+    bool _havePrevious = false;
+    double _sumSq = 0.0;
+    uint32_t _pairs = 0;
+};
+
+enum SpeedStabilityState : uint8_t {
+    SPEED_STATS_IDLE,      ///< Motor stopped; nothing measured.
+    SPEED_STATS_SETTLING,  ///< New setpoint; waiting for the ramp to end.
+    SPEED_STATS_STEADY     ///< Accumulating error statistics.
+};
+
+/**
+ * @brief Statistics of one constant-setpoint segment. Plain data, safe to publish through a SeqLock.
+ *
+ * Errors are measured minus target, in RPM.
+ */
+struct SpeedStabilityReport {
+    float targetRpm;
+    uint32_t samples;
+    uint32_t durationMs;     ///< Time spent in steady state.
+    uint32_t tau0Ms;         ///< Sample period; tau of SPEED_ADEV_FACTORS[i] is factor * tau0Ms.
+    float meanError;
+    float rmsError;
+    float peakError;         ///< Largest |error|.
+    float adev[SPEED_ADEV_TAUS];
+    uint32_t adevPairs[SPEED_ADEV_TAUS];  ///< 0: not enough data for that tau yet.
+    uint8_t state;           ///< SpeedStabilityState.
+};
+
+/**
+ * @brief Running speed-error statistics over the current setpoint, in O(1) memory.
+ *
+ * Fed with every RPM estimate. A setpoint change starts a new segment; its
+ * samples count only once the measured speed first comes within the settle
+ * band, so the acceleration ramp is left out.
+ */
+class SpeedStabilityMonitor {
+public:
+    /**
+     * @param tau0Ms Nominal period between samples.
+     * @param settleBandRpm |error| that ends the settling phase.
+     */
+    explicit SpeedStabilityMonitor(uint32_t tau0Ms, float settleBandRpm = 1.0f)
+        : _tau0Ms(tau0Ms), _settleBand(settleBandRpm) {
+        reset(0.0f);
+    }
+
+    /**
+     * @brief Adds one RPM estimate.
+     *
+     * @param targetRpm Setpoint in force for this sample.
+     * @param measuredRpm Estimated speed.
+     * @param elapsedMs Time covered by the sample.
+     * @return true if this call ended a steady segment; see lastSegment().
+     */
+    bool update(float targetRpm, float measuredRpm, uint32_t elapsedMs) {
+        bool ended = false;
+        if (targetRpm != _target) {
+            if (_state == SPEED_STATS_STEADY && _samples > 0) {
+                fill(_last);
+                ended = true;
+            }
+            reset(targetRpm);
+        }
+        if (_state == SPEED_STATS_IDLE) return ended;
+
+        double error = (double)measuredRpm - (double)targetRpm;
+        if (_state == SPEED_STATS_SETTLING) {
+            if (fabs(error) > _settleBand) return ended;
+            _state = SPEED_STATS_STEADY;
+        }
+
+        _samples++;
+        _durationMs += elapsedMs;
+        _sum += error;
+        _sumSq += error * error;
+        if (fabs(error) > _peak) _peak = fabs(error);
+        for (size_t i = 0; i < SPEED_ADEV_TAUS; ++i) _allan[i].add(error, SPEED_ADEV_FACTORS[i]);
+        return ended;
+    }
+
+    /** @brief Statistics of the segment in progress. */
+    SpeedStabilityReport report() const {
+        SpeedStabilityReport r;
+        fill(r);
+        return r;
+    }
+
+    /** @brief Statistics of the last steady segment that ended. */
+    const SpeedStabilityReport &lastSegment() const { return _last; }
+
+    /**
+     * @brief One-line summary for the serial run log.
+     */
+    static int format(const SpeedStabilityReport &r, char *out, size_t len) {
+        int n = snprintf(out, len, "target %.1f rpm, %lu s steady: mean %+.3f rms %.3f peak %.3f adev",
+                         (double)r.targetRpm, (unsigned long)(r.durationMs / 1000), (double)r.meanError,
+                         (double)r.rmsError, (double)r.peakError);
+        for (size_t i = 0; i < SPEED_ADEV_TAUS && n >= 0 && (size_t)n < len; ++i) {
+            if (!r.adevPairs[i]) break;
+            n += snprintf(out + n, len - n, " %gs=%.3f", SPEED_ADEV_FACTORS[i] * r.tau0Ms / 1000.0,
+                          (double)r.adev[i]);
+        }
+        return n;
+    }
+
+private:
+    void reset(float targetRpm) {
+        _target = targetRpm;
+        _state = targetRpm >= 1.0f ? SPEED_STATS_SETTLING : SPEED_STATS_IDLE;
+        _samples = 0;
+        _durationMs = 0;
+        _sum = 0.0;
+        _sumSq = 0.0;
+        _peak = 0.0;
+        for (size_t i = 0; i < SPEED_ADEV_TAUS; ++i) _allan[i].reset();
+    }
+
+    void fill(SpeedStabilityReport &r) const {
+        r.targetRpm = _target;
+        r.samples = _samples;
+        r.durationMs = _durationMs;
+        r.tau0Ms = _tau0Ms;
+        r.meanError = _samples ? (float)(_sum / _samples) : 0.0f;
+        r.rmsError = _samples ? (float)sqrt(_sumSq / _samples) : 0.0f;
+        r.peakError = (float)_peak;
+        for (size_t i = 0; i < SPEED_ADEV_TAUS; ++i) {
+            r.adev[i] = (float)_allan[i].deviation();
+            r.adevPairs[i] = _allan[i].pairs();
+        }
+        r.state = _state;
+    }
+
+    uint32_t _tau0Ms;
+    float _settleBand;
+    float _target;
+    uint8_t _state;
+    uint32_t _samples;
+    uint32_t _durationMs;
+    double _sum;
+    double _sumSq;
+    double _peak;
+    AllanAccumulator _allan[SPEED_ADEV_TAUS];
+    SpeedStabilityReport _last = {};
+};
+
+#endif // SPEED_STATS_H
@@ -0,0 +1,77 @@
+#ifndef STATUS_JSON_H
+#define STATUS_JSON_H
+
+#include <ArduinoJson.h>
+#include <cstddef>
+#include <cstdint>
+
+#include "speed_stats.h"
+
+// ============================
+// Documento de /status
+// ============================
+
+const size_t STATUS_JSON_CAPACITY = 1024;
+
+/**
+ * @brief Everything /status reports, gathered by the handler.
+ *
+ * Strings are not copied; they must outlive the serialization.
+ */
+struct StatusInfo {
+    bool staConnected;
+    const char *ip;         ///< Station IP, or the AP IP when not connected.
+    const char *ssid;
+    int32_t rssi;
+    float currentRpm;
+    const char *provision;  ///< Provisioning state name.
+    uint32_t runSeconds;
+    bool resumed;
+    bool haveStability;
+    SpeedStabilityReport stability;
+};
+
+/**
+ * @brief Fills the /status document.
+ */
+inline void status_json_fill(JsonDocument &doc, const StatusInfo &s) {
+    if (s.staConnected) {
+        doc["wifi"] = true;
+        doc["mode"] = "STA";
+        doc["ip"] = s.ip;
+        doc["ssid"] = s.ssid;
+        doc["rssi"] = s.rssi;
+        doc["currentRpm"] = s.currentRpm;
+    } else {
+        doc["wifi"] = false;
+        doc["mode"] = "AP";
+        doc["ip_ap"] = s.ip;
+        doc["ssid"] = "";
+        doc["rssi"] = nullptr;
+        doc["currentRpm"] = 0.0;
+    }
+    doc["provision"] = s.provision;
+    doc["runSeconds"] = s.runSeconds;
+    doc["resumed"] = s.resumed;
+
+    if (s.haveStability) {
+        static const char *const STATES[] = {"idle", "settling", "steady"};
+        const SpeedStabilityReport &stats = s.stability;
+        JsonObject st = doc.createNestedObject("stability");
+        st["state"] = STATES[stats.state];
+        st["targetRpm"] = stats.targetRpm;
+        st["samples"] = stats.samples;
+        st["steadySeconds"] = stats.durationMs / 1000;
+        st["meanError"] = stats.meanError;
+        st["rmsError"] = stats.rmsError;
+        st["peakError"] = stats.peakError;
+        JsonArray adev = st.createNestedArray("allan");
+        for (size_t i = 0; i < SPEED_ADEV_TAUS && stats.adevPairs[i]; ++i) {
+            JsonObject point = adev.createNestedObject();
+            point["tau"] = SPEED_ADEV_FACTORS[i] * stats.tau0Ms / 1000.0;
+            point["adev"] = stats.adev[i];
+        }
+    }
+}
+
+#endif // STATUS_JSON_H
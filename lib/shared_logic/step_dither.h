@@ -0,0 +1,67 @@
+#ifndef STEP_DITHER_H
+#define STEP_DITHER_H
+
+#include <cstdint>
+
+#include "step_tables.h"
+
+// ============================
+// Dither del periodo de paso
+// ============================
+
+/**
+ * @brief Sigma-delta between the two whole-tick periods around the exact one.
+ *
+ * FastAccelStepper takes the period in whole ticks, so a setpoint between
+ * two of them runs slightly fast or slow (up to 0.1% at 600 RPM, where a
+ * step is 500 ticks). Called once per control cycle, next() commands the
+ * shorter period while the motor is behind the position the exact period
+ * would have reached, and the longer one while it is ahead.
+ *
+ * The integrator is that position error, measured on the stepper itself
+ * rather than on the commanded periods: the driver ramps between the two
+ * speeds at the configured acceleration and may not reach either within a
+ * cycle, so only feedback from the position keeps the long-run mean exact.
+ * The error is clamped to WINDUP_STEPS steps so the ramp to a new setpoint
+ * does not leave a debt to repay afterwards.
+ */
+class StepPeriodDither {
+public:
+    static constexpr uint32_t UNIT = 1u << STEP_TICK_FRAC_BITS;
+    static constexpr uint32_t TICKS_PER_US = STEPPER_TICKS_PER_S / 1000000;
+    static constexpr int64_t WINDUP_STEPS = 4;
+
+    /**
+     * @param periodFrac Period in 1/256 ticks, from rpm_to_ticks_frac(); 0 when stopped.
+     * @param position Stepper position now (wraps).
+     * @param nowUs micros() now.
+     * @return Whole-tick period for this cycle, for setSpeedInTicks(); 0 when stopped.
+     */
+    uint32_t next(uint32_t periodFrac, int32_t position, uint32_t nowUs) {
+        uint32_t ticks = periodFrac >> STEP_TICK_FRAC_BITS;
+        if (periodFrac != _periodFrac) {
+            // New setpoint: start integrating from here.
+            _periodFrac = periodFrac;
+            _errorFrac = 0;
+        } else if (periodFrac != 0) {
+            int32_t steps = (int32_t)((uint32_t)position - (uint32_t)_position);
+            _errorFrac += (int64_t)(nowUs - _nowUs) * TICKS_PER_US * UNIT - (int64_t)steps * periodFrac;
+            int64_t limit = WINDUP_STEPS * periodFrac;
+            if (_errorFrac > limit) _errorFrac = limit;
+            if (_errorFrac < -limit) _errorFrac = -limit;
+        }
+        _position = position;
+        _nowUs = nowUs;
+        if ((periodFrac & (UNIT - 1)) == 0) return ticks;
+        // Positive error: the time elapsed covers more steps than were made.
+        return _errorFrac > 0 ? ticks : ticks + 1;
+    }
+
+private:
+    uint32_t _periodFrac = 0;
+    int32_t _position = 0;
+    uint32_t _nowUs = 0;
+    int64_t _errorFrac = 0;  ///< Elapsed time minus steps made times the period, in 1/256 ticks.
+};
+
+#endif // STEP_DITHER_H
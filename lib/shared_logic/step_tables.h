@@ -0,0 +1,134 @@
+#ifndef STEP_TABLES_H
+#define STEP_TABLES_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "motion_math.h"
+
+// ============================
+// Tablas RPM -> periodo de paso
+// ============================
+//
+// The step period for a setpoint is STEPPER_TICKS_PER_S * 60 / (rpm * SPR_CMD),
+// a pure function of constants. The tables below hold it for a grid of
+// setpoints, built by the compiler; being const data they stay in flash
+// (.rodata) on the ESP32. A lookup interpolates between two entries with
+// integer arithmetic only: no division, no floating point.
+//
+// Linear interpolation of 1/x is worst at low speed, so below
+// RPM_LUT_FINE_MAX the grid is 1/RPM_LUT_FINE_STEPS RPM; above it, 1 RPM.
+// Entries keep STEP_TICK_FRAC_BITS fractional bits, so the fraction of a
+// tick is known to whoever dithers between adjacent periods (step_dither.h).
+
+constexpr uint32_t STEPPER_TICKS_PER_S = 16000000;  // FastAccelStepper's TICKS_PER_S on the ESP32
+constexpr uint32_t RPM_LUT_MAX = 600;               // Highest setpoint in the table; above it, clamped.
+constexpr uint32_t RPM_LUT_FINE_MAX = 32;
+constexpr uint32_t RPM_LUT_FINE_STEPS = 16;         // Entries per RPM below RPM_LUT_FINE_MAX (power of two).
+constexpr uint32_t RPM_LUT_FINE_SHIFT = 4;          // log2(RPM_LUT_FINE_STEPS)
+constexpr uint32_t STEP_TICK_FRAC_BITS = 8;         // Periods in the tables are ticks * 256.
+
+static_assert((1u << RPM_LUT_FINE_SHIFT) == RPM_LUT_FINE_STEPS, "RPM_LUT_FINE_SHIFT must match RPM_LUT_FINE_STEPS");
+
+/** @brief Exact step period at @p rpm, in (fractional) ticks. */
+constexpr double rpm_ticks_exact(double rpm) {
+    return STEPPER_TICKS_PER_S * 60.0 / (rpm * SPR_CMD);
+}
+
+/**
+ * @brief Periods on a grid of setpoints, in 1/256 ticks.
+ *
+ * bow[i] is how far the chord from entry i to i + 1 lies above the curve at
+ * the middle of the interval, times four: subtracting f * (1 - f) * bow[i]
+ * from the linear interpolation makes it quadratic, which is what makes the
+ * fractional part of the period usable for dithering at low speeds.
+ */
+template <size_t N>
+struct StepTickTable {
+    uint32_t ticks[N];
+    uint32_t bow[N];
+};
+
+/** @brief Entry i is the period at i / perRpm RPM, rounded; 0 for 0 RPM. */
+template <size_t N>
+constexpr StepTickTable<N> make_step_tick_table(uint32_t perRpm) {
+    constexpr double UNIT = 1u << STEP_TICK_FRAC_BITS;
+    StepTickTable<N> t = {};
+    for (size_t i = 1; i < N; ++i) {
+        double x = (double)i / perRpm, h = 1.0 / perRpm;
+        t.ticks[i] = (uint32_t)(rpm_ticks_exact(x) * UNIT + 0.5);
+        if (i + 1 < N) {
+            double chord = (rpm_ticks_exact(x) + rpm_ticks_exact(x + h)) / 2.0;
+            t.bow[i] = (uint32_t)(4.0 * (chord - rpm_ticks_exact(x + h / 2.0)) * UNIT + 0.5);
+        }
+    }
+    return t;
+}
+
+constexpr StepTickTable<RPM_LUT_FINE_MAX * RPM_LUT_FINE_STEPS + 1> RPM_TICKS_FINE =
+    make_step_tick_table<RPM_LUT_FINE_MAX * RPM_LUT_FINE_STEPS + 1>(RPM_LUT_FINE_STEPS);
+constexpr StepTickTable<RPM_LUT_MAX + 1> RPM_TICKS_COARSE = make_step_tick_table<RPM_LUT_MAX + 1>(1);
+
+/** @brief Quadratic interpolation in interval @p i, @p frac in units of 2^-fracBits. */
+template <size_t N>
+constexpr uint32_t lut_interpolate(const StepTickTable<N> &t, uint32_t i, uint32_t frac, uint32_t fracBits) {
+    uint32_t a = t.ticks[i], b = t.ticks[i + 1];
+    uint32_t linear = a - (uint32_t)(((uint64_t)(a - b) * frac + (1u << (fracBits - 1))) >> fracBits);
+    uint64_t curve = (uint64_t)t.bow[i] * frac * ((1u << fracBits) - frac);
+    return linear - (uint32_t)((curve + (1ull << (2 * fracBits - 1))) >> (2 * fracBits));
+}
+
+/**
+ * @brief Step period for a setpoint, from the tables, with its fraction of a tick.
+ *
+ * @param rpm Setpoint; below 1 RPM (the stop threshold) gives 0.
+ * @return Period in 1/256 FastAccelStepper ticks.
+ */
+constexpr uint32_t rpm_to_ticks_frac(Q16_16 rpm) {
+    constexpr uint32_t CLAMP = RPM_LUT_MAX << Q16_16::FRAC_BITS;
+    constexpr uint32_t FINE_BITS = Q16_16::FRAC_BITS - RPM_LUT_FINE_SHIFT;
+    uint32_t raw = rpm.raw < Q16_16::ONE ? 0 : (uint32_t)rpm.raw > CLAMP ? CLAMP : (uint32_t)rpm.raw;
+    if (raw == 0) return 0;
+    if (raw < (RPM_LUT_FINE_MAX << Q16_16::FRAC_BITS)) {
+        uint32_t i = raw >> FINE_BITS;
+        return lut_interpolate(RPM_TICKS_FINE, i, raw & ((1u << FINE_BITS) - 1), FINE_BITS);
+    }
+    uint32_t i = raw >> Q16_16::FRAC_BITS;
+    if (i == RPM_LUT_MAX) return RPM_TICKS_COARSE.ticks[RPM_LUT_MAX];
+    return lut_interpolate(RPM_TICKS_COARSE, i, raw & (Q16_16::ONE - 1), Q16_16::FRAC_BITS);
+}
+
+/**
+ * @brief Step period for a setpoint rounded to whole ticks, for setSpeedInTicks().
+ */
+constexpr uint32_t rpm_to_ticks(Q16_16 rpm) {
+    return (rpm_to_ticks_frac(rpm) + (1u << (STEP_TICK_FRAC_BITS - 1))) >> STEP_TICK_FRAC_BITS;
+}
+
+inline uint32_t rpm_to_ticks(float rpm) {
+    return rpm_to_ticks(Q16_16::fromFloat(rpm));
+}
+
+/**
+ * @brief Allowed error of the fractional period: 20 ppm of it (interpolation)
+ * plus one table unit (rounding of the entries and of the setpoint).
+ */
+constexpr bool lut_within_bound(uint32_t ticksFrac, double exact) {
+    double ticks = (double)ticksFrac / (1u << STEP_TICK_FRAC_BITS);
+    return (ticks > exact ? ticks - exact : exact - ticks) <= exact * 20e-6 + 1.0 / (1u << STEP_TICK_FRAC_BITS);
+}
+
+/** @brief Compares lookups every 1/128 RPM (8 points per fine interval) with the exact period. */
+constexpr bool lut_accuracy_holds() {
+    for (uint32_t raw = Q16_16::ONE; raw <= (RPM_LUT_MAX << Q16_16::FRAC_BITS); raw += Q16_16::ONE / 128) {
+        if (!lut_within_bound(rpm_to_ticks_frac(Q16_16::fromRaw((int32_t)raw)),
+                              rpm_ticks_exact((double)raw / Q16_16::ONE))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(lut_accuracy_holds(), "step period tables exceed their error bound");
+
+#endif // STEP_TABLES_H
@@ -0,0 +1,115 @@
+#ifndef STOP_RAMP_H
+#define STOP_RAMP_H
+
+#include <cstdint>
+#include <cstring>
+
+// ============================
+// Parada con rampa
+// ============================
+
+/**
+ * @brief How a stop brings the motor to standstill. Every caller picks one.
+ */
+enum StopMode : uint8_t {
+    STOP_MODE_GRACEFUL = 0,  ///< Decelerate along the stop ramp, then disable the driver.
+    STOP_MODE_HARD = 1,      ///< Stop the step generator and disable the driver at once.
+    STOP_MODE_COUNT
+};
+
+/** @brief Name of @p mode in the web API; "" if unknown. */
+inline const char *stop_mode_name(uint8_t mode) {
+    static const char *const names[STOP_MODE_COUNT] = {"graceful", "hard"};
+    return mode < STOP_MODE_COUNT ? names[mode] : "";
+}
+
+/** @brief Parses "graceful" or "hard"; false for anything else. */
+inline bool stop_mode_parse(const char *name, StopMode &out) {
+    for (uint8_t m = 0; m < STOP_MODE_COUNT; ++m) {
+        if (name && strcmp(name, stop_mode_name(m)) == 0) {
+            out = (StopMode)m;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Deceleration for a graceful stop from @p speedMilliHz.
+ *
+ * The configured ramp, or a steeper one when the configured ramp would take
+ * longer than @p maxTimeMs: the stop time is v / a, so a >= v / maxTime,
+ * which in mHz and ms is already steps/s^2.
+ */
+inline uint32_t stop_decel_sps2(uint32_t speedMilliHz, uint32_t decelSps2, uint32_t maxTimeMs) {
+    uint32_t bound = maxTimeMs ? (uint32_t)(((uint64_t)speedMilliHz + maxTimeMs - 1) / maxTimeMs) : speedMilliHz;
+    return bound > decelSps2 ? bound : decelSps2;
+}
+
+/** @brief Steps travelled decelerating from @p speedMilliHz at @p decelSps2: v^2 / 2a. */
+inline uint32_t stop_distance_steps(uint32_t speedMilliHz, uint32_t decelSps2) {
+    if (decelSps2 == 0) return UINT32_MAX;
+    double v = speedMilliHz / 1000.0;
+    return (uint32_t)(v * v / (2.0 * decelSps2) + 0.5);
+}
+
+enum StopPoll : uint8_t {
+    STOP_POLL_IDLE,     ///< No stop in progress.
+    STOP_POLL_RAMPING,  ///< Still decelerating.
+    STOP_POLL_DONE,     ///< Reached standstill; outputs disabled now.
+    STOP_POLL_FORCED    ///< Not stopped in time: hard-stopped; outputs disabled now.
+};
+
+/**
+ * @brief Drives one graceful stop of a FastAccelStepper-like motor.
+ *
+ * begin() starts the deceleration; poll(), once per control cycle, disables
+ * the driver when the motor reaches standstill. If it still moves
+ * GRACE_MS after the time the ramp was sized for (the driver ignored the
+ * ramp, or the speed was read wrong), poll() stops it hard so the bound on
+ * the stop time holds whatever happens.
+ */
+class GracefulStop {
+public:
+    static constexpr uint32_t GRACE_MS = 500;
+
+    /**
+     * @param maxTimeMs The stop must take at most this long (see stop_decel_sps2()).
+     */
+    template <typename Stepper>
+    void begin(Stepper &stepper, uint32_t decelSps2, uint32_t maxTimeMs, uint32_t nowMs) {
+        stepper.setAcceleration((int32_t)decelSps2);
+        stepper.applySpeedAcceleration();
+        stepper.stopMove();
+        _active = true;
+        _startMs = nowMs;
+        _deadlineMs = maxTimeMs + GRACE_MS;
+    }
+
+    template <typename Stepper>
+    StopPoll poll(Stepper &stepper, uint32_t nowMs) {
+        if (!_active) return STOP_POLL_IDLE;
+        if (!stepper.isRunning()) {
+            stepper.disableOutputs();
+            _active = false;
+            return STOP_POLL_DONE;
+        }
+        if (nowMs - _startMs < _deadlineMs) return STOP_POLL_RAMPING;
+        stepper.forceStop();
+        stepper.disableOutputs();
+        _active = false;
+        return STOP_POLL_FORCED;
+    }
+
+    /** @brief Forgets the stop (a new setpoint took over, or a hard stop did). */
+    void cancel() { _active = false; }
+
+    bool active() const { return _active; }
+
+private:
+    bool _active = false;
+    uint32_t _startMs = 0;
+    uint32_t _deadlineMs = 0;
+};
+
+#endif // STOP_RAMP_H
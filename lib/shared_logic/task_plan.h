@@ -0,0 +1,140 @@
+#ifndef TASK_PLAN_H
+#define TASK_PLAN_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ============================
+// Plan de tareas
+// ============================
+//
+// Every task of the firmware, with its core, priority and stack, in one
+// table. Core 1 is reserved for time-critical control: the motor loop, the
+// step generator and the boot task that attaches their interrupts there.
+// Networking, UI, logging, scanning and diagnostics run on core 0. The
+// checks below reject at compile time a table that breaks that rule.
+
+constexpr int8_t CONTROL_CORE = 1;
+constexpr int8_t SYSTEM_CORE = 0;
+constexpr int8_t ANY_CORE = -1;  ///< No affinity (tskNO_AFFINITY); only the jitter probe uses it.
+
+enum TaskId : uint8_t {
+    TASK_MOTOR,
+    TASK_STEPPER,       ///< FastAccelStepper's queue task (engine.init(core)).
+    TASK_BOOT_HW,
+    TASK_SUPERVISOR,
+    TASK_UI,
+    TASK_WIFI,
+    TASK_WIFI_SCAN,
+    TASK_ASYNC_TCP,     ///< AsyncTCP's event task (CONFIG_ASYNC_TCP_RUNNING_CORE).
+    TASK_MODBUS,
+    TASK_SETTINGS,
+    TASK_JOURNAL,
+    TASK_MONITOR,
+    TASK_JITTER,        ///< Runs the jitter measurement (the probes use JITTER_PLACEMENTS).
+    TASK_SERIAL,        ///< SCPI console on the USB serial port.
+    TASK_COUNT
+};
+
+enum TaskRole : uint8_t {
+    TASK_ROLE_CONTROL,  ///< Time-critical: core 1.
+    TASK_ROLE_SYSTEM    ///< Everything else: core 0.
+};
+
+/**
+ * @brief Where and how one task runs.
+ */
+struct TaskPlacement {
+    const char *name;     ///< FreeRTOS task name.
+    TaskRole role;
+    int8_t core;
+    uint8_t priority;     ///< 0 for tasks a library creates at its own priority.
+    uint16_t stackBytes;  ///< 0 for tasks a library creates.
+};
+
+constexpr TaskPlacement TASK_PLAN[TASK_COUNT] = {
+    {"motorTask", TASK_ROLE_CONTROL, CONTROL_CORE, 5, 4096},
+    {"StepperTask", TASK_ROLE_CONTROL, CONTROL_CORE, 0, 0},
+    {"bootHw", TASK_ROLE_CONTROL, CONTROL_CORE, 1, 4096},
+    {"supervisor", TASK_ROLE_SYSTEM, SYSTEM_CORE, 3, 3072},  // above the tasks it watches
+    {"uiTask", TASK_ROLE_SYSTEM, SYSTEM_CORE, 1, 4096},
+    {"wifiTask", TASK_ROLE_SYSTEM, SYSTEM_CORE, 1, 4096},
+    {"wifiScanTask", TASK_ROLE_SYSTEM, SYSTEM_CORE, 1, 4096},
+    {"async_tcp", TASK_ROLE_SYSTEM, SYSTEM_CORE, 0, 0},
+    {"modbusTask", TASK_ROLE_SYSTEM, SYSTEM_CORE, 1, 3072},
+    {"settingsTask", TASK_ROLE_SYSTEM, SYSTEM_CORE, 1, 3072},
+    {"journalTask", TASK_ROLE_SYSTEM, SYSTEM_CORE, 1, 3072},
+    {"taskMonitor", TASK_ROLE_SYSTEM, SYSTEM_CORE, 1, 3072},
+    {"jitterRun", TASK_ROLE_SYSTEM, SYSTEM_CORE, 1, 3072},
+    {"serialScpi", TASK_ROLE_SYSTEM, SYSTEM_CORE, 1, 3072},
+};
+
+/**
+ * @brief Whether the table keeps control on core 1 and everything else off it.
+ */
+constexpr bool task_plan_isolated() {
+    for (size_t i = 0; i < TASK_COUNT; ++i) {
+        const TaskPlacement &t = TASK_PLAN[i];
+        int8_t core = t.role == TASK_ROLE_CONTROL ? CONTROL_CORE : SYSTEM_CORE;
+        if (t.core != core) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Whether the control loop outranks every other task we create on its core.
+ */
+constexpr bool task_plan_control_first() {
+    for (size_t i = 0; i < TASK_COUNT; ++i) {
+        if (i != TASK_MOTOR && TASK_PLAN[i].core == CONTROL_CORE && TASK_PLAN[i].priority >= TASK_PLAN[TASK_MOTOR].priority) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(task_plan_isolated(), "TASK_PLAN puts a system task on the control core or the reverse");
+static_assert(task_plan_control_first(), "motorTask must have the highest priority on the control core");
+
+// ============================
+// Ubicaciones del sondeo de jitter
+// ============================
+
+/**
+ * @brief A placement the jitter measurement tries for a control-like periodic task.
+ */
+struct ProbePlacement {
+    const char *label;
+    int8_t core;
+    uint8_t priority;
+};
+
+/**
+ * @brief Where the planned control loop runs, where it would run among the
+ *        network tasks, and where FreeRTOS would put it unpinned.
+ *
+ * The control probe runs one level below motorTask: it sees the same core
+ * and the same interference from below, but never delays the motor.
+ */
+constexpr ProbePlacement JITTER_PLACEMENTS[] = {
+    {"control", CONTROL_CORE, TASK_PLAN[TASK_MOTOR].priority - 1},
+    {"system", SYSTEM_CORE, TASK_PLAN[TASK_WIFI].priority},
+    {"unpinned", ANY_CORE, TASK_PLAN[TASK_WIFI].priority},
+};
+constexpr size_t JITTER_PLACEMENT_COUNT = sizeof(JITTER_PLACEMENTS) / sizeof(JITTER_PLACEMENTS[0]);
+
+/**
+ * @brief Whether every probe that can land on the control core stays below motorTask.
+ */
+constexpr bool jitter_placements_below_control() {
+    for (size_t i = 0; i < JITTER_PLACEMENT_COUNT; ++i) {
+        if (JITTER_PLACEMENTS[i].core != SYSTEM_CORE && JITTER_PLACEMENTS[i].priority >= TASK_PLAN[TASK_MOTOR].priority) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(jitter_placements_below_control(), "a jitter probe would preempt motorTask");
+
+#endif // TASK_PLAN_H
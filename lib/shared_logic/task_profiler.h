@@ -0,0 +1,229 @@
+#ifndef TASK_PROFILER_H
+#define TASK_PROFILER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ============================
+// Perfil de tareas
+// ============================
+
+const int8_t TASK_CORE_ANY = -1;  ///< Task not pinned to a core.
+const size_t TASK_PROFILER_CORES = 2;
+
+/**
+ * @brief State of one task at sampling time, as read from the scheduler.
+ */
+struct TaskSample {
+    char name[16];
+    uint32_t id;              ///< Scheduler task number; stable for the task's life.
+    uint32_t runtime;         ///< Run-time counter (microseconds on the ESP32; wraps).
+    uint32_t stackFreeBytes;  ///< Stack high-water mark: bytes never used so far.
+    uint8_t priority;
+    int8_t core;              ///< 0, 1 or TASK_CORE_ANY.
+};
+
+/**
+ * @brief One task in a report.
+ */
+struct TaskStat {
+    TaskSample sample;
+    float cpuPct;  ///< Share of one core over the window; -1 if run-time stats are off.
+};
+
+/**
+ * @brief Idle time of one core, measured from its idle hook when run-time stats are off.
+ *
+ * The hook calls tick() on every pass of the idle loop. Two passes closer
+ * than the maximum gap mean the core stayed idle in between; a longer gap
+ * means the idle task was preempted and is not counted. Interrupts shorter
+ * than the gap are counted as idle, which bounds the error. Only the core's
+ * idle task calls tick(); any task may read idleCycles().
+ */
+class IdleMeter {
+public:
+    void setMaxGap(uint32_t cycles) { _maxGap = cycles; }
+
+    void tick(uint32_t nowCycles) {
+        uint32_t gap = nowCycles - _last;
+        _last = nowCycles;
+        if (_started && gap <= _maxGap) {
+            _idle.store(_idle.load(std::memory_order_relaxed) + gap, std::memory_order_relaxed);
+        }
+        _started = true;
+    }
+
+    /** @brief Idle cycles so far; wraps, so compare samples less than 2^32 cycles apart. */
+    uint32_t idleCycles() const { return _idle.load(std::memory_order_relaxed); }
+
+private:
+    uint32_t _maxGap = 0;
+    uint32_t _last = 0;
+    bool _started = false;
+    std::atomic<uint32_t> _idle{0};
+};
+
+/**
+ * @brief Idle counters of every core at sampling time (see IdleMeter).
+ */
+struct IdleSample {
+    uint32_t idleCycles[TASK_PROFILER_CORES];
+    uint32_t cyclesPerUs;
+};
+
+/**
+ * @brief Result of comparing two samples.
+ */
+struct TaskReport {
+    std::vector<TaskStat> tasks;         ///< Sorted by CPU, then by name.
+    float coreLoadPct[TASK_PROFILER_CORES];  ///< 100 - idle share (idle task or idle hook); -1 if unknown.
+    uint32_t windowUs = 0;
+    bool runtimeStats = false;
+    bool idleHooks = false;              ///< Core load comes from IdleMeter, not from run-time counters.
+    std::string json;
+    std::string text;
+};
+
+/**
+ * @brief Turns successive scheduler samples into per-task CPU and per-core load.
+ *
+ * Only the sampling task calls update(); reports are immutable and can be
+ * shared with readers (see SnapshotSlot in scan_cache.h).
+ */
+class TaskProfiler {
+public:
+    /**
+     * @param tasks Current tasks.
+     * @param nowUs Time of the sample on the run-time counter clock.
+     * @param runtimeStats false if the scheduler does not keep run-time counters.
+     * @param idle Idle-hook counters; without run-time stats they give the core load. May be null.
+     */
+    std::shared_ptr<TaskReport> update(const TaskSample *tasks, size_t count, uint32_t nowUs, bool runtimeStats,
+                                       const IdleSample *idle = nullptr) {
+        std::shared_ptr<TaskReport> report = std::make_shared<TaskReport>();
+        report->runtimeStats = runtimeStats;
+        report->windowUs = _hasPrevious ? nowUs - _previousUs : 0;
+        for (size_t c = 0; c < TASK_PROFILER_CORES; ++c) report->coreLoadPct[c] = -1.0f;
+
+        if (!runtimeStats && idle) {
+            report->idleHooks = true;
+            if (_hasPreviousIdle && report->windowUs > 0 && idle->cyclesPerUs > 0) {
+                for (size_t c = 0; c < TASK_PROFILER_CORES; ++c) {
+                    float idleUs = (float)(idle->idleCycles[c] - _previousIdle.idleCycles[c]) / idle->cyclesPerUs;
+                    float load = 100.0f - 100.0f * idleUs / (float)report->windowUs;
+                    report->coreLoadPct[c] = load < 0.0f ? 0.0f : load;
+                }
+            }
+            _previousIdle = *idle;
+            _hasPreviousIdle = true;
+        }
+
+        bool haveWindow = runtimeStats && report->windowUs > 0;
+        for (size_t i = 0; i < count; ++i) {
+            TaskStat stat;
+            stat.sample = tasks[i];
+            stat.cpuPct = -1.0f;
+            if (haveWindow) {
+                uint32_t before = previousRuntime(tasks[i].id);
+                float pct = 100.0f * (float)(tasks[i].runtime - before) / (float)report->windowUs;
+                stat.cpuPct = pct > 100.0f ? 100.0f : pct;
+                int8_t core = tasks[i].core;
+                if (strncmp(tasks[i].name, "IDLE", 4) == 0 && core >= 0 && (size_t)core < TASK_PROFILER_CORES) {
+                    report->coreLoadPct[core] = 100.0f - stat.cpuPct;
+                }
+            }
+            report->tasks.push_back(stat);
+        }
+        std::sort(report->tasks.begin(), report->tasks.end(), [](const TaskStat &a, const TaskStat &b) {
+            if (a.cpuPct != b.cpuPct) return a.cpuPct > b.cpuPct;
+            return strcmp(a.sample.name, b.sample.name) < 0;
+        });
+
+        _previous.assign(tasks, tasks + count);
+        _previousUs = nowUs;
+        _hasPrevious = true;
+
+        render_json(*report);
+        render_text(*report);
+        return report;
+    }
+
+    /**
+     * @brief Renders {"window_ms":..,"runtime_stats":..,"idle_hooks":..,"cores":[..],"tasks":[..]}.
+     */
+    static void render_json(TaskReport &r) {
+        char buf[160];
+        std::string &out = r.json;
+        out.clear();
+        snprintf(buf, sizeof(buf), "{\"window_ms\":%lu,\"runtime_stats\":%s,\"idle_hooks\":%s,\"cores\":[",
+                 (unsigned long)(r.windowUs / 1000), r.runtimeStats ? "true" : "false",
+                 r.idleHooks ? "true" : "false");
+        out += buf;
+        for (size_t c = 0; c < TASK_PROFILER_CORES; ++c) {
+            snprintf(buf, sizeof(buf), "%s{\"core\":%u,\"load\":%.1f}", c ? "," : "", (unsigned)c,
+                     (double)r.coreLoadPct[c]);
+            out += buf;
+        }
+        out += "],\"tasks\":[";
+        for (size_t i = 0; i < r.tasks.size(); ++i) {
+            const TaskStat &t = r.tasks[i];
+            out += i ? ",{\"name\":\"" : "{\"name\":\"";
+            for (const char *p = t.sample.name; *p; ++p) {
+                if (*p == '"' || *p == '\\') out += '\\';
+                if ((unsigned char)*p >= 0x20) out += *p;
+            }
+            snprintf(buf, sizeof(buf), "\",\"core\":%d,\"prio\":%u,\"cpu\":%.1f,\"stack_free\":%lu}",
+                     (int)t.sample.core, (unsigned)t.sample.priority, (double)t.cpuPct,
+                     (unsigned long)t.sample.stackFreeBytes);
+            out += buf;
+        }
+        out += "]}";
+    }
+
+    /**
+     * @brief Renders a fixed-width table for the serial console.
+     */
+    static void render_text(TaskReport &r) {
+        char buf[96];
+        std::string &out = r.text;
+        out.clear();
+        snprintf(buf, sizeof(buf), "core0 %5.1f%%  core1 %5.1f%%  window %lu ms\n", (double)r.coreLoadPct[0],
+                 (double)r.coreLoadPct[1], (unsigned long)(r.windowUs / 1000));
+        out += buf;
+        out += "task             core prio   cpu%  stack_free\n";
+        for (const TaskStat &t : r.tasks) {
+            char core[5];
+            if (t.sample.core == TASK_CORE_ANY) {
+                snprintf(core, sizeof(core), "-");
+            } else {
+                snprintf(core, sizeof(core), "%d", (int)t.sample.core);
+            }
+            snprintf(buf, sizeof(buf), "%-16.16s %4s %4u %6.1f %11lu\n", t.sample.name, core,
+                     (unsigned)t.sample.priority, (double)t.cpuPct, (unsigned long)t.sample.stackFreeBytes);
+            out += buf;
+        }
+    }
+
+private:
+    uint32_t previousRuntime(uint32_t id) const {
+        for (const TaskSample &s : _previous) {
+            if (s.id == id) return s.runtime;
+        }
+        return 0;  // new task: everything it ran happened in this window
+    }
+
+    std::vector<TaskSample> _previous;
+    uint32_t _previousUs = 0;
+    bool _hasPrevious = false;
+    IdleSample _previousIdle = {};
+    bool _hasPreviousIdle = false;
+};
+
+#endif // TASK_PROFILER_H
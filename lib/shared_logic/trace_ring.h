@@ -0,0 +1,297 @@
+#ifndef TRACE_RING_H
+#define TRACE_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "motor_state.h"
+
+// ============================
+// Anillo de eventos de traza
+// ============================
+
+enum TracePhase : uint8_t {
+    TRACE_PHASE_BEGIN = 'B',
+    TRACE_PHASE_END = 'E',
+    TRACE_PHASE_INSTANT = 'i'
+};
+
+/**
+ * @brief One decoded trace event.
+ */
+struct TraceEvent {
+    uint32_t cycles;   ///< CPU cycle counter of the core that wrote it (wraps).
+    const char *name;  ///< String literal; never copied.
+    uint32_t tid;      ///< Writer identity (task handle on the device).
+    uint32_t arg;      ///< Free-form value shown in the viewer.
+    uint8_t phase;     ///< TracePhase.
+};
+
+/**
+ * @brief Cycle counter / wall clock pair used to place a core's events in time.
+ */
+struct TraceClockSync {
+    uint32_t cycles;
+    uint32_t pad;
+    uint64_t us;
+};
+
+/**
+ * @brief Per-core lock-free ring buffers of trace events.
+ *
+ * Any task or ISR may record: a slot is claimed with one atomic increment on
+ * its core's ring and then stamped with a per-slot sequence, so readers can
+ * tell a complete event from one that is being (over)written. Old events are
+ * overwritten; nothing ever blocks. When disabled, record() is a single
+ * relaxed load.
+ *
+ * @tparam CORES Number of rings (one per CPU core).
+ * @tparam SIZE Events per ring; must be a power of two.
+ */
+template <size_t CORES, size_t SIZE>
+class TraceBuffer {
+    static_assert((SIZE & (SIZE - 1)) == 0, "TraceBuffer size must be a power of two");
+
+public:
+    static constexpr size_t cores() { return CORES; }
+    static constexpr size_t capacity() { return SIZE; }
+
+    void setEnabled(bool enabled) { _enabled.store(enabled, std::memory_order_relaxed); }
+
+    bool enabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+    void record(size_t core, uint32_t cycles, uint8_t phase, const char *name, uint32_t tid, uint32_t arg) {
+        if (!enabled() || core >= CORES) return;
+        Ring &ring = _rings[core];
+        uint32_t index = ring.head.fetch_add(1, std::memory_order_relaxed);
+        Slot &slot = ring.slots[index & (SIZE - 1)];
+        slot.seq.store(index * 2 + 1, std::memory_order_relaxed);  // odd: being written
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.cycles.store(cycles, std::memory_order_relaxed);
+        slot.name.store((uintptr_t)name, std::memory_order_relaxed);
+        slot.tid.store(tid, std::memory_order_relaxed);
+        slot.arg.store(arg, std::memory_order_relaxed);
+        slot.phase.store(phase, std::memory_order_relaxed);
+        slot.seq.store(index * 2 + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Records a clock reference for @p core; called from a task on that core.
+     */
+    void sync(size_t core, uint32_t cycles, uint64_t us) {
+        if (core >= CORES) return;
+        TraceClockSync s = {cycles, 0, us};
+        _rings[core].sync.publish(s);
+        _rings[core].synced.store(true, std::memory_order_release);
+    }
+
+    /** @return false if @p core never synced. */
+    bool readSync(size_t core, TraceClockSync &out) const {
+        return core < CORES && _rings[core].synced.load(std::memory_order_acquire) && _rings[core].sync.read(out);
+    }
+
+    /** @brief Index one past the newest event claimed on @p core. */
+    uint32_t head(size_t core) const { return _rings[core].head.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Reads event @p index of @p core.
+     *
+     * @return false if the event was never written completely, was
+     *         overwritten, or is being written right now.
+     */
+    bool read(size_t core, uint32_t index, TraceEvent &out) const {
+        const Slot &slot = _rings[core].slots[index & (SIZE - 1)];
+        uint32_t expected = index * 2 + 2;
+        if (slot.seq.load(std::memory_order_acquire) != expected) return false;
+        out.cycles = slot.cycles.load(std::memory_order_relaxed);
+        out.name = (const char *)slot.name.load(std::memory_order_relaxed);
+        out.tid = slot.tid.load(std::memory_order_relaxed);
+        out.arg = slot.arg.load(std::memory_order_relaxed);
+        out.phase = slot.phase.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.seq.load(std::memory_order_relaxed) == expected;
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> seq{0};
+        std::atomic<uint32_t> cycles{0};
+        std::atomic<uintptr_t> name{0};
+        std::atomic<uint32_t> tid{0};
+        std::atomic<uint32_t> arg{0};
+        std::atomic<uint8_t> phase{0};
+    };
+
+    struct Ring {
+        std::atomic<uint32_t> head{0};
+        std::atomic<bool> synced{false};
+        SeqLock<TraceClockSync> sync;
+        Slot slots[SIZE];
+    };
+
+    std::atomic<bool> _enabled{false};
+    Ring _rings[CORES];
+};
+
+// ============================
+// Exportación Chrome trace
+// ============================
+
+/**
+ * @brief Streams the rings as Chrome trace JSON ({"traceEvents":[...]}), loadable in Perfetto.
+ *
+ * Each ring is walked from its newest event backwards. The newest event is
+ * placed with the core's clock reference and every older one relative to
+ * its successor, so the 32-bit cycle counter may wrap any number of times
+ * as long as consecutive events on a core are less than 2^31 cycles apart.
+ * Events written after the export started, or overwritten during it, are
+ * skipped. Thread-name metadata is appended for every writer seen.
+ */
+template <size_t CORES, size_t SIZE>
+class ChromeTraceStream {
+public:
+    static constexpr size_t MAX_THREADS = 24;
+
+    /**
+     * @param cyclesPerUs Cycle counter rate (CPU MHz).
+     * @param threadName Returns a display name for a tid, or NULL.
+     */
+    ChromeTraceStream(const TraceBuffer<CORES, SIZE> &buffer, uint32_t cyclesPerUs,
+                      const char *(*threadName)(uint32_t tid))
+        : _buffer(buffer), _cyclesPerUs(cyclesPerUs ? cyclesPerUs : 1), _threadName(threadName) {
+        for (size_t c = 0; c < CORES; ++c) {
+            _next[c] = buffer.head(c);
+            _stop[c] = _next[c] > SIZE ? _next[c] - SIZE : 0;
+            _haveSync[c] = buffer.readSync(c, _sync[c]);
+            _havePrev[c] = false;
+        }
+    }
+
+    /**
+     * @brief Copies the next bytes of the JSON document into @p out.
+     *
+     * @return Bytes written; 0 once the document is complete.
+     */
+    size_t fill(uint8_t *out, size_t len) {
+        size_t used = 0;
+        while (used < len) {
+            if (_linePos == _lineLen) {
+                if (!nextLine()) break;
+                _linePos = 0;
+            }
+            size_t n = _lineLen - _linePos;
+            if (n > len - used) n = len - used;
+            memcpy(out + used, _line + _linePos, n);
+            _linePos += n;
+            used += n;
+        }
+        return used;
+    }
+
+private:
+    enum Stage { HEADER, EVENTS, THREADS, FOOTER, DONE };
+
+    bool nextLine() {
+        switch (_stage) {
+            case HEADER:
+                _stage = EVENTS;
+                return format("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+            case EVENTS:
+                while (_core < CORES) {
+                    if (!_haveSync[_core] || _next[_core] == _stop[_core]) {
+                        _core++;
+                        continue;
+                    }
+                    uint32_t index = --_next[_core];
+                    TraceEvent ev;
+                    if (!_buffer.read(_core, index, ev)) continue;
+                    return formatEvent(_core, ev);
+                }
+                _stage = THREADS;
+                /* fall through */
+            case THREADS:
+                while (_threadPos < _threadCount) {
+                    uint32_t tid = _threads[_threadPos++];
+                    const char *name = _threadName ? _threadName(tid) : nullptr;
+                    if (!name) continue;
+                    return format("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,"
+                                  "\"args\":{\"name\":\"%s\"}}",
+                                  sep(), (unsigned long)tid, name);
+                }
+                _stage = FOOTER;
+                /* fall through */
+            case FOOTER:
+                _stage = DONE;
+                return format("]}\n");
+            case DONE:
+                break;
+        }
+        return false;
+    }
+
+    bool formatEvent(size_t core, const TraceEvent &ev) {
+        double ts;
+        if (!_havePrev[core]) {
+            ts = (double)_sync[core].us + (double)(int32_t)(ev.cycles - _sync[core].cycles) / _cyclesPerUs;
+        } else {
+            ts = _prevTs[core] - (double)(int32_t)(_prevCycles[core] - ev.cycles) / _cyclesPerUs;
+        }
+        _havePrev[core] = true;
+        _prevTs[core] = ts;
+        _prevCycles[core] = ev.cycles;
+        rememberThread(ev.tid);
+        const char *scope = ev.phase == TRACE_PHASE_INSTANT ? ",\"s\":\"t\"" : "";
+        return format("%s{\"name\":\"%s\",\"ph\":\"%c\"%s,\"ts\":%.3f,\"pid\":1,\"tid\":%lu,"
+                      "\"args\":{\"core\":%u,\"arg\":%lu}}",
+                      sep(), ev.name ? ev.name : "?", (char)ev.phase, scope, ts, (unsigned long)ev.tid,
+                      (unsigned)core, (unsigned long)ev.arg);
+    }
+
+    void rememberThread(uint32_t tid) {
+        for (size_t i = 0; i < _threadCount; ++i) {
+            if (_threads[i] == tid) return;
+        }
+        if (_threadCount < MAX_THREADS) _threads[_threadCount++] = tid;
+    }
+
+    const char *sep() {
+        const char *s = _first ? "" : ",\n";
+        _first = false;
+        return s;
+    }
+
+    template <typename... Args>
+    bool format(const char *fmt, Args... args) {
+        int n = snprintf(_line, sizeof(_line), fmt, args...);
+        if (n < 0) n = 0;
+        _lineLen = (size_t)n < sizeof(_line) ? (size_t)n : sizeof(_line) - 1;
+        return true;
+    }
+
+    const TraceBuffer<CORES, SIZE> &_buffer;
+    double _cyclesPerUs;
+    const char *(*_threadName)(uint32_t);
+
+    Stage _stage = HEADER;
+    size_t _core = 0;
+    uint32_t _next[CORES];
+    uint32_t _stop[CORES];
+    TraceClockSync _sync[CORES];
+    bool _haveSync[CORES];
+    bool _havePrev[CORES];
+    double _prevTs[CORES];
+    uint32_t _prevCycles[CORES];
+    uint32_t _threads[MAX_THREADS];
+    size_t _threadCount = 0;
+    size_t _threadPos = 0;
+    bool _first = true;
+
+    char _line[224];
+    size_t _lineLen = 0;
+    size_t _linePos = 0;
+};
+
+#endif // TRACE_RING_H
@@ -0,0 +1,176 @@
+#ifndef WIFI_RECONNECT_H
+#define WIFI_RECONNECT_H
+
+#include <cstdint>
+
+// ============================
+// Espera exponencial con jitter
+// ============================
+
+/**
+ * @brief Exponential backoff with "equal jitter".
+ *
+ * The n-th delay is uniformly distributed in [d/2, d] where
+ * d = min(base * 2^n, max). Randomness is injected by the caller so the
+ * sequence is reproducible in native tests (esp_random() on the device).
+ */
+class ExponentialBackoff {
+public:
+    ExponentialBackoff(uint32_t baseMs = 500, uint32_t maxMs = 60000)
+        : _baseMs(baseMs), _maxMs(maxMs) {}
+
+    void configure(uint32_t baseMs, uint32_t maxMs) {
+        _baseMs = baseMs;
+        _maxMs = maxMs;
+        reset();
+    }
+
+    /**
+     * @brief Returns the next delay and advances the attempt counter.
+     *
+     * @param entropy Random 32-bit value.
+     * @return Delay in milliseconds.
+     */
+    uint32_t next(uint32_t entropy) {
+        uint32_t ceiling = _maxMs;
+        if (_attempts < 31 && (_baseMs <= (_maxMs >> _attempts))) {
+            ceiling = _baseMs << _attempts;
+        }
+        _attempts++;
+        uint32_t half = ceiling / 2;
+        return half + (entropy % (ceiling - half + 1));
+    }
+
+    void reset() { _attempts = 0; }
+
+    uint32_t attempts() const { return _attempts; }
+
+private:
+    uint32_t _baseMs;
+    uint32_t _maxMs;
+    uint32_t _attempts = 0;
+};
+
+// ============================
+// Máquina de estados de reconexión
+// ============================
+
+/**
+ * @brief What the owner of the radio must do after a poll.
+ */
+enum ReconnectAction {
+    RECONNECT_NONE,      ///< Nothing to do.
+    RECONNECT_FAST,      ///< Connect using the cached BSSID and channel.
+    RECONNECT_FULL_SCAN  ///< Connect by SSID, letting the driver scan all channels.
+};
+
+/**
+ * @brief Station reconnect policy, independent of the WiFi driver.
+ *
+ * Owned by a single task: WiFi events are forwarded to it and poll() is
+ * called periodically. Fast connects (known BSSID/channel) are tried first;
+ * after FAST_ATTEMPTS_BEFORE_SCAN consecutive failures the policy falls back
+ * to a full scan, in case the access point moved to another channel.
+ */
+class ReconnectStateMachine {
+public:
+    enum State {
+        IDLE,        ///< Not trying to connect (offline or no credentials).
+        CONNECTED,   ///< Associated and with an IP address.
+        BACKOFF,     ///< Waiting for the next attempt.
+        CONNECTING   ///< An attempt is in progress.
+    };
+
+    static constexpr uint8_t FAST_ATTEMPTS_BEFORE_SCAN = 2;
+
+    void configure(uint32_t baseMs, uint32_t maxMs, uint32_t attemptTimeoutMs) {
+        _backoff.configure(baseMs, maxMs);
+        _attemptTimeoutMs = attemptTimeoutMs;
+    }
+
+    /**
+     * @brief Enables or disables reconnection (e.g. the user went offline).
+     */
+    void setEnabled(bool enabled) {
+        _enabled = enabled;
+        if (!enabled && _state != CONNECTED) _state = IDLE;
+    }
+
+    void setFastConnectAvailable(bool available) { _fastAvailable = available; }
+
+    /**
+     * @brief Starts connecting right away, forgetting previous failures.
+     */
+    void connectNow(uint32_t nowMs) {
+        _backoff.reset();
+        _fastFailures = 0;
+        _state = BACKOFF;
+        _dueMs = nowMs;
+    }
+
+    void onConnected() {
+        _state = CONNECTED;
+        _backoff.reset();
+        _fastFailures = 0;
+    }
+
+    /**
+     * @brief Handles a station disconnect (link lost or attempt rejected).
+     */
+    void onDisconnected(uint32_t nowMs, uint32_t entropy) {
+        if (_state == CONNECTED) {
+            // First retry after losing the link is immediate.
+            connectNow(nowMs);
+        } else if (_state == CONNECTING) {
+            fail(nowMs, entropy);
+        }
+    }
+
+    /**
+     * @brief Advances timers and tells the caller whether to start an attempt.
+     */
+    ReconnectAction poll(uint32_t nowMs, uint32_t entropy) {
+        if (!_enabled) return RECONNECT_NONE;
+        if (_state == CONNECTING && (nowMs - _attemptStartMs) >= _attemptTimeoutMs) {
+            fail(nowMs, entropy);
+        }
+        if (_state == BACKOFF && (int32_t)(nowMs - _dueMs) >= 0) {
+            _state = CONNECTING;
+            _attemptStartMs = nowMs;
+            _attempts++;
+            _lastAction = (_fastAvailable && _fastFailures < FAST_ATTEMPTS_BEFORE_SCAN)
+                              ? RECONNECT_FAST
+                              : RECONNECT_FULL_SCAN;
+            return _lastAction;
+        }
+        return RECONNECT_NONE;
+    }
+
+    State state() const { return _state; }
+
+    /** @brief Total connection attempts started. */
+    uint32_t attempts() const { return _attempts; }
+
+    /** @brief Time at which the next attempt is due (valid in BACKOFF). */
+    uint32_t dueMs() const { return _dueMs; }
+
+private:
+    void fail(uint32_t nowMs, uint32_t entropy) {
+        if (_lastAction == RECONNECT_FAST) _fastFailures++;
+        _state = BACKOFF;
+        _dueMs = nowMs + _backoff.next(entropy);
+    }
+
+    ExponentialBackoff _backoff;
+    State _state = IDLE;
+    ReconnectAction _lastAction = RECONNECT_NONE;
+    bool _enabled = true;
+    bool _fastAvailable = false;
+    uint8_t _fastFailures = 0;
+    uint32_t _attemptTimeoutMs = 10000;
+    uint32_t _attemptStartMs = 0;
+    uint32_t _dueMs = 0;
+    uint32_t _attempts = 0;
+};
+
+#endif // WIFI_RECONNECT_H
@@ -0,0 +1,144 @@
+#include "supervisor.h"
+#include "motor_control.h"
+#include "trace.h"
+#include "task_monitor.h"
+#include <esp_system.h>
+#include <esp_task_wdt.h>
+#include <atomic>
+
+// ============================
+// Plazos por tarea
+// ============================
+struct SupervisedSpec {
+  const char* name;
+  uint32_t deadlineMs;
+  bool critical;
+};
+
+static const SupervisedSpec SPECS[SUPERVISED_COUNT] = {
+  {"motorTask", 250, true},    // 50 ms cycle
+  {"uiTask", 1000, false},     // 20 ms cycle
+  {"wifiTask", 2000, false},   // 100 ms queue poll
+  {"modbusTask", 1000, false}, // 10 ms event wait
+};
+
+static DeadlineSupervisor<SUPERVISED_COUNT> g_deadlines;
+static std::atomic<int> g_handles[SUPERVISED_COUNT]; // handle + 1; 0 = not registered yet
+static std::atomic<bool> g_twdtExpired{false};
+
+/**
+ * @brief Returns the supervisor handle of a task, or INVALID.
+ */
+static int handle_of(SupervisedTask task) {
+  return g_handles[task].load(std::memory_order_acquire) - 1;
+}
+
+/**
+ * @brief Called from the TWDT interrupt when the core configured it without panic.
+ *
+ * Overrides the ESP-IDF weak handler; supervisor_task() restarts the board
+ * if the expired task is the control task.
+ */
+extern "C" void esp_task_wdt_isr_user_handler(void) {
+  g_twdtExpired.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Starts the supervisor task.
+ *
+ * The ESP-IDF task watchdog keeps the timeout and panic setting the Arduino
+ * core gave it; the critical task only subscribes to it.
+ */
+void supervisor_setup() {
+  task_start(TASK_SUPERVISOR, supervisor_task);
+}
+
+/**
+ * @brief Registers the calling task and subscribes it to the TWDT if it is critical.
+ */
+void supervisor_register(SupervisedTask task) {
+  const SupervisedSpec& spec = SPECS[task];
+  int id = g_deadlines.add(spec.name, spec.deadlineMs, spec.critical, millis());
+  g_handles[task].store(id + 1, std::memory_order_release);
+  if (spec.critical) {
+    esp_err_t err = esp_task_wdt_add(NULL);
+    if (err != ESP_OK) Serial.printf("[wdt] %s not on the task watchdog: %d\n", spec.name, (int)err);
+  }
+}
+
+/**
+ * @brief Marks the end of one cycle of the calling task.
+ */
+void supervisor_check_in(SupervisedTask task) {
+  g_deadlines.checkIn(handle_of(task), millis());
+  if (SPECS[task].critical) esp_task_wdt_reset();
+}
+
+/**
+ * @brief Deadline misses of a task since boot.
+ */
+uint32_t supervisor_misses(SupervisedTask task) {
+  return g_deadlines.misses(handle_of(task));
+}
+
+/**
+ * @brief Checks the deadlines, logs misses and stops the motor if the control task stalls.
+ *
+ * The stop comes first and does not depend on motor_task. If the control
+ * task is still silent CONTROL_STALL_RESTART_S later, or the TWDT expired
+ * while it was stalled, the board restarts; the journal does not resume a
+ * run after a software restart. A TWDT set to panic resets the board by
+ * itself, even if this task hangs too.
+ */
+void supervisor_task(void *parameter) {
+  uint32_t reported[SUPERVISED_COUNT] = {0};
+  bool wasStalled[SUPERVISED_COUNT] = {false};
+  while (true) {
+    vTaskDelay(pdMS_TO_TICKS(SUPERVISOR_PERIOD_MS));
+    uint32_t now = millis();
+    int stalled[SUPERVISED_COUNT];
+    size_t n = g_deadlines.poll(now, stalled, SUPERVISED_COUNT);
+    // The TWDT interrupt repeats every timeout while a task stays unfed.
+    bool twdtFired = g_twdtExpired.exchange(false, std::memory_order_relaxed);
+
+    for (int t = 0; t < SUPERVISED_COUNT; ++t) {
+      int id = handle_of((SupervisedTask)t);
+      if (id < 0) continue;
+      for (size_t i = 0; i < n; ++i) {
+        if (stalled[i] != id) continue;
+        reported[t]++;
+        TRACE_INSTANT("deadline_miss", t);
+        Serial.printf("[wdt] %s silent for %lu ms (deadline %lu ms)\n", SPECS[t].name,
+                      (unsigned long)g_deadlines.silenceMs(id, now), (unsigned long)SPECS[t].deadlineMs);
+        if (SPECS[t].critical) {
+          motor_safe_stop();
+          Serial.print("[wdt] control task stalled: motor stopped\n");
+        }
+      }
+
+      // Overruns that ended before this poll could see them.
+      uint32_t misses = g_deadlines.misses(id);
+      if (misses > reported[t]) {
+        TRACE_INSTANT("deadline_miss", t);
+        Serial.printf("[wdt] %s overran its %lu ms deadline (longest cycle %lu ms)\n", SPECS[t].name,
+                      (unsigned long)SPECS[t].deadlineMs, (unsigned long)g_deadlines.worstGapMs(id));
+        reported[t] = misses;
+      }
+
+      bool isStalled = g_deadlines.stalled(id);
+      bool twdtExpired = isStalled && twdtFired;
+      if (isStalled && SPECS[t].critical && CONTROL_STALL_RESTART_S > 0 &&
+          (twdtExpired ||
+           g_deadlines.silenceMs(id, now) >= SPECS[t].deadlineMs + CONTROL_STALL_RESTART_S * 1000u)) {
+        Serial.printf("[wdt] %s still silent after the safe stop (%s): restarting\n", SPECS[t].name,
+                      twdtExpired ? "task watchdog" : "supervisor");
+        Serial.flush();
+        esp_restart();
+      }
+      if (wasStalled[t] && !isStalled) {
+        Serial.printf("[wdt] %s resumed\n", SPECS[t].name);
+      }
+      wasStalled[t] = isStalled;
+    }
+  }
+}
@@ -0,0 +1,68 @@
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+#include "config.h"
+#include <Arduino.h>
+#include "deadline_supervisor.h"
+
+/**
+ * @file supervisor.h
+ * @brief Supervisión de plazos de las tareas y watchdog de tareas (TWDT) del lazo de control.
+ *
+ * Cada tarea periódica se registra al arrancar con su plazo y llama a
+ * `supervisor_check_in` en cada ciclo. La tarea del supervisor comprueba los
+ * plazos cada `SUPERVISOR_PERIOD_MS`: cuenta y registra por serie cada plazo
+ * incumplido con el nombre de la tarea y, si la que se detiene es la de
+ * control (`motor_task`), lleva el motor a una parada segura.
+ *
+ * `motor_task` además se suscribe al watchdog de tareas (TWDT) del ESP-IDF,
+ * con el plazo y el modo que le da el núcleo de Arduino. Si la tarea de
+ * control sigue sin dar señales `CONTROL_STALL_RESTART_S` después, o el TWDT
+ * vence mientras está detenida, el supervisor reinicia el equipo con
+ * `esp_restart()`; un TWDT configurado con pánico reinicia por sí solo.
+ */
+
+/**
+ * @brief Tareas supervisadas. El plazo de cada una está en `supervisor.cpp`.
+ */
+enum SupervisedTask {
+  SUPERVISED_MOTOR,   ///< `motor_task`; crítica.
+  SUPERVISED_UI,      ///< `ui_task`.
+  SUPERVISED_WIFI,    ///< `wifi_task`.
+  SUPERVISED_MODBUS,  ///< `modbus_task`.
+  SUPERVISED_COUNT
+};
+
+/**
+ * @brief Periodo de comprobación del supervisor.
+ */
+const uint32_t SUPERVISOR_PERIOD_MS = 50;
+
+/**
+ * @brief Crea la tarea del supervisor.
+ */
+void supervisor_setup();
+
+/**
+ * @brief Registra la tarea llamante; llamar una vez, al principio de la tarea.
+ */
+void supervisor_register(SupervisedTask task);
+
+/**
+ * @brief Señal de vida de la tarea llamante; llamar una vez por ciclo.
+ */
+void supervisor_check_in(SupervisedTask task);
+
+/**
+ * @brief Plazos incumplidos por una tarea desde el arranque.
+ */
+uint32_t supervisor_misses(SupervisedTask task);
+
+/**
+ * @brief Tarea de FreeRTOS del supervisor.
+ *
+ * @param parameter Puntero a los parámetros de la tarea (no se usa).
+ */
+void supervisor_task(void *parameter);
+
+#endif // SUPERVISOR_H
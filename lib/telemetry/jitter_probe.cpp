@@ -0,0 +1,104 @@
+#include "jitter_probe.h"
+#include "scan_cache.h"
+#include "serial_console.h"
+#include "task_monitor.h"
+#include <atomic>
+#include <esp_timer.h>
+
+// ============================
+// Sondeo
+// ============================
+static SnapshotSlot<JitterReport> g_jitterReport;
+static std::atomic<bool> g_jitterRunning{false};
+
+/**
+ * @brief What one probe task measures and whom it tells when done.
+ */
+struct ProbeRun {
+  uint32_t seconds;
+  TaskHandle_t runner;
+  JitterStats stats;
+};
+
+/**
+ * @brief Periodic task that records how far each wake-up period is from nominal.
+ */
+static void jitter_probe_task(void *parameter) {
+  ProbeRun *run = static_cast<ProbeRun *>(parameter);
+  const int64_t periodUs = (int64_t)JITTER_PROBE_PERIOD_MS * 1000;
+  const int64_t endUs = esp_timer_get_time() + (int64_t)run->seconds * 1000000;
+  TickType_t lastWake = xTaskGetTickCount();
+  vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(JITTER_PROBE_PERIOD_MS)); // align with the tick first
+  int64_t previous = esp_timer_get_time();
+  while (previous < endUs) {
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(JITTER_PROBE_PERIOD_MS));
+    int64_t now = esp_timer_get_time();
+    int64_t error = now - previous - periodUs;
+    run->stats.add((uint32_t)(error < 0 ? -error : error));
+    previous = now;
+  }
+  xTaskNotifyGive(run->runner);
+  vTaskDelete(NULL);
+}
+
+/**
+ * @brief Publishes a copy of @p report with its JSON and text rendered.
+ */
+static std::shared_ptr<JitterReport> publish(const JitterReport &report) {
+  std::shared_ptr<JitterReport> snap = std::make_shared<JitterReport>(report);
+  jitter_render_json(*snap);
+  jitter_render_text(*snap);
+  g_jitterReport.publish(snap);
+  return snap;
+}
+
+/**
+ * @brief Runs the probe in every placement, one after the other.
+ */
+void jitter_run_task(void *parameter) {
+  JitterReport report;
+  report.running = true;
+  report.periodMs = JITTER_PROBE_PERIOD_MS;
+  report.secondsPerPlacement = (uint32_t)(uintptr_t)parameter;
+  publish(report);
+
+  for (size_t i = 0; i < JITTER_PLACEMENT_COUNT; ++i) {
+    const ProbePlacement &p = JITTER_PLACEMENTS[i];
+    ProbeRun run = {report.secondsPerPlacement, xTaskGetCurrentTaskHandle(), JitterStats()};
+    BaseType_t core = p.core == ANY_CORE ? tskNO_AFFINITY : (BaseType_t)p.core;
+    if (xTaskCreatePinnedToCore(jitter_probe_task, "jitterProbe", 2048, &run, p.priority, NULL, core) != pdPASS) {
+      Serial.printf("[jitter] could not start the %s probe\n", p.label);
+      continue;
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    report.results.push_back({p, run.stats});
+    publish(report);
+  }
+
+  report.running = false;
+  std::shared_ptr<JitterReport> done = publish(report);
+  serial_log("jitter", done->text.c_str());
+  g_jitterRunning.store(false);
+  vTaskDelete(NULL);
+}
+
+/**
+ * @brief Starts a measurement unless one is running.
+ */
+bool jitter_probe_start(uint32_t seconds) {
+  if (seconds < 1 || seconds > JITTER_PROBE_MAX_SECONDS) return false;
+  bool expected = false;
+  if (!g_jitterRunning.compare_exchange_strong(expected, true)) return false;
+  if (!task_start(TASK_JITTER, jitter_run_task, (void *)(uintptr_t)seconds)) {
+    g_jitterRunning.store(false);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Returns the latest published report.
+ */
+std::shared_ptr<const JitterReport> jitter_probe_report() {
+  return g_jitterReport.get();
+}
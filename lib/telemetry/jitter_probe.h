@@ -0,0 +1,48 @@
+#ifndef JITTER_PROBE_H
+#define JITTER_PROBE_H
+
+#include "config.h"
+#include <Arduino.h>
+#include <memory>
+#include "jitter_stats.h"
+
+/**
+ * @file jitter_probe.h
+ * @brief Medida en el equipo del jitter de una tarea periódica según dónde corre.
+ *
+ * Una tarea de sondeo con el periodo `JITTER_PROBE_PERIOD_MS` (el de una
+ * tarea de control) despierta con `vTaskDelayUntil` y anota cuánto se desvía
+ * cada periodo real del nominal. Se prueba en cada ubicación de
+ * `JITTER_PLACEMENTS`: en el núcleo de control (un nivel por debajo de
+ * `motor_task`, para no retrasarla), en el núcleo del sistema con
+ * la prioridad de la red y sin afinidad. Lanzada mientras `bioshaker_jitter`
+ * carga el servidor HTTP, muestra lo que la separación de núcleos de
+ * `TASK_PLAN` protege al lazo de control. `/debug/jitter?run=N` la inicia y
+ * `/debug/jitter` devuelve el último informe.
+ */
+
+/**
+ * @brief Duración máxima de cada ubicación.
+ */
+const uint32_t JITTER_PROBE_MAX_SECONDS = 60;
+
+/**
+ * @brief Inicia una medida de @p seconds segundos por ubicación.
+ *
+ * @return `false` si ya hay una en curso o @p seconds no está en 1..`JITTER_PROBE_MAX_SECONDS`.
+ */
+bool jitter_probe_start(uint32_t seconds);
+
+/**
+ * @brief Último informe publicado (`nullptr` si nunca se ha medido).
+ */
+std::shared_ptr<const JitterReport> jitter_probe_report();
+
+/**
+ * @brief Tarea de FreeRTOS que recorre las ubicaciones.
+ *
+ * @param parameter Segundos por ubicación, como `uintptr_t`.
+ */
+void jitter_run_task(void *parameter);
+
+#endif // JITTER_PROBE_H
@@ -0,0 +1,114 @@
+#include "task_monitor.h"
+#include "scan_cache.h"
+#include "serial_console.h"
+#include <esp_freertos_hooks.h>
+#include <esp_timer.h>
+
+// ============================
+// Muestreo
+// ============================
+const size_t TASK_MONITOR_MAX_TASKS = 32;
+// Idle-loop passes further apart than this mean the idle task was preempted.
+const uint32_t IDLE_GAP_MAX_US = 5;
+
+static TaskProfiler g_profiler;
+static SnapshotSlot<TaskReport> g_taskReport;
+static TaskStatus_t g_taskStatus[TASK_MONITOR_MAX_TASKS];
+static TaskSample g_taskSamples[TASK_MONITOR_MAX_TASKS];
+static IdleMeter g_idleMeters[TASK_PROFILER_CORES];
+
+/**
+ * @brief Idle hook: counts the time the core spends in its idle loop.
+ *
+ * Returning false keeps the idle task spinning instead of waiting for an
+ * interrupt, so every idle stretch is seen. The cycle counter is per core.
+ */
+static bool idle_hook() {
+  g_idleMeters[xPortGetCoreID()].tick(ESP.getCycleCount());
+  return false;
+}
+
+/**
+ * @brief Creates a task where TASK_PLAN puts it.
+ */
+bool task_start(TaskId id, TaskFunction_t fn, void *parameter, TaskHandle_t *handle) {
+  const TaskPlacement &p = TASK_PLAN[id];
+  BaseType_t core = p.core == ANY_CORE ? tskNO_AFFINITY : (BaseType_t)p.core;
+  if (xTaskCreatePinnedToCore(fn, p.name, p.stackBytes, parameter, p.priority, handle, core) != pdPASS) {
+    Serial.printf("[tasks] could not create %s\n", p.name);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Starts the profiler task.
+ */
+void task_monitor_setup() {
+#if !configGENERATE_RUN_TIME_STATS
+  // Stock arduino-esp32 has no run-time counters: measure core load from the idle loops.
+  for (int c = 0; c < (int)TASK_PROFILER_CORES; ++c) {
+    g_idleMeters[c].setMaxGap(IDLE_GAP_MAX_US * getCpuFrequencyMhz());
+    esp_register_freertos_idle_hook_for_cpu(idle_hook, c);
+  }
+#endif
+  task_start(TASK_MONITOR, task_monitor_task);
+}
+
+/**
+ * @brief Returns the latest published report.
+ */
+std::shared_ptr<const TaskReport> task_monitor_report() {
+  return g_taskReport.get();
+}
+
+/**
+ * @brief Reads the scheduler state into g_taskSamples.
+ *
+ * @param nowUs Set to the run-time counter clock at sampling time.
+ * @return Number of tasks sampled.
+ */
+static size_t sample_tasks(uint32_t *nowUs) {
+  uint32_t totalRunTime = 0;
+  UBaseType_t n = uxTaskGetSystemState(g_taskStatus, TASK_MONITOR_MAX_TASKS, &totalRunTime);
+#if configGENERATE_RUN_TIME_STATS
+  *nowUs = totalRunTime;
+#else
+  *nowUs = (uint32_t)esp_timer_get_time();
+#endif
+  for (UBaseType_t i = 0; i < n; ++i) {
+    const TaskStatus_t &st = g_taskStatus[i];
+    TaskSample &s = g_taskSamples[i];
+    strlcpy(s.name, st.pcTaskName, sizeof(s.name));
+    s.id = st.xTaskNumber;
+    s.runtime = st.ulRunTimeCounter;
+    s.stackFreeBytes = st.usStackHighWaterMark; // bytes: StackType_t is uint8_t on the ESP32
+    s.priority = (uint8_t)st.uxCurrentPriority;
+    BaseType_t affinity = xTaskGetAffinity(st.xHandle);
+    s.core = (affinity == tskNO_AFFINITY) ? TASK_CORE_ANY : (int8_t)affinity;
+  }
+  return n;
+}
+
+/**
+ * @brief Samples all tasks periodically and publishes the report.
+ */
+void task_monitor_task(void *parameter) {
+  uint32_t lastSerialMs = millis();
+  while (true) {
+    uint32_t nowUs = 0;
+    size_t n = sample_tasks(&nowUs);
+    IdleSample idle;
+    for (size_t c = 0; c < TASK_PROFILER_CORES; ++c) idle.idleCycles[c] = g_idleMeters[c].idleCycles();
+    idle.cyclesPerUs = getCpuFrequencyMhz();
+    std::shared_ptr<TaskReport> report =
+        g_profiler.update(g_taskSamples, n, nowUs, configGENERATE_RUN_TIME_STATS != 0, &idle);
+    g_taskReport.publish(report);
+
+    if (TASK_PROFILER_SERIAL_PERIOD_MS > 0 && millis() - lastSerialMs >= TASK_PROFILER_SERIAL_PERIOD_MS) {
+      lastSerialMs = millis();
+      serial_log("tasks", report->text.c_str());
+    }
+    vTaskDelay(pdMS_TO_TICKS(TASK_PROFILER_PERIOD_MS));
+  }
+}
@@ -0,0 +1,57 @@
+#ifndef TASK_MONITOR_H
+#define TASK_MONITOR_H
+
+#include "config.h"
+#include <Arduino.h>
+#include <memory>
+#include "task_profiler.h"
+#include "task_plan.h"
+
+/**
+ * @file task_monitor.h
+ * @brief Perfil periódico de tareas: CPU por tarea, carga por núcleo y pila libre.
+ *
+ * Cada `TASK_PROFILER_PERIOD_MS` se toma una muestra del planificador
+ * (`uxTaskGetSystemState`) y se publica un informe inmutable que sirve
+ * `/debug/tasks`. Cada `TASK_PROFILER_SERIAL_PERIOD_MS` el informe se imprime
+ * también por el puerto serie.
+ *
+ * El porcentaje de CPU por tarea requiere `CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS`,
+ * que el arduino-esp32 de serie no activa; sin esa opción la CPU por tarea
+ * aparece como -1 y la carga de cada núcleo se mide con un gancho en su
+ * tarea IDLE (`IdleMeter`, `task_profiler.h`).
+ *
+ * Todas las tareas del firmware se crean con `task_start`, que toma núcleo,
+ * prioridad y pila de `TASK_PLAN` (`task_plan.h`): el núcleo 1 queda para el
+ * control y el resto corre en el núcleo 0.
+ */
+
+/**
+ * @brief Crea una tarea con el núcleo, la prioridad y la pila de su entrada en `TASK_PLAN`.
+ *
+ * @param id Entrada del plan; debe ser una tarea que crea el firmware (pila > 0).
+ * @param fn Función de la tarea.
+ * @param parameter Parámetro de la tarea.
+ * @param handle Si no es `NULL`, recibe el manejador de la tarea.
+ * @return `false` si FreeRTOS no pudo crearla (sin memoria).
+ */
+bool task_start(TaskId id, TaskFunction_t fn, void *parameter = NULL, TaskHandle_t *handle = NULL);
+
+/**
+ * @brief Crea la tarea del perfilador.
+ */
+void task_monitor_setup();
+
+/**
+ * @brief Último informe publicado (puede ser `nullptr` antes de la primera muestra).
+ */
+std::shared_ptr<const TaskReport> task_monitor_report();
+
+/**
+ * @brief Tarea de FreeRTOS del perfilador.
+ *
+ * @param parameter Puntero a los parámetros de la tarea (no se usa).
+ */
+void task_monitor_task(void *parameter);
+
+#endif // TASK_MONITOR_H
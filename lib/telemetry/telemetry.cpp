@@ -0,0 +1,190 @@
+#include "telemetry.h"
+#include "motor_control.h"
+#include "wifi_manager.h"
+#include "supervisor.h"
+#include "settings.h"
+#include "boot_timeline.h"
+#include <WiFi.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <math.h>
+
+// ============================
+// Registro
+// ============================
+DeviceMetrics g_metrics;
+static MetricsRegistry<TELEMETRY_MAX_SERIES> g_registry;
+extern BootTimeline g_bootTimeline;
+
+static const char* const ROUTE_LABELS[HTTP_ROUTE_COUNT] = {
+  "route=\"/\"", "route=\"/status\"", "route=\"/rpm\"", "route=\"/stop\"",
+  "route=\"/scan\"", "route=\"/scan-results\"", "route=\"/saveWifi\"", "route=\"/metrics\"",
+  "route=\"/debug/tasks\"", "route=\"/debug/trace\"", "route=\"/config\"", "route=\"/pattern\"",
+  "route=\"/estop\"", "route=\"/debug/jitter\"",
+};
+
+static const char* const TASK_LABELS[SUPERVISED_COUNT] = {
+  "task=\"motorTask\"", "task=\"uiTask\"", "task=\"wifiTask\"", "task=\"modbusTask\"",
+};
+
+static const char* const SOURCE_LABELS[CMD_SOURCE_COUNT] = {
+  "source=\"http\"", "source=\"encoder\"", "source=\"protocol\"", "source=\"serial\"", "source=\"supervisor\"",
+};
+
+// Series telemetry_setup() registers: one per route (requests, duration), per
+// source (apply, settle, superseded) and per supervised task, plus the ones
+// without labels. Update TELEMETRY_SINGLE_SERIES when adding or removing one.
+const size_t TELEMETRY_SINGLE_SERIES = 19;
+const size_t TELEMETRY_SERIES =
+    TELEMETRY_SINGLE_SERIES + 2 * HTTP_ROUTE_COUNT + 3 * CMD_SOURCE_COUNT + SUPERVISED_COUNT;
+static_assert(TELEMETRY_SERIES <= TELEMETRY_MAX_SERIES, "raise TELEMETRY_MAX_SERIES");
+
+const char* const HTTP_ROUTE_PATHS[HTTP_ROUTE_COUNT] = {
+  "/", "/status", "/rpm", "/stop", "/scan", "/scan-results", "/saveWifi", "/metrics",
+  "/debug/tasks", "/debug/trace", "/config", "/pattern", "/estop",
+  "/debug/jitter",
+};
+
+// ============================
+// Lectores de valores
+// ============================
+static double read_boot_seconds(const void*) {
+  uint32_t ready = g_bootTimeline.timeOf("ready");
+  return ready == UINT32_MAX ? NAN : ready / 1e6;
+}
+
+static double read_config_commits(const void*) {
+  return settings_commits();
+}
+
+static double read_deadline_misses(const void* ctx) {
+  return supervisor_misses((SupervisedTask)(intptr_t)ctx);
+}
+
+static double read_heap_free(const void*) {
+  return heap_caps_get_free_size(MALLOC_CAP_8BIT);
+}
+
+static double read_heap_largest_block(const void*) {
+  return heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+}
+
+static double read_heap_min_free(const void*) {
+  return heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+}
+
+static double read_uptime(const void*) {
+  return esp_timer_get_time() / 1e6;
+}
+
+static double read_wifi_reconnects(const void*) {
+  return wifi_reconnect_attempts();
+}
+
+static double read_wifi_rssi(const void*) {
+  return isStaConnected() ? (double)WiFi.RSSI() : NAN;
+}
+
+static double read_rpm_error(const void*) {
+  MotorStateSnapshot motor;
+  if (!g_motorState.read(motor)) return NAN;
+  return motor.targetRpm - motor.currentRpm;
+}
+
+static double read_target_rpm(const void*) {
+  MotorStateSnapshot motor;
+  return g_motorState.read(motor) ? motor.targetRpm : NAN;
+}
+
+static double read_estop_latched(const void*) {
+  return motor_estop_status().latched ? 1.0 : 0.0;
+}
+
+static double read_estop_trips(const void*) {
+  return motor_estop_status().trips;
+}
+
+static double read_estop_latency(const void*) {
+  return motor_estop_status().maxLatencyCycles / (getCpuFrequencyMhz() * 1e6);
+}
+
+/**
+ * @brief Registers every series exposed at /metrics.
+ */
+void telemetry_setup() {
+  g_registry.addGauge("bioshaker_heap_free_bytes", "Free 8-bit heap.", &read_heap_free);
+  g_registry.addGauge("bioshaker_heap_largest_free_block_bytes", "Largest allocatable heap block.",
+                      &read_heap_largest_block);
+  g_registry.addGauge("bioshaker_heap_min_free_bytes", "Lowest free heap since boot.", &read_heap_min_free);
+  g_registry.addGauge("bioshaker_uptime_seconds", "Time since boot.", &read_uptime);
+
+  g_registry.addCounter("bioshaker_rpm_mutex_contended_total", "rpmMutex was already held when requested.",
+                        &g_metrics.rpmMutexContended);
+  g_registry.addCounter("bioshaker_rpm_mutex_timeouts_total", "rpmMutex could not be taken in time.",
+                        &g_metrics.rpmMutexTimeouts);
+
+  for (int r = 0; r < HTTP_ROUTE_COUNT; ++r) {
+    g_registry.addCounter("bioshaker_http_requests_total", "HTTP requests handled per route.",
+                          &g_metrics.http[r].requests, ROUTE_LABELS[r]);
+  }
+  for (int r = 0; r < HTTP_ROUTE_COUNT; ++r) {
+    g_registry.addHistogram("bioshaker_http_request_duration_seconds", "Time spent in the HTTP handler.",
+                            &g_metrics.http[r].latency, ROUTE_LABELS[r]);
+  }
+  g_registry.addCounter("bioshaker_http_rejected_total", "Requests answered 429 by admission control.",
+                        &g_metrics.httpRejected);
+
+  g_registry.addCounter("bioshaker_wifi_reconnect_attempts_total", "Station association attempts.",
+                        &read_wifi_reconnects);
+  g_registry.addGauge("bioshaker_wifi_rssi_dbm", "Station RSSI; NaN when not connected.", &read_wifi_rssi);
+
+  g_registry.addCounter("bioshaker_lcd_i2c_bytes_total", "Data bytes written to the LCD I2C expander.",
+                        &g_metrics.lcdI2cBytes);
+
+  for (int c = 0; c < CMD_SOURCE_COUNT; ++c) {
+    g_registry.addHistogram("bioshaker_command_apply_latency_seconds",
+                            "Delay from a command entering the firmware to the stepper being given it.",
+                            &g_metrics.commands[c].applied, SOURCE_LABELS[c]);
+  }
+  for (int c = 0; c < CMD_SOURCE_COUNT; ++c) {
+    g_registry.addHistogram("bioshaker_command_settle_latency_seconds",
+                            "Delay from a command entering the firmware to the stepper running at its speed.",
+                            &g_metrics.commands[c].reached, SOURCE_LABELS[c]);
+  }
+  for (int c = 0; c < CMD_SOURCE_COUNT; ++c) {
+    g_registry.addCounter("bioshaker_commands_superseded_total",
+                          "Commands replaced before the stepper reached their speed.",
+                          &g_metrics.commands[c].superseded, SOURCE_LABELS[c]);
+  }
+  g_registry.addGauge("bioshaker_boot_duration_seconds", "Time from reset to every boot phase finished.",
+                      &read_boot_seconds);
+  for (intptr_t t = 0; t < SUPERVISED_COUNT; ++t) {
+    g_registry.addCounter("bioshaker_task_deadline_misses_total", "Cycles in which a task missed its deadline.",
+                          &read_deadline_misses, (const void*)t, TASK_LABELS[t]);
+  }
+  g_registry.addHistogram("bioshaker_journal_write_seconds", "Time to append one run-journal record.",
+                          &g_metrics.journalWrite);
+  g_registry.addCounter("bioshaker_config_commits_total", "Writes of /config.bin to flash.",
+                        &read_config_commits);
+  g_registry.addGauge("bioshaker_motor_target_rpm", "Setpoint applied by motor_task.", &read_target_rpm);
+  g_registry.addGauge("bioshaker_motor_rpm_error", "Setpoint minus measured speed.", &read_rpm_error);
+  g_registry.addCounter("bioshaker_stop_overruns_total", "Graceful stops still moving after their bound, then hard-stopped.",
+                        &g_metrics.stopOverruns);
+  g_registry.addGauge("bioshaker_estop_latched", "1 while the emergency stop is latched.", &read_estop_latched);
+  g_registry.addCounter("bioshaker_estop_trips_total", "Emergency-stop trips, input and software.",
+                        &read_estop_trips);
+  g_registry.addGauge("bioshaker_estop_latency_max_seconds",
+                      "Worst delay from an emergency-stop trip to the driver outputs disabled.", &read_estop_latency);
+
+  if (g_registry.dropped() != 0 || g_registry.size() != TELEMETRY_SERIES) {
+    Serial.printf("[telemetry] %u series registered, %u dropped, %u expected\n", (unsigned)g_registry.size(),
+                  (unsigned)g_registry.dropped(), (unsigned)TELEMETRY_SERIES);
+  }
+}
+
+/**
+ * @brief Returns a fresh exposition generator; the caller keeps it alive while streaming.
+ */
+std::shared_ptr<PromStream<TELEMETRY_MAX_SERIES>> telemetry_open_stream() {
+  return std::make_shared<PromStream<TELEMETRY_MAX_SERIES>>(g_registry);
+}
@@ -0,0 +1,110 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "config.h"
+#include <Arduino.h>
+#include <memory>
+#include "metrics.h"
+#include "command_latency.h"
+#include "trace.h"
+
+/**
+ * @file telemetry.h
+ * @brief Métricas internas del firmware, expuestas en `/metrics`.
+ *
+ * Los módulos incrementan contadores y alimentan histogramas de `g_metrics`
+ * (operaciones atómicas, sin bloqueos). `/metrics` genera el formato de
+ * texto de Prometheus por partes, directamente en el buffer de la
+ * respuesta, sin construir la exposición completa en memoria.
+ */
+
+/**
+ * @brief Rutas HTTP con contadores e histograma de latencia propios.
+ */
+enum HttpRoute {
+  HTTP_ROUTE_ROOT,
+  HTTP_ROUTE_STATUS,
+  HTTP_ROUTE_RPM,
+  HTTP_ROUTE_STOP,
+  HTTP_ROUTE_SCAN,
+  HTTP_ROUTE_SCAN_RESULTS,
+  HTTP_ROUTE_SAVE_WIFI,
+  HTTP_ROUTE_METRICS,
+  HTTP_ROUTE_DEBUG_TASKS,
+  HTTP_ROUTE_DEBUG_TRACE,
+  HTTP_ROUTE_CONFIG,
+  HTTP_ROUTE_PATTERN,
+  HTTP_ROUTE_ESTOP,
+  HTTP_ROUTE_DEBUG_JITTER,
+  HTTP_ROUTE_COUNT
+};
+
+/**
+ * @brief Ruta de cada `HttpRoute`, usada como nombre del tramo en la traza.
+ */
+extern const char* const HTTP_ROUTE_PATHS[HTTP_ROUTE_COUNT];
+
+/**
+ * @brief Métricas de una ruta HTTP.
+ */
+struct RouteMetrics {
+  Counter requests;          ///< Peticiones atendidas (incluidas las rechazadas con 429).
+  LatencyHistogram latency;  ///< Tiempo dentro del manejador.
+};
+
+/**
+ * @brief Todas las métricas que los módulos actualizan en tiempo de ejecución.
+ */
+struct DeviceMetrics {
+  Counter rpmMutexContended;           ///< `rpmMutex` estaba ocupado al pedirlo.
+  Counter rpmMutexTimeouts;            ///< No se obtuvo `rpmMutex` dentro del plazo.
+  RouteMetrics http[HTTP_ROUTE_COUNT];
+  Counter httpRejected;                ///< Respuestas 429 del control de admisión.
+  Counter lcdI2cBytes;                 ///< Bytes de datos enviados al expansor I2C de la LCD.
+  CommandLatencyStats commands[CMD_SOURCE_COUNT]; ///< Latencia de las órdenes de velocidad por origen.
+  LatencyHistogram journalWrite;       ///< Escritura de un registro del diario de marcha.
+  Counter stopOverruns;                ///< Paradas con rampa que no terminaron a tiempo y se forzaron.
+};
+
+extern DeviceMetrics g_metrics;
+
+/**
+ * @brief Registra todas las series de la exposición. Llamar una vez al arrancar.
+ */
+void telemetry_setup();
+
+/**
+ * @brief Tamaño máximo del registro de métricas.
+ *
+ * `telemetry.cpp` comprueba en compilación que caben todas las series que
+ * registra `telemetry_setup()`.
+ */
+const size_t TELEMETRY_MAX_SERIES = 72;
+
+/**
+ * @brief Crea un generador nuevo de la exposición para una petición `/metrics`.
+ */
+std::shared_ptr<PromStream<TELEMETRY_MAX_SERIES>> telemetry_open_stream();
+
+/**
+ * @brief Cuenta una petición, mide su latencia y la marca en la traza mientras el objeto está vivo.
+ *
+ * Se declara al principio del manejador: `HttpRouteTimer timer(HTTP_ROUTE_RPM);`
+ */
+class HttpRouteTimer {
+public:
+  explicit HttpRouteTimer(HttpRoute route) : _route(route), _startUs(micros()) {
+    trace_event(TRACE_PHASE_BEGIN, HTTP_ROUTE_PATHS[route]);
+  }
+  ~HttpRouteTimer() {
+    trace_event(TRACE_PHASE_END, HTTP_ROUTE_PATHS[_route]);
+    g_metrics.http[_route].requests.inc();
+    g_metrics.http[_route].latency.observe(micros() - _startUs);
+  }
+
+private:
+  HttpRoute _route;
+  uint32_t _startUs;
+};
+
+#endif // TELEMETRY_H
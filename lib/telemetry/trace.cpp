@@ -0,0 +1,47 @@
+#include "trace.h"
+#include <esp_timer.h>
+
+// ============================
+// Anillos de traza
+// ============================
+DeviceTraceBuffer g_trace;
+static uint32_t g_lastSyncCycles[portNUM_PROCESSORS];
+
+/**
+ * @brief Refreshes this core's cycle/time reference once per second at most.
+ */
+void trace_clock_sync() {
+#if BIOSHAKER_TRACE
+  if (!g_trace.enabled()) return;
+  BaseType_t core = xPortGetCoreID();
+  uint32_t cycles = ESP.getCycleCount();
+  if (cycles - g_lastSyncCycles[core] < getCpuFrequencyMhz() * 1000000UL) return;
+  g_lastSyncCycles[core] = cycles;
+  g_trace.sync(core, cycles, esp_timer_get_time());
+#endif
+}
+
+/**
+ * @brief Enables or disables recording.
+ */
+void trace_set_enabled(bool enabled) {
+  if (enabled) {
+    // Force a fresh reference on both cores.
+    for (int c = 0; c < portNUM_PROCESSORS; ++c) g_lastSyncCycles[c] = ESP.getCycleCount() - getCpuFrequencyMhz() * 1000000UL;
+  }
+  g_trace.setEnabled(enabled);
+}
+
+/**
+ * @brief Display name of a traced task.
+ */
+static const char* trace_thread_name(uint32_t tid) {
+  return tid ? pcTaskGetName((TaskHandle_t)(uintptr_t)tid) : NULL;
+}
+
+/**
+ * @brief Returns an exporter over the current ring contents.
+ */
+std::shared_ptr<DeviceTraceStream> trace_open_stream() {
+  return std::make_shared<DeviceTraceStream>(g_trace, getCpuFrequencyMhz(), &trace_thread_name);
+}
@@ -0,0 +1,80 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "config.h"
+#include <Arduino.h>
+#include <memory>
+#include "trace_ring.h"
+
+/**
+ * @file trace.h
+ * @brief Traza de eventos con marca de ciclos de CPU, exportable a Perfetto.
+ *
+ * Los eventos (inicio/fin de un tramo o instantáneos) se escriben en un anillo
+ * sin bloqueos por núcleo. Con la traza desactivada cada punto cuesta una
+ * lectura atómica; compilando con `-D BIOSHAKER_TRACE=0` desaparecen del todo.
+ * `POST /debug/trace` con `enable=1` la activa y `GET /debug/trace` descarga el
+ * contenido en formato Chrome trace JSON.
+ */
+
+#ifndef BIOSHAKER_TRACE
+#define BIOSHAKER_TRACE 1
+#endif
+
+/**
+ * @brief Eventos guardados por núcleo (potencia de dos).
+ */
+const size_t TRACE_EVENTS_PER_CORE = 256;
+
+typedef TraceBuffer<portNUM_PROCESSORS, TRACE_EVENTS_PER_CORE> DeviceTraceBuffer;
+typedef ChromeTraceStream<portNUM_PROCESSORS, TRACE_EVENTS_PER_CORE> DeviceTraceStream;
+
+extern DeviceTraceBuffer g_trace;
+
+/**
+ * @brief Registra un evento en el anillo del núcleo actual.
+ *
+ * @param phase `TRACE_PHASE_BEGIN`, `TRACE_PHASE_END` o `TRACE_PHASE_INSTANT`.
+ * @param name Literal de cadena (no se copia).
+ * @param arg Valor libre que se muestra en el visor.
+ */
+inline void trace_event(uint8_t phase, const char* name, uint32_t arg = 0) {
+#if BIOSHAKER_TRACE
+  if (!g_trace.enabled()) return;
+  g_trace.record(xPortGetCoreID(), ESP.getCycleCount(), phase, name,
+                 (uint32_t)(uintptr_t)xTaskGetCurrentTaskHandle(), arg);
+#endif
+}
+
+/**
+ * @brief Actualiza la referencia ciclos/tiempo del núcleo actual (como mucho una vez por segundo).
+ *
+ * La llaman periódicamente `motor_task` (núcleo 1) y `ui_task` (núcleo 0).
+ */
+void trace_clock_sync();
+
+/**
+ * @brief Activa o desactiva la traza.
+ */
+void trace_set_enabled(bool enabled);
+
+/**
+ * @brief Crea un exportador Chrome trace del contenido actual de los anillos.
+ */
+std::shared_ptr<DeviceTraceStream> trace_open_stream();
+
+/**
+ * @brief Tramo con inicio y fin automáticos según el ámbito.
+ */
+class TraceScope {
+public:
+  explicit TraceScope(const char* name, uint32_t arg = 0) : _name(name) { trace_event(TRACE_PHASE_BEGIN, name, arg); }
+  ~TraceScope() { trace_event(TRACE_PHASE_END, _name); }
+
+private:
+  const char* _name;
+};
+
+#define TRACE_INSTANT(name, arg) trace_event(TRACE_PHASE_INSTANT, (name), (arg))
+
+#endif // TRACE_H
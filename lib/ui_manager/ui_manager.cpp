@@ -2,8 +2,16 @@
 #include "ui_manager.h"
 #include "motor_control.h"
 #include "wifi_manager.h"
+#include "wifi_scan.h"
+#include "telemetry.h"
+#include "supervisor.h"
+#include "settings.h"
+#include "lcd_format.h"
+#include "quadrature.h"
 #include <LiquidCrystal_I2C.h>
-#include <ESP32RotaryEncoder.h>
+#include <driver/gpio.h>
+#include <esp_timer.h>
+#include <soc/gpio_struct.h>
 #include <WiFi.h>
 
 // ============================
@@ -15,6 +23,8 @@
 #define ENC_DT 18
 #define ENC_SW 19
 
+static_assert(ENC_CLK < 32 && ENC_DT < 32, "encoder_isr() reads the low GPIO bank");
+
 // ============================
 // Constantes de la UI
 // ============================
@@ -31,9 +41,38 @@ extern float currentRpm;
 extern SemaphoreHandle_t rpmMutex;
 extern FastAccelStepper *stepper;
 
+// Each LCD byte goes out as two 4-bit nibbles, three PCF8574 writes per nibble.
+const uint32_t LCD_I2C_BYTES_PER_LCD_BYTE = 6;
+
+/**
+ * @brief LiquidCrystal_I2C that counts the bytes it puts on the I2C bus for /metrics.
+ *
+ * Characters go through the virtual write(); clear() and setCursor() are the
+ * only commands the UI issues after init, so they are counted here too.
+ */
+class CountingLcd : public LiquidCrystal_I2C {
+public:
+  using LiquidCrystal_I2C::LiquidCrystal_I2C;
+
+  size_t write(uint8_t value) override {
+    g_metrics.lcdI2cBytes.inc(LCD_I2C_BYTES_PER_LCD_BYTE);
+    return LiquidCrystal_I2C::write(value);
+  }
+
+  void clear() {
+    g_metrics.lcdI2cBytes.inc(LCD_I2C_BYTES_PER_LCD_BYTE);
+    LiquidCrystal_I2C::clear();
+  }
+
+  void setCursor(uint8_t col, uint8_t row) {
+    g_metrics.lcdI2cBytes.inc(LCD_I2C_BYTES_PER_LCD_BYTE);
+    LiquidCrystal_I2C::setCursor(col, row);
+  }
+};
+
 // Instancias de hardware
-RotaryEncoder rotaryEncoder(ENC_DT, ENC_CLK, ENC_SW);
-LiquidCrystal_I2C lcd(0x27, 16, 2);
+static QuadratureDecoder g_quadrature; // fed only by encoder_isr()
+CountingLcd lcd(0x27, 16, 2);
 
 // Estado de la UI
 UiState uiState = UI_SPLASH;
@@ -43,8 +82,14 @@ volatile bool uiForceRedraw = true;
 
 // Variables auxiliares
 volatile long KnobValue = 0;
+static volatile uint32_t g_knobIngressUs = 0; // first unconsumed detent, for command latency
 volatile bool g_resetRpmEstimator = false;
 volatile bool g_offlineRequested  = false;
+static uint32_t g_connectStartMs = 0; // when UI_WIFI_CONNECTING was entered
+
+// Estabilidad de velocidad
+SeqLock<SpeedStabilityReport> g_speedStats;
+static SpeedStabilityMonitor g_speedMonitor(RPM_CALCULATION_INTERVAL_MS);
 
 // Prototipos locales
 void handle_splash();
@@ -56,7 +101,34 @@ void handle_language();
 void handle_wifi_disconnected();
 void handle_wifi();
 void handle_ask_ap_mode();
-void IRAM_ATTR knob_callback(long value);
+void handle_wifi_connecting();
+static void IRAM_ATTR encoder_isr(void *);
+static bool button_pressed();
+
+/**
+ * @brief Feeds one RPM estimate to the stability statistics and writes the run log.
+ *
+ * @param measuredRpm Unfiltered estimate over the last window.
+ * @param elapsedMs Length of that window.
+ */
+static void update_speed_stats(float measuredRpm, uint32_t elapsedMs) {
+  static uint32_t lastLogMs = 0;
+  MotorStateSnapshot motor = {};
+  if (!g_motorState.read(motor)) return;
+  char line[200];
+  if (g_speedMonitor.update(motor.targetRpm, measuredRpm, elapsedMs)) {
+    SpeedStabilityMonitor::format(g_speedMonitor.lastSegment(), line, sizeof(line));
+    Serial.printf("[run] end %s\n", line);
+  }
+  SpeedStabilityReport report = g_speedMonitor.report();
+  g_speedStats.publish(report);
+  if (report.state == SPEED_STATS_STEADY && SPEED_STATS_LOG_PERIOD_MS > 0 &&
+      millis() - lastLogMs >= SPEED_STATS_LOG_PERIOD_MS) {
+    lastLogMs = millis();
+    SpeedStabilityMonitor::format(report, line, sizeof(line));
+    Serial.printf("[run] %s\n", line);
+  }
+}
 
 /**
  * @brief Initializes the UI components (LCD and rotary encoder).
@@ -65,10 +137,19 @@ void ui_setup() {
     Wire.begin(I2C_SDA, I2C_SCL);
     lcd.init();
     lcd.backlight();
-    rotaryEncoder.begin();
-    rotaryEncoder.setBoundaries(-1000000, 1000000, false);
-    rotaryEncoder.onTurned(knob_callback);
+    pinMode(ENC_CLK, INPUT_PULLUP);
+    pinMode(ENC_DT, INPUT_PULLUP);
     pinMode(ENC_SW, INPUT_PULLUP);
+    uint32_t in = GPIO.in;
+    g_quadrature.reset(in & (1u << ENC_DT), in & (1u << ENC_CLK));
+    // Same IRAM GPIO service as the E-stop (motor_setup() installs it first
+    // when the input is enabled); attachInterrupt() would dispatch from flash.
+    esp_err_t err = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) Serial.printf("[ui] isr service: %d\n", (int)err);
+    gpio_set_intr_type((gpio_num_t)ENC_CLK, GPIO_INTR_ANYEDGE);
+    gpio_set_intr_type((gpio_num_t)ENC_DT, GPIO_INTR_ANYEDGE);
+    gpio_isr_handler_add((gpio_num_t)ENC_CLK, encoder_isr, NULL);
+    gpio_isr_handler_add((gpio_num_t)ENC_DT, encoder_isr, NULL);
 }
 
 /**
@@ -76,23 +157,32 @@ void ui_setup() {
  */
 void ui_task(void *parameter) {
   static uint32_t lastRpmCalc = 0;
-  static long lastStepperPos = 0;
-  static float smoothedRpm = 0.0f;
+  static RpmEstimator estimator;
 
+  language = settings_get().language;
+  supervisor_register(SUPERVISED_UI);
   while (true) {
+    supervisor_check_in(SUPERVISED_UI);
+    trace_clock_sync();
     // Handle rotary encoder input
     long delta = 0;
+    uint32_t knobIngressUs = 0;
     if (KnobValue != 0) {
+      knobIngressUs = g_knobIngressUs;
       delta = KnobValue;
       KnobValue = 0;
       uiForceRedraw = true;
     }
     if (delta != 0) {
-      if (xSemaphoreTake(rpmMutex, pdMS_TO_TICKS(5)) == pdTRUE) {
+      TRACE_INSTANT("encoder", (uint32_t)delta);
+      if (rpm_mutex_take(pdMS_TO_TICKS(5))) {
         if (uiState == UI_ADJUST_RPM) {
           targetRpm += delta;
           if (targetRpm < 0) targetRpm = 0;
-          if (targetRpm > MAX_RPM) targetRpm = MAX_RPM;
+          float maxRpm = settings_get().maxRpm;
+          if (targetRpm > maxRpm) targetRpm = maxRpm;
+          // Also through the mailbox so motor_task times it from the detent.
+          motor_post_setpoint(targetRpm, CMD_SOURCE_ENCODER, knobIngressUs);
         } else if (uiState == UI_MENU) {
           const int menuCount = 6;
           menuIndex += delta;
@@ -101,6 +191,7 @@ void ui_task(void *parameter) {
         } else if (uiState == UI_LANGUAGE) {
           language = (language + delta) % 2;
           if (language < 0) language = 1;
+          settings_set_language((uint8_t)language);
         }
         xSemaphoreGive(rpmMutex);
       }
@@ -108,7 +199,7 @@ void ui_task(void *parameter) {
 
     // Handle button presses
     static uint32_t lastBtn = 0;
-    if (rotaryEncoder.buttonPressed() && (millis() - lastBtn > BUTTON_DEBOUNCE_MS)) {
+    if (button_pressed() && (millis() - lastBtn > BUTTON_DEBOUNCE_MS)) {
       lastBtn = millis();
       uiForceRedraw = true;
       lcd.clear();
@@ -119,7 +210,7 @@ void ui_task(void *parameter) {
         case UI_MENU:
           switch (menuIndex) {
             case 0: uiState = UI_ADJUST_RPM; break;
-            case 1: stop_motor_hard(true); uiState = UI_NORMAL; break;
+            case 1: motor_stop(STOP_MODE_GRACEFUL, CMD_SOURCE_ENCODER, micros()); uiState = UI_NORMAL; break;
             case 2: startAPAlways(); uiState = UI_WIFI; break;
             case 3:
               if (isStaConnected() || (WiFi.getMode() & WIFI_AP)) {
@@ -127,12 +218,12 @@ void ui_task(void *parameter) {
                 uiState = UI_WIFI_DISCONNECTED;
               } else {
                 g_offlineRequested = false;
-                WiFi.mode(WIFI_STA);
-                tryConnectSavedWifi(false);
-                if (!isStaConnected()) {
-                  uiState = UI_ASK_AP_MODE;
+                // wifi_task associates; handle_wifi_connecting() watches the result.
+                if (tryConnectSavedWifi()) {
+                  g_connectStartMs = millis();
+                  uiState = UI_WIFI_CONNECTING;
                 } else {
-                  uiState = UI_NORMAL;
+                  uiState = UI_ASK_AP_MODE;
                 }
               }
               break;
@@ -141,6 +232,7 @@ void ui_task(void *parameter) {
           }
           break;
         case UI_ADJUST_RPM: case UI_AP_MODE: case UI_LANGUAGE: case UI_WIFI:
+        case UI_WIFI_CONNECTING: // the attempt goes on in the background
           uiState = UI_NORMAL;
           uiForceRedraw = true;
           break;
@@ -156,38 +248,42 @@ void ui_task(void *parameter) {
     }
 
     // Update the display based on the current state
-    switch (uiState) {
-      case UI_SPLASH: handle_splash(); break;
-      case UI_NORMAL: handle_normal(); break;
-      case UI_MENU: handle_menu(); break;
-      case UI_ASK_AP_MODE: handle_ask_ap_mode(); break;
-      case UI_ADJUST_RPM: handle_adjust_rpm(); break;
-      case UI_AP_MODE: handle_ap_mode(); break;
-      case UI_LANGUAGE: handle_language(); break;
-      case UI_WIFI: handle_wifi(); break;
-      case UI_WIFI_DISCONNECTED: handle_wifi_disconnected(); break;
+    {
+      TraceScope drawTrace("ui_draw", uiState);
+      switch (uiState) {
+        case UI_SPLASH: handle_splash(); break;
+        case UI_NORMAL: handle_normal(); break;
+        case UI_MENU: handle_menu(); break;
+        case UI_ASK_AP_MODE: handle_ask_ap_mode(); break;
+        case UI_ADJUST_RPM: handle_adjust_rpm(); break;
+        case UI_AP_MODE: handle_ap_mode(); break;
+        case UI_LANGUAGE: handle_language(); break;
+        case UI_WIFI: handle_wifi(); break;
+        case UI_WIFI_DISCONNECTED: handle_wifi_disconnected(); break;
+        case UI_WIFI_CONNECTING: handle_wifi_connecting(); break;
+      }
     }
 
     // RPM Calculation
     if (g_resetRpmEstimator) {
-      lastStepperPos = stepper ? stepper->getCurrentPosition() : 0;
-      smoothedRpm = 0.0f;
-      if (xSemaphoreTake(rpmMutex, pdMS_TO_TICKS(5)) == pdTRUE) {
+      estimator.reset(stepper ? stepper->getCurrentPosition() : 0);
+      if (rpm_mutex_take(pdMS_TO_TICKS(5))) {
         currentRpm = 0.0f;
         xSemaphoreGive(rpmMutex);
       }
       g_resetRpmEstimator = false;
     }
-    if (millis() - lastRpmCalc >= RPM_CALCULATION_INTERVAL_MS) {
+    uint32_t rpmElapsedMs = millis() - lastRpmCalc;
+    if (rpmElapsedMs >= RPM_CALCULATION_INTERVAL_MS) {
       lastRpmCalc = millis();
       long pos = stepper ? stepper->getCurrentPosition() : 0;
-      float rpm = ((pos - lastStepperPos) / (float)SPR_MEAS) * (60000.0f / RPM_CALCULATION_INTERVAL_MS);
-      lastStepperPos = pos;
-      smoothedRpm = 0.35f * rpm + 0.65f * smoothedRpm;
-      if (xSemaphoreTake(rpmMutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-        currentRpm = smoothedRpm;
+      float rpm = estimator.update(pos, settings_get().measStepsPerRev, RPM_CALCULATION_INTERVAL_MS);
+      if (rpm_mutex_take(pdMS_TO_TICKS(5))) {
+        currentRpm = estimator.smoothed();
         xSemaphoreGive(rpmMutex);
       }
+      // Stability uses the unfiltered estimate over the actual window.
+      update_speed_stats(rpm * RPM_CALCULATION_INTERVAL_MS / (float)rpmElapsedMs, rpmElapsedMs);
     }
 
     vTaskDelay(pdMS_TO_TICKS(20));
@@ -202,7 +298,7 @@ void handle_splash() {
     lcd.setCursor(0, 1); lcd.print("v" FIRMWARE_VERSION);
     t0 = millis();
   }
-  if ((millis() - t0 > SPLASH_SCREEN_DURATION_MS) || rotaryEncoder.buttonPressed()) {
+  if ((millis() - t0 > SPLASH_SCREEN_DURATION_MS) || button_pressed()) {
     t0 = 0; uiState = UI_NORMAL; uiForceRedraw = true;
   }
 }
@@ -212,7 +308,8 @@ void handle_normal() {
   String l0; static bool blink = false; static uint32_t lastBlink = 0;
   bool apOn = (WiFi.getMode() & WIFI_AP); bool staOn = isStaConnected();
 
-  if (staOn) l0 = WiFi.localIP().toString();
+  if (motor_estop_status().latched) l0 = (language==0) ? "PARADA EMERG." : "E-STOP";
+  else if (staOn) l0 = WiFi.localIP().toString();
   else if (apOn) {
     if (millis() - lastBlink >= BLINK_INTERVAL_MS) { blink = !blink; lastBlink = millis(); }
     l0 = blink ? (language==0 ? "MODO AP" : "AP MODE") : WiFi.softAPIP().toString();
@@ -220,18 +317,18 @@ void handle_normal() {
 
   bool timeToRefresh = (millis() - lastRefresh) >= NORMAL_SCREEN_REFRESH_MS;
   if (l0 != lastLine0 || uiForceRedraw || timeToRefresh) {
-    lcd.setCursor(0,0); char line[17]; snprintf(line,sizeof(line),"%-16s", l0.c_str()); lcd.print(line);
+    lcd.setCursor(0,0); char line[LCD_COLS + 1]; lcd_pad_line(line, l0.c_str()); lcd.print(line);
     lastLine0 = l0; lastRefresh = millis(); uiForceRedraw = false;
   }
 
   float cur=0, tgt=0;
-  if (xSemaphoreTake(rpmMutex, pdMS_TO_TICKS(5)) == pdTRUE) {
+  if (rpm_mutex_take(pdMS_TO_TICKS(5))) {
     cur = currentRpm; tgt = targetRpm; xSemaphoreGive(rpmMutex);
   }
-  char buf[17]; snprintf(buf,sizeof(buf),"A:%3.0f T:%3.0f", cur, tgt);
-  static char lastRpm[17]="";
+  char buf[LCD_COLS + 1]; lcd_format_rpm_line(buf, cur, tgt);
+  static char lastRpm[LCD_COLS + 1]="";
   if (strcmp(buf,lastRpm)!=0 || uiForceRedraw) {
-    lcd.setCursor(0,1); char l2[17]; snprintf(l2,sizeof(l2),"%-16s", buf); lcd.print(l2);
+    lcd.setCursor(0,1); lcd.print(buf);
     strcpy(lastRpm, buf);
   }
 }
@@ -264,15 +361,15 @@ void handle_menu() {
 
 void handle_adjust_rpm() {
   if (uiForceRedraw) { lcd.clear(); lcd.setCursor(0,0); lcd.print((language==0)?"Ajustar RPM":"Adjust RPM"); uiForceRedraw=false; }
-  float newTarget=0; if (xSemaphoreTake(rpmMutex,pdMS_TO_TICKS(5))==pdTRUE){ newTarget=targetRpm; xSemaphoreGive(rpmMutex); }
+  float newTarget=0; if (rpm_mutex_take(pdMS_TO_TICKS(5))){ newTarget=targetRpm; xSemaphoreGive(rpmMutex); }
   lcd.setCursor(0,1); char buf[17]; snprintf(buf,sizeof(buf),"RPM: %.0f      ", newTarget); lcd.print(buf);
 }
 
 void handle_ap_mode() {
   if (uiForceRedraw) { lcd.clear(); uiForceRedraw=false; }
-  float cur=0,tgt=0; if (xSemaphoreTake(rpmMutex,pdMS_TO_TICKS(5))==pdTRUE){cur=currentRpm;tgt=targetRpm;xSemaphoreGive(rpmMutex);}
+  float cur=0,tgt=0; if (rpm_mutex_take(pdMS_TO_TICKS(5))){cur=currentRpm;tgt=targetRpm;xSemaphoreGive(rpmMutex);}
   lcd.setCursor(0,0); {const char* t=(language==0)?"MODO AP":"AP MODE"; char l0[17]; snprintf(l0,sizeof(l0),"%-16s",t); lcd.print(l0);}
-  lcd.setCursor(0,1); {char l1[17]; snprintf(l1,sizeof(l1),"A:%3.0f T:%3.0f",cur,tgt); char pad[17]; snprintf(pad,sizeof(pad),"%-16s",l1); lcd.print(pad);}
+  lcd.setCursor(0,1); {char l1[LCD_COLS + 1]; lcd_format_rpm_line(l1,cur,tgt); lcd.print(l1);}
 }
 
 void handle_language() {
@@ -285,42 +382,77 @@ void handle_wifi_disconnected() {
   if (uiForceRedraw) { lcd.clear(); uiForceRedraw=false; }
   lcd.setCursor(0,0); { const char* t=(language==0)?(g_offlineRequested?"Sin WiFi":"WiFi Perdido"):(g_offlineRequested?"No WiFi":"WiFi Lost"); char l1[17]; snprintf(l1,sizeof(l1),"%-16s",t); lcd.print(l1); }
   if (millis()-lastRefresh>=250) {
-    float cur=0,tgt=0; if (xSemaphoreTake(rpmMutex,pdMS_TO_TICKS(5))==pdTRUE){cur=currentRpm;tgt=targetRpm;xSemaphoreGive(rpmMutex);}
-    lcd.setCursor(0,1); char l2[17]; snprintf(l2,sizeof(l2),"A:%3.0f T:%3.0f",cur,tgt); char pad[17]; snprintf(pad,sizeof(pad),"%-16s",l2); lcd.print(pad); lastRefresh=millis();
+    float cur=0,tgt=0; if (rpm_mutex_take(pdMS_TO_TICKS(5))){cur=currentRpm;tgt=targetRpm;xSemaphoreGive(rpmMutex);}
+    lcd.setCursor(0,1); char l2[LCD_COLS + 1]; lcd_format_rpm_line(l2,cur,tgt); lcd.print(l2); lastRefresh=millis();
+  }
+}
+
+void handle_wifi_connecting() {
+  if (isStaConnected()) { uiState = UI_NORMAL; uiForceRedraw = true; return; }
+  if (millis() - g_connectStartMs > (uint32_t)WIFI_CONNECT_TIMEOUT_MS) {
+    uiState = UI_ASK_AP_MODE; uiForceRedraw = true; return;
+  }
+  if (uiForceRedraw) {
+    lcd.clear();
+    lcd.setCursor(0,0); lcd.print((language==0) ? "Conectando..." : "Connecting...");
+    char l2[LCD_COLS + 1]; lcd_pad_line(l2, settings_get().wifiSsid); lcd.setCursor(0,1); lcd.print(l2);
+    uiForceRedraw = false;
   }
 }
 
 void handle_wifi() {
-  static uint32_t lastScanTime=0; static int networkCount=-1; static int selectedNetworkIndex=0;
+  static int selectedNetworkIndex=0; static uint32_t lastBuiltMs=0;
   static bool blink=false; static uint32_t lastBlink=0;
 
-  if (uiForceRedraw) { lcd.clear(); uiForceRedraw=false; networkCount=-1; }
+  if (uiForceRedraw) { lcd.clear(); uiForceRedraw=false; }
 
   if (millis()-lastBlink >= BLINK_INTERVAL_MS) { blink = !blink; lastBlink = millis(); }
   String l0 = blink ? (language==0 ? "MODO AP" : "AP MODE") : WiFi.softAPIP().toString();
   lcd.setCursor(0,0); char line0[17]; snprintf(line0,sizeof(line0),"%-16s", l0.c_str()); lcd.print(line0);
 
-  if (networkCount<0 || millis()-lastScanTime>WIFI_SCAN_INTERVAL_MS) {
-    networkCount = WiFi.scanNetworks();
-    lastScanTime = millis();
-    selectedNetworkIndex = 0;
-  }
+  // Never scan here: ask the scan service and show whatever snapshot it has.
+  std::shared_ptr<const ScanSnapshot> snap = wifi_scan_snapshot();
+  if (!snap || millis()-snap->builtMs > WIFI_SCAN_INTERVAL_MS) wifi_scan_request();
+  if (snap && snap->builtMs != lastBuiltMs) { lastBuiltMs = snap->builtMs; selectedNetworkIndex = 0; }
 
   lcd.setCursor(0,1);
+  int networkCount = snap ? (int)snap->entries.size() : 0;
+  char ssidLine[17];
   if (networkCount > 0) {
-    char ssidLine[17];
     snprintf(ssidLine,sizeof(ssidLine),"%d/%d %s",
              selectedNetworkIndex+1, networkCount,
-             WiFi.SSID(selectedNetworkIndex).c_str());
-    lcd.print(ssidLine);
+             snap->entries[selectedNetworkIndex].ssid);
+  } else if (!snap || wifi_scan_in_progress()) {
+    snprintf(ssidLine,sizeof(ssidLine),"%-16s",(language==0)?"Escaneando...":"Scanning...");
   } else {
-    lcd.print("No networks found");
+    snprintf(ssidLine,sizeof(ssidLine),"%-16s","No networks found");
   }
+  lcd.print(ssidLine);
 }
 
-void IRAM_ATTR knob_callback(long value) {
-  KnobValue = -value;
-  rotaryEncoder.resetEncoderValue();
+/**
+ * @brief Either encoder line changed: one detent adds to KnobValue for ui_task.
+ *
+ * On the IRAM GPIO service, so it may run while the flash cache is off:
+ * register reads and esp_timer_get_time() only (Arduino's micros() is in flash).
+ */
+static void IRAM_ATTR encoder_isr(void *) {
+  uint32_t in = GPIO.in;
+  int8_t detent = g_quadrature.update(in & (1u << ENC_DT), in & (1u << ENC_CLK));
+  if (detent == 0) return;
+  if (KnobValue == 0) g_knobIngressUs = (uint32_t)esp_timer_get_time();
+  KnobValue -= detent;
+}
+
+/**
+ * @brief True once per press of the encoder button, polled by ui_task.
+ */
+static bool button_pressed() {
+  static bool wasDown = false;
+  bool down = digitalRead(ENC_SW) == LOW;
+  bool pressed = down && !wasDown;
+  wasDown = down;
+  return pressed;
 }
 
 void handle_ask_ap_mode() {
@@ -3,6 +3,8 @@
 
 #include "config.h"
 #include <Arduino.h>
+#include "motor_state.h"
+#include "speed_stats.h"
 
 /**
  * @file ui_manager.h
@@ -21,7 +23,8 @@ enum UiState {
   UI_LANGUAGE,           ///< Pantalla para cambiar el idioma.
   UI_AP_MODE,            ///< Pantalla que indica que se está en Modo AP.
   UI_WIFI_DISCONNECTED,  ///< Pantalla que indica que se ha perdido la conexión WiFi.
-  UI_ASK_AP_MODE         ///< Pantalla para preguntar si se activa el modo AP.
+  UI_ASK_AP_MODE,        ///< Pantalla para preguntar si se activa el modo AP.
+  UI_WIFI_CONNECTING     ///< Conectando a la red guardada; la UI sigue respondiendo.
 };
 
 extern UiState uiState; // La máquina de estados es global
@@ -29,6 +32,13 @@ extern volatile bool g_resetRpmEstimator;
 extern volatile bool uiForceRedraw;
 extern volatile bool g_offlineRequested;
 
+/**
+ * @brief Estadísticas de estabilidad de la consigna actual (error medio, RMS, pico y desviación de Allan).
+ *
+ * `ui_task` las actualiza con cada estimación de RPM; se leen sin bloqueo desde `/status`.
+ */
+extern SeqLock<SpeedStabilityReport> g_speedStats;
+
 /**
  * @brief Inicializa los componentes de la interfaz de usuario (LCD y encoder).
  */
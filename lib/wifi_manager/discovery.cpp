@@ -0,0 +1,73 @@
+#include "discovery.h"
+#include "motor_control.h"
+#include <WiFi.h>
+#include <mdns.h>
+
+// ============================
+// Servicio DNS-SD
+// ============================
+static const char* DISCOVERY_SERVICE = "_bioshaker";
+static const char* DISCOVERY_PROTO = "_tcp";
+static const uint16_t DISCOVERY_PORT = 80;
+
+static bool g_discoveryStarted = false;
+static int8_t g_advertisedRunning = -1;  // -1 = not published yet
+
+/**
+ * @brief Returns the TXT value for the run state.
+ */
+static const char* run_state_name(bool running) {
+  return running ? "running" : "stopped";
+}
+
+/**
+ * @brief Starts the mDNS responder and registers _bioshaker._tcp.
+ */
+void discovery_setup() {
+  if (mdns_init() != ESP_OK) {
+    Serial.print("[mdns] init failed\n");
+    return;
+  }
+
+  String suffix = String((uint32_t)ESP.getEfuseMac(), HEX).substring(4);
+  String hostname = "bioshaker-" + suffix;
+  String instance = "BioShaker-" + suffix;
+  mdns_hostname_set(hostname.c_str());
+  mdns_instance_name_set(instance.c_str());
+
+  char channels[4];
+  snprintf(channels, sizeof(channels), "%u", (unsigned)SHAKER_CHANNEL_COUNT);
+  mdns_txt_item_t txt[] = {
+    {"fw", FIRMWARE_VERSION},
+    {"ch", channels},
+    {"state", run_state_name(false)},
+    {"id", suffix.c_str()},
+  };
+  if (mdns_service_add(instance.c_str(), DISCOVERY_SERVICE, DISCOVERY_PROTO, DISCOVERY_PORT,
+                       txt, sizeof(txt) / sizeof(txt[0])) != ESP_OK) {
+    Serial.print("[mdns] service add failed\n");
+    mdns_free();
+    return;
+  }
+  g_advertisedRunning = 0;
+  g_discoveryStarted = true;
+  Serial.printf("[mdns] %s.local advertising %s.%s\n", hostname.c_str(), DISCOVERY_SERVICE, DISCOVERY_PROTO);
+}
+
+/**
+ * @brief Republishes the state TXT item when the motor starts or stops.
+ *
+ * Reads the motor snapshot without locking; if the read collides with a
+ * publish the check is simply retried on the next call.
+ */
+void discovery_poll() {
+  if (!g_discoveryStarted) return;
+  MotorStateSnapshot motor;
+  if (!g_motorState.read(motor)) return;
+  bool running = motor.runState == MOTOR_RUNNING;
+
+  if ((int8_t)running == g_advertisedRunning) return;
+  if (mdns_service_txt_item_set(DISCOVERY_SERVICE, DISCOVERY_PROTO, "state", run_state_name(running)) == ESP_OK) {
+    g_advertisedRunning = running;
+  }
+}
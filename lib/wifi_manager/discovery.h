@@ -0,0 +1,36 @@
+#ifndef DISCOVERY_H
+#define DISCOVERY_H
+
+#include "config.h"
+#include <Arduino.h>
+
+/**
+ * @file discovery.h
+ * @brief Anuncio del equipo en la red local mediante mDNS / DNS-SD.
+ *
+ * El equipo se publica como servicio `_bioshaker._tcp` en el puerto HTTP,
+ * con registros TXT que permiten inventariar una planta completa con una
+ * sola consulta (ver `tools/bioshaker_discover`):
+ *
+ * - `fw`: versión del firmware.
+ * - `ch`: número de canales (agitadores) que controla el equipo.
+ * - `state`: `running` o `stopped`.
+ * - `id`: identificador corto derivado de la MAC.
+ */
+
+/**
+ * @brief Inicia el responder mDNS y registra el servicio.
+ *
+ * Debe llamarse después de iniciar la interfaz WiFi; el responder anuncia
+ * en el AP y en la estación en cuanto esta obtiene IP.
+ */
+void discovery_setup();
+
+/**
+ * @brief Actualiza el TXT `state` si el estado de marcha cambió.
+ *
+ * Barato cuando no hay cambios; se llama periódicamente desde `wifi_task`.
+ */
+void discovery_poll();
+
+#endif // DISCOVERY_H
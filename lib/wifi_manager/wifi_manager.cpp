@@ -2,83 +2,272 @@
 #include "wifi_manager.h"
 #include "motor_control.h"
 #include "ui_manager.h"
+#include "rate_limiter.h"
+#include "wifi_reconnect.h"
+#include "boot_timeline.h"
+#include "wifi_scan.h"
+#include "discovery.h"
+#include "telemetry.h"
+#include "task_monitor.h"
+#include "jitter_probe.h"
+#include "supervisor.h"
+#include "settings.h"
+#include "journal.h"
+#include "status_json.h"
 #include <ESPAsyncWebServer.h>
 #include <ArduinoJson.h>
 #include <FS.h>
 #include <LittleFS.h>
 #include <WiFi.h>
 
+static_assert(CONFIG_ASYNC_TCP_RUNNING_CORE == TASK_PLAN[TASK_ASYNC_TCP].core,
+              "AsyncTCP must run where TASK_PLAN puts async_tcp (see platformio.ini)");
+
 // Extern variables
-extern float targetRpm;
-extern float currentRpm;
-extern SemaphoreHandle_t rpmMutex;
+extern BootTimeline g_bootTimeline;
 
 // Web server instance
 AsyncWebServer server(80);
 
-// Variables para el escaneo en segundo plano
-static volatile bool g_startScan = false;
-static String g_scanResults = "[]";
-SemaphoreHandle_t g_scanMutex;
+// ============================
+// Tarea de WiFi
+// ============================
+const uint32_t WIFI_TASK_POLL_MS = 100;
+const uint32_t WIFI_BACKOFF_BASE_MS = 500;
+const uint32_t WIFI_BACKOFF_MAX_MS = 60000;
+const uint32_t WIFI_ATTEMPT_TIMEOUT_MS = 10000;
+
+enum WifiCommandType {
+  WIFI_CMD_APPLY_CREDENTIALS,
+  WIFI_CMD_CONNECT_SAVED,
+  WIFI_CMD_STA_GOT_IP,
+  WIFI_CMD_STA_DISCONNECTED
+};
+
+struct WifiCommand {
+  WifiCommandType type;
+  char ssid[33];
+  char password[65];
+};
+
+static QueueHandle_t g_wifiCmdQueue;
+static ReconnectStateMachine g_reconnect;
+static bool g_ignoreNextDisconnect = false;
+static uint32_t g_provisionStartMs = 0;
+volatile WifiProvisionState g_wifiProvisionState = WIFI_PROVISION_IDLE;
+
+// Control de admisión del servidor web
+static const size_t HTTP_RATE_LIMIT_CLIENTS = 8;
+static ClientRateLimiter<HTTP_RATE_LIMIT_CLIENTS> g_rpmLimiter;
+static ConcurrencyGate g_httpGate;
 
 // Prototypes
 void setup_server();
 void on_wifi_event(WiFiEvent_t event);
-void wifi_scan_task(void *parameter);
 
 /**
- * @brief Initializes the WiFi manager, starts the AP, and connects to a saved network if available.
+ * @brief Initializes the WiFi manager, starts the AP and the web server.
+ *
+ * Does not wait for the saved network: wifi_task associates in the background.
  */
 void wifi_setup() {
-    g_scanMutex = xSemaphoreCreateMutex();
+    g_wifiCmdQueue = xQueueCreate(8, sizeof(WifiCommand));
+    g_reconnect.configure(WIFI_BACKOFF_BASE_MS, WIFI_BACKOFF_MAX_MS, WIFI_ATTEMPT_TIMEOUT_MS);
+    g_reconnect.setFastConnectAvailable(settings_get().wifiChannel > 0);
+    WiFi.setAutoReconnect(false); // wifi_task owns reconnection
     WiFi.onEvent(on_wifi_event);
     startAPAlways();
-    tryConnectSavedWifi(false);
+    discovery_setup();
+    task_start(TASK_WIFI, wifi_task);
+    tryConnectSavedWifi(); // association finishes in the background
     setup_server();
-    xTaskCreatePinnedToCore(wifi_scan_task, "wifiScanTask", 4096, NULL, 1, NULL, 0);
+    wifi_scan_setup();
 }
 
 /**
  * @brief Starts the WiFi in AP+STA mode.
  */
 void startAPAlways() {
+  bool restart = WiFi.getMode() & WIFI_AP;
   WiFi.mode(WIFI_AP_STA);
   String ssid = String(AP_SSID_PREFIX) + String((uint32_t)ESP.getEfuseMac(), HEX).substring(4);
-  WiFi.softAPdisconnect(true);
-  delay(30);
+  // Only a running AP has clients to drop; the driver calls below block until applied.
+  if (restart) WiFi.softAPdisconnect(false);
   WiFi.softAPConfig(AP_IP, AP_GATEWAY, AP_SUBNET);
   WiFi.softAP(ssid.c_str(), AP_PASSWORD, 6, 0, 4);
-  delay(50);
   uiState = UI_AP_MODE;
   uiForceRedraw = true;
 }
 
 /**
- * @brief Tries to connect to a previously saved WiFi network.
- * @param asyncRetry If true, the connection attempt is non-blocking.
+ * @brief Posts a command to wifi_task without blocking.
+ * @return True if the command was queued.
+ */
+static bool post_wifi_command(WifiCommandType type) {
+  WifiCommand cmd;
+  cmd.type = type;
+  cmd.ssid[0] = '\0';
+  cmd.password[0] = '\0';
+  return xQueueSend(g_wifiCmdQueue, &cmd, 0) == pdTRUE;
+}
+
+/**
+ * @brief Asks wifi_task to connect to the saved network; never blocks.
+ * @return True if the request was queued.
+ */
+bool tryConnectSavedWifi() {
+  return post_wifi_command(WIFI_CMD_CONNECT_SAVED);
+}
+
+/**
+ * @brief Starts one association attempt as requested by the reconnect policy.
  */
-void tryConnectSavedWifi(bool asyncRetry) {
-  File f = LittleFS.open("/wifiConfig.json", "r");
-  if (!f) return;
+static void begin_connect(ReconnectAction action) {
+  // Add the station without touching the AP: after goOffline() only STA comes up.
+  if (!(WiFi.getMode() & WIFI_STA)) WiFi.mode((wifi_mode_t)(WiFi.getMode() | WIFI_STA));
+  DeviceSettings cfg = settings_get();
+  if (action == RECONNECT_FAST) {
+    WiFi.begin(cfg.wifiSsid, cfg.wifiPassword, cfg.wifiChannel, cfg.wifiBssid);
+  } else {
+    WiFi.begin(cfg.wifiSsid, cfg.wifiPassword);
+  }
+}
 
-  StaticJsonDocument<256> doc;
-  if (deserializeJson(doc, f)) {
-    f.close();
+/**
+ * @brief Saves new credentials and reconnects the STA interface in place.
+ *
+ * Runs on wifi_task; the AP stays up so the browser that sent the credentials
+ * can follow the progress through /status.
+ */
+static void apply_credentials(const WifiCommand &cmd) {
+  g_wifiProvisionState = WIFI_PROVISION_SAVING;
+  settings_set_wifi(cmd.ssid, cmd.password, NULL, 0);
+  g_reconnect.setFastConnectAvailable(false);
+  // Written now rather than coalesced: the user waits for it.
+  if (!settings_flush()) {
+    g_wifiProvisionState = WIFI_PROVISION_FAILED;
     return;
   }
-  f.close();
 
-  String ssid = doc["ssid"] | "";
-  String password = doc["password"] | "";
-  if (ssid.length() == 0) return;
+  g_wifiProvisionState = WIFI_PROVISION_CONNECTING;
+  g_provisionStartMs = millis();
+  g_offlineRequested = false;
+  if (isStaConnected()) {
+    // Our own disconnect must not count as a failed attempt.
+    g_ignoreNextDisconnect = true;
+    WiFi.disconnect(false, false);
+  }
+  g_reconnect.connectNow(millis());
+}
+
+/**
+ * @brief Handles GOT_IP on wifi_task: resets the policy and remembers the AP.
+ */
+static void on_sta_got_ip() {
+  static bool firstConnection = true;
+  if (firstConnection) {
+    firstConnection = false;
+    g_bootTimeline.mark("wifi_connected", micros());
+    Serial.printf("[boot] wifi_connected +%lu ms\n", (unsigned long)(micros() / 1000));
+  }
+  g_reconnect.onConnected();
+  if (g_wifiProvisionState == WIFI_PROVISION_CONNECTING) {
+    g_wifiProvisionState = WIFI_PROVISION_CONNECTED;
+  }
+
+  const uint8_t* bssid = WiFi.BSSID();
+  int32_t channel = WiFi.channel();
+  if (bssid && channel > 0) {
+    // A no-op for the store unless the AP changed.
+    DeviceSettings cfg = settings_get();
+    settings_set_wifi(cfg.wifiSsid, cfg.wifiPassword, bssid, channel);
+    g_reconnect.setFastConnectAvailable(true);
+  }
+}
 
-  WiFi.begin(ssid.c_str(), password.c_str());
+/**
+ * @brief Queues new credentials for wifi_task.
+ */
+bool wifi_apply_credentials(const String& ssid, const String& password) {
+  WifiCommand cmd;
+  if (ssid.length() == 0 || ssid.length() >= sizeof(cmd.ssid) ||
+      password.length() >= sizeof(cmd.password)) {
+    return false;
+  }
+  if (g_wifiProvisionState == WIFI_PROVISION_SAVING) return false;
+  cmd.type = WIFI_CMD_APPLY_CREDENTIALS;
+  strlcpy(cmd.ssid, ssid.c_str(), sizeof(cmd.ssid));
+  strlcpy(cmd.password, password.c_str(), sizeof(cmd.password));
+  if (xQueueSend(g_wifiCmdQueue, &cmd, 0) != pdTRUE) return false;
+  g_wifiProvisionState = WIFI_PROVISION_SAVING;
+  return true;
+}
 
-  if (!asyncRetry) {
-    unsigned long t = millis();
-    while (WiFi.status() != WL_CONNECTED && millis() - t < WIFI_CONNECT_TIMEOUT_MS) {
-      delay(250);
+/**
+ * @brief Returns the number of association attempts started so far.
+ */
+uint32_t wifi_reconnect_attempts() {
+  return g_reconnect.attempts();
+}
+
+/**
+ * @brief Returns the API name of a provisioning state.
+ */
+const char* wifi_provision_state_name(WifiProvisionState state) {
+  switch (state) {
+    case WIFI_PROVISION_SAVING: return "saving";
+    case WIFI_PROVISION_CONNECTING: return "connecting";
+    case WIFI_PROVISION_CONNECTED: return "connected";
+    case WIFI_PROVISION_FAILED: return "failed";
+    default: return "idle";
+  }
+}
+
+/**
+ * @brief FreeRTOS task that owns the station: reconnects, credentials and saves.
+ *
+ * WiFi events only post commands here, so no flash access or JSON parsing
+ * happens in the event context. Reconnects use the cached BSSID/channel and
+ * exponential backoff with jitter.
+ */
+void wifi_task(void *parameter) {
+  WifiCommand cmd;
+  supervisor_register(SUPERVISED_WIFI);
+  while (true) {
+    supervisor_check_in(SUPERVISED_WIFI);
+    if (xQueueReceive(g_wifiCmdQueue, &cmd, pdMS_TO_TICKS(WIFI_TASK_POLL_MS)) == pdTRUE) {
+      switch (cmd.type) {
+        case WIFI_CMD_APPLY_CREDENTIALS:
+          apply_credentials(cmd);
+          break;
+        case WIFI_CMD_CONNECT_SAVED:
+          if (settings_get().wifiSsid[0] != '\0') g_reconnect.connectNow(millis());
+          break;
+        case WIFI_CMD_STA_GOT_IP:
+          on_sta_got_ip();
+          break;
+        case WIFI_CMD_STA_DISCONNECTED:
+          if (g_ignoreNextDisconnect) {
+            g_ignoreNextDisconnect = false;
+          } else {
+            g_reconnect.onDisconnected(millis(), esp_random());
+          }
+          break;
+      }
+    }
+
+    g_reconnect.setEnabled(!g_offlineRequested && settings_get().wifiSsid[0] != '\0');
+    ReconnectAction action = g_reconnect.poll(millis(), esp_random());
+    if (action != RECONNECT_NONE) begin_connect(action);
+
+    if (g_wifiProvisionState == WIFI_PROVISION_CONNECTING &&
+        millis() - g_provisionStartMs > (uint32_t)WIFI_CONNECT_TIMEOUT_MS) {
+      // Keep retrying in the background, but tell the user it did not work.
+      g_wifiProvisionState = WIFI_PROVISION_FAILED;
+      uiForceRedraw = true;
     }
+
+    discovery_poll();
   }
 }
 
@@ -101,11 +290,59 @@ bool isStaConnected() {
   return WiFi.status() == WL_CONNECTED;
 }
 
+/**
+ * @brief Answers 429 Too Many Requests with a Retry-After header.
+ *
+ * @param request The rejected request.
+ * @param retryAfterMs Suggested back-off in milliseconds.
+ */
+static void send_too_many_requests(AsyncWebServerRequest *request, uint32_t retryAfterMs) {
+  g_metrics.httpRejected.inc();
+  uint32_t retryAfterS = (retryAfterMs + 999) / 1000;
+  if (retryAfterS == 0) retryAfterS = 1;
+  AsyncWebServerResponse *response =
+      request->beginResponse(429, "application/json", "{\"status\":\"busy\"}");
+  response->addHeader("Retry-After", String(retryAfterS));
+  request->send(response);
+}
+
+/**
+ * @brief Admission control for API handlers.
+ *
+ * Caps the number of requests in flight and, if @p limiter is given, applies
+ * the per-client token bucket. The slot is released when the client disconnects.
+ *
+ * @param request Incoming request.
+ * @param limiter Per-client limiter for the route, or NULL.
+ * @return true if the handler may proceed; otherwise a 429 was already sent.
+ */
+static bool admit_request(AsyncWebServerRequest *request,
+                          ClientRateLimiter<HTTP_RATE_LIMIT_CLIENTS> *limiter) {
+  if (limiter) {
+    uint32_t retryAfterMs = 0;
+    uint32_t ip = (uint32_t)request->client()->remoteIP();
+    if (!limiter->allow(ip, millis(), &retryAfterMs)) {
+      send_too_many_requests(request, retryAfterMs);
+      return false;
+    }
+  }
+  if (!g_httpGate.tryEnter()) {
+    send_too_many_requests(request, 1000);
+    return false;
+  }
+  request->onDisconnect([]() { g_httpGate.leave(); });
+  return true;
+}
+
 /**
  * @brief Sets up the web server and API endpoints.
  */
 void setup_server() {
+  g_rpmLimiter.configure(HTTP_RPM_RATE_PER_S, HTTP_RPM_BURST);
+  g_httpGate.setLimit(HTTP_MAX_CONCURRENT_REQUESTS);
+
   server.on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
+    HttpRouteTimer timer(HTTP_ROUTE_ROOT);
     if (LittleFS.exists("/index.html")) {
       request->send(LittleFS, "/index.html", "text/html");
     } else {
@@ -116,28 +353,27 @@ void setup_server() {
   });
 
   server.on("/status", HTTP_GET, [](AsyncWebServerRequest *request) {
-    StaticJsonDocument<512> doc;
-    float cur = 0.0f;
-    if (xSemaphoreTake(rpmMutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-      cur = currentRpm;
-      xSemaphoreGive(rpmMutex);
-    }
+    HttpRouteTimer timer(HTTP_ROUTE_STATUS);
+    if (!admit_request(request, NULL)) return;
+    MotorStateSnapshot motor = {};
+    g_motorState.read(motor); // lock-free; zeros if it kept colliding with a publish
 
-    if (isStaConnected()) {
-      doc["wifi"] = true;
-      doc["mode"] = "STA";
-      doc["ip"] = WiFi.localIP().toString();
-      doc["ssid"] = WiFi.SSID();
-      doc["rssi"] = WiFi.RSSI();
-      doc["currentRpm"] = cur;
-    } else {
-      doc["wifi"] = false;
-      doc["mode"] = "AP";
-      doc["ip_ap"] = WiFi.softAPIP().toString();
-      doc["ssid"] = "";
-      doc["rssi"] = nullptr;
-      doc["currentRpm"] = 0.0;
-    }
+    StatusInfo info = {};
+    info.staConnected = isStaConnected();
+    // Kept alive until serialization: the document stores the pointers.
+    String ip = info.staConnected ? WiFi.localIP().toString() : WiFi.softAPIP().toString();
+    String ssid = info.staConnected ? WiFi.SSID() : String();
+    info.ip = ip.c_str();
+    info.ssid = ssid.c_str();
+    info.rssi = info.staConnected ? WiFi.RSSI() : 0;
+    info.currentRpm = motor.currentRpm;
+    info.provision = wifi_provision_state_name(g_wifiProvisionState);
+    info.runSeconds = journal_run_seconds();
+    info.resumed = journal_resumed();
+    info.haveStability = g_speedStats.read(info.stability);
+
+    StaticJsonDocument<STATUS_JSON_CAPACITY> doc;
+    status_json_fill(doc, info);
 
     String json;
     serializeJson(doc, json);
@@ -145,15 +381,16 @@ void setup_server() {
   });
 
   server.on("/rpm", HTTP_GET, [](AsyncWebServerRequest *request) {
+    HttpRouteTimer timer(HTTP_ROUTE_RPM);
+    uint32_t ingressUs = micros();
+    if (!admit_request(request, &g_rpmLimiter)) return;
     if (request->hasParam("value")) {
       float val = request->getParam("value")->value().toFloat();
       if (val < 0) val = 0;
-      if (val > MAX_RPM) val = MAX_RPM;
-      if (xSemaphoreTake(rpmMutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-        targetRpm = val;
-        xSemaphoreGive(rpmMutex);
-      }
-      if (val <= 1.0f) stop_motor_hard(false);
+      float maxRpm = settings_get().maxRpm;
+      if (val > maxRpm) val = maxRpm;
+      // motor_task applies it; rapid writes coalesce into the last one.
+      motor_post_setpoint(val, CMD_SOURCE_HTTP, ingressUs);
       request->send(200, "text/plain", "OK");
     } else {
       request->send(400, "text/plain", "Missing value");
@@ -161,52 +398,242 @@ void setup_server() {
   });
 
   server.on("/stop", HTTP_POST, [](AsyncWebServerRequest *request) {
-    stop_motor_hard(false);
-    request->send(200, "application/json", "{\"status\":\"stopped\"}");
+    HttpRouteTimer timer(HTTP_ROUTE_STOP);
+    uint32_t ingressUs = micros();
+    StopMode mode;
+    String name = request->hasParam("mode", true) ? request->getParam("mode", true)->value() : String();
+    if (!stop_mode_parse(name.c_str(), mode)) {
+      request->send(400, "application/json", "{\"status\":\"error\",\"msg\":\"mode must be graceful or hard\"}");
+      return;
+    }
+    motor_stop(mode, CMD_SOURCE_HTTP, ingressUs);
+    request->send(200, "application/json", mode == STOP_MODE_HARD ? "{\"status\":\"stopped\"}" : "{\"status\":\"stopping\"}");
   });
 
   server.on("/scan", HTTP_GET, [](AsyncWebServerRequest *request) {
-    if (g_startScan) {
-      request->send(200, "application/json", "{\"status\":\"scanning\"}");
-    } else {
-      g_startScan = true;
+    HttpRouteTimer timer(HTTP_ROUTE_SCAN);
+    if (!admit_request(request, NULL)) return;
+    if (wifi_scan_request()) {
       request->send(200, "application/json", "{\"status\":\"scan_started\"}");
+    } else {
+      request->send(200, "application/json", "{\"status\":\"scanning\"}");
     }
   });
 
   server.on("/scan-results", HTTP_GET, [](AsyncWebServerRequest *request) {
-    if (g_startScan) {
+    HttpRouteTimer timer(HTTP_ROUTE_SCAN_RESULTS);
+    if (!admit_request(request, NULL)) return;
+    std::shared_ptr<const ScanSnapshot> snap = wifi_scan_snapshot();
+    if (wifi_scan_in_progress() || !snap) {
       request->send(200, "application/json", "{\"status\":\"scanning\"}");
-    } else {
-      if (xSemaphoreTake(g_scanMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        String currentResults = g_scanResults;
-        xSemaphoreGive(g_scanMutex);
-        request->send(200, "application/json", currentResults);
-      } else {
-        request->send(503, "application/json", "{\"status\":\"busy\"}");
-      }
+      return;
     }
+    // Stream straight from the shared snapshot; the lambda keeps it alive.
+    AsyncWebServerResponse *response = request->beginResponse(
+        "application/json", snap->json.size(),
+        [snap](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+          size_t n = snap->json.size() - index;
+          if (n > maxLen) n = maxLen;
+          memcpy(buffer, snap->json.data() + index, n);
+          return n;
+        });
+    request->send(response);
   });
 
   server.on("/saveWifi", HTTP_POST, [](AsyncWebServerRequest *request) {
+    HttpRouteTimer timer(HTTP_ROUTE_SAVE_WIFI);
+    if (!admit_request(request, NULL)) return;
     if (request->hasParam("ssid", true) && request->hasParam("password", true)) {
       String ssid = request->getParam("ssid", true)->value();
       String password = request->getParam("password", true)->value();
-      StaticJsonDocument<256> doc;
-      doc["ssid"] = ssid;
-      doc["password"] = password;
-      File configFile = LittleFS.open("/wifiConfig.json", "w");
-      serializeJson(doc, configFile);
-      configFile.close();
-      String response = "{\"status\":\"ok\", \"message\":\"Guardado. El dispositivo se reiniciara. Busque la nueva IP en la pantalla del BioShaker.\"}";
-      request->send(200, "application/json", response);
-      delay(2000); // Aumentar el retraso para dar tiempo al navegador a mostrar el mensaje
-      ESP.restart();
+      if (wifi_apply_credentials(ssid, password)) {
+        String response = "{\"status\":\"ok\", \"message\":\"Guardado. Conectando a la nueva red; siga el progreso en /status.\"}";
+        request->send(200, "application/json", response);
+      } else {
+        request->send(503, "application/json", "{\"status\":\"error\",\"msg\":\"busy or invalid params\"}");
+      }
     } else {
       request->send(400, "application/json", "{\"status\":\"error\",\"msg\":\"missing params\"}");
     }
   });
 
+  server.on("/config", HTTP_ANY, [](AsyncWebServerRequest *request) {
+    HttpRouteTimer timer(HTTP_ROUTE_CONFIG);
+    if (!admit_request(request, NULL)) return;
+    if (request->method() == HTTP_POST) {
+      // Only the RAM copy changes here; settingsTask writes the file.
+      float maxRpm = request->hasParam("maxRpm", true) ? request->getParam("maxRpm", true)->value().toFloat() : 0;
+      double spr = request->hasParam("stepsPerRev", true) ? request->getParam("stepsPerRev", true)->value().toDouble() : 0;
+      settings_set_calibration(maxRpm, spr);
+    }
+    DeviceSettings cfg = settings_get();
+    StaticJsonDocument<192> doc;
+    doc["language"] = cfg.language;
+    doc["maxRpm"] = cfg.maxRpm;
+    doc["stepsPerRev"] = cfg.measStepsPerRev;
+    doc["lastTargetRpm"] = cfg.lastTargetRpm;
+    doc["commits"] = settings_commits();
+    String json;
+    serializeJson(doc, json);
+    request->send(200, "application/json", json);
+  });
+
+  server.on("/estop", HTTP_ANY, [](AsyncWebServerRequest *request) {
+    HttpRouteTimer timer(HTTP_ROUTE_ESTOP);
+    // No admission control: a stop must never be answered 429.
+    int code = 200;
+    if (request->method() == HTTP_POST) {
+      String action = request->hasParam("action", true) ? request->getParam("action", true)->value() : String();
+      if (action == "trip") {
+        motor_estop_trigger();
+      } else if (action == "ack") {
+        if (!motor_estop_acknowledge()) code = 409; // input still in its stop state
+      } else {
+        request->send(400, "application/json", "{\"status\":\"error\",\"msg\":\"action must be trip or ack\"}");
+        return;
+      }
+    }
+    EStopStatus st = motor_estop_status();
+    double cyclesPerUs = getCpuFrequencyMhz();
+    StaticJsonDocument<192> doc;
+    doc["latched"] = st.latched;
+    doc["source"] = estop_source_name(st.source);
+    doc["trips"] = st.trips;
+    doc["lastLatencyUs"] = st.lastLatencyCycles / cyclesPerUs;
+    doc["maxLatencyUs"] = st.maxLatencyCycles / cyclesPerUs;
+    String json;
+    serializeJson(doc, json);
+    request->send(code, "application/json", json);
+  });
+
+  server.on("/pattern", HTTP_ANY, [](AsyncWebServerRequest *request) {
+    HttpRouteTimer timer(HTTP_ROUTE_PATTERN);
+    if (!admit_request(request, NULL)) return;
+    if (request->method() == HTTP_POST) {
+      // Uploaded once; motor_task runs it from then on without the network.
+      SpeedPattern p = {};
+      String shape = request->hasParam("shape", true) ? request->getParam("shape", true)->value() : String();
+      p.shape = PATTERN_SHAPE_COUNT;
+      for (uint8_t s = 0; s < PATTERN_SHAPE_COUNT; ++s) {
+        if (shape == pattern_shape_name(s)) p.shape = s;
+      }
+      p.highRpm = request->hasParam("high", true) ? request->getParam("high", true)->value().toFloat() : 0;
+      p.lowRpm = request->hasParam("low", true) ? request->getParam("low", true)->value().toFloat() : 0;
+      p.periodMs = request->hasParam("period", true) ? request->getParam("period", true)->value().toInt() : 0;
+      p.onMs = request->hasParam("on", true) ? request->getParam("on", true)->value().toInt() : 0;
+      p.cycles = request->hasParam("cycles", true) ? request->getParam("cycles", true)->value().toInt() : 0;
+      if (!pattern_valid(p, settings_get().maxRpm)) {
+        request->send(400, "application/json", "{\"status\":\"error\",\"msg\":\"invalid pattern\"}");
+        return;
+      }
+      motor_start_pattern(p);
+    }
+    MotorStateSnapshot motor = {};
+    g_motorState.read(motor);
+    StaticJsonDocument<256> doc;
+    doc["active"] = motor.patternActive != 0;
+    doc["cycle"] = motor.patternCycle;
+    SpeedPattern p;
+    if (motor_last_pattern(p)) {
+      doc["shape"] = pattern_shape_name(p.shape);
+      doc["high"] = p.highRpm;
+      doc["low"] = p.lowRpm;
+      doc["period"] = p.periodMs;
+      doc["on"] = p.onMs;
+      doc["cycles"] = p.cycles;
+    }
+    String json;
+    serializeJson(doc, json);
+    request->send(200, "application/json", json);
+  });
+
+  server.on("/metrics", HTTP_GET, [](AsyncWebServerRequest *request) {
+    HttpRouteTimer timer(HTTP_ROUTE_METRICS);
+    if (!admit_request(request, NULL)) return;
+    // Rendered line by line into the server's send buffer as the client reads.
+    std::shared_ptr<PromStream<TELEMETRY_MAX_SERIES>> stream = telemetry_open_stream();
+    AsyncWebServerResponse *response = request->beginChunkedResponse(
+        "text/plain; version=0.0.4",
+        [stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+          return stream->fill(buffer, maxLen);
+        });
+    request->send(response);
+  });
+
+  server.on("/debug/tasks", HTTP_GET, [](AsyncWebServerRequest *request) {
+    HttpRouteTimer timer(HTTP_ROUTE_DEBUG_TASKS);
+    if (!admit_request(request, NULL)) return;
+    std::shared_ptr<const TaskReport> report = task_monitor_report();
+    if (!report) {
+      request->send(503, "application/json", "{\"status\":\"sampling\"}");
+      return;
+    }
+    AsyncWebServerResponse *response = request->beginResponse(
+        "application/json", report->json.size(),
+        [report](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+          size_t n = report->json.size() - index;
+          if (n > maxLen) n = maxLen;
+          memcpy(buffer, report->json.data() + index, n);
+          return n;
+        });
+    request->send(response);
+  });
+
+  server.on("/debug/trace", HTTP_POST, [](AsyncWebServerRequest *request) {
+    HttpRouteTimer timer(HTTP_ROUTE_DEBUG_TRACE);
+    if (!admit_request(request, NULL)) return;
+    if (!request->hasParam("enable", true)) {
+      request->send(400, "application/json", "{\"status\":\"error\",\"msg\":\"missing enable\"}");
+      return;
+    }
+    bool on = request->getParam("enable", true)->value() != "0";
+    trace_set_enabled(on);
+    request->send(200, "application/json", on ? "{\"trace\":\"on\"}" : "{\"trace\":\"off\"}");
+  });
+
+  server.on("/debug/trace", HTTP_GET, [](AsyncWebServerRequest *request) {
+    HttpRouteTimer timer(HTTP_ROUTE_DEBUG_TRACE);
+    if (!admit_request(request, NULL)) return;
+    // Chrome trace JSON for Perfetto, rendered event by event as the client reads.
+    std::shared_ptr<DeviceTraceStream> stream = trace_open_stream();
+    AsyncWebServerResponse *response = request->beginChunkedResponse(
+        "application/json",
+        [stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+          return stream->fill(buffer, maxLen);
+        });
+    request->send(response);
+  });
+
+  server.on("/debug/jitter", HTTP_GET, [](AsyncWebServerRequest *request) {
+    HttpRouteTimer timer(HTTP_ROUTE_DEBUG_JITTER);
+    if (!admit_request(request, NULL)) return;
+    if (request->hasParam("run")) {
+      long seconds = request->getParam("run")->value().toInt();
+      if (seconds < 1 || seconds > (long)JITTER_PROBE_MAX_SECONDS) {
+        request->send(400, "application/json", "{\"error\":\"run must be 1..60 seconds\"}");
+      } else if (!jitter_probe_start((uint32_t)seconds)) {
+        request->send(409, "application/json", "{\"error\":\"already running\"}");
+      } else {
+        request->send(202, "application/json", "{\"status\":\"started\"}");
+      }
+      return;
+    }
+    std::shared_ptr<const JitterReport> report = jitter_probe_report();
+    if (!report) {
+      request->send(404, "application/json", "{\"status\":\"not run\"}");
+      return;
+    }
+    AsyncWebServerResponse *response = request->beginResponse(
+        "application/json", report->json.size(),
+        [report](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+          size_t n = report->json.size() - index;
+          if (n > maxLen) n = maxLen;
+          memcpy(buffer, report->json.data() + index, n);
+          return n;
+        });
+    request->send(response);
+  });
+
   server.serveStatic("/", LittleFS, "/");
   server.begin();
 }
@@ -215,43 +642,26 @@ void setup_server() {
  * @brief WiFi event handler.
  */
 void on_wifi_event(WiFiEvent_t event) {
+  TRACE_INSTANT("wifi_event", (uint32_t)event);
   uiForceRedraw = true;
   switch (event) {
     case SYSTEM_EVENT_STA_GOT_IP:
       g_offlineRequested = false;
       uiState = UI_NORMAL;
+      post_wifi_command(WIFI_CMD_STA_GOT_IP);
       break;
     case SYSTEM_EVENT_STA_DISCONNECTED:
       if (!g_offlineRequested) {
-        uiState = UI_WIFI_DISCONNECTED;
-        tryConnectSavedWifi(true);
+        // A failed attempt while the UI waits for it is not a lost connection.
+        if (uiState != UI_WIFI_CONNECTING) uiState = UI_WIFI_DISCONNECTED;
+        // wifi_task decides when to retry; nothing slow runs in the event context.
+        post_wifi_command(WIFI_CMD_STA_DISCONNECTED);
       }
       break;
+    case SYSTEM_EVENT_SCAN_DONE:
+      wifi_scan_on_done();
+      break;
     default:
       break;
   }
 }
-
-/**
- * @brief Tarea de FreeRTOS que gestiona el escaneo de redes WiFi en segundo plano.
- */
-void wifi_scan_task(void *parameter) {
-  while (true) {
-    if (g_startScan) {
-      g_startScan = false;
-      int n = WiFi.scanNetworks();
-
-      StaticJsonDocument<1024> doc;
-      JsonArray redes = doc.to<JsonArray>();
-      for (int i = 0; i < n; ++i) {
-        redes.add(WiFi.SSID(i));
-      }
-
-      if (xSemaphoreTake(g_scanMutex, portMAX_DELAY) == pdTRUE) {
-        serializeJson(redes, g_scanResults);
-        xSemaphoreGive(g_scanMutex);
-      }
-    }
-    vTaskDelay(pdMS_TO_TICKS(1000));
-  }
-}
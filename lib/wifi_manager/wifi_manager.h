@@ -9,11 +9,62 @@
  * @brief Gestión de la conectividad WiFi y del servidor web.
  */
 
+/**
+ * @brief Progreso de la aplicación de nuevas credenciales WiFi.
+ *
+ * Se publica en `/status` (campo `provision`) para que la interfaz web pueda
+ * seguir la reconexión sin que el dispositivo se reinicie.
+ */
+enum WifiProvisionState {
+  WIFI_PROVISION_IDLE,        ///< No hay credenciales nuevas en curso.
+  WIFI_PROVISION_SAVING,      ///< Guardando las credenciales en `/config.bin`.
+  WIFI_PROVISION_CONNECTING,  ///< Asociándose a la nueva red.
+  WIFI_PROVISION_CONNECTED,   ///< Conectado con las nuevas credenciales.
+  WIFI_PROVISION_FAILED       ///< No se pudo conectar; el modo AP sigue activo.
+};
+
+extern volatile WifiProvisionState g_wifiProvisionState;
+
+/**
+ * @brief Número de intentos de conexión STA iniciados por `wifi_task`.
+ */
+uint32_t wifi_reconnect_attempts();
+
 /**
  * @brief Inicializa el WiFi, el servidor web y los eventos asociados.
  */
 void wifi_setup();
 
+/**
+ * @brief Devuelve el nombre de un estado de aprovisionamiento para la API.
+ *
+ * @param state Estado a convertir.
+ * @return Cadena estática (`idle`, `saving`, `connecting`, `connected`, `failed`).
+ */
+const char* wifi_provision_state_name(WifiProvisionState state);
+
+/**
+ * @brief Encola nuevas credenciales para que `wifi_task` las guarde y aplique.
+ *
+ * No bloquea: el guardado en LittleFS y la reconexión se hacen en la tarea
+ * de WiFi mientras el motor sigue funcionando.
+ *
+ * @param ssid SSID de la red (máximo 32 caracteres).
+ * @param password Contraseña (máximo 64 caracteres).
+ * @return `true` si se encoló, `false` si los parámetros no son válidos o ya
+ *         hay una reconfiguración pendiente.
+ */
+bool wifi_apply_credentials(const String& ssid, const String& password);
+
+/**
+ * @brief Tarea de FreeRTOS que ejecuta las operaciones WiFi lentas.
+ *
+ * Guarda credenciales y se reconecta en caliente, sin reiniciar el dispositivo.
+ *
+ * @param parameter Puntero a los parámetros de la tarea (no se usa).
+ */
+void wifi_task(void *parameter);
+
 /**
  * @brief Inicia el dispositivo en modo AP+STA.
  *
@@ -22,11 +73,14 @@ void wifi_setup();
 void startAPAlways();
 
 /**
- * @brief Intenta conectarse a una red WiFi previamente guardada.
+ * @brief Pide a `wifi_task` que se conecte a la red WiFi guardada.
+ *
+ * No bloquea: la asociación termina en segundo plano y el resultado se
+ * consulta con isStaConnected().
  *
- * @param asyncRetry Si es `true`, el intento de conexión no es bloqueante.
+ * @return `true` si la petición quedó en cola.
  */
-void tryConnectSavedWifi(bool asyncRetry);
+bool tryConnectSavedWifi();
 
 /**
  * @brief Desconecta el WiFi y apaga la radio.
@@ -40,11 +94,4 @@ void goOffline();
  */
 bool isStaConnected();
 
-/**
- * @brief Tarea de FreeRTOS que gestiona el escaneo de redes WiFi en segundo plano.
- *
- * @param parameter Puntero a los parámetros de la tarea (no se usa).
- */
-void wifi_scan_task(void *parameter);
-
 #endif // WIFI_MANAGER_H
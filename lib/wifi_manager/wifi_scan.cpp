@@ -0,0 +1,118 @@
+#include "wifi_scan.h"
+#include "trace.h"
+#include "task_monitor.h"
+#include <WiFi.h>
+
+// ============================
+// Constantes del servicio
+// ============================
+const uint32_t WIFI_SCAN_TTL_MS = 60000;        // Entries not seen for this long are dropped
+const uint32_t WIFI_SCAN_TIMEOUT_MS = 15000;    // Give up if SCAN_DONE never arrives
+const size_t WIFI_SCAN_CACHE_CAPACITY = 32;
+
+// Task notification bits
+const uint32_t SCAN_NOTIFY_REQUEST = 1u << 0;
+const uint32_t SCAN_NOTIFY_DONE = 1u << 1;
+
+static TaskHandle_t g_scanTask = NULL;
+static volatile bool g_scanInProgress = false;
+static ScanCache g_scanCache(WIFI_SCAN_CACHE_CAPACITY, WIFI_SCAN_TTL_MS);
+static SnapshotSlot<ScanSnapshot> g_scanSnapshot;
+
+/**
+ * @brief Creates the scan service task.
+ */
+void wifi_scan_setup() {
+  task_start(TASK_WIFI_SCAN, wifi_scan_task, NULL, &g_scanTask);
+}
+
+/**
+ * @brief Asks the scan service for a new scan.
+ */
+bool wifi_scan_request() {
+  if (g_scanInProgress || g_scanTask == NULL) return false;
+  g_scanInProgress = true; // visible to /scan-results before the task wakes up
+  xTaskNotify(g_scanTask, SCAN_NOTIFY_REQUEST, eSetBits);
+  return true;
+}
+
+bool wifi_scan_in_progress() {
+  return g_scanInProgress;
+}
+
+std::shared_ptr<const ScanSnapshot> wifi_scan_snapshot() {
+  return g_scanSnapshot.get();
+}
+
+/**
+ * @brief Called from the WiFi event handler when SCAN_DONE arrives.
+ */
+void wifi_scan_on_done() {
+  if (g_scanTask) xTaskNotify(g_scanTask, SCAN_NOTIFY_DONE, eSetBits);
+}
+
+/**
+ * @brief Maps the driver authentication mode to ScanAuth.
+ */
+static uint8_t to_scan_auth(wifi_auth_mode_t mode) {
+  switch (mode) {
+    case WIFI_AUTH_OPEN: return SCAN_AUTH_OPEN;
+    case WIFI_AUTH_WEP: return SCAN_AUTH_WEP;
+    case WIFI_AUTH_WPA_PSK: return SCAN_AUTH_WPA;
+    case WIFI_AUTH_WPA2_PSK: return SCAN_AUTH_WPA2;
+    case WIFI_AUTH_WPA_WPA2_PSK: return SCAN_AUTH_WPA_WPA2;
+    case WIFI_AUTH_WPA2_ENTERPRISE: return SCAN_AUTH_WPA2_ENTERPRISE;
+    case WIFI_AUTH_WPA3_PSK: return SCAN_AUTH_WPA3;
+    default: return SCAN_AUTH_OTHER;
+  }
+}
+
+/**
+ * @brief Merges the driver results into the cache and publishes a snapshot.
+ */
+static void collect_results() {
+  int16_t n = WiFi.scanComplete();
+  uint32_t now = millis();
+  for (int16_t i = 0; i < n; ++i) {
+    g_scanCache.add(WiFi.SSID(i).c_str(), (int8_t)WiFi.RSSI(i), (uint8_t)WiFi.channel(i),
+                    to_scan_auth(WiFi.encryptionType(i)), now);
+  }
+  WiFi.scanDelete();
+  g_scanCache.expire(now);
+  g_scanSnapshot.publish(g_scanCache.snapshot(now));
+}
+
+/**
+ * @brief FreeRTOS task that runs asynchronous scans on request.
+ */
+void wifi_scan_task(void *parameter) {
+  bool running = false;
+  uint32_t scanStartMs = 0;
+  while (true) {
+    uint32_t bits = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &bits, pdMS_TO_TICKS(1000));
+
+    if ((bits & SCAN_NOTIFY_REQUEST) && !running) {
+      if (WiFi.scanNetworks(true) == WIFI_SCAN_RUNNING) {
+        running = true;
+        TRACE_INSTANT("scan_start", 0);
+        scanStartMs = millis();
+      } else {
+        g_scanInProgress = false;
+      }
+    }
+
+    if (running) {
+      if ((bits & SCAN_NOTIFY_DONE) || WiFi.scanComplete() >= 0) {
+        collect_results();
+        TRACE_INSTANT("scan_done", (uint32_t)(millis() - scanStartMs));
+        running = false;
+        g_scanInProgress = false;
+      } else if (millis() - scanStartMs > WIFI_SCAN_TIMEOUT_MS) {
+        WiFi.scanDelete();
+        running = false;
+        g_scanInProgress = false;
+      }
+    }
+  }
+}
@@ -0,0 +1,54 @@
+#ifndef WIFI_SCAN_H
+#define WIFI_SCAN_H
+
+#include "config.h"
+#include <Arduino.h>
+#include "scan_cache.h"
+
+/**
+ * @file wifi_scan.h
+ * @brief Servicio único de escaneo WiFi compartido por la LCD y la API web.
+ *
+ * El escaneo es asíncrono (`WiFi.scanNetworks(true)`): la tarea del servicio
+ * lo inicia y recoge los resultados cuando llega el evento de fin de escaneo.
+ * Los consumidores obtienen una instantánea inmutable con recuento de
+ * referencias, de modo que nunca esperan ni copian los resultados.
+ */
+
+/**
+ * @brief Crea la tarea del servicio de escaneo.
+ */
+void wifi_scan_setup();
+
+/**
+ * @brief Solicita un escaneo sin bloquear.
+ *
+ * @return `true` si se inició un escaneo nuevo, `false` si ya había uno en curso.
+ */
+bool wifi_scan_request();
+
+/**
+ * @brief Indica si hay un escaneo en curso.
+ */
+bool wifi_scan_in_progress();
+
+/**
+ * @brief Devuelve la última instantánea publicada (puede ser `nullptr`).
+ */
+std::shared_ptr<const ScanSnapshot> wifi_scan_snapshot();
+
+/**
+ * @brief Notifica al servicio que el driver terminó el escaneo.
+ *
+ * Se llama desde el manejador de eventos WiFi; solo despierta a la tarea.
+ */
+void wifi_scan_on_done();
+
+/**
+ * @brief Tarea de FreeRTOS del servicio de escaneo.
+ *
+ * @param parameter Puntero a los parámetros de la tarea (no se usa).
+ */
+void wifi_scan_task(void *parameter);
+
+#endif // WIFI_SCAN_H
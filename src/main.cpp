@@ -4,7 +4,15 @@
 #include "motor_control.h"
 #include "ui_manager.h"
 #include "wifi_manager.h"
+#include "modbus_slave.h"
+#include "telemetry.h"
+#include "task_monitor.h"
+#include "supervisor.h"
+#include "settings.h"
+#include "journal.h"
+#include "serial_console.h"
 #include "config.h"
+#include "boot_timeline.h"
 
 // ============================
 // Definiciones de Configuración
@@ -17,32 +25,125 @@ const IPAddress AP_IP(192, 168, 4, 1);
 const IPAddress AP_GATEWAY(192, 168, 4, 1);
 const IPAddress AP_SUBNET(255, 255, 255, 0);
 const int WIFI_CONNECT_TIMEOUT_MS = 20000;
+const uint32_t HTTP_RPM_RATE_PER_S = 10;
+const uint32_t HTTP_RPM_BURST = 20;
+const int HTTP_MAX_CONCURRENT_REQUESTS = 8;
+const uint16_t MODBUS_TCP_PORT = 502;
+const uint8_t MODBUS_SLAVE_UID = 1;
+const bool SERIAL_SCPI_ENABLED = true;
+const uint32_t SERIAL_SCPI_POLL_MS = 20;
+const uint32_t TASK_PROFILER_PERIOD_MS = 5000;
+const uint32_t TASK_PROFILER_SERIAL_PERIOD_MS = 60000;
+const bool TRACE_ENABLED_AT_BOOT = false;
+const uint32_t SPEED_STATS_LOG_PERIOD_MS = 600000;
+const uint32_t JITTER_PROBE_PERIOD_MS = 1;
+const uint8_t CONTROL_STALL_RESTART_S = 3;
+const bool POWER_LOSS_RESUME = true;
+const uint32_t RUN_JOURNAL_PERIOD_S = 60;
+const float STOP_DECEL_RPM_PER_S = 60.0f;
+const uint32_t STOP_MAX_TIME_MS = 5000;
+const bool ESTOP_INPUT_ENABLED = false;
 
 // ============================
 // Variables Globales
 // ============================
 SemaphoreHandle_t rpmMutex;
+BootTimeline g_bootTimeline;
+static SemaphoreHandle_t g_bootHwDone;
+static SemaphoreHandle_t g_settingsLoaded;
+
+/**
+ * @brief Prints the boot timeline recorded so far over Serial.
+ */
+static void print_boot_timeline() {
+  char buf[BootTimeline::MAX_MARKS * 80];
+  g_bootTimeline.format(buf, sizeof(buf));
+  Serial.print("[boot] timeline:\n");
+  serial_log("boot", buf);
+  uint32_t ready = g_bootTimeline.timeOf("ready");
+  if (ready != UINT32_MAX) {
+    Serial.printf("[boot] ready in %lu ms; phases add up to %lu ms\n", (unsigned long)(ready / 1000),
+                  (unsigned long)(g_bootTimeline.phaseSumUs() / 1000));
+  }
+}
+
+/**
+ * @brief Brings up the motor driver, LCD and encoder, then starts the control tasks.
+ *
+ * Runs on core 1 (where setup() used to do it, so the stepper and encoder
+ * interrupts stay there) while setup() mounts LittleFS and starts the radio.
+ * The tasks are only created once the stored settings are loaded, so they
+ * never see the defaults.
+ */
+static void boot_hw_task(void *parameter) {
+  uint32_t t0 = micros();
+  motor_setup();
+  uint32_t t1 = micros();
+  g_bootTimeline.span("motor_setup", t0, t1);
+  ui_setup();
+  g_bootTimeline.span("ui_setup", t1, micros());
+
+  xSemaphoreTake(g_settingsLoaded, portMAX_DELAY);
+  task_start(TASK_UI, ui_task);
+  task_start(TASK_MOTOR, motor_task);
+  g_bootTimeline.mark("motor_ready", micros());
+
+  xSemaphoreGive(g_bootHwDone);
+  vTaskDelete(NULL);
+}
 
 void setup() {
+  g_bootTimeline.mark("reset", 0);
   Serial.begin(115200);
-  delay(80);
+  g_bootTimeline.mark("serial", micros());
+
+  rpmMutex = xSemaphoreCreateMutex();
+  telemetry_setup();
+  trace_set_enabled(TRACE_ENABLED_AT_BOOT);
+
+  // Before any supervised task starts, so they can subscribe to the watchdog.
+  supervisor_setup();
+
+  // Control first, in parallel: the motor and the LCD must not wait for the FS or the radio.
+  g_bootHwDone = xSemaphoreCreateBinary();
+  g_settingsLoaded = xSemaphoreCreateBinary();
+  task_start(TASK_BOOT_HW, boot_hw_task);
 
+  uint32_t t0 = micros();
   if (!LittleFS.begin()) {
-    Serial.println("LittleFS mount failed");
+    Serial.print("[fs] LittleFS mount failed\n");
   }
+  uint32_t t1 = micros();
+  g_bootTimeline.span("littlefs", t0, t1);
+  settings_setup();
+  xSemaphoreGive(g_settingsLoaded);
+  uint32_t t2 = micros();
+  g_bootTimeline.span("settings", t1, t2);
+  journal_setup();
+  uint32_t t3 = micros();
+  g_bootTimeline.span("journal", t2, t3);
 
-  rpmMutex = xSemaphoreCreateMutex();
-
-  motor_setup();
-  ui_setup();
+  // AP + HTTP server; the STA association continues in wifi_task.
   wifi_setup();
+  uint32_t t4 = micros();
+  g_bootTimeline.span("wifi_setup", t3, t4);
+  g_bootTimeline.mark("http_ready", t4);
+
+  modbus_setup();
+  g_bootTimeline.span("modbus_setup", t4, micros());
+
+  task_monitor_setup();
+
+  xSemaphoreTake(g_bootHwDone, portMAX_DELAY);
+  g_bootTimeline.mark("ready", micros());
+  print_boot_timeline();
 
-  xTaskCreatePinnedToCore(ui_task, "uiTask", 4096, NULL, 1, NULL, 0);
-  xTaskCreatePinnedToCore(motor_task, "motorTask", 4096, NULL, 2, NULL, 1);
+  // After the boot report, so a host on the port only sees replies from here on.
+  serial_console_setup();
 }
 
 void loop() {
-  // El loop principal está ahora vacío, ya que todo se gestiona en las tareas de FreeRTOS.
-  // Se podría añadir aquí lógica de bajo nivel si fuera necesario en el futuro.
-  vTaskDelay(pdMS_TO_TICKS(1000));
+  // Todo corre en las tareas de TASK_PLAN. loopTask está fijada al núcleo 1
+  // (CONFIG_ARDUINO_RUNNING_CORE); se borra para dejar ese núcleo al control.
+  vTaskDelete(NULL);
 }
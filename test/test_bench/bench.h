@@ -0,0 +1,120 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/**
+ * @brief Minimal microbenchmark harness for the native test environment.
+ *
+ * The iteration count is doubled until one sample takes BENCH_MIN_SAMPLE_NS,
+ * a few samples are discarded as warm-up, and BENCH_SAMPLES timed samples
+ * are kept. Results are per call, in nanoseconds of host time: compare runs
+ * of the same build on the same machine, not against the ESP32.
+ *
+ * Each result is printed as one `BENCH {...}` JSON line and, when
+ * BENCH_OUTPUT names a file, appended to it as JSON Lines.
+ */
+
+const uint64_t BENCH_MIN_SAMPLE_NS = 1000000;
+const size_t BENCH_WARMUP = 3;
+const size_t BENCH_SAMPLES = 31;
+
+struct BenchResult {
+    const char *name;
+    uint64_t iterations;   ///< Calls per sample.
+    size_t samples;
+    double medianNs;
+    double minNs;
+    double p90Ns;
+    double madNs;          ///< Median absolute deviation from the median.
+    double ciLowNs;        ///< 95% confidence interval of the median (order statistics).
+    double ciHighNs;
+};
+
+/** @brief Keeps @p value alive so the compiler cannot drop the code computing it. */
+template <typename T>
+inline void bench_keep(const T &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline uint64_t bench_now_ns() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+template <typename F>
+inline double bench_sample_ns(F &body, uint64_t iterations) {
+    uint64_t start = bench_now_ns();
+    for (uint64_t i = 0; i < iterations; ++i) body();
+    return (double)(bench_now_ns() - start);
+}
+
+/** @brief Writes @p r as one JSON object, without a newline. */
+inline void bench_print_json(FILE *out, const BenchResult &r) {
+    fprintf(out,
+            "{\"name\":\"%s\",\"unit\":\"ns\",\"iterations\":%llu,\"samples\":%zu,\"median\":%.3f,"
+            "\"min\":%.3f,\"p90\":%.3f,\"mad\":%.3f,\"ci95\":[%.3f,%.3f]}",
+            r.name, (unsigned long long)r.iterations, r.samples, r.medianNs, r.minNs, r.p90Ns, r.madNs,
+            r.ciLowNs, r.ciHighNs);
+}
+
+inline void bench_report(const BenchResult &r) {
+    printf("BENCH ");
+    bench_print_json(stdout, r);
+    printf("\n");
+    const char *path = getenv("BENCH_OUTPUT");
+    if (!path || !path[0]) return;
+    FILE *f = fopen(path, "a");
+    if (!f) return;
+    bench_print_json(f, r);
+    fprintf(f, "\n");
+    fclose(f);
+}
+
+/**
+ * @brief Times @p body (one call per iteration) and reports the result.
+ */
+template <typename F>
+BenchResult bench_run(const char *name, F body) {
+    uint64_t iterations = 1;
+    while (bench_sample_ns(body, iterations) < BENCH_MIN_SAMPLE_NS && iterations < (1ull << 40)) iterations *= 2;
+    for (size_t i = 0; i < BENCH_WARMUP; ++i) bench_sample_ns(body, iterations);
+
+    std::vector<double> perCall(BENCH_SAMPLES);
+    for (size_t i = 0; i < BENCH_SAMPLES; ++i) perCall[i] = bench_sample_ns(body, iterations) / iterations;
+    std::sort(perCall.begin(), perCall.end());
+
+    const size_t n = perCall.size();
+    BenchResult r = {};
+    r.name = name;
+    r.iterations = iterations;
+    r.samples = n;
+    r.medianNs = perCall[n / 2];
+    r.minNs = perCall[0];
+    r.p90Ns = perCall[(size_t)(0.9 * (n - 1))];
+
+    std::vector<double> dev(n);
+    for (size_t i = 0; i < n; ++i) dev[i] = std::fabs(perCall[i] - r.medianNs);
+    std::sort(dev.begin(), dev.end());
+    r.madNs = dev[n / 2];
+
+    // 1-based ranks floor(n/2 - 0.98 sqrt(n)) and ceil(1 + n/2 + 0.98 sqrt(n)):
+    // normal approximation of the binomial, 10 and 22 for 31 samples.
+    double half = 0.98 * std::sqrt((double)n);
+    size_t lo = (size_t)std::max(0.0, std::floor(n / 2.0 - half) - 1);
+    size_t hi = (size_t)std::min((double)(n - 1), std::ceil(n / 2.0 + half));
+    r.ciLowNs = perCall[lo];
+    r.ciHighNs = perCall[hi];
+
+    bench_report(r);
+    return r;
+}
+
+#endif // BENCH_H
@@ -0,0 +1,238 @@
+#include <unity.h>
+#include <cstring>
+#include "bench.h"
+#include "shared_logic.h"
+#include "motion_math.h"
+#include "step_tables.h"
+#include "scan_cache.h"
+#include "lcd_format.h"
+#include "config_store.h"
+#include "status_json.h"
+
+// Each test times one hot path of the firmware and checks its output, so a
+// benchmark cannot silently measure code that no longer does the real work.
+
+/**
+ * @brief Setpoint conversion done for every command motor_task applies.
+ */
+void bench_rpm2sps() {
+    volatile double rpm = 120.0;
+    double out = 0.0;
+    bench_run("rpm2sps", [&]() {
+        out = rpm2sps(rpm);
+        bench_keep(out);
+    });
+    TEST_ASSERT_EQUAL_DOUBLE(2.0 * SPR_CMD, out);
+}
+
+/**
+ * @brief motor_task's setpoint conversion in float and Q16.16, RPM to mHz.
+ *
+ * On the host all three cost about the same; the ESP32 cycle counts are in
+ * test/test_motion_cycles.
+ */
+void bench_rpm_to_milli_hz() {
+    volatile float rpm = 120.0f;
+    uint32_t viaFloat = 0, viaQ16 = 0, viaDouble = 0;
+    bench_run("rpm_to_milli_hz_double", [&]() {
+        viaDouble = (uint32_t)(rpm2sps(rpm) * 1000.0);
+        bench_keep(viaDouble);
+    });
+    bench_run("rpm_to_milli_hz_float", [&]() {
+        viaFloat = sps_to_milli_hz(rpm_to_sps((float)rpm));
+        bench_keep(viaFloat);
+    });
+    bench_run("rpm_to_milli_hz_q16", [&]() {
+        viaQ16 = sps_to_milli_hz(rpm_to_sps(Q16_16::fromFloat(rpm)));
+        bench_keep(viaQ16);
+    });
+    TEST_ASSERT_EQUAL_UINT32(viaDouble, viaFloat);
+    TEST_ASSERT_UINT32_WITHIN(5, viaDouble, viaQ16);
+}
+
+/**
+ * @brief Step period for a setpoint: table lookup against a float division.
+ *
+ * The host divides in hardware, so here the lookup is not the faster one;
+ * see test/test_motion_cycles for the ESP32.
+ */
+void bench_rpm_to_ticks() {
+    volatile float rpm = 137.5f;
+    uint32_t viaTable = 0, viaDivision = 0;
+    bench_run("rpm_to_ticks_division", [&]() {
+        viaDivision = (uint32_t)(STEPPER_TICKS_PER_S * 60.0f / (rpm * (float)SPR_CMD) + 0.5f);
+        bench_keep(viaDivision);
+    });
+    bench_run("rpm_to_ticks_table", [&]() {
+        viaTable = rpm_to_ticks((float)rpm);
+        bench_keep(viaTable);
+    });
+    TEST_ASSERT_UINT32_WITHIN(2, viaDivision, viaTable);
+}
+
+/**
+ * @brief One window of the ui_task speed estimator.
+ */
+void bench_rpm_estimator() {
+    const double stepsPerRev = 3200.0;
+    const uint32_t windowMs = 100;
+    // 60 RPM: one revolution per second, a tenth of it per window.
+    const int32_t stepsPerWindow = (int32_t)(stepsPerRev / 10.0);
+    RpmEstimator estimator;
+    estimator.reset(0);
+    uint32_t position = 0;  // wraps like the driver's counter
+    float rpm = 0.0f;
+    bench_run("rpm_estimator_update", [&]() {
+        position += stepsPerWindow;
+        rpm = estimator.update((int32_t)position, stepsPerRev, windowMs);
+        bench_keep(rpm);
+    });
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 60.0f, rpm);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 60.0f, estimator.smoothed());
+}
+
+static StatusInfo sample_status() {
+    StatusInfo info = {};
+    info.staConnected = true;
+    info.ip = "192.168.1.57";
+    info.ssid = "Laboratorio-2.4G";
+    info.rssi = -61;
+    info.currentRpm = 149.7f;
+    info.provision = "idle";
+    info.runSeconds = 5421;
+    info.resumed = false;
+    info.haveStability = true;
+    SpeedStabilityReport &st = info.stability;
+    st.state = 2;
+    st.targetRpm = 150.0f;
+    st.samples = 5400;
+    st.durationMs = 540000;
+    st.tau0Ms = 100;
+    st.meanError = -0.12f;
+    st.rmsError = 0.41f;
+    st.peakError = 1.9f;
+    for (size_t i = 0; i < 3; ++i) {
+        st.adev[i] = 0.3f / (i + 1);
+        st.adevPairs[i] = 100;
+    }
+    return info;
+}
+
+/**
+ * @brief Building and serializing the /status document.
+ */
+void bench_status_json() {
+    const StatusInfo info = sample_status();
+    char out[STATUS_JSON_CAPACITY];
+    size_t len = 0;
+    bench_run("status_json", [&]() {
+        StaticJsonDocument<STATUS_JSON_CAPACITY> doc;
+        status_json_fill(doc, info);
+        len = serializeJson(doc, out, sizeof(out));
+        bench_keep(len);
+    });
+    TEST_ASSERT_GREATER_THAN(0, len);
+    TEST_ASSERT_NOT_NULL(strstr(out, "\"mode\":\"STA\""));
+    TEST_ASSERT_NOT_NULL(strstr(out, "\"allan\":[{"));
+}
+
+/**
+ * @brief Sorting a full scan round and rendering the /scan JSON.
+ */
+void bench_scan_snapshot() {
+    ScanCache cache(32, 60000);
+    char ssid[33];
+    for (int i = 0; i < 20; ++i) {
+        snprintf(ssid, sizeof(ssid), "Red \"%02d\"", i);
+        cache.add(ssid, (int8_t)(-40 - (i * 7) % 50), (uint8_t)(1 + i % 13), (uint8_t)(i % 8), 1000);
+    }
+    size_t len = 0;
+    bench_run("scan_snapshot", [&]() {
+        std::shared_ptr<const ScanSnapshot> snap = cache.snapshot(2000);
+        len = snap->json.size();
+        bench_keep(len);
+    });
+    TEST_ASSERT_EQUAL(20, cache.size());
+    TEST_ASSERT_GREATER_THAN(0, len);
+}
+
+/**
+ * @brief The RPM line the main screen redraws on every change.
+ */
+void bench_lcd_rpm_line() {
+    volatile float current = 149.6f;
+    volatile float target = 150.0f;
+    char line[LCD_COLS + 1];
+    bench_run("lcd_rpm_line", [&]() {
+        lcd_format_rpm_line(line, current, target);
+        bench_keep(line[0]);
+    });
+    TEST_ASSERT_EQUAL_STRING("A:150 T:150     ", line);
+}
+
+// Same shape as DeviceSettings (lib/settings), which needs the Arduino core.
+struct BenchSettings {
+    uint8_t language;
+    float lastTargetRpm;
+    float maxRpm;
+    double measStepsPerRev;
+    char wifiSsid[33];
+    char wifiPassword[65];
+    uint8_t wifiBssid[6];
+    int32_t wifiChannel;
+};
+
+static const ConfigField BENCH_FIELDS[] = {
+    CONFIG_FIELD(1, BenchSettings, language),        CONFIG_FIELD(2, BenchSettings, lastTargetRpm),
+    CONFIG_FIELD(3, BenchSettings, maxRpm),          CONFIG_FIELD(4, BenchSettings, measStepsPerRev),
+    CONFIG_FIELD(5, BenchSettings, wifiSsid),        CONFIG_FIELD(6, BenchSettings, wifiPassword),
+    CONFIG_FIELD(7, BenchSettings, wifiBssid),       CONFIG_FIELD(8, BenchSettings, wifiChannel),
+};
+static const size_t BENCH_FIELD_COUNT = sizeof(BENCH_FIELDS) / sizeof(BENCH_FIELDS[0]);
+
+/**
+ * @brief Parsing /config.bin at boot, CRC included.
+ */
+void bench_config_decode() {
+    BenchSettings saved = {};
+    saved.language = 1;
+    saved.lastTargetRpm = 150.0f;
+    saved.maxRpm = 300.0f;
+    saved.measStepsPerRev = 3205.4;
+    strcpy(saved.wifiSsid, "Laboratorio-2.4G");
+    strcpy(saved.wifiPassword, "una clave bastante larga");
+    saved.wifiChannel = 6;
+    uint8_t file[256];
+    size_t len = config_encode(saved, BENCH_FIELDS, BENCH_FIELD_COUNT, file, sizeof(file));
+    TEST_ASSERT_GREATER_THAN(0, len);
+
+    BenchSettings loaded = {};
+    bool ok = false;
+    bench_run("config_decode", [&]() {
+        loaded = BenchSettings{};
+        ok = config_decode(file, len, BENCH_FIELDS, BENCH_FIELD_COUNT, loaded);
+        bench_keep(loaded);
+    });
+    TEST_ASSERT_TRUE(ok);
+    TEST_ASSERT_EQUAL_UINT8(saved.language, loaded.language);
+    TEST_ASSERT_EQUAL_FLOAT(saved.maxRpm, loaded.maxRpm);
+    TEST_ASSERT_EQUAL_DOUBLE(saved.measStepsPerRev, loaded.measStepsPerRev);
+    TEST_ASSERT_EQUAL_STRING(saved.wifiPassword, loaded.wifiPassword);
+    TEST_ASSERT_EQUAL_INT32(saved.wifiChannel, loaded.wifiChannel);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(bench_rpm2sps);
+    RUN_TEST(bench_rpm_to_milli_hz);
+    RUN_TEST(bench_rpm_to_ticks);
+    RUN_TEST(bench_rpm_estimator);
+    RUN_TEST(bench_status_json);
+    RUN_TEST(bench_scan_snapshot);
+    RUN_TEST(bench_lcd_rpm_line);
+    RUN_TEST(bench_config_decode);
+    return UNITY_END();
+}
@@ -0,0 +1,60 @@
+#include <Arduino.h>
+#include <unity.h>
+#include "shared_logic.h"
+#include "motion_math.h"
+#include "step_tables.h"
+
+// Runs on the board (pio test -e esp32dev -f test_motion_cycles): CPU cycles
+// per setpoint conversion on the control path, against the slower ways of
+// computing the same value.
+
+static const uint32_t ITERATIONS = 1000;
+static volatile float g_rpm = 137.5f;
+static volatile uint32_t g_sink;
+
+template <typename F>
+static uint32_t cycles_per_call(F body) {
+    uint32_t start = ESP.getCycleCount();
+    for (uint32_t i = 0; i < ITERATIONS; ++i) g_sink = body((float)g_rpm);
+    return (ESP.getCycleCount() - start) / ITERATIONS;
+}
+
+/**
+ * @brief float and Q16.16 must beat the double reference on the control path.
+ */
+void test_control_math_is_faster_than_double() {
+    uint32_t viaDouble = cycles_per_call([](float rpm) { return (uint32_t)(rpm2sps(rpm) * 1000.0); });
+    uint32_t viaFloat = cycles_per_call([](float rpm) { return sps_to_milli_hz(rpm_to_sps(rpm)); });
+    uint32_t viaQ16 =
+        cycles_per_call([](float rpm) { return sps_to_milli_hz(rpm_to_sps(Q16_16::fromFloat(rpm))); });
+    printf("BENCH {\"name\":\"rpm_to_milli_hz\",\"unit\":\"cycles\",\"double\":%u,\"float\":%u,\"q16\":%u}\n",
+           (unsigned)viaDouble, (unsigned)viaFloat, (unsigned)viaQ16);
+    TEST_ASSERT_LESS_THAN_UINT32(viaDouble, viaFloat);
+    TEST_ASSERT_LESS_THAN_UINT32(viaDouble, viaQ16);
+}
+
+/**
+ * @brief Step period from the tables, from a float division and as the double path computed it.
+ *
+ * Only the double comparison is asserted: whether the lookup beats a float
+ * division depends on the core, and the numbers are printed to check.
+ */
+void test_step_table_is_faster_than_double() {
+    uint32_t viaDouble = cycles_per_call([](float rpm) { return (uint32_t)(STEPPER_TICKS_PER_S / rpm2sps(rpm) + 0.5); });
+    uint32_t viaDivision = cycles_per_call(
+        [](float rpm) { return (uint32_t)(STEPPER_TICKS_PER_S * 60.0f / (rpm * (float)SPR_CMD) + 0.5f); });
+    uint32_t viaTable = cycles_per_call([](float rpm) { return rpm_to_ticks(rpm); });
+    printf("BENCH {\"name\":\"rpm_to_ticks\",\"unit\":\"cycles\",\"double\":%u,\"division\":%u,\"table\":%u}\n",
+           (unsigned)viaDouble, (unsigned)viaDivision, (unsigned)viaTable);
+    TEST_ASSERT_LESS_THAN_UINT32(viaDouble, viaTable);
+}
+
+void setup() {
+    delay(2000);  // let the serial monitor attach
+    UNITY_BEGIN();
+    RUN_TEST(test_control_math_is_faster_than_double);
+    RUN_TEST(test_step_table_is_faster_than_double);
+    UNITY_END();
+}
+
+void loop() {}
@@ -0,0 +1,55 @@
+#ifndef SIM_FLASH_H
+#define SIM_FLASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * @brief Host model of a raw NOR flash partition.
+ *
+ * Programming can only clear bits and erasing works on whole 4 KB sectors,
+ * as on the ESP32's SPI flash. tearNextWrite() makes the next write stop
+ * after a few bytes, like a power loss in the middle of it.
+ */
+class SimFlash {
+public:
+    explicit SimFlash(size_t size) : _data(size, 0x00) {}  // never erased, like a fresh partition
+
+    size_t size() const { return _data.size(); }
+
+    bool read(size_t offset, void *dst, size_t len) const {
+        if (offset + len > _data.size()) return false;
+        memcpy(dst, _data.data() + offset, len);
+        return true;
+    }
+
+    bool write(size_t offset, const void *src, size_t len) {
+        if (offset + len > _data.size()) return false;
+        if (_tearAfter >= 0 && (size_t)_tearAfter < len) len = (size_t)_tearAfter;
+        _tearAfter = -1;
+        const uint8_t *bytes = (const uint8_t *)src;
+        for (size_t i = 0; i < len; ++i) _data[offset + i] &= bytes[i];
+        writes++;
+        return true;
+    }
+
+    bool erase(size_t offset, size_t len) {
+        if (offset % 4096 != 0 || len % 4096 != 0 || offset + len > _data.size()) return false;
+        memset(_data.data() + offset, 0xFF, len);
+        erases++;
+        return true;
+    }
+
+    void tearNextWrite(int bytes) { _tearAfter = bytes; }
+
+    uint32_t writes = 0;
+    uint32_t erases = 0;
+
+private:
+    std::vector<uint8_t> _data;
+    int _tearAfter = -1;
+};
+
+#endif // SIM_FLASH_H
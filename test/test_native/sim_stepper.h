@@ -0,0 +1,96 @@
+#ifndef SIM_STEPPER_H
+#define SIM_STEPPER_H
+
+#include <cstdint>
+
+/**
+ * @brief Host model of FastAccelStepper in continuous (runForward) mode.
+ *
+ * Implements the subset motor_task uses with the same semantics: a new speed
+ * or acceleration only takes effect on runForward() or
+ * applySpeedAcceleration(), the speed follows a linear ramp, stopMove()
+ * decelerates to standstill and forceStop() halts at once. advance() moves
+ * simulated time forward.
+ */
+class SimStepper {
+public:
+    int8_t setAcceleration(int32_t stepsPerS2) {
+        _nextAccel = stepsPerS2 > 0 ? (double)stepsPerS2 : 1.0;
+        return 0;
+    }
+
+    int8_t setSpeedInHz(uint32_t hz) {
+        _nextSpeed = (double)hz;
+        return 0;
+    }
+
+    /** @brief Period in ticks of the ESP32 driver (16 MHz). */
+    int8_t setSpeedInTicks(uint32_t ticks) {
+        _nextSpeed = ticks ? 16000000.0 / ticks : 0.0;
+        return 0;
+    }
+
+    int8_t runForward() {
+        _running = true;
+        applySpeedAcceleration();
+        return 0;
+    }
+
+    void applySpeedAcceleration() {
+        if (!_running) return;
+        _target = _nextSpeed;
+        _accel = _nextAccel;
+    }
+
+    void stopMove() {
+        _target = 0.0;
+        _stopping = true;
+    }
+
+    void forceStop() {
+        _speed = 0.0;
+        _target = 0.0;
+        _running = false;
+        _stopping = false;
+    }
+
+    bool isRunningContinuously() const { return _running; }
+    bool isRunning() const { return _running; }
+
+    bool enableOutputs() { return true; }
+    bool disableOutputs() { return true; }
+
+    int32_t getCurrentSpeedInMilliHz() const { return (int32_t)(_speed * 1000.0); }
+
+    int32_t getCurrentPosition() const { return (int32_t)_position; }
+
+    /** @brief Runs the ramp generator for @p us microseconds. */
+    void advance(uint32_t us) {
+        double dt = us / 1e6;
+        double before = _speed;
+        if (_speed < _target) {
+            _speed += _accel * dt;
+            if (_speed > _target) _speed = _target;
+        } else if (_speed > _target) {
+            _speed -= _accel * dt;
+            if (_speed < _target) _speed = _target;
+        }
+        _position += (before + _speed) / 2.0 * dt;
+        if (_stopping && _speed == 0.0) {
+            _running = false;
+            _stopping = false;
+        }
+    }
+
+private:
+    double _speed = 0.0;
+    double _target = 0.0;
+    double _accel = 1.0;
+    double _nextSpeed = 0.0;
+    double _nextAccel = 1.0;
+    double _position = 0.0;
+    bool _running = false;
+    bool _stopping = false;
+};
+
+#endif // SIM_STEPPER_H
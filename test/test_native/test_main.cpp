@@ -1,5 +1,45 @@
 #include <unity.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
 #include "shared_logic.h"
+#include "rate_limiter.h"
+#include "setpoint_mailbox.h"
+#include "wifi_reconnect.h"
+#include "boot_timeline.h"
+#include "scan_cache.h"
+#include "mdns_wire.h"
+#include "motor_state.h"
+#include "modbus_map.h"
+#include "metrics.h"
+#include "task_profiler.h"
+#include "trace_ring.h"
+#include "command_latency.h"
+#include "sim_stepper.h"
+#include "speed_stats.h"
+#include "deadline_supervisor.h"
+#include "config_store.h"
+#include "run_journal.h"
+#include "sim_flash.h"
+#include "lcd_format.h"
+#include "motion_math.h"
+#include "step_tables.h"
+#include "step_dither.h"
+#include "motor_cycle.h"
+#include "speed_pattern.h"
+#include "estop.h"
+#include "quadrature.h"
+#include "stop_ramp.h"
+#include "task_plan.h"
+#include "jitter_stats.h"
+#include "scpi.h"
 
 /**
  * @brief Test the rpm2sps function for various inputs.
@@ -17,9 +57,1957 @@ void test_rpm2sps_negative_input() {
     TEST_ASSERT_EQUAL_DOUBLE(-(SPR_CMD / 60.0), rpm2sps(-1.0));
 }
 
+/**
+ * @brief A client is admitted up to its burst, then refilled at the sustained rate.
+ */
+void test_token_bucket_burst_and_refill() {
+    TokenBucket bucket;
+    bucket.configure(10, 5, 0);
+    for (int i = 0; i < 5; ++i) TEST_ASSERT_TRUE(bucket.tryConsume(0));
+    uint32_t retryAfterMs = 0;
+    TEST_ASSERT_FALSE(bucket.tryConsume(0, &retryAfterMs));
+    TEST_ASSERT_EQUAL_UINT32(100, retryAfterMs);
+    TEST_ASSERT_FALSE(bucket.tryConsume(99));
+    TEST_ASSERT_TRUE(bucket.tryConsume(100));
+}
+
+/**
+ * @brief Each client IP gets its own bucket; the oldest client is evicted when full.
+ */
+void test_client_rate_limiter_is_per_ip() {
+    ClientRateLimiter<2> limiter;
+    limiter.configure(1, 1);
+    TEST_ASSERT_TRUE(limiter.allow(0x0A000001, 0));
+    TEST_ASSERT_FALSE(limiter.allow(0x0A000001, 10));
+    TEST_ASSERT_TRUE(limiter.allow(0x0A000002, 20));
+    // A third client evicts 10.0.0.1, which therefore starts with a full bucket.
+    TEST_ASSERT_TRUE(limiter.allow(0x0A000003, 30));
+    TEST_ASSERT_TRUE(limiter.allow(0x0A000001, 40));
+}
+
+/**
+ * @brief The concurrency gate never admits more than its limit.
+ */
+void test_concurrency_gate_limit() {
+    ConcurrencyGate gate(2);
+    TEST_ASSERT_TRUE(gate.tryEnter());
+    TEST_ASSERT_TRUE(gate.tryEnter());
+    TEST_ASSERT_FALSE(gate.tryEnter());
+    gate.leave();
+    TEST_ASSERT_TRUE(gate.tryEnter());
+    TEST_ASSERT_EQUAL_INT(2, gate.inFlight());
+}
+
+/**
+ * @brief Setpoint writes coalesce: the consumer only sees the last one.
+ */
+void test_setpoint_mailbox_last_writer_wins() {
+    SetpointMailbox mailbox;
+    SetpointCommand cmd;
+    TEST_ASSERT_FALSE(mailbox.take(cmd));
+    mailbox.post(100.0f);
+    mailbox.post(250.5f);
+    TEST_ASSERT_TRUE(mailbox.take(cmd));
+    TEST_ASSERT_FALSE(cmd.stop);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 250.5f, cmd.rpm);
+    TEST_ASSERT_FALSE(mailbox.take(cmd));
+    mailbox.post(0.5f);
+    TEST_ASSERT_TRUE(mailbox.take(cmd));
+    TEST_ASSERT_TRUE(cmd.stop);
+}
+
+/**
+ * @brief Load test: a 1000 req/s /rpm flood must not delay motor_task.
+ *
+ * Simulates 10 s of one request per millisecond spread over four clients,
+ * with motor_task consuming the mailbox every 50 ms. Every motor cycle takes
+ * at most one command, always the newest admitted one, and no admitted
+ * setpoint waits longer than one motor period to be applied.
+ */
+void test_rpm_flood_keeps_motor_latency_bounded() {
+    const uint32_t RATE = 10, BURST = 20, MOTOR_PERIOD_MS = 50, DURATION_MS = 10000;
+    const uint32_t CLIENTS = 4;
+    ClientRateLimiter<8> limiter;
+    limiter.configure(RATE, BURST);
+    SetpointMailbox mailbox;
+
+    uint32_t admitted[CLIENTS] = {0};
+    uint32_t rejected = 0;
+    float lastPostedRpm = -1.0f;
+    uint32_t lastPostedMs = 0;
+    bool unapplied = false;
+    uint32_t maxLatencyMs = 0;
+
+    for (uint32_t t = 0; t <= DURATION_MS; ++t) {
+        uint32_t client = t % CLIENTS;
+        uint32_t retryAfterMs = 0;
+        if (limiter.allow(0xC0A80100 + client, t, &retryAfterMs)) {
+            admitted[client]++;
+            lastPostedRpm = (float)(10 + (t % 400));
+            mailbox.post(lastPostedRpm);
+            if (!unapplied) lastPostedMs = t;
+            unapplied = true;
+        } else {
+            rejected++;
+            TEST_ASSERT_GREATER_THAN_UINT32(0, retryAfterMs);
+        }
+
+        if (t % MOTOR_PERIOD_MS == 0) {
+            SetpointCommand cmd;
+            if (mailbox.take(cmd)) {
+                TEST_ASSERT_FLOAT_WITHIN(0.01f, lastPostedRpm, cmd.rpm);
+                uint32_t latency = t - lastPostedMs;
+                if (latency > maxLatencyMs) maxLatencyMs = latency;
+                unapplied = false;
+            }
+            TEST_ASSERT_FALSE(mailbox.take(cmd));
+        }
+    }
+
+    for (uint32_t c = 0; c < CLIENTS; ++c) {
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(RATE * DURATION_MS / 1000 + BURST + 1, admitted[c]);
+    }
+    TEST_ASSERT_GREATER_THAN_UINT32(DURATION_MS * 9 / 10, rejected);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(MOTOR_PERIOD_MS, maxLatencyMs);
+}
+
+/**
+ * @brief Backoff delays double up to the cap and stay within [d/2, d].
+ */
+void test_backoff_grows_with_bounded_jitter() {
+    ExponentialBackoff backoff(500, 8000);
+    const uint32_t ceilings[] = {500, 1000, 2000, 4000, 8000, 8000, 8000};
+    for (uint32_t ceiling : ceilings) {
+        uint32_t lo = backoff.next(0);
+        TEST_ASSERT_EQUAL_UINT32(ceiling / 2, lo);
+    }
+    backoff.reset();
+    for (uint32_t ceiling : ceilings) {
+        uint32_t hi = backoff.next(UINT32_MAX);
+        TEST_ASSERT_GREATER_OR_EQUAL(ceiling / 2, hi);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(ceiling, hi);
+    }
+}
+
+/**
+ * @brief After losing the link the first retry is immediate and uses the cached AP.
+ */
+void test_reconnect_fast_connect_then_full_scan() {
+    ReconnectStateMachine sm;
+    sm.configure(500, 60000, 10000);
+    sm.setFastConnectAvailable(true);
+    sm.onConnected();
+
+    sm.onDisconnected(1000, 0);
+    TEST_ASSERT_EQUAL_INT(RECONNECT_FAST, sm.poll(1000, 0));
+    sm.onDisconnected(1200, 0);
+    TEST_ASSERT_EQUAL_INT(ReconnectStateMachine::BACKOFF, sm.state());
+    TEST_ASSERT_EQUAL_INT(RECONNECT_NONE, sm.poll(1200, 0));
+    TEST_ASSERT_EQUAL_INT(RECONNECT_FAST, sm.poll(1200 + 250, 0));
+    sm.onDisconnected(1500, 0);
+    // Two fast attempts failed: the AP may have changed channel.
+    TEST_ASSERT_EQUAL_INT(RECONNECT_FULL_SCAN, sm.poll(1500 + 500, 0));
+    sm.onConnected();
+    TEST_ASSERT_EQUAL_INT(ReconnectStateMachine::CONNECTED, sm.state());
+    sm.onDisconnected(5000, 0);
+    TEST_ASSERT_EQUAL_INT(RECONNECT_FAST, sm.poll(5000, 0));
+}
+
+/**
+ * @brief During a long AP outage attempts are spaced out and never flood the radio.
+ */
+void test_reconnect_backoff_during_outage() {
+    ReconnectStateMachine sm;
+    sm.configure(500, 60000, 10000);
+    sm.setFastConnectAvailable(true);
+    sm.onConnected();
+    sm.onDisconnected(0, 0);
+
+    // One hour outage: every attempt times out without an event.
+    uint32_t entropy = 12345;
+    for (uint32_t t = 0; t < 3600u * 1000u; t += 100) {
+        entropy = entropy * 1103515245u + 12345u;
+        sm.poll(t, entropy);
+    }
+    // Without backoff a 10 s timeout would allow 360 attempts.
+    TEST_ASSERT_LESS_THAN(80, (int)sm.attempts());
+    TEST_ASSERT_GREATER_THAN(40, (int)sm.attempts());
+}
+
+/**
+ * @brief Going offline stops all attempts.
+ */
+void test_reconnect_disabled_when_offline() {
+    ReconnectStateMachine sm;
+    sm.connectNow(0);
+    sm.setEnabled(false);
+    TEST_ASSERT_EQUAL_INT(RECONNECT_NONE, sm.poll(100, 0));
+    TEST_ASSERT_EQUAL_INT(ReconnectStateMachine::IDLE, sm.state());
+    sm.setEnabled(true);
+    sm.connectNow(200);
+    TEST_ASSERT_EQUAL_INT(RECONNECT_FULL_SCAN, sm.poll(200, 0));
+}
+
+/**
+ * @brief Boot marks keep their order and can be looked up and printed.
+ */
+void test_boot_timeline_records_phases() {
+    BootTimeline timeline;
+    timeline.mark("reset", 0);
+    timeline.mark("motor_ready", 412345);
+    timeline.mark("http_ready", 530000);
+    TEST_ASSERT_EQUAL_size_t(3, timeline.count());
+    TEST_ASSERT_EQUAL_UINT32(412345, timeline.timeOf("motor_ready"));
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, timeline.timeOf("wifi_connected"));
+
+    char buf[256];
+    timeline.format(buf, sizeof(buf));
+    TEST_ASSERT_NOT_NULL(strstr(buf, "motor_ready      +412.345 ms (+412345 us)"));
+    TEST_ASSERT_NOT_NULL(strstr(buf, "http_ready       +530.000 ms (+117655 us)"));
+}
+
+/**
+ * @brief Phases recorded from two tasks keep their own start and end.
+ */
+void test_boot_timeline_parallel_phases() {
+    BootTimeline timeline;
+    timeline.mark("reset", 0);
+    std::thread hw([&]() { timeline.span("ui_setup", 1000, 151000); });
+    timeline.span("littlefs", 1200, 41200);
+    timeline.span("wifi_setup", 41200, 181200);
+    hw.join();
+    timeline.mark("ready", 181500);
+    TEST_ASSERT_EQUAL_size_t(5, timeline.count());
+    TEST_ASSERT_EQUAL_UINT32(150000 + 40000 + 140000, timeline.phaseSumUs());
+    TEST_ASSERT_EQUAL_UINT32(181500, timeline.timeOf("ready"));
+
+    char buf[512];
+    timeline.format(buf, sizeof(buf));
+    TEST_ASSERT_NOT_NULL(strstr(buf, "ui_setup         +151.000 ms [start +1.000, took 150.000 ms]"));
+    TEST_ASSERT_NOT_NULL(strstr(buf, "littlefs         +41.200 ms [start +1.200, took 40.000 ms]"));
+    TEST_ASSERT_NOT_NULL(strstr(buf, "ready            +181.500 ms (+181500 us)"));
+}
+
+/**
+ * @brief Marks beyond the capacity are dropped instead of overflowing.
+ */
+void test_boot_timeline_is_bounded() {
+    BootTimeline timeline;
+    for (size_t i = 0; i < BootTimeline::MAX_MARKS + 5; ++i) timeline.mark("phase", (uint32_t)i);
+    TEST_ASSERT_EQUAL_size_t(BootTimeline::MAX_MARKS, timeline.count());
+    char small[40];
+    size_t n = timeline.format(small, sizeof(small));
+    TEST_ASSERT_LESS_THAN(sizeof(small), n);
+}
+
+/**
+ * @brief Duplicate SSIDs collapse to the strongest BSS and snapshots are sorted by RSSI.
+ */
+void test_scan_cache_dedup_and_sort() {
+    ScanCache cache(8, 60000);
+    cache.add("Lab", -70, 1, SCAN_AUTH_WPA2, 1000);
+    cache.add("Lab", -40, 6, SCAN_AUTH_WPA2, 1000);
+    cache.add("Lab", -80, 11, SCAN_AUTH_WPA2, 1000);
+    cache.add("Guest", -55, 11, SCAN_AUTH_OPEN, 1000);
+    cache.add("", -30, 3, SCAN_AUTH_OPEN, 1000);
+    TEST_ASSERT_EQUAL_size_t(2, cache.size());
+
+    std::shared_ptr<const ScanSnapshot> snap = cache.snapshot(1000);
+    TEST_ASSERT_EQUAL_STRING("Lab", snap->entries[0].ssid);
+    TEST_ASSERT_EQUAL_INT(-40, snap->entries[0].rssi);
+    TEST_ASSERT_EQUAL_INT(6, snap->entries[0].channel);
+    TEST_ASSERT_EQUAL_STRING(
+        "[{\"ssid\":\"Lab\",\"rssi\":-40,\"channel\":6,\"auth\":\"wpa2\"},"
+        "{\"ssid\":\"Guest\",\"rssi\":-55,\"channel\":11,\"auth\":\"open\"}]",
+        snap->json.c_str());
+}
+
+/**
+ * @brief Entries expire after the TTL and a full cache keeps the strongest networks.
+ */
+void test_scan_cache_ttl_and_capacity() {
+    ScanCache cache(2, 10000);
+    cache.add("A", -60, 1, SCAN_AUTH_WPA2, 0);
+    cache.add("B", -70, 1, SCAN_AUTH_WPA2, 0);
+    cache.add("C", -50, 1, SCAN_AUTH_WPA2, 0);   // replaces B
+    cache.add("D", -90, 1, SCAN_AUTH_WPA2, 0);   // too weak, dropped
+    std::shared_ptr<const ScanSnapshot> snap = cache.snapshot(0);
+    TEST_ASSERT_EQUAL_size_t(2, snap->entries.size());
+    TEST_ASSERT_EQUAL_STRING("C", snap->entries[0].ssid);
+    TEST_ASSERT_EQUAL_STRING("A", snap->entries[1].ssid);
+
+    cache.add("A", -61, 1, SCAN_AUTH_WPA2, 8000);
+    cache.expire(15000);
+    TEST_ASSERT_EQUAL_size_t(1, cache.size());
+}
+
+/**
+ * @brief SSIDs with quotes or control characters produce valid JSON.
+ */
+void test_scan_cache_json_escaping() {
+    ScanCache cache;
+    cache.add("a\"b\\c\x01", -50, 1, SCAN_AUTH_OPEN, 0);
+    TEST_ASSERT_NOT_NULL(strstr(cache.snapshot(0)->json.c_str(), "\"a\\\"b\\\\c\\u0001\""));
+}
+
+/**
+ * @brief A reader keeps its snapshot alive even after a newer one is published.
+ */
+void test_snapshot_slot_readers_keep_old_snapshot() {
+    SnapshotSlot<ScanSnapshot> slot;
+    TEST_ASSERT_TRUE(slot.get() == nullptr);
+    ScanCache cache;
+    cache.add("Old", -50, 1, SCAN_AUTH_OPEN, 0);
+    slot.publish(cache.snapshot(0));
+    std::shared_ptr<const ScanSnapshot> reader = slot.get();
+    cache.add("New", -40, 1, SCAN_AUTH_OPEN, 5);
+    slot.publish(cache.snapshot(5));
+    TEST_ASSERT_EQUAL_size_t(1, reader->entries.size());
+    TEST_ASSERT_EQUAL_size_t(2, slot.get()->entries.size());
+}
+
+/**
+ * @brief A PTR query round-trips through the responder-side parser.
+ */
+void test_mdns_query_round_trip() {
+    uint8_t buf[128];
+    size_t len = mdns_build_ptr_query(buf, sizeof(buf), "_bioshaker._tcp.local", true);
+    TEST_ASSERT_TRUE(len > 12);
+    std::string qname;
+    uint16_t qtype = 0;
+    bool qu = false;
+    TEST_ASSERT_TRUE(mdns_parse_query(buf, len, qname, qtype, qu));
+    TEST_ASSERT_EQUAL_STRING("_bioshaker._tcp.local", qname.c_str());
+    TEST_ASSERT_EQUAL_UINT16(DNS_TYPE_PTR, qtype);
+    TEST_ASSERT_TRUE(qu);
+    TEST_ASSERT_EQUAL_size_t(0, mdns_build_ptr_query(buf, 16, "_bioshaker._tcp.local", false));
+}
+
+/**
+ * @brief The browser follows compression pointers, as real responders use them.
+ */
+void test_mdns_browser_parses_compressed_answer() {
+    std::vector<uint8_t> m = {0, 0, 0x84, 0, 0, 0, 0, 4, 0, 0, 0, 0};
+    auto label = [&](const char *l) { m.push_back((uint8_t)strlen(l)); m.insert(m.end(), l, l + strlen(l)); };
+    auto u16 = [&](uint16_t v) { m.push_back((uint8_t)(v >> 8)); m.push_back((uint8_t)v); };
+    auto ptr = [&](size_t off) { u16((uint16_t)(0xC000 | off)); };
+    auto header = [&](uint16_t type, uint16_t rdlen) { u16(type); u16(0x8001); u16(0); u16(120); u16(rdlen); };
+
+    const size_t serviceOff = m.size();  // _bioshaker._tcp.local
+    label("_bioshaker"); label("_tcp");
+    const size_t localOff = m.size();
+    label("local"); m.push_back(0);
+    header(DNS_TYPE_PTR, 1 + 5 + 2);
+    const size_t instanceOff = m.size();  // Lab 3._bioshaker._tcp.local
+    label("Lab 3"); ptr(serviceOff);
+
+    ptr(instanceOff);
+    header(DNS_TYPE_SRV, 6 + 1 + 4 + 2);
+    u16(0); u16(0); u16(8080);
+    const size_t hostOff = m.size();  // lab3.local
+    label("lab3"); ptr(localOff);
+
+    ptr(instanceOff);
+    header(DNS_TYPE_TXT, 7 + 14);
+    label("fw=1.0"); label("state=running");
+
+    ptr(hostOff);
+    header(DNS_TYPE_A, 4);
+    m.push_back(192); m.push_back(168); m.push_back(1); m.push_back(7);
+
+    MdnsBrowser browser("_bioshaker._tcp.local");
+    TEST_ASSERT_TRUE(browser.ingest(m.data(), m.size()));
+    std::vector<MdnsServiceRecord> found = browser.results();
+    TEST_ASSERT_EQUAL_size_t(1, found.size());
+    TEST_ASSERT_EQUAL_STRING("Lab 3._bioshaker._tcp.local", found[0].instance.c_str());
+    TEST_ASSERT_EQUAL_STRING("lab3.local", found[0].host.c_str());
+    TEST_ASSERT_EQUAL_UINT16(8080, found[0].port);
+    TEST_ASSERT_EQUAL_HEX32(0xC0A80107, found[0].ipv4);
+    TEST_ASSERT_EQUAL_STRING("running", found[0].txtValue("state").c_str());
+
+    // A pointer loop or a truncated record is rejected without side effects.
+    std::vector<uint8_t> loop = {0, 0, 0x84, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0xC0, 12};
+    TEST_ASSERT_FALSE(browser.ingest(loop.data(), loop.size()));
+    TEST_ASSERT_FALSE(browser.ingest(m.data(), m.size() - 3));
+}
+
+/**
+ * @brief Readers racing a writer only ever see complete snapshots.
+ */
+void test_seqlock_readers_never_see_torn_snapshot() {
+    SeqLock<MotorStateSnapshot> lock;
+    std::atomic<bool> stop(false);
+    std::atomic<uint32_t> published(0);
+    std::thread writer([&]() {
+        uint32_t i = 0;
+        while (!stop) {
+            ++i;
+            MotorStateSnapshot s = {};
+            s.targetRpm = (float)(i % 1000);
+            s.currentRpm = s.targetRpm;
+            s.stepCount = i;
+            s.updatedMs = ~i;
+            lock.publish(s);
+            published = i;
+        }
+    });
+    uint32_t reads = 0, torn = 0, lastStep = 0, backwards = 0;
+    while (reads < 20000 || published < 20000) {
+        MotorStateSnapshot s;
+        if (!lock.read(s) || s.stepCount == 0) continue;  // 0 = initial empty value
+        reads++;
+        if (s.updatedMs != ~s.stepCount || s.currentRpm != s.targetRpm) torn++;
+        if (s.stepCount < lastStep) backwards++;
+        lastStep = s.stepCount;
+    }
+    stop = true;
+    writer.join();
+    TEST_ASSERT_EQUAL_UINT32(0, torn);
+    TEST_ASSERT_EQUAL_UINT32(0, backwards);
+    MotorStateSnapshot last;
+    TEST_ASSERT_TRUE(lock.read(last));
+    TEST_ASSERT_EQUAL_UINT32(published.load(), last.stepCount);
+    TEST_ASSERT_EQUAL_UINT32(published.load() + 1, lock.version());
+}
+
+/**
+ * @brief Input registers carry scaled speeds and a big-endian step count.
+ */
+void test_modbus_encode_inputs() {
+    MotorStateSnapshot s = {};
+    s.targetRpm = 250.0f;
+    s.currentRpm = 249.96f;
+    s.stepCount = 0x12345678;
+    s.errorFlags = MOTOR_ERR_LOCK_TIMEOUT;
+    s.runState = MOTOR_RUNNING;
+    uint16_t regs[MB_INPUT_REGISTER_COUNT];
+    modbus_encode_inputs(s, 0x10007, regs);
+    TEST_ASSERT_EQUAL_UINT16(2500, regs[MB_IR_SETPOINT_X10]);
+    TEST_ASSERT_EQUAL_UINT16(2500, regs[MB_IR_ACTUAL_X10]);
+    TEST_ASSERT_EQUAL_UINT16(MOTOR_RUNNING, regs[MB_IR_RUN_STATE]);
+    TEST_ASSERT_EQUAL_HEX16(0x1234, regs[MB_IR_STEPS_HI]);
+    TEST_ASSERT_EQUAL_HEX16(0x5678, regs[MB_IR_STEPS_LO]);
+    TEST_ASSERT_EQUAL_UINT16(MOTOR_ERR_LOCK_TIMEOUT, regs[MB_IR_ERROR_FLAGS]);
+    TEST_ASSERT_EQUAL_UINT16(7, regs[MB_IR_VERSION]);
+    TEST_ASSERT_EQUAL_UINT16(0, modbus_rpm_to_reg(-3.0f));
+    TEST_ASSERT_EQUAL_UINT16(65535, modbus_rpm_to_reg(1e6f));
+}
+
+/**
+ * @brief Holding registers map to a clamped setpoint, or stop when RUN is 0.
+ */
+void test_modbus_decode_command() {
+    uint16_t regs[MB_HOLDING_REGISTER_COUNT] = {0, 0};
+    regs[MB_HR_SETPOINT_X10] = 1235;
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, modbus_decode_command(regs, 510.0f));
+    regs[MB_HR_RUN] = 1;
+    TEST_ASSERT_EQUAL_FLOAT(123.5f, modbus_decode_command(regs, 510.0f));
+    regs[MB_HR_SETPOINT_X10] = 9000;
+    TEST_ASSERT_EQUAL_FLOAT(510.0f, modbus_decode_command(regs, 510.0f));
+    regs[MB_HR_RUN] = MB_RUN_HARD_STOP;
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, modbus_decode_command(regs, 510.0f));
+    TEST_ASSERT_EQUAL_UINT8(STOP_MODE_HARD, modbus_decode_stop_mode(regs));
+    regs[MB_HR_RUN] = MB_RUN_STOP;
+    TEST_ASSERT_EQUAL_UINT8(STOP_MODE_GRACEFUL, modbus_decode_stop_mode(regs));
+    regs[MB_HR_RUN] = 7;  // unknown: stop, gently
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, modbus_decode_command(regs, 510.0f));
+    TEST_ASSERT_EQUAL_UINT8(STOP_MODE_GRACEFUL, modbus_decode_stop_mode(regs));
+}
+
+static double read_half(const void *) { return 0.5; }
+
+/**
+ * @brief Renders the whole exposition by pulling chunks of @p chunk bytes.
+ */
+template <size_t N>
+static std::string render_metrics(const MetricsRegistry<N> &registry, size_t chunk) {
+    PromStream<N> stream(registry);
+    std::string text;
+    uint8_t buf[512];
+    size_t n;
+    while ((n = stream.fill(buf, chunk)) > 0) text.append((const char *)buf, n);
+    return text;
+}
+
+/**
+ * @brief Counters, gauges and labelled histograms render in text format.
+ */
+void test_metrics_exposition_format() {
+    Counter requests;
+    requests.inc(3);
+    LatencyHistogram rpm, status;
+    rpm.observe(80);       // <= 100 us
+    rpm.observe(2000);     // <= 2.5 ms
+    rpm.observe(5000000);  // overflow
+    status.observe(300);
+
+    MetricsRegistry<8> registry;
+    registry.addCounter("x_requests_total", "Requests.", &requests);
+    registry.addGauge("x_ratio", "A gauge.", &read_half);
+    registry.addHistogram("x_seconds", "Latency.", &rpm, "route=\"/rpm\"");
+    registry.addHistogram("x_seconds", "Latency.", &status, "route=\"/status\"");
+
+    std::string text = render_metrics(registry, 512);
+    TEST_ASSERT_TRUE(text.find("# HELP x_requests_total Requests.\n# TYPE x_requests_total counter\n"
+                               "x_requests_total 3\n") == 0);
+    TEST_ASSERT_TRUE(text.find("# TYPE x_ratio gauge\nx_ratio 0.5\n") != std::string::npos);
+    TEST_ASSERT_TRUE(text.find("x_seconds_bucket{route=\"/rpm\",le=\"0.0001\"} 1\n") != std::string::npos);
+    TEST_ASSERT_TRUE(text.find("x_seconds_bucket{route=\"/rpm\",le=\"0.0025\"} 2\n") != std::string::npos);
+    TEST_ASSERT_TRUE(text.find("x_seconds_bucket{route=\"/rpm\",le=\"1\"} 2\n") != std::string::npos);
+    TEST_ASSERT_TRUE(text.find("x_seconds_bucket{route=\"/rpm\",le=\"+Inf\"} 3\n") != std::string::npos);
+    TEST_ASSERT_TRUE(text.find("x_seconds_sum{route=\"/rpm\"} 5.002080\n") != std::string::npos);
+    TEST_ASSERT_TRUE(text.find("x_seconds_count{route=\"/status\"} 1\n") != std::string::npos);
+    // One HELP/TYPE pair per family, even with two labelled series.
+    TEST_ASSERT_TRUE(text.find("# TYPE x_seconds") == text.rfind("# TYPE x_seconds"));
+}
+
+/**
+ * @brief Streaming through a tiny buffer produces exactly the same bytes.
+ */
+void test_metrics_stream_in_small_chunks() {
+    LatencyHistogram h;
+    h.observe(1234);
+    MetricsRegistry<4> registry;
+    registry.addGauge("g", "Gauge.", &read_half);
+    registry.addHistogram("h_seconds", "H.", &h);
+    std::string whole = render_metrics(registry, 512);
+    TEST_ASSERT_EQUAL_STRING(whole.c_str(), render_metrics(registry, 7).c_str());
+    TEST_ASSERT_EQUAL_STRING(whole.c_str(), render_metrics(registry, 1).c_str());
+    TEST_ASSERT_TRUE(whole.find("h_seconds_bucket{le=\"0.0025\"} 1\n") != std::string::npos);
+    TEST_ASSERT_EQUAL(0, registry.dropped());
+    TEST_ASSERT_TRUE(registry.addGauge("a", "", &read_half));
+    TEST_ASSERT_TRUE(registry.addGauge("b", "", &read_half));
+    TEST_ASSERT_FALSE(registry.addGauge("c", "", &read_half));
+    TEST_ASSERT_EQUAL(4, registry.size());
+    TEST_ASSERT_EQUAL(1, registry.dropped());
+}
+
+static TaskSample make_task(const char *name, uint32_t id, uint32_t runtime, int8_t core, uint32_t stackFree) {
+    TaskSample t = {};
+    snprintf(t.name, sizeof(t.name), "%s", name);
+    t.id = id;
+    t.runtime = runtime;
+    t.core = core;
+    t.stackFreeBytes = stackFree;
+    t.priority = 1;
+    return t;
+}
+
+/**
+ * @brief CPU share per task and core load come from run-time counter deltas.
+ */
+void test_task_profiler_cpu_and_core_load() {
+    TaskProfiler profiler;
+    TaskSample first[] = {make_task("IDLE0", 1, 1000, 0, 800), make_task("IDLE1", 2, 1000, 1, 800),
+                          make_task("motorTask", 3, 0xFFFFFF00u, 1, 2100), make_task("uiTask", 4, 0, 0, 900)};
+    std::shared_ptr<TaskReport> r = profiler.update(first, 4, 5000, true);
+    TEST_ASSERT_EQUAL_FLOAT(-1.0f, r->tasks[0].cpuPct);  // no window yet
+    TEST_ASSERT_EQUAL_FLOAT(-1.0f, r->coreLoadPct[0]);
+
+    // 1 s later: core 0 idle 70 %, core 1 idle 90 %, motorTask wrapped its counter.
+    TaskSample second[] = {make_task("IDLE0", 1, 701000, 0, 800), make_task("IDLE1", 2, 901000, 1, 800),
+                           make_task("motorTask", 3, 99744u, 1, 2000), make_task("uiTask", 4, 250000, 0, 850),
+                           make_task("async_tcp", 9, 50000, TASK_CORE_ANY, 4000)};
+    r = profiler.update(second, 5, 1005000, true);
+    TEST_ASSERT_EQUAL_UINT32(1000000, r->windowUs);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 30.0f, r->coreLoadPct[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 10.0f, r->coreLoadPct[1]);
+    TEST_ASSERT_EQUAL_STRING("IDLE1", r->tasks[0].sample.name);  // sorted by CPU
+    TEST_ASSERT_EQUAL_STRING("uiTask", r->tasks[2].sample.name);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 25.0f, r->tasks[2].cpuPct);
+    TEST_ASSERT_EQUAL_STRING("motorTask", r->tasks[3].sample.name);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 10.0f, r->tasks[3].cpuPct);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 5.0f, r->tasks[4].cpuPct);  // new task, counted from 0
+    TEST_ASSERT_TRUE(r->json.find("{\"name\":\"motorTask\",\"core\":1,\"prio\":1,\"cpu\":10.0,\"stack_free\":2000}") !=
+                     std::string::npos);
+    TEST_ASSERT_TRUE(r->json.find("\"cores\":[{\"core\":0,\"load\":30.0},{\"core\":1,\"load\":10.0}]") !=
+                     std::string::npos);
+    TEST_ASSERT_TRUE(r->text.find("async_tcp           -") != std::string::npos);
+}
+
+/**
+ * @brief Without run-time counters only stack data is reported.
+ */
+void test_task_profiler_without_runtime_stats() {
+    TaskProfiler profiler;
+    TaskSample tasks[] = {make_task("uiTask", 4, 0, 0, 900)};
+    profiler.update(tasks, 1, 0, false);
+    std::shared_ptr<TaskReport> r = profiler.update(tasks, 1, 1000000, false);
+    TEST_ASSERT_FALSE(r->runtimeStats);
+    TEST_ASSERT_EQUAL_FLOAT(-1.0f, r->tasks[0].cpuPct);
+    TEST_ASSERT_EQUAL_UINT32(900, r->tasks[0].sample.stackFreeBytes);
+    TEST_ASSERT_TRUE(r->json.find("\"runtime_stats\":false") != std::string::npos);
+    TEST_ASSERT_EQUAL_FLOAT(-1.0f, r->coreLoadPct[0]);  // no idle hooks either
+}
+
+/**
+ * @brief Without run-time counters the idle hooks give the core load.
+ */
+void test_task_profiler_idle_hook_core_load() {
+    // 240 MHz; idle-loop passes more than 5 us apart are preemptions.
+    const uint32_t MHZ = 240;
+    IdleMeter meter;
+    meter.setMaxGap(5 * MHZ);
+    uint32_t t = 0xFFFFF000u;  // the cycle counter wraps during the run
+    meter.tick(t);
+    for (int i = 0; i < 1000; ++i) meter.tick(t += MHZ);  // 1 ms idle in 1 us passes
+    t += 3000 * MHZ;                                       // preempted for 3 ms
+    meter.tick(t);
+    for (int i = 0; i < 1000; ++i) meter.tick(t += MHZ);  // 1 ms idle
+    TEST_ASSERT_EQUAL_UINT32(2000 * MHZ, meter.idleCycles());
+
+    TaskProfiler profiler;
+    TaskSample tasks[] = {make_task("uiTask", 4, 0, 0, 900)};
+    IdleSample idle = {{0u, 0xFFFFFFF0u}, MHZ};
+    std::shared_ptr<TaskReport> r = profiler.update(tasks, 1, 0, false, &idle);
+    TEST_ASSERT_EQUAL_FLOAT(-1.0f, r->coreLoadPct[0]);  // no window yet
+    TEST_ASSERT_TRUE(r->idleHooks);
+
+    // 1 s later: core 0 idle 750 ms, core 1 idle 100 ms across a counter wrap.
+    idle.idleCycles[0] += 750000u * MHZ;
+    idle.idleCycles[1] += 100000u * MHZ;
+    r = profiler.update(tasks, 1, 1000000, false, &idle);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 25.0f, r->coreLoadPct[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 90.0f, r->coreLoadPct[1]);
+    TEST_ASSERT_EQUAL_FLOAT(-1.0f, r->tasks[0].cpuPct);  // per-task CPU still needs run-time stats
+    TEST_ASSERT_TRUE(r->json.find("\"idle_hooks\":true,\"cores\":[{\"core\":0,\"load\":25.0}") != std::string::npos);
+
+    // With run-time counters the idle hooks are ignored.
+    TaskProfiler withStats;
+    r = withStats.update(tasks, 1, 0, true, &idle);
+    TEST_ASSERT_FALSE(r->idleHooks);
+}
+
+static const char *trace_thread_name(uint32_t tid) { return tid == 7 ? "motorTask" : nullptr; }
+
+template <size_t C, size_t N>
+static std::string export_trace(const TraceBuffer<C, N> &buffer, uint32_t mhz, size_t chunk) {
+    ChromeTraceStream<C, N> stream(buffer, mhz, &trace_thread_name);
+    std::string text;
+    uint8_t buf[512];
+    size_t n;
+    while ((n = stream.fill(buf, chunk)) > 0) text.append((const char *)buf, n);
+    return text;
+}
+
+/**
+ * @brief Disabled tracing records nothing; enabled events export as Chrome JSON.
+ */
+void test_trace_export_chrome_json() {
+    static TraceBuffer<2, 8> trace;
+    trace.record(0, 100, TRACE_PHASE_INSTANT, "ignored", 7, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, trace.head(0));
+
+    trace.setEnabled(true);
+    // 240 cycles per us; the counter wraps between begin and end.
+    trace.sync(1, 0xFFFFFF10u, 1000000);
+    trace.record(1, 0xFFFFFF10u, TRACE_PHASE_BEGIN, "motor_cycle", 7, 0);
+    trace.record(1, 0xFFFFFF10u + 240 * 11, TRACE_PHASE_END, "motor_cycle", 7, 0);
+    trace.record(0, 5, TRACE_PHASE_INSTANT, "no_sync_yet", 3, 0);  // core 0 never synced: skipped
+    std::string json = export_trace(trace, 240, 512);
+
+    TEST_ASSERT_TRUE(json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[") == 0);
+    TEST_ASSERT_TRUE(json.find("{\"name\":\"motor_cycle\",\"ph\":\"B\",\"ts\":1000000.000,\"pid\":1,\"tid\":7,"
+                               "\"args\":{\"core\":1,\"arg\":0}}") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"ph\":\"E\",\"ts\":1000011.000") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("no_sync_yet") == std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"ph\":\"M\",\"pid\":1,\"tid\":7,\"args\":{\"name\":\"motorTask\"}") !=
+                     std::string::npos);
+    TEST_ASSERT_TRUE(json.rfind("]}\n") == json.size() - 3);
+    TEST_ASSERT_EQUAL_STRING(json.c_str(), export_trace(trace, 240, 5).c_str());
+}
+
+/**
+ * @brief Only the newest SIZE events per core survive, and concurrent writers never corrupt them.
+ */
+void test_trace_ring_overwrite_and_concurrency() {
+    static TraceBuffer<1, 64> trace;
+    trace.setEnabled(true);
+    trace.sync(0, 0, 0);
+    std::thread a([&]() { for (uint32_t i = 0; i < 50000; ++i) trace.record(0, i, TRACE_PHASE_INSTANT, "a", 1, i); });
+    std::thread b([&]() { for (uint32_t i = 0; i < 50000; ++i) trace.record(0, i, TRACE_PHASE_INSTANT, "b", 2, i); });
+    a.join();
+    b.join();
+    TEST_ASSERT_EQUAL_UINT32(100000, trace.head(0));
+    TraceEvent ev;
+    TEST_ASSERT_FALSE(trace.read(0, 100000 - 65, ev));  // overwritten
+    size_t valid = 0;
+    for (uint32_t i = 100000 - 64; i < 100000; ++i) {
+        if (!trace.read(0, i, ev)) continue;
+        valid++;
+        TEST_ASSERT_TRUE((ev.tid == 1 && strcmp(ev.name, "a") == 0) || (ev.tid == 2 && strcmp(ev.name, "b") == 0));
+        TEST_ASSERT_EQUAL_UINT32(ev.cycles, ev.arg);
+    }
+    TEST_ASSERT_EQUAL_size_t(64, valid);
+}
+
+/** @brief One command as its producer delivers it to motor_task. */
+struct SimCommand {
+    uint32_t ingressMs;
+    uint32_t postMs;  ///< When the producer posts it (its own task period after ingress).
+    CommandSource source;
+    float rpm;
+    StopMode stop;  ///< STOP_MODE_COUNT for a speed command.
+};
+
+struct SimMotorRun {
+    uint32_t posted;
+    uint32_t completed;
+    uint32_t maxApplyMs;
+    uint32_t stopOverruns;
+};
+
+/**
+ * @brief Runs motor_task's control step (MotorCycle) every 50 ms against a SimStepper.
+ *
+ * Commands are posted as their producers do: speeds and graceful stops go
+ * through the mailbox; a hard stop halts the stepper and observes its apply
+ * latency in the producer first, like motor_stop(). Time advances in 1 ms steps.
+ */
+static SimMotorRun simulate_motor_task(const SimCommand *cmds, uint32_t count, float startRpm, uint32_t durationMs,
+                                       CommandLatencyStats *stats) {
+    const uint32_t MOTOR_PERIOD_MS = 50;
+    CommandLatencyTracker tracker(stats);
+    MotorCycleConfig config = {(uint32_t)(rpm_to_sps(60.0f) + 0.5f), 5000};
+    MotorCycle<float> cycle(tracker, config);
+    SetpointMailbox mailbox;
+    SimStepper stepper;
+    float targetRpm = startRpm, currentRpm = startRpm;
+
+    if (startRpm >= 1.0f) {
+        stepper.setAcceleration(ramp_accel_sps2());
+        stepper.setSpeedInTicks(rpm_to_ticks(startRpm));
+        stepper.runForward();
+        for (int i = 0; i < 10000; ++i) stepper.advance(1000);
+    }
+
+    SimMotorRun run = {};
+    for (uint32_t t = 0; t < durationMs; ++t) {
+        while (run.posted < count && cmds[run.posted].postMs == t) {
+            const SimCommand &c = cmds[run.posted++];
+            if (c.stop == STOP_MODE_HARD) {
+                targetRpm = 0.0f;
+                stepper.forceStop();
+                stepper.disableOutputs();
+                stats[c.source].applied.observe((t - c.ingressMs) * 1000);
+            }
+            mailbox.post(c.rpm, c.source, c.ingressMs * 1000, c.stop == STOP_MODE_HARD);
+        }
+        if (t % MOTOR_PERIOD_MS == 0) {
+            SetpointCommand cmd;
+            bool took = mailbox.take(cmd);
+            cycle.resolve(took ? &cmd : nullptr, nullptr, false, &targetRpm, &currentRpm);
+            MotorCycleResult result = cycle.drive(&stepper, t, t * 1000);
+            if (took && !(cmd.stop && cmd.applied)) run.maxApplyMs = std::max(run.maxApplyMs, t - cmd.ingressUs / 1000);
+            if (result.commandReached) run.completed++;
+            if (result.stopOverrun) run.stopOverruns++;
+            currentRpm = stepper.getCurrentSpeedInMilliHz() / 1000.0f / (float)(SPR_CMD / 60.0);
+        }
+        stepper.advance(1000);
+    }
+    TEST_ASSERT_FALSE(tracker.pending());
+    return run;
+}
+
+/** @brief When a source's task picks up a command that arrived at @p ingressMs. */
+static uint32_t sim_post_ms(CommandSource source, uint32_t ingressMs) {
+    const uint32_t UI_PERIOD_MS = 20, PROTOCOL_PERIOD_MS = 10, HTTP_HANDLER_MS = 2;
+    if (source == CMD_SOURCE_ENCODER) return (ingressMs / UI_PERIOD_MS + 1) * UI_PERIOD_MS;
+    if (source == CMD_SOURCE_PROTOCOL) return (ingressMs / PROTOCOL_PERIOD_MS + 1) * PROTOCOL_PERIOD_MS;
+    return ingressMs + HTTP_HANDLER_MS;
+}
+
+/**
+ * @brief Simulates motor_task driving a stepper and checks per-source command latency.
+ *
+ * Commands arrive from the three sources on each source's own task period
+ * (HTTP handled at once, encoder picked up by the 20 ms UI loop, Modbus by
+ * the 10 ms protocol loop) and motor_task applies them every 50 ms. Each
+ * command changes the speed by 10 RPM, a one-second ramp at A_CMD.
+ */
+void test_command_latency_p99_on_simulated_stepper() {
+    const uint32_t MOTOR_PERIOD_MS = 50, UI_PERIOD_MS = 20;
+    const uint32_t COMMANDS = 60, SPACING_MS = 3000;
+    const uint32_t SOURCES = CMD_SOURCE_PROTOCOL + 1;  // the external ones
+    static CommandLatencyStats stats[CMD_SOURCE_COUNT];
+
+    SimCommand cmds[COMMANDS + 1];
+    for (uint32_t k = 0; k < COMMANDS; ++k) {
+        uint32_t t = 1000 + k * SPACING_MS + (k * 37) % 500;
+        CommandSource source = (CommandSource)(k % SOURCES);
+        cmds[k] = {t, sim_post_ms(source, t), source, 70.0f - (float)(k % 2) * 10.0f, STOP_MODE_COUNT};
+    }
+    // One more command 100 ms after the last one replaces it mid-ramp.
+    cmds[COMMANDS] = {cmds[COMMANDS - 1].ingressMs + 100, cmds[COMMANDS - 1].ingressMs + 102, CMD_SOURCE_HTTP, 80.0f,
+                      STOP_MODE_COUNT};
+
+    // Already spinning at 60 RPM before the first command.
+    SimMotorRun run = simulate_motor_task(cmds, COMMANDS + 1, 60.0f, 1000 + (COMMANDS + 4) * SPACING_MS, stats);
+
+    TEST_ASSERT_EQUAL_UINT32(COMMANDS + 1, run.posted);
+    TEST_ASSERT_EQUAL_UINT32(COMMANDS, run.completed);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(MOTOR_PERIOD_MS + UI_PERIOD_MS, run.maxApplyMs);
+    uint32_t superseded = 0;
+    for (size_t s = 0; s < SOURCES; ++s) {
+        TEST_ASSERT_EQUAL_UINT32(COMMANDS / SOURCES + (s == CMD_SOURCE_HTTP ? 1 : 0), stats[s].applied.count());
+        // Apply: one motor period plus the source's own polling.
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(100000, stats[s].applied.quantileUs(0.99));
+        // Reached: the 1 s ramp plus apply delay plus one motor period to notice.
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(2500000, stats[s].reached.quantileUs(0.99));
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32(1000000, stats[s].reached.quantileUs(0.5));
+        superseded += stats[s].superseded.value();
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, superseded);
+    TEST_ASSERT_EQUAL_UINT32(1, stats[(COMMANDS - 1) % SOURCES].superseded.value());
+}
+
+/**
+ * @brief Stop commands through the same control step: graceful along the stop ramp, hard at once.
+ *
+ * The motor runs at 20 RPM; each round stops it and restarts it a second
+ * later. HTTP and the encoder stop gracefully (20 RPM at 60 RPM/s is a
+ * 333 ms ramp), Modbus stops hard. The restarts come from the supervisor
+ * source so the external sources' histograms hold only stops.
+ */
+void test_stop_latency_p99_on_simulated_stepper() {
+    const uint32_t ROUNDS = 30, SPACING_MS = 4000;
+    const uint32_t SOURCES = CMD_SOURCE_PROTOCOL + 1;
+    static CommandLatencyStats stats[CMD_SOURCE_COUNT];
+
+    SimCommand cmds[2 * ROUNDS];
+    for (uint32_t k = 0; k < ROUNDS; ++k) {
+        uint32_t t = 1000 + k * SPACING_MS + (k * 37) % 300;
+        CommandSource source = (CommandSource)(k % SOURCES);
+        StopMode mode = source == CMD_SOURCE_PROTOCOL ? STOP_MODE_HARD : STOP_MODE_GRACEFUL;
+        cmds[2 * k] = {t, sim_post_ms(source, t), source, 0.0f, mode};
+        cmds[2 * k + 1] = {t + 1000, t + 1000, CMD_SOURCE_SUPERVISOR, 20.0f, STOP_MODE_COUNT};
+    }
+
+    SimMotorRun run = simulate_motor_task(cmds, 2 * ROUNDS, 20.0f, 1000 + (ROUNDS + 1) * SPACING_MS, stats);
+
+    TEST_ASSERT_EQUAL_UINT32(2 * ROUNDS, run.posted);
+    TEST_ASSERT_EQUAL_UINT32(2 * ROUNDS, run.completed);
+    TEST_ASSERT_EQUAL_UINT32(0, run.stopOverruns);
+    for (size_t s = 0; s < SOURCES; ++s) {
+        TEST_ASSERT_EQUAL_UINT32(ROUNDS / SOURCES, stats[s].applied.count());
+        TEST_ASSERT_EQUAL_UINT32(ROUNDS / SOURCES, stats[s].reached.count());
+    }
+    for (CommandSource s : {CMD_SOURCE_HTTP, CMD_SOURCE_ENCODER}) {
+        // Apply: one motor period plus polling. Reached: the ramp, plus apply, plus a period to notice.
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(100000, stats[s].applied.quantileUs(0.99));
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(500000, stats[s].reached.quantileUs(0.99));
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32(250000, stats[s].reached.quantileUs(0.5));
+    }
+    // Hard: applied by the producer within its 10 ms poll; motor_task only notices the standstill.
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(10000, stats[CMD_SOURCE_PROTOCOL].applied.quantileUs(0.99));
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(100000, stats[CMD_SOURCE_PROTOCOL].reached.quantileUs(0.99));
+}
+
+/**
+ * @brief Stops still stop when motor_task cannot take rpmMutex.
+ *
+ * A hard stop whose producer also missed the lock leaves targetRpm at the
+ * old speed; the applied stop must zero it on the next locked cycle instead
+ * of letting that cycle restart the motor, and must stop a stepper that a
+ * racing cycle restarted. A graceful stop or a new speed taken while
+ * unlocked acts at once and reaches targetRpm later.
+ */
+void test_motor_cycle_stops_without_the_lock() {
+    static CommandLatencyStats stats[CMD_SOURCE_COUNT];
+    CommandLatencyTracker tracker(stats);
+    MotorCycleConfig config = {(uint32_t)(rpm_to_sps(60.0f) + 0.5f), 5000};
+    MotorCycle<float> cycle(tracker, config);
+    SimStepper stepper;
+    float targetRpm = 60.0f, currentRpm = 60.0f;
+    uint32_t t = 0;
+    auto run_for = [&](uint32_t ms) {
+        for (uint32_t i = 0; i < ms; ++i) stepper.advance(1000);
+        t += ms;
+    };
+
+    cycle.resolve(nullptr, nullptr, false, &targetRpm, &currentRpm);
+    MotorCycleResult result = cycle.drive(&stepper, t, t * 1000);
+    TEST_ASSERT_TRUE(result.outputsEnabled);
+    run_for(8000);
+    TEST_ASSERT_TRUE(stepper.isRunningContinuously());
+
+    // Hard stop, producer without the lock: the stepper halts, targetRpm stays at 60.
+    stepper.forceStop();
+    stepper.disableOutputs();
+    SetpointCommand cmd = {0.0f, true, true, CMD_SOURCE_PROTOCOL, t * 1000};
+    // A cycle racing the producer restarted it before taking the stop.
+    stepper.runForward();
+    cycle.resolve(&cmd, nullptr, false, nullptr, nullptr);
+    result = cycle.drive(&stepper, t, t * 1000);
+    TEST_ASSERT_EQUAL_UINT16(MOTOR_ERR_LOCK_TIMEOUT, result.errorFlags);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, result.setpointRpm);
+    TEST_ASSERT_FALSE(stepper.isRunning());
+    TEST_ASSERT_FALSE(result.outputsEnabled);
+    TEST_ASSERT_TRUE(result.commandReached);
+    run_for(50);
+    cycle.resolve(nullptr, nullptr, false, &targetRpm, &currentRpm);
+    result = cycle.drive(&stepper, t, t * 1000);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, targetRpm);
+    TEST_ASSERT_EQUAL_UINT16(0, result.errorFlags);
+    TEST_ASSERT_FALSE(stepper.isRunning());
+
+    // A speed taken unlocked drives at once and is written once the lock is back.
+    cmd = {40.0f, false, false, CMD_SOURCE_HTTP, t * 1000};
+    cycle.resolve(&cmd, nullptr, false, nullptr, nullptr);
+    result = cycle.drive(&stepper, t, t * 1000);
+    TEST_ASSERT_TRUE(result.outputsEnabled);
+    TEST_ASSERT_TRUE(stepper.isRunningContinuously());
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, targetRpm);
+    run_for(50);
+    cycle.resolve(nullptr, nullptr, false, &targetRpm, &currentRpm);
+    cycle.drive(&stepper, t, t * 1000);
+    TEST_ASSERT_EQUAL_FLOAT(40.0f, targetRpm);
+    run_for(5000);
+
+    // Graceful stop taken unlocked: the ramp starts now, targetRpm follows later.
+    cmd = {0.0f, true, false, CMD_SOURCE_ENCODER, t * 1000};
+    cycle.resolve(&cmd, nullptr, false, nullptr, nullptr);
+    cycle.drive(&stepper, t, t * 1000);
+    TEST_ASSERT_TRUE(stepper.isRunning());
+    for (int i = 0; i < 20 && stepper.isRunning(); ++i) {
+        run_for(50);
+        cycle.resolve(nullptr, nullptr, false, nullptr, nullptr);  // still no lock
+        result = cycle.drive(&stepper, t, t * 1000);
+        TEST_ASSERT_FALSE(result.outputsEnabled);
+    }
+    TEST_ASSERT_FALSE(stepper.isRunning());
+    TEST_ASSERT_EQUAL_FLOAT(40.0f, targetRpm);
+    cycle.resolve(nullptr, nullptr, false, &targetRpm, &currentRpm);
+    result = cycle.drive(&stepper, t, t * 1000);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, targetRpm);
+    TEST_ASSERT_FALSE(result.outputsEnabled);
+    TEST_ASSERT_FALSE(stepper.isRunning());
+    TEST_ASSERT_FALSE(tracker.pending());
+}
+
+/**
+ * @brief The mailbox carries each command's source and ingress stamp.
+ */
+void test_setpoint_mailbox_carries_source_and_stamp() {
+    SetpointMailbox mailbox;
+    SetpointCommand cmd;
+    mailbox.post(120.0f, CMD_SOURCE_PROTOCOL, 4242);
+    TEST_ASSERT_TRUE(mailbox.take(cmd));
+    TEST_ASSERT_EQUAL_UINT8(CMD_SOURCE_PROTOCOL, cmd.source);
+    TEST_ASSERT_EQUAL_UINT32(4242, cmd.ingressUs);
+    TEST_ASSERT_FALSE(cmd.applied);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 120.0f, cmd.rpm);
+    mailbox.post(0.0f, CMD_SOURCE_ENCODER, 99, true);
+    TEST_ASSERT_TRUE(mailbox.take(cmd));
+    TEST_ASSERT_TRUE(cmd.stop);
+    TEST_ASSERT_TRUE(cmd.applied);
+    TEST_ASSERT_EQUAL_UINT8(CMD_SOURCE_ENCODER, cmd.source);
+    TEST_ASSERT_EQUAL_UINT32(99, cmd.ingressUs);
+    // Every source survives the packing, the last ones included.
+    for (uint8_t s = 0; s < CMD_SOURCE_COUNT; ++s) {
+        mailbox.post(50.0f, (CommandSource)s, 1000u + s);
+        TEST_ASSERT_TRUE(mailbox.take(cmd));
+        TEST_ASSERT_EQUAL_UINT8(s, cmd.source);
+        TEST_ASSERT_EQUAL_UINT32(1000u + s, cmd.ingressUs);
+        TEST_ASSERT_FALSE(cmd.stop);
+    }
+}
+
+/**
+ * @brief Constant and alternating errors give closed-form mean, RMS, peak and Allan deviation.
+ */
+void test_speed_stats_synthetic_streams() {
+    SpeedStabilityMonitor offset(300);
+    for (int i = 0; i < 1000; ++i) offset.update(200.0f, 200.5f, 300);
+    SpeedStabilityReport r = offset.report();
+    TEST_ASSERT_EQUAL_UINT8(SPEED_STATS_STEADY, r.state);
+    TEST_ASSERT_EQUAL_UINT32(1000, r.samples);
+    TEST_ASSERT_EQUAL_UINT32(300000, r.durationMs);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.5f, r.meanError);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.5f, r.rmsError);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.5f, r.peakError);
+    TEST_ASSERT_EQUAL_UINT32(999, r.adevPairs[0]);
+    TEST_ASSERT_EQUAL_UINT32(99, r.adevPairs[1]);
+    TEST_ASSERT_EQUAL_UINT32(0, r.adevPairs[3]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, r.adev[0]);
+
+    // +-1 RPM every other sample: sample-to-sample differences are 2, blocks of 10 cancel out.
+    SpeedStabilityMonitor alternating(300);
+    for (int i = 0; i < 2000; ++i) alternating.update(200.0f, (i % 2) ? 201.0f : 199.0f, 300);
+    r = alternating.report();
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.0f, r.meanError);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 1.0f, r.rmsError);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 1.0f, r.peakError);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, sqrtf(2.0f), r.adev[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.0f, r.adev[1]);
+
+    char line[200];
+    SpeedStabilityMonitor::format(r, line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("target 200.0 rpm, 600 s steady: mean +0.000 rms 1.000 peak 1.000 adev 0.3s=1.414 3s=0.000 "
+                             "30s=0.000 300s=0.000", line);
+}
+
+/**
+ * @brief White noise of deviation sigma has an Allan deviation of sigma / sqrt(m).
+ */
+void test_speed_stats_white_noise_allan() {
+    SpeedStabilityMonitor monitor(300, 100.0f);
+    uint32_t seed = 12345;
+    const double sigma = 0.2;
+    for (int i = 0; i < 200000; ++i) {
+        // Sum of 12 uniforms: mean 6, variance 1.
+        double g = 0.0;
+        for (int k = 0; k < 12; ++k) {
+            seed = seed * 1664525u + 1013904223u;
+            g += (seed >> 8) / 16777216.0;
+        }
+        monitor.update(150.0f, (float)(150.0 + sigma * (g - 6.0)), 300);
+    }
+    SpeedStabilityReport r = monitor.report();
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, r.meanError);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, (float)sigma, r.rmsError);
+    TEST_ASSERT_FLOAT_WITHIN(0.03f * sigma, sigma, r.adev[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f * sigma / sqrt(10.0), sigma / sqrt(10.0), r.adev[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.15f * sigma / 10.0, sigma / 10.0, r.adev[2]);
+}
+
+/**
+ * @brief The ramp is excluded and a setpoint change closes the segment.
+ */
+void test_speed_stats_settling_and_segments() {
+    SpeedStabilityMonitor monitor(300, 1.0f);
+    TEST_ASSERT_FALSE(monitor.update(0.0f, 0.0f, 300));
+    TEST_ASSERT_EQUAL_UINT8(SPEED_STATS_IDLE, monitor.report().state);
+
+    for (int rpm = 0; rpm < 100; rpm += 10) monitor.update(100.0f, (float)rpm, 300);  // ramp
+    TEST_ASSERT_EQUAL_UINT8(SPEED_STATS_SETTLING, monitor.report().state);
+    TEST_ASSERT_EQUAL_UINT32(0, monitor.report().samples);
+    for (int i = 0; i < 10; ++i) monitor.update(100.0f, 100.2f, 300);
+    TEST_ASSERT_EQUAL_UINT32(10, monitor.report().samples);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.2f, monitor.report().peakError);
+
+    TEST_ASSERT_TRUE(monitor.update(120.0f, 100.2f, 300));
+    TEST_ASSERT_EQUAL_UINT32(10, monitor.lastSegment().samples);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 100.0f, monitor.lastSegment().targetRpm);
+    TEST_ASSERT_EQUAL_UINT32(0, monitor.report().samples);
+
+    // A change before the new segment settled does not report an empty one.
+    TEST_ASSERT_FALSE(monitor.update(0.0f, 110.0f, 300));
+    TEST_ASSERT_EQUAL_UINT8(SPEED_STATS_IDLE, monitor.report().state);
+}
+
+/**
+ * @brief A stall is counted once, whether poll() or the late check-in sees it first.
+ */
+void test_deadline_supervisor_counts_each_stall_once() {
+    DeadlineSupervisor<4> sup;
+    int motor = sup.add("motorTask", 200, true, 0);
+    int ui = sup.add("uiTask", 1000, false, 0);
+    TEST_ASSERT_EQUAL_INT(0, motor);
+    TEST_ASSERT_EQUAL_INT(1, ui);
+    int out[4];
+
+    for (uint32_t t = 50; t <= 1000; t += 50) {
+        sup.checkIn(motor, t);
+        if (t % 500 == 0) sup.checkIn(ui, t);
+        TEST_ASSERT_EQUAL_size_t(0, sup.poll(t, out, 4));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, sup.misses(motor));
+
+    // Motor silent: poll reports it once, however often it looks.
+    TEST_ASSERT_EQUAL_size_t(0, sup.poll(1200, out, 4));
+    TEST_ASSERT_EQUAL_size_t(1, sup.poll(1201, out, 4));
+    TEST_ASSERT_EQUAL_INT(motor, out[0]);
+    TEST_ASSERT_TRUE(sup.critical(out[0]));
+    TEST_ASSERT_TRUE(sup.stalled(motor));
+    TEST_ASSERT_EQUAL_size_t(0, sup.poll(1400, out, 4));
+    TEST_ASSERT_EQUAL_UINT32(600, sup.checkIn(motor, 1600));  // the late check-in does not count again
+    TEST_ASSERT_FALSE(sup.stalled(motor));
+    TEST_ASSERT_EQUAL_UINT32(1, sup.misses(motor));
+    TEST_ASSERT_EQUAL_UINT32(600, sup.worstGapMs(motor));
+
+    // A short overrun between two polls is counted by the check-in.
+    sup.checkIn(motor, 1850);
+    TEST_ASSERT_EQUAL_UINT32(2, sup.misses(motor));
+    TEST_ASSERT_EQUAL_size_t(0, sup.poll(1860, out, 4));
+    TEST_ASSERT_EQUAL_UINT32(2, sup.misses(motor));
+
+    // The UI last checked in at 1000; it is reported on its own deadline.
+    TEST_ASSERT_EQUAL_size_t(1, sup.poll(2001, out, 4));
+    TEST_ASSERT_EQUAL_STRING("uiTask", sup.name(out[0]));
+    TEST_ASSERT_FALSE(sup.critical(out[0]));
+
+    TEST_ASSERT_EQUAL_INT(2, sup.add("a", 1, false, 0));
+    TEST_ASSERT_EQUAL_INT(3, sup.add("b", 1, false, 0));
+    TEST_ASSERT_EQUAL_INT(DeadlineSupervisor<4>::INVALID, sup.add("c", 1, false, 0));
+}
+
+/**
+ * @brief A task checking in while the supervisor polls: every late cycle is counted exactly once.
+ */
+void test_deadline_supervisor_concurrent_poll() {
+    static DeadlineSupervisor<1> sup;
+    std::atomic<uint32_t> clock{0};
+    std::atomic<bool> done{false};
+    int id = sup.add("worker", 20, true, 0);
+    uint32_t late = 0;
+    std::thread worker([&]() {
+        uint32_t seed = 7;
+        for (int i = 0; i < 200000; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            uint32_t gap = (seed >> 16) % 100 == 0 ? 25 + (seed >> 8) % 50 : 1 + (seed >> 8) % 20;
+            if (gap > 20) late++;
+            clock.fetch_add(gap);
+            sup.checkIn(id, clock.load());
+        }
+        done = true;
+    });
+    int out[1];
+    while (!done) sup.poll(clock.load(), out, 1);
+    worker.join();
+    TEST_ASSERT_GREATER_THAN_UINT32(0, late);
+    TEST_ASSERT_EQUAL_UINT32(late, sup.misses(id));
+}
+
+struct TestConfig {
+    uint8_t language;
+    float maxRpm;
+    char name[12];
+};
+
+/**
+ * @brief Members round-trip by key; keys missing from the file keep their default, unknown ones are skipped.
+ */
+void test_config_store_roundtrip_and_versioned_keys() {
+    const ConfigField v1[] = {CONFIG_FIELD(1, TestConfig, language), CONFIG_FIELD(3, TestConfig, name)};
+    const ConfigField v2[] = {CONFIG_FIELD(1, TestConfig, language), CONFIG_FIELD(2, TestConfig, maxRpm),
+                              CONFIG_FIELD(3, TestConfig, name)};
+    TestConfig written = {1, 400.0f, "lab-a"};
+    uint8_t buf[128];
+    size_t n = config_encode(written, v1, 2, buf, sizeof(buf));
+    TEST_ASSERT_GREATER_THAN(0, n);
+
+    // Newer firmware reading an older file: maxRpm keeps its default.
+    TestConfig loaded = {0, 510.0f, ""};
+    TEST_ASSERT_TRUE(config_decode(buf, n, v2, 3, loaded));
+    TEST_ASSERT_EQUAL_UINT8(1, loaded.language);
+    TEST_ASSERT_EQUAL_FLOAT(510.0f, loaded.maxRpm);
+    TEST_ASSERT_EQUAL_STRING("lab-a", loaded.name);
+
+    // Older firmware reading a newer file skips key 2.
+    n = config_encode(written, v2, 3, buf, sizeof(buf));
+    TestConfig old = {0, 510.0f, ""};
+    TEST_ASSERT_TRUE(config_decode(buf, n, v1, 2, old));
+    TEST_ASSERT_EQUAL_FLOAT(510.0f, old.maxRpm);
+    TEST_ASSERT_EQUAL_STRING("lab-a", old.name);
+
+    TEST_ASSERT_EQUAL_UINT(0, config_encode(written, v2, 3, buf, 20));
+}
+
+/**
+ * @brief A truncated or corrupted file is rejected and leaves the defaults alone.
+ */
+void test_config_store_rejects_corrupt_file() {
+    const ConfigField fields[] = {CONFIG_FIELD(1, TestConfig, language), CONFIG_FIELD(2, TestConfig, maxRpm)};
+    TestConfig written = {1, 400.0f, ""};
+    uint8_t buf[64];
+    size_t n = config_encode(written, fields, 2, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, config_crc32((const uint8_t *)"123456789", 9));
+
+    TestConfig out = {0, 510.0f, ""};
+    TEST_ASSERT_FALSE(config_decode(buf, n - 1, fields, 2, out));
+    buf[n - 1] ^= 0x01;
+    TEST_ASSERT_FALSE(config_decode(buf, n, fields, 2, out));
+    TEST_ASSERT_EQUAL_UINT8(0, out.language);
+    TEST_ASSERT_EQUAL_FLOAT(510.0f, out.maxRpm);
+}
+
+/**
+ * @brief A burst of changes is committed once, after the quiet period or the maximum delay.
+ */
+void test_config_store_coalesces_writes() {
+    TestConfig defaults = {0, 510.0f, ""};
+    ConfigStore<TestConfig> store(defaults, 2000, 30000);
+    TEST_ASSERT_FALSE(store.dirty());
+
+    TestConfig c = store.value();
+    TEST_ASSERT_FALSE(store.set(c, 0));  // unchanged: nothing to write
+    for (uint32_t t = 0; t < 10; ++t) {
+        c.maxRpm = 400.0f + t;
+        store.set(c, 100 * t);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(409.0f, store.get().maxRpm);
+    TEST_ASSERT_FALSE(store.commitDue(2800));
+    TEST_ASSERT_TRUE(store.commitDue(2900));
+
+    // A change while the file is written stays pending.
+    uint32_t version = store.version();
+    c.language = 1;
+    store.set(c, 2950);
+    store.committed(version, true, 3000);
+    TEST_ASSERT_TRUE(store.dirty());
+    store.committed(store.version(), true, 5000);
+    TEST_ASSERT_FALSE(store.dirty());
+    TEST_ASSERT_EQUAL_UINT32(2, store.commits());
+
+    // Continuous edits still reach flash after the maximum delay.
+    uint32_t t = 10000;
+    for (; !store.commitDue(t); t += 500) {
+        c.maxRpm = (float)t;
+        store.set(c, t);
+    }
+    TEST_ASSERT_EQUAL_UINT32(40000, t);  // 30 s after the first change
+
+    // A failed write is retried after another quiet period.
+    store.committed(store.version(), false, 40000);
+    TEST_ASSERT_EQUAL_UINT32(1, store.failures());
+    TEST_ASSERT_FALSE(store.commitDue(41000));
+    TEST_ASSERT_TRUE(store.commitDue(42000));
+}
+
+/**
+ * @brief A reboot replays the latest record, also after the ring wrapped around its sectors.
+ */
+void test_run_journal_replays_latest_across_wrap() {
+    SimFlash flash(2 * RUN_JOURNAL_SECTOR_SIZE);
+    RunJournal<SimFlash> journal(flash);
+    RunState state = {};
+    TEST_ASSERT_FALSE(journal.begin());
+    TEST_ASSERT_FALSE(journal.latest(state));
+
+    const uint32_t total = 3 * RunJournal<SimFlash>::SLOTS_PER_SECTOR + 17;  // wraps the 2-sector ring
+    for (uint32_t i = 1; i <= total; ++i) {
+        RunState s = {true, 100.0f + (i % 50) / 10.0f, 0, i * 60};
+        TEST_ASSERT_TRUE(journal.append(s));
+    }
+    TEST_ASSERT_EQUAL_UINT32(total, flash.writes);
+    TEST_ASSERT_EQUAL_UINT32(4, flash.erases);  // one per sector entered
+
+    RunJournal<SimFlash> rebooted(flash);
+    TEST_ASSERT_TRUE(rebooted.begin());
+    TEST_ASSERT_TRUE(rebooted.latest(state));
+    TEST_ASSERT_TRUE(state.running);
+    TEST_ASSERT_EQUAL_UINT32(total * 60, state.elapsedS);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 100.0f + (total % 50) / 10.0f, state.rpm);
+
+    // Appending after the reboot continues the sequence.
+    RunState stopped = {false, 0.0f, 0, total * 60};
+    TEST_ASSERT_TRUE(rebooted.append(stopped));
+    RunJournal<SimFlash> again(flash);
+    TEST_ASSERT_TRUE(again.begin());
+    again.latest(state);
+    TEST_ASSERT_FALSE(state.running);
+}
+
+/**
+ * @brief A record torn by a power loss is ignored and its slot is not written again.
+ */
+void test_run_journal_survives_torn_write() {
+    SimFlash flash(2 * RUN_JOURNAL_SECTOR_SIZE);
+    RunJournal<SimFlash> journal(flash);
+    journal.begin();
+    RunState a = {true, 150.0f, 0, 3600};
+    journal.append(a);
+    flash.tearNextWrite(6);
+    RunState b = {true, 200.0f, 0, 3660};
+    journal.append(b);
+
+    RunJournal<SimFlash> rebooted(flash);
+    RunState state = {};
+    TEST_ASSERT_TRUE(rebooted.begin());
+    rebooted.latest(state);
+    TEST_ASSERT_EQUAL_FLOAT(150.0f, state.rpm);
+    TEST_ASSERT_EQUAL_UINT32(3600, state.elapsedS);
+
+    RunState c = {true, 150.0f, 0, 3720};
+    TEST_ASSERT_TRUE(rebooted.append(c));
+    RunJournal<SimFlash> again(flash);
+    again.begin();
+    again.latest(state);
+    TEST_ASSERT_EQUAL_UINT32(3720, state.elapsedS);
+}
+
+/**
+ * @brief Setpoint changes are journaled at once and a steady run once per period.
+ */
+void test_run_journal_policy() {
+    RunJournalPolicy policy(60);
+    TEST_ASSERT_FALSE(policy.update(0.0f, 1));
+    TEST_ASSERT_TRUE(policy.update(120.0f, 1));  // start
+    uint32_t writes = 0;
+    for (int s = 0; s < 300; ++s) writes += policy.update(120.0f, 1);
+    TEST_ASSERT_EQUAL_UINT32(5, writes);
+    TEST_ASSERT_EQUAL_UINT32(300, policy.state().elapsedS);
+    TEST_ASSERT_TRUE(policy.update(130.0f, 1));  // new setpoint, same run
+    TEST_ASSERT_EQUAL_UINT32(301, policy.state().elapsedS);
+    TEST_ASSERT_TRUE(policy.update(0.0f, 1));  // stop
+    TEST_ASSERT_FALSE(policy.state().running);
+
+    // A resumed run keeps counting from the journaled time.
+    RunState restored = {true, 90.0f, 0, 7200};
+    policy.resume(restored);
+    TEST_ASSERT_FALSE(policy.update(90.0f, 1));
+    TEST_ASSERT_EQUAL_UINT32(7201, policy.state().elapsedS);
+
+    // Only a power loss resumes; a panic or watchdog reset leaves the run stopped.
+    TEST_ASSERT_TRUE(run_journal_should_resume(restored, RESET_POWER_LOSS, true));
+    TEST_ASSERT_FALSE(run_journal_should_resume(restored, RESET_OTHER, true));
+    TEST_ASSERT_FALSE(run_journal_should_resume(restored, RESET_POWER_LOSS, false));
+    restored.running = false;
+    TEST_ASSERT_FALSE(run_journal_should_resume(restored, RESET_POWER_LOSS, true));
+}
+
+/**
+ * @brief The estimator follows the counter across its wrap and smooths towards the speed.
+ */
+void test_rpm_estimator_wraps_and_smooths() {
+    RpmEstimator estimator;
+    estimator.reset(INT32_MAX - 100);
+    // 320 steps in 100 ms at 3200 steps/rev: 60 RPM, across the wrap.
+    int32_t wrapped = (int32_t)((uint32_t)INT32_MAX - 100u + 320u);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 60.0f, estimator.update(wrapped, 3200.0, 100));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 60.0f * RpmEstimator::SMOOTHING, estimator.smoothed());
+    estimator.reset(0);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, estimator.smoothed());
+}
+
+/**
+ * @brief LCD lines always fill the 16 columns so shorter text erases the previous one.
+ */
+void test_lcd_lines_fill_the_display() {
+    char line[LCD_COLS + 1];
+    lcd_format_rpm_line(line, 59.6f, 60.0f);
+    TEST_ASSERT_EQUAL_STRING("A: 60 T: 60     ", line);
+    lcd_pad_line(line, "MODO AP");
+    TEST_ASSERT_EQUAL_STRING("MODO AP         ", line);
+    lcd_pad_line(line, "192.168.100.200:80");
+    TEST_ASSERT_EQUAL_STRING("192.168.100.200:", line);
+}
+
+/**
+ * @brief The float conversion stays within float rounding of the double reference.
+ */
+void test_motion_math_float_matches_reference() {
+    double worst = 0.0;
+    for (int i = 0; i <= 6000; ++i) {
+        float rpm = i * 0.1f;
+        double ref = rpm2sps((double)rpm);
+        double err = std::fabs(rpm_to_sps(rpm) - ref);
+        if (err > worst) worst = err;
+        uint32_t milli = sps_to_milli_hz(rpm_to_sps(rpm));
+        TEST_ASSERT_UINT32_WITHIN(4, (uint32_t)(ref * 1000.0 + 0.5), milli);
+    }
+    // float has 24 bits: below 2^15 SPS the spacing is at most 2^-9.
+    TEST_ASSERT_TRUE(worst <= 32000.0 * 1.2e-7);
+    TEST_ASSERT_EQUAL_INT32(533, ramp_accel_sps2());
+}
+
+/**
+ * @brief Q16.16 stays within a few LSB of the reference and saturates past its range.
+ */
+void test_motion_math_q16_matches_reference() {
+    double worst = 0.0;
+    for (int i = 0; i <= 6000; ++i) {
+        Q16_16 rpm = Q16_16::fromRaw(i * Q16_16::ONE / 10);
+        double ref = rpm2sps(rpm.toDouble());
+        double err = std::fabs(rpm_to_sps(rpm).toDouble() - ref);
+        if (err > worst) worst = err;
+        TEST_ASSERT_UINT32_WITHIN(5, (uint32_t)(ref * 1000.0 + 0.5), sps_to_milli_hz(rpm_to_sps(rpm)));
+    }
+    // Constant rounded to 2^-17, times up to 600 RPM, plus the product rounding.
+    TEST_ASSERT_TRUE(worst <= 600.0 / 131072.0 + 1.0 / 131072.0);
+
+    Q16_16 top = rpm_to_sps(Q16_16::fromDouble(700.0));
+    TEST_ASSERT_EQUAL_INT32(INT32_MAX, top.raw);
+    TEST_ASSERT_EQUAL_UINT32(0, sps_to_milli_hz(rpm_to_sps(Q16_16::fromDouble(-5.0))));
+    TEST_ASSERT_EQUAL_INT32(Q16_16::fromDouble(-1.5).raw, (Q16_16::fromDouble(0.5) - Q16_16::fromDouble(2.0)).raw);
+    TEST_ASSERT_EQUAL_INT32(INT32_MIN, (Q16_16::fromDouble(-30000.0) - Q16_16::fromDouble(10000.0)).raw);
+}
+
+/**
+ * @brief Table lookups stay within their bound of the exact period, including between entries.
+ */
+void test_step_tables_match_exact_period() {
+    TEST_ASSERT_EQUAL_UINT32(0, rpm_to_ticks(0.0f));
+    TEST_ASSERT_EQUAL_UINT32(0, rpm_to_ticks(0.99f));
+    TEST_ASSERT_EQUAL_UINT32(300000, rpm_to_ticks(1.0f));
+    TEST_ASSERT_EQUAL_UINT32(2000, rpm_to_ticks(150.0f));
+    TEST_ASSERT_EQUAL_UINT32(500, rpm_to_ticks(600.0f));
+    TEST_ASSERT_EQUAL_UINT32(500, rpm_to_ticks(900.0f));  // clamped to RPM_LUT_MAX
+
+    // Setpoints as they arrive: tenths from Modbus, arbitrary floats over HTTP.
+    for (int i = 10; i < 6000; ++i) {
+        float rpm = i * 0.1f + 0.037f;
+        double exact = rpm_ticks_exact(rpm);
+        TEST_ASSERT_TRUE(lut_within_bound(rpm_to_ticks_frac(Q16_16::fromFloat(rpm)), exact));
+    }
+    // Integer setpoints are exact up to rounding (twice: into the table, then to whole ticks).
+    for (uint32_t rpm = 1; rpm <= RPM_LUT_MAX; ++rpm) {
+        TEST_ASSERT_DOUBLE_WITHIN(0.5 + 1.0 / 256, rpm_ticks_exact(rpm), (double)rpm_to_ticks((float)rpm));
+    }
+}
+
+/**
+ * @brief Mean step rate over 20 s of simulated motor_task cycles, relative to the setpoint.
+ */
+static double simulated_speed_error(float rpm, bool dither) {
+    const uint32_t MOTOR_PERIOD_MS = 50, SETTLE_MS = 2000, MEASURE_MS = 20000;
+    SimStepper stepper;
+    StepPeriodDither ditherer;
+    uint32_t periodFrac = rpm_to_ticks_frac(Q16_16::fromFloat(rpm));
+    // Reach the speed at once, then run with the real ramp as motor_task does.
+    stepper.setAcceleration(100000000);
+    stepper.setSpeedInTicks(rpm_to_ticks(rpm));
+    stepper.runForward();
+    stepper.advance(1000);
+    int32_t start = 0;
+    for (uint32_t t = 0; t < SETTLE_MS + MEASURE_MS; ++t) {
+        if (t == SETTLE_MS) start = stepper.getCurrentPosition();
+        if (t % MOTOR_PERIOD_MS == 0) {
+            stepper.setAcceleration(ramp_accel_sps2());
+            uint32_t ticks = dither ? ditherer.next(periodFrac, stepper.getCurrentPosition(), t * 1000)
+                                    : rpm_to_ticks(rpm);
+            stepper.setSpeedInTicks(ticks);
+            stepper.applySpeedAcceleration();
+        }
+        stepper.advance(1000);
+    }
+    double expected = rpm2sps(rpm) * MEASURE_MS / 1000.0;
+    return (stepper.getCurrentPosition() - start - expected) / expected;
+}
+
+/**
+ * @brief Dithering brings the mean speed to the setpoint where whole-tick periods cannot.
+ */
+void test_step_dither_mean_speed_error() {
+    double worstPlain = 0.0, worstDither = 0.0;
+    for (float rpm = 1.0f; rpm <= 600.0f; rpm += 1.37f) {
+        double plain = std::fabs(simulated_speed_error(rpm, false));
+        double dithered = std::fabs(simulated_speed_error(rpm, true));
+        // Whole steps over 20 s: one step of slack in the measurement.
+        double slack = 1.0 / (rpm2sps(rpm) * 20.0);
+        TEST_ASSERT_TRUE(dithered <= 30e-6 + slack);
+        if (plain - slack > worstPlain) worstPlain = plain - slack;
+        if (dithered - slack > worstDither) worstDither = dithered - slack;
+    }
+    TEST_ASSERT_TRUE(worstPlain > 300e-6);  // about 900 ppm near 600 RPM
+    TEST_ASSERT_TRUE(worstDither < worstPlain / 10.0);
+}
+
+/**
+ * @brief Square edges stay at start + k * period however late the evaluation is.
+ */
+void test_speed_pattern_square_is_phase_accurate() {
+    SpeedPattern p = {PATTERN_SQUARE, 200.0f, 0.0f, 60000, 15000, 0};
+    PatternGenerator gen;
+    const uint64_t t0 = 123456789;
+    gen.start(p, t0);
+    // Ten hours in: still exactly on the schedule, edge to the microsecond.
+    const uint64_t k = 600;
+    uint64_t base = t0 + k * 60000000ull;
+    TEST_ASSERT_EQUAL_FLOAT(200.0f, gen.rpmAt(base));
+    TEST_ASSERT_EQUAL_FLOAT(200.0f, gen.rpmAt(base + 14999999));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, gen.rpmAt(base + 15000000));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, gen.rpmAt(base + 59999999));
+    TEST_ASSERT_EQUAL_UINT32(k, gen.cycle(base + 1));
+    TEST_ASSERT_EQUAL_UINT64(base + 15000000, gen.nextEdgeUs(base + 3));
+    TEST_ASSERT_EQUAL_UINT64(base + 60000000, gen.nextEdgeUs(base + 15000000));
+    TEST_ASSERT_FALSE(gen.finished(base));
+    // Before the start (clock read before start() on another core): first period.
+    TEST_ASSERT_EQUAL_FLOAT(200.0f, gen.rpmAt(t0 - 10));
+}
+
+/**
+ * @brief Triangle and sine at the quarter points of a period, and the end of a finite run.
+ */
+void test_speed_pattern_shapes_and_cycles() {
+    PatternGenerator gen;
+    SpeedPattern tri = {PATTERN_TRIANGLE, 300.0f, 100.0f, 1000, 0, 2};
+    gen.start(tri, 0);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 100.0f, gen.rpmAt(0));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 200.0f, gen.rpmAt(250000));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 300.0f, gen.rpmAt(500000));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 200.0f, gen.rpmAt(1750000));
+    TEST_ASSERT_EQUAL_UINT64(0, gen.nextEdgeUs(250000));  // continuous: no edges to time
+    TEST_ASSERT_FALSE(gen.finished(1999999));
+    TEST_ASSERT_TRUE(gen.finished(2000000));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, gen.rpmAt(2000000));
+
+    SpeedPattern sine = {PATTERN_SINE, 250.0f, 50.0f, 4000, 0, 0};
+    gen.start(sine, 1000);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 50.0f, gen.rpmAt(1000));
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 150.0f, gen.rpmAt(1000 + 1000000));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 250.0f, gen.rpmAt(1000 + 2000000));
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 150.0f, gen.rpmAt(1000 + 3000000));
+    TEST_ASSERT_FALSE(gen.finished(1000 + 3600000000ull));
+
+    // The last square edge is the end of the run, where the motor stops.
+    SpeedPattern onOff = {PATTERN_SQUARE, 120.0f, 0.0f, 1000, 400, 3};
+    gen.start(onOff, 0);
+    TEST_ASSERT_EQUAL_UINT64(3000000, gen.nextEdgeUs(2500000));
+    TEST_ASSERT_EQUAL_UINT64(0, gen.nextEdgeUs(3000000));
+    gen.stop();
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, gen.rpmAt(100));
+    TEST_ASSERT_EQUAL_UINT32(0, gen.cycle(5000000));
+}
+
+/**
+ * @brief Patterns the web API must refuse.
+ */
+void test_speed_pattern_validation() {
+    SpeedPattern p = {PATTERN_SQUARE, 200.0f, 0.0f, 1000, 500, 0};
+    TEST_ASSERT_TRUE(pattern_valid(p, 300.0f));
+    TEST_ASSERT_FALSE(pattern_valid(p, 150.0f));  // above maxRpm
+    SpeedPattern bad = p;
+    bad.onMs = 1000;
+    TEST_ASSERT_FALSE(pattern_valid(bad, 300.0f));
+    bad = p;
+    bad.onMs = 0;
+    TEST_ASSERT_FALSE(pattern_valid(bad, 300.0f));
+    bad = p;
+    bad.periodMs = PATTERN_MIN_PERIOD_MS - 1;
+    bad.onMs = 50;
+    TEST_ASSERT_FALSE(pattern_valid(bad, 300.0f));
+    bad = p;
+    bad.lowRpm = 250.0f;
+    TEST_ASSERT_FALSE(pattern_valid(bad, 300.0f));
+    bad = p;
+    bad.lowRpm = NAN;
+    TEST_ASSERT_FALSE(pattern_valid(bad, 300.0f));
+    bad = p;
+    bad.shape = PATTERN_SHAPE_COUNT;
+    TEST_ASSERT_FALSE(pattern_valid(bad, 300.0f));
+    SpeedPattern sine = {PATTERN_SINE, 200.0f, 20.0f, 5000, 0, 10};  // onMs unused
+    TEST_ASSERT_TRUE(pattern_valid(sine, 300.0f));
+    TEST_ASSERT_EQUAL_STRING("sine", pattern_shape_name(PATTERN_SINE));
+    TEST_ASSERT_EQUAL_STRING("", pattern_shape_name(9));
+}
+
+/**
+ * @brief The E-stop latch holds until acknowledged with the input released.
+ */
+void test_estop_latch_until_acknowledged() {
+    EStopLatch latch;
+    TEST_ASSERT_FALSE(latch.latched());
+    TEST_ASSERT_FALSE(latch.takePending());
+
+    TEST_ASSERT_TRUE(latch.trip(ESTOP_SOURCE_INPUT, 42));
+    TEST_ASSERT_TRUE(latch.latched());
+    TEST_ASSERT_TRUE(latch.takePending());
+    TEST_ASSERT_FALSE(latch.takePending());  // motor_task finishes the stop once
+
+    // Bounce or a second trigger: counted and timed, but the first source stays.
+    TEST_ASSERT_FALSE(latch.trip(ESTOP_SOURCE_SOFTWARE, 97));
+    TEST_ASSERT_FALSE(latch.takePending());
+    EStopStatus st = latch.status();
+    TEST_ASSERT_EQUAL_UINT8(ESTOP_SOURCE_INPUT, st.source);
+    TEST_ASSERT_EQUAL_UINT32(2, st.trips);
+    TEST_ASSERT_EQUAL_UINT32(97, st.lastLatencyCycles);
+    TEST_ASSERT_EQUAL_UINT32(97, st.maxLatencyCycles);
+
+    TEST_ASSERT_FALSE(latch.acknowledge(true));  // still pressed
+    TEST_ASSERT_TRUE(latch.latched());
+    TEST_ASSERT_TRUE(latch.acknowledge(false));
+    TEST_ASSERT_FALSE(latch.latched());
+    TEST_ASSERT_EQUAL_STRING("none", estop_source_name(latch.status().source));
+
+    TEST_ASSERT_TRUE(latch.trip(ESTOP_SOURCE_SOFTWARE, 30));
+    st = latch.status();
+    TEST_ASSERT_EQUAL_STRING("software", estop_source_name(st.source));
+    TEST_ASSERT_EQUAL_UINT32(30, st.lastLatencyCycles);
+    TEST_ASSERT_EQUAL_UINT32(97, st.maxLatencyCycles);
+}
+
+/**
+ * @brief The encoder decoder counts one detent per four edges, each way, and ignores bounce.
+ */
+void test_quadrature_decoder_detents() {
+    // A leading B: 00 -> 10 -> 11 -> 01 -> 00 is one detent forward.
+    const bool fwd[4][2] = {{true, false}, {true, true}, {false, true}, {false, false}};
+    QuadratureDecoder dec;
+    dec.reset(false, false);
+    int total = 0;
+    for (int detent = 0; detent < 3; ++detent) {
+        for (int i = 0; i < 4; ++i) {
+            int8_t d = dec.update(fwd[i][0], fwd[i][1]);
+            TEST_ASSERT_EQUAL_INT(i == 3 ? 1 : 0, d);
+            total += d;
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(3, total);
+
+    // Backwards: the same states in reverse order.
+    for (int i = 2; i >= -1; --i) {
+        int8_t d = i >= 0 ? dec.update(fwd[i][0], fwd[i][1]) : dec.update(false, false);
+        TEST_ASSERT_EQUAL_INT(i == -1 ? -1 : 0, d);
+    }
+
+    // Contact bounce on one line goes back and forth without counting.
+    for (int i = 0; i < 10; ++i) {
+        TEST_ASSERT_EQUAL_INT(0, dec.update(true, false));
+        TEST_ASSERT_EQUAL_INT(0, dec.update(false, false));
+    }
+    // A missed edge (both lines change at once) is skipped; the steps either side still count.
+    TEST_ASSERT_EQUAL_INT(0, dec.update(true, true));
+    TEST_ASSERT_EQUAL_INT(0, dec.update(false, true));
+    TEST_ASSERT_EQUAL_INT(0, dec.update(false, false));
+}
+
+/**
+ * @brief Runs a graceful stop on the simulated stepper in 50 ms control cycles.
+ *
+ * @return Time to standstill in ms; @p result gets the final poll.
+ */
+static uint32_t simulate_graceful_stop(double rpm, float decelRpmPerS, uint32_t maxTimeMs, StopPoll &result,
+                                       int32_t &distance) {
+    SimStepper stepper;
+    stepper.setAcceleration(100000000);
+    stepper.setSpeedInHz((uint32_t)rpm2sps(rpm));
+    stepper.runForward();
+    stepper.advance(1000);
+    int32_t start = stepper.getCurrentPosition();
+    GracefulStop stop;
+    uint32_t configured = (uint32_t)(rpm_to_sps(decelRpmPerS) + 0.5f);
+    uint32_t decel = stop_decel_sps2((uint32_t)stepper.getCurrentSpeedInMilliHz(), configured, maxTimeMs);
+    stop.begin(stepper, decel, maxTimeMs, 0);
+    uint32_t t = 0;
+    result = STOP_POLL_RAMPING;
+    while (result == STOP_POLL_RAMPING && t < 60000) {
+        stepper.advance(50000);
+        t += 50;
+        result = stop.poll(stepper, t);
+    }
+    distance = stepper.getCurrentPosition() - start;
+    TEST_ASSERT_EQUAL_UINT8(STOP_POLL_IDLE, stop.poll(stepper, t + 50));
+    return t;
+}
+
+/**
+ * @brief A graceful stop follows the configured ramp, steepens it to meet the time bound,
+ * and travels the distance the ramp predicts.
+ */
+void test_graceful_stop_is_time_bounded() {
+    StopPoll result;
+    int32_t distance;
+    // 120 RPM at 60 RPM/s: 2 s on the configured ramp, well inside 5 s.
+    uint32_t t = simulate_graceful_stop(120.0, 60.0f, 5000, result, distance);
+    TEST_ASSERT_EQUAL_UINT8(STOP_POLL_DONE, result);
+    TEST_ASSERT_UINT32_WITHIN(50, 2000, t);
+    uint32_t decel = (uint32_t)(rpm_to_sps(60.0f) + 0.5f);
+    TEST_ASSERT_INT_WITHIN(5, (int32_t)stop_distance_steps((uint32_t)(rpm2sps(120.0) * 1000), decel), distance);
+
+    // 600 RPM would take 10 s at 60 RPM/s: the ramp steepens to stop within 5 s.
+    t = simulate_graceful_stop(600.0, 60.0f, 5000, result, distance);
+    TEST_ASSERT_EQUAL_UINT8(STOP_POLL_DONE, result);
+    TEST_ASSERT_TRUE(t <= 5000 + 50);
+    TEST_ASSERT_TRUE(t >= 4900);
+
+    TEST_ASSERT_EQUAL_UINT32(1000, stop_decel_sps2(10000000, 100, 10000));
+    TEST_ASSERT_EQUAL_UINT32(5000, stop_decel_sps2(10000000, 5000, 10000));
+    TEST_ASSERT_EQUAL_UINT32(1, stop_decel_sps2(1, 0, 10000));  // rounds up: never exceeds the bound
+}
+
+/**
+ * @brief A stop that does not reach standstill in time is forced, and the driver disabled.
+ */
+void test_graceful_stop_forced_after_deadline() {
+    SimStepper stepper;
+    stepper.setAcceleration(100000000);
+    stepper.setSpeedInHz(16000);
+    stepper.runForward();
+    stepper.advance(1000);
+    GracefulStop stop;
+    stop.begin(stepper, 1, 1000, 100);  // far too gentle: the motor is still turning at the deadline
+    TEST_ASSERT_EQUAL_UINT8(STOP_POLL_RAMPING, stop.poll(stepper, 100 + 1000 + GracefulStop::GRACE_MS - 1));
+    TEST_ASSERT_TRUE(stepper.isRunning());
+    TEST_ASSERT_EQUAL_UINT8(STOP_POLL_FORCED, stop.poll(stepper, 100 + 1000 + GracefulStop::GRACE_MS));
+    TEST_ASSERT_FALSE(stepper.isRunning());
+    TEST_ASSERT_FALSE(stop.active());
+
+    StopMode mode = STOP_MODE_HARD;
+    TEST_ASSERT_TRUE(stop_mode_parse("graceful", mode));
+    TEST_ASSERT_EQUAL_UINT8(STOP_MODE_GRACEFUL, mode);
+    TEST_ASSERT_TRUE(stop_mode_parse("hard", mode));
+    TEST_ASSERT_EQUAL_UINT8(STOP_MODE_HARD, mode);
+    TEST_ASSERT_FALSE(stop_mode_parse("", mode));
+    TEST_ASSERT_FALSE(stop_mode_parse(nullptr, mode));
+}
+
+void test_task_plan_isolates_control_core() {
+    TEST_ASSERT_TRUE(task_plan_isolated());
+    TEST_ASSERT_TRUE(task_plan_control_first());
+    for (size_t i = 0; i < TASK_COUNT; ++i) {
+        const TaskPlacement &t = TASK_PLAN[i];
+        TEST_ASSERT_NOT_NULL(t.name);
+        TEST_ASSERT_TRUE(strlen(t.name) < 16);  // configMAX_TASK_NAME_LEN
+        if (t.core == CONTROL_CORE) TEST_ASSERT_EQUAL_UINT8(TASK_ROLE_CONTROL, t.role);
+    }
+    TEST_ASSERT_EQUAL_INT(CONTROL_CORE, TASK_PLAN[TASK_MOTOR].core);
+    TEST_ASSERT_EQUAL_INT(CONTROL_CORE, TASK_PLAN[TASK_STEPPER].core);
+    TEST_ASSERT_EQUAL_INT(SYSTEM_CORE, TASK_PLAN[TASK_ASYNC_TCP].core);
+    TEST_ASSERT_EQUAL_INT(SYSTEM_CORE, TASK_PLAN[TASK_WIFI].core);
+    TEST_ASSERT_EQUAL_INT(CONTROL_CORE, JITTER_PLACEMENTS[0].core);
+    TEST_ASSERT_EQUAL_UINT8(TASK_PLAN[TASK_MOTOR].priority - 1, JITTER_PLACEMENTS[0].priority);
+    TEST_ASSERT_TRUE(jitter_placements_below_control());
+}
+
+void test_jitter_stats_quantiles_and_report() {
+    JitterStats stats;
+    TEST_ASSERT_EQUAL_UINT32(0, stats.quantileUs(0.99f));
+    for (int i = 0; i < 990; ++i) stats.add(3);
+    for (int i = 0; i < 9; ++i) stats.add(150);
+    stats.add(25000);  // past the last bucket
+    TEST_ASSERT_EQUAL_UINT32(1000, stats.count());
+    TEST_ASSERT_EQUAL_UINT32(3, stats.minUs());
+    TEST_ASSERT_EQUAL_UINT32(25000, stats.maxUs());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, (990 * 3 + 9 * 150 + 25000) / 1000.0f, stats.meanUs());
+    TEST_ASSERT_EQUAL_UINT32(5, stats.quantileUs(0.5f));
+    TEST_ASSERT_EQUAL_UINT32(5, stats.quantileUs(0.99f));
+    TEST_ASSERT_EQUAL_UINT32(200, stats.quantileUs(0.999f));
+    TEST_ASSERT_EQUAL_UINT32(25000, stats.quantileUs(1.0f));
+
+    JitterReport report;
+    report.periodMs = 1;
+    report.secondsPerPlacement = 10;
+    report.results.push_back({JITTER_PLACEMENTS[0], stats});
+    jitter_render_json(report);
+    jitter_render_text(report);
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"running\":false,\"period_ms\":1,\"seconds\":10,\"results\":[{\"placement\":\"control\",\"core\":1,"
+        "\"prio\":4,\"samples\":1000,\"mean_us\":29.3,\"p99_us\":5,\"max_us\":25000}]}",
+        report.json.c_str());
+    TEST_ASSERT_NOT_NULL(strstr(report.text.c_str(), "control"));
+}
+
+struct FakeScpiDevice {
+    MotorStateSnapshot snap = {};
+    bool latched = false;
+    bool inputAsserted = false;
+    int stops = 0;
+    StopMode lastStop = STOP_MODE_HARD;
+
+    const char *identity() const { return "BioShaker,1a2b,test"; }
+    float maxRpm() const { return 600.0f; }
+    void setSpeed(float rpm) {
+        snap.targetRpm = rpm;
+        snap.runState = rpm > 0 ? MOTOR_RUNNING : MOTOR_STOPPED;
+    }
+    void stop(StopMode mode) {
+        stops++;
+        lastStop = mode;
+        setSpeed(0);
+    }
+    bool state(MotorStateSnapshot &out) const {
+        out = snap;
+        return true;
+    }
+    void estopTrip() { latched = true; }
+    bool estopAcknowledge() {
+        if (inputAsserted) return false;
+        latched = false;
+        return true;
+    }
+    bool estopLatched() const { return latched; }
+};
+
+static std::string scpi_reply(FakeScpiDevice &dev, const char *line) {
+    std::string out;
+    scpi_execute(line, dev, out);
+    return out;
+}
+
+void test_scpi_commands() {
+    FakeScpiDevice dev;
+    TEST_ASSERT_EQUAL_STRING("BioShaker,1a2b,test\n", scpi_reply(dev, "*idn?").c_str());
+    TEST_ASSERT_EQUAL_STRING("OK\n", scpi_reply(dev, "SPEED 250").c_str());
+    TEST_ASSERT_EQUAL_STRING("250.0\n", scpi_reply(dev, "  speed?  ").c_str());
+    dev.snap.currentRpm = 249.6f;
+    TEST_ASSERT_EQUAL_STRING("249.6,250.0,1,0\n", scpi_reply(dev, "STAT?").c_str());
+    TEST_ASSERT_EQUAL_STRING("ERR -222,\"Data out of range\"\n", scpi_reply(dev, "SPEED 601").c_str());
+    TEST_ASSERT_EQUAL_STRING("ERR -222,\"Data out of range\"\n", scpi_reply(dev, "SPEED -1").c_str());
+    TEST_ASSERT_EQUAL_STRING("ERR -224,\"Illegal parameter value\"\n", scpi_reply(dev, "SPEED 25x").c_str());
+    TEST_ASSERT_EQUAL_STRING("ERR -109,\"Missing parameter\"\n", scpi_reply(dev, "SPEED").c_str());
+    TEST_ASSERT_EQUAL_STRING("ERR -113,\"Undefined header\"\n", scpi_reply(dev, "SPIN 3").c_str());
+    TEST_ASSERT_EQUAL_FLOAT(250.0f, dev.snap.targetRpm);
+
+    TEST_ASSERT_EQUAL_STRING("OK\n", scpi_reply(dev, "STOP").c_str());
+    TEST_ASSERT_EQUAL_UINT8(STOP_MODE_GRACEFUL, dev.lastStop);
+    TEST_ASSERT_EQUAL_STRING("OK\n", scpi_reply(dev, "stop hard").c_str());
+    TEST_ASSERT_EQUAL_UINT8(STOP_MODE_HARD, dev.lastStop);
+    TEST_ASSERT_EQUAL_STRING("ERR -224,\"Illegal parameter value\"\n", scpi_reply(dev, "STOP NOW").c_str());
+    TEST_ASSERT_EQUAL_INT(2, dev.stops);
+
+    // Several commands on one line answer on one line.
+    TEST_ASSERT_EQUAL_STRING("OK;1;ERR -221,\"Settings conflict\"\n", scpi_reply(dev, "ESTOP;ESTOP?;SPEED 10").c_str());
+    dev.inputAsserted = true;
+    TEST_ASSERT_EQUAL_STRING("ERR -221,\"Settings conflict\"\n", scpi_reply(dev, "ESTOP:ACK").c_str());
+    dev.inputAsserted = false;
+    TEST_ASSERT_EQUAL_STRING("OK;0\n", scpi_reply(dev, "estop:ack; estop?").c_str());
+
+    // Line framing: CR, LF and CRLF; blank lines get no reply; long lines are refused whole.
+    ScpiSession<FakeScpiDevice> session;
+    std::string out;
+    std::string input = "SPEED 100\r\nSPEED?\r\n\nSPEED?\r" + std::string(SCPI_MAX_LINE + 1, 'X') + "\nSPEED?\n";
+    TEST_ASSERT_EQUAL_UINT32(5, session.feed(input.data(), input.size(), dev, out));
+    TEST_ASSERT_EQUAL_STRING("OK\n100.0\n100.0\nERR -363,\"Input buffer overrun\"\n100.0\n", out.c_str());
+
+    // Logs on the same port: every line tagged, so a host can skip them.
+    std::string log;
+    scpi_log_lines("tasks", "a 1\n\nb 2", log);
+    TEST_ASSERT_EQUAL_STRING("[tasks] a 1\n[tasks] \n[tasks] b 2\n", log.c_str());
+    log.clear();
+    scpi_log_lines("boot", "x\n", log);
+    TEST_ASSERT_EQUAL_STRING("[boot] x\n", log.c_str());
+}
+
+/**
+ * @brief Console loop over the slave side of a pty, as serial_console_task runs over the UART.
+ */
+static void scpi_pty_device(int fd, std::atomic<bool> *stop) {
+    FakeScpiDevice dev;
+    ScpiSession<FakeScpiDevice> session;
+    std::string replies;
+    char buf[64];
+    while (!*stop) {
+        pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, 5) <= 0) continue;
+        ssize_t n;
+        while ((n = read(fd, buf, sizeof(buf))) > 0) session.feed(buf, (size_t)n, dev, replies);
+        if (!replies.empty()) {
+            // Not a Unity assertion: this thread must not longjmp; a short write shows up as a wrong reply.
+            if (write(fd, replies.data(), replies.size()) < 0) break;
+            replies.clear();
+        }
+    }
+}
+
+static std::string pty_read_line(int fd) {
+    std::string line;
+    char c;
+    while (true) {
+        pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, 2000) <= 0) return line + "<timeout>";
+        if (read(fd, &c, 1) != 1) continue;
+        if (c == '\n') return line;
+        line += c;
+    }
+}
+
+void test_scpi_over_pty_round_trip_and_pipelined() {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    TEST_ASSERT_TRUE(master >= 0);
+    TEST_ASSERT_EQUAL_INT(0, grantpt(master));
+    TEST_ASSERT_EQUAL_INT(0, unlockpt(master));
+    int slave = open(ptsname(master), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    TEST_ASSERT_TRUE(slave >= 0);
+    termios raw;
+    tcgetattr(slave, &raw);
+    cfmakeraw(&raw);  // no echo, no line discipline: bytes as the UART delivers them
+    tcsetattr(slave, TCSANOW, &raw);
+
+    std::atomic<bool> stop(false);
+    std::thread device(scpi_pty_device, slave, &stop);
+
+    // One command at a time: the round trip a robot sees when it waits for each reply.
+    const int ROUNDS = 200;
+    std::vector<uint32_t> rttUs;
+    for (int i = 0; i < ROUNDS; ++i) {
+        const char *cmd = i % 2 ? "SPEED?\n" : "SPEED 120\n";
+        auto t0 = std::chrono::steady_clock::now();
+        TEST_ASSERT_EQUAL_INT((int)strlen(cmd), (int)write(master, cmd, strlen(cmd)));
+        std::string reply = pty_read_line(master);
+        rttUs.push_back((uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - t0).count());
+        TEST_ASSERT_EQUAL_STRING(i % 2 ? "120.0" : "OK", reply.c_str());
+    }
+    std::sort(rttUs.begin(), rttUs.end());
+    printf("SCPI over pty: round trip median %u us, p99 %u us, max %u us\n", rttUs[ROUNDS / 2],
+           rttUs[ROUNDS * 99 / 100], rttUs[ROUNDS - 1]);
+    TEST_ASSERT_TRUE(rttUs[ROUNDS / 2] < 20000);
+
+    // Pipelined: every command sent at once, replies matched by position.
+    const int PIPELINED = 100;
+    std::string batch;
+    for (int i = 0; i < PIPELINED; ++i) batch += (i % 2 ? "SPEED?\n" : "SPEED " + std::to_string(i) + "\n");
+    auto t0 = std::chrono::steady_clock::now();
+    TEST_ASSERT_EQUAL_INT((int)batch.size(), (int)write(master, batch.data(), batch.size()));
+    for (int i = 0; i < PIPELINED; ++i) {
+        std::string want = i % 2 ? std::to_string(i - 1) + ".0" : "OK";
+        TEST_ASSERT_EQUAL_STRING(want.c_str(), pty_read_line(master).c_str());
+    }
+    uint32_t batchUs = (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                           std::chrono::steady_clock::now() - t0).count();
+    printf("SCPI over pty: %d pipelined commands in %u us (%u us each)\n", PIPELINED, batchUs, batchUs / PIPELINED);
+
+    stop = true;
+    device.join();
+    close(slave);
+    close(master);
+}
+
 int main(int, char**) {
     UNITY_BEGIN();
     RUN_TEST(test_rpm2sps_conversion);
     RUN_TEST(test_rpm2sps_negative_input);
+    RUN_TEST(test_token_bucket_burst_and_refill);
+    RUN_TEST(test_client_rate_limiter_is_per_ip);
+    RUN_TEST(test_concurrency_gate_limit);
+    RUN_TEST(test_setpoint_mailbox_last_writer_wins);
+    RUN_TEST(test_rpm_flood_keeps_motor_latency_bounded);
+    RUN_TEST(test_backoff_grows_with_bounded_jitter);
+    RUN_TEST(test_reconnect_fast_connect_then_full_scan);
+    RUN_TEST(test_reconnect_backoff_during_outage);
+    RUN_TEST(test_reconnect_disabled_when_offline);
+    RUN_TEST(test_boot_timeline_records_phases);
+    RUN_TEST(test_boot_timeline_is_bounded);
+    RUN_TEST(test_boot_timeline_parallel_phases);
+    RUN_TEST(test_scan_cache_dedup_and_sort);
+    RUN_TEST(test_scan_cache_ttl_and_capacity);
+    RUN_TEST(test_scan_cache_json_escaping);
+    RUN_TEST(test_snapshot_slot_readers_keep_old_snapshot);
+    RUN_TEST(test_mdns_query_round_trip);
+    RUN_TEST(test_mdns_browser_parses_compressed_answer);
+    RUN_TEST(test_seqlock_readers_never_see_torn_snapshot);
+    RUN_TEST(test_modbus_encode_inputs);
+    RUN_TEST(test_modbus_decode_command);
+    RUN_TEST(test_metrics_exposition_format);
+    RUN_TEST(test_metrics_stream_in_small_chunks);
+    RUN_TEST(test_task_profiler_cpu_and_core_load);
+    RUN_TEST(test_task_profiler_without_runtime_stats);
+    RUN_TEST(test_task_profiler_idle_hook_core_load);
+    RUN_TEST(test_trace_export_chrome_json);
+    RUN_TEST(test_trace_ring_overwrite_and_concurrency);
+    RUN_TEST(test_setpoint_mailbox_carries_source_and_stamp);
+    RUN_TEST(test_command_latency_p99_on_simulated_stepper);
+    RUN_TEST(test_stop_latency_p99_on_simulated_stepper);
+    RUN_TEST(test_motor_cycle_stops_without_the_lock);
+    RUN_TEST(test_speed_stats_synthetic_streams);
+    RUN_TEST(test_speed_stats_white_noise_allan);
+    RUN_TEST(test_speed_stats_settling_and_segments);
+    RUN_TEST(test_deadline_supervisor_counts_each_stall_once);
+    RUN_TEST(test_deadline_supervisor_concurrent_poll);
+    RUN_TEST(test_config_store_roundtrip_and_versioned_keys);
+    RUN_TEST(test_config_store_rejects_corrupt_file);
+    RUN_TEST(test_config_store_coalesces_writes);
+    RUN_TEST(test_run_journal_replays_latest_across_wrap);
+    RUN_TEST(test_run_journal_survives_torn_write);
+    RUN_TEST(test_run_journal_policy);
+    RUN_TEST(test_rpm_estimator_wraps_and_smooths);
+    RUN_TEST(test_lcd_lines_fill_the_display);
+    RUN_TEST(test_motion_math_float_matches_reference);
+    RUN_TEST(test_motion_math_q16_matches_reference);
+    RUN_TEST(test_step_tables_match_exact_period);
+    RUN_TEST(test_step_dither_mean_speed_error);
+    RUN_TEST(test_speed_pattern_square_is_phase_accurate);
+    RUN_TEST(test_speed_pattern_shapes_and_cycles);
+    RUN_TEST(test_speed_pattern_validation);
+    RUN_TEST(test_estop_latch_until_acknowledged);
+    RUN_TEST(test_quadrature_decoder_detents);
+    RUN_TEST(test_graceful_stop_is_time_bounded);
+    RUN_TEST(test_graceful_stop_forced_after_deadline);
+    RUN_TEST(test_task_plan_isolates_control_core);
+    RUN_TEST(test_jitter_stats_quantiles_and_report);
+    RUN_TEST(test_scpi_commands);
+    RUN_TEST(test_scpi_over_pty_round_trip_and_pipelined);
     return UNITY_END();
 }
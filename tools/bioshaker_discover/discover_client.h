@@ -0,0 +1,96 @@
+#ifndef DISCOVER_CLIENT_H
+#define DISCOVER_CLIENT_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mdns_wire.h"
+
+// ============================
+// Cliente de descubrimiento (POSIX)
+// ============================
+
+const char *const BIOSHAKER_SERVICE = "_bioshaker._tcp.local";
+const char *const MDNS_GROUP = "224.0.0.251";
+
+/**
+ * @brief Where and for how long to browse.
+ */
+struct BrowseOptions {
+    std::string target = MDNS_GROUP;  ///< Multicast group, or a unicast address for tests.
+    uint16_t port = MDNS_PORT;
+    uint32_t timeoutMs = 1500;        ///< Time spent collecting answers after the query.
+    std::string service = BIOSHAKER_SERVICE;
+};
+
+/**
+ * @brief Sends one PTR query and collects every answer until the timeout.
+ *
+ * The query goes out from an ephemeral port, so responders treat it as a
+ * legacy unicast query (RFC 6762 section 6.7) and answer straight to this
+ * socket: one packet out, one reply per device on the floor.
+ *
+ * @param out Instances found, merged across replies.
+ * @param error Set to a description when the function returns false.
+ * @return false if the socket could not be set up or the query not sent.
+ */
+inline bool bioshaker_browse(const BrowseOptions &opt, std::vector<MdnsServiceRecord> &out, std::string &error) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        error = "socket() failed";
+        return false;
+    }
+    unsigned char ttl = 255;
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+
+    sockaddr_in dst = {};
+    dst.sin_family = AF_INET;
+    dst.sin_port = htons(opt.port);
+    if (inet_pton(AF_INET, opt.target.c_str(), &dst.sin_addr) != 1) {
+        close(fd);
+        error = "invalid target address: " + opt.target;
+        return false;
+    }
+
+    uint8_t buf[1500];
+    size_t len = mdns_build_ptr_query(buf, sizeof(buf), opt.service, false);
+    if (len == 0 || sendto(fd, buf, len, 0, (const sockaddr *)&dst, sizeof(dst)) != (ssize_t)len) {
+        close(fd);
+        error = "sendto() failed";
+        return false;
+    }
+
+    MdnsBrowser browser(opt.service);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(opt.timeoutMs);
+    while (true) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (left.count() <= 0) break;
+        pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, (int)left.count()) <= 0) continue;
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n > 0) browser.ingest(buf, (size_t)n);  // malformed packets are ignored
+    }
+    close(fd);
+    out = browser.results();
+    return true;
+}
+
+/**
+ * @brief Formats a host-order IPv4 address.
+ */
+inline std::string ipv4_to_string(uint32_t ip) {
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", (unsigned)(ip >> 24), (unsigned)((ip >> 16) & 0xFF),
+             (unsigned)((ip >> 8) & 0xFF), (unsigned)(ip & 0xFF));
+    return text;
+}
+
+#endif // DISCOVER_CLIENT_H
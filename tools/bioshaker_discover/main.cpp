@@ -0,0 +1,87 @@
+/**
+ * @file main.cpp
+ * @brief bioshaker_discover: lists every BioShaker on the local network.
+ *
+ * Sends a single mDNS query for _bioshaker._tcp and prints one line per
+ * device with its address and the TXT records the firmware publishes
+ * (firmware version, channel count and run state).
+ *
+ * Build:  cmake -S tools/bioshaker_discover -B build/discover && cmake --build build/discover
+ * Usage:  bioshaker_discover [--timeout ms] [--target addr] [--port n] [--json]
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "discover_client.h"
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--timeout ms] [--target addr] [--port n] [--json]\n", argv0);
+}
+
+static void print_json_string(const std::string &s) {
+    putchar('"');
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            putchar('\\');
+            putchar(c);
+        } else if ((unsigned char)c < 0x20) {
+            printf("\\u%04x", (unsigned char)c);
+        } else {
+            putchar(c);
+        }
+    }
+    putchar('"');
+}
+
+int main(int argc, char **argv) {
+    BrowseOptions opt;
+    bool json = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+            opt.timeoutMs = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--target") == 0 && i + 1 < argc) {
+            opt.target = argv[++i];
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            opt.port = (uint16_t)strtoul(argv[++i], NULL, 10);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<MdnsServiceRecord> found;
+    std::string error;
+    if (!bioshaker_browse(opt, found, error)) {
+        fprintf(stderr, "bioshaker_discover: %s\n", error.c_str());
+        return 1;
+    }
+
+    if (json) {
+        printf("[");
+        for (size_t i = 0; i < found.size(); ++i) {
+            const MdnsServiceRecord &r = found[i];
+            printf("%s{\"instance\":", i ? "," : "");
+            print_json_string(r.instance);
+            printf(",\"host\":");
+            print_json_string(r.host);
+            printf(",\"ip\":\"%s\",\"port\":%u,\"fw\":", ipv4_to_string(r.ipv4).c_str(), (unsigned)r.port);
+            print_json_string(r.txtValue("fw"));
+            printf(",\"channels\":%d,\"state\":", atoi(r.txtValue("ch").c_str()));
+            print_json_string(r.txtValue("state"));
+            printf("}");
+        }
+        printf("]\n");
+    } else {
+        printf("%-32s %-21s %-20s %-3s %s\n", "INSTANCE", "ADDRESS", "FIRMWARE", "CH", "STATE");
+        for (const MdnsServiceRecord &r : found) {
+            std::string addr = ipv4_to_string(r.ipv4) + ":" + std::to_string(r.port);
+            printf("%-32s %-21s %-20s %-3s %s\n", r.instance.c_str(), addr.c_str(), r.txtValue("fw").c_str(),
+                   r.txtValue("ch").c_str(), r.txtValue("state").c_str());
+        }
+        printf("%zu device(s)\n", found.size());
+    }
+    return 0;
+}
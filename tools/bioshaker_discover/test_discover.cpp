@@ -0,0 +1,140 @@
+/**
+ * @file test_discover.cpp
+ * @brief Browses a local mDNS responder that simulates a floor of devices.
+ *
+ * The responder binds an ephemeral loopback port and answers a PTR query for
+ * _bioshaker._tcp with one reply per simulated device, the way every board
+ * on a floor answers the same multicast query. One device splits its A
+ * record into a second packet and a malformed packet is thrown in, to check
+ * the browser merges and ignores correctly.
+ */
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+#include "discover_client.h"
+
+static int g_failures = 0;
+
+#define CHECK(cond)                                                   \
+    do {                                                              \
+        if (!(cond)) {                                                \
+            fprintf(stderr, "%s:%d: CHECK(%s)\n", __FILE__, __LINE__, #cond); \
+            g_failures++;                                             \
+        }                                                             \
+    } while (0)
+
+static const int FLOOR_SIZE = 12;
+
+static MdnsServiceRecord simulated_device(int i) {
+    char suffix[8];
+    snprintf(suffix, sizeof(suffix), "%04x", 0x1a00 + i);
+    MdnsServiceRecord rec;
+    rec.instance = std::string("BioShaker-") + suffix + "." + BIOSHAKER_SERVICE;
+    rec.host = std::string("bioshaker-") + suffix + ".local";
+    rec.port = 80;
+    rec.ipv4 = (10u << 24) | (0u << 16) | (3u << 8) | (uint32_t)(10 + i);
+    rec.txt = {{"fw", "1.2.3-Refactored"}, {"ch", "1"}, {"state", i % 3 == 0 ? "running" : "stopped"}, {"id", suffix}};
+    return rec;
+}
+
+/**
+ * @brief Answers queries on @p fd until @p stop is set.
+ */
+static void responder(int fd, std::atomic<bool> *stop, std::atomic<int> *queries) {
+    uint8_t buf[1500];
+    while (!*stop) {
+        pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, 50) <= 0) continue;
+        sockaddr_in from = {};
+        socklen_t fromLen = sizeof(from);
+        ssize_t n = recvfrom(fd, buf, sizeof(buf), 0, (sockaddr *)&from, &fromLen);
+        std::string qname;
+        uint16_t qtype = 0;
+        bool qu = false;
+        if (n <= 0 || !mdns_parse_query(buf, (size_t)n, qname, qtype, qu)) continue;
+        if (qtype != DNS_TYPE_PTR || !mdns_wire::sameName(qname, BIOSHAKER_SERVICE)) continue;
+        (*queries)++;
+
+        const uint8_t junk[] = {0, 0, 0x84, 0, 0, 0, 0, 5, 0, 0, 0, 0, 3, 'a'};
+        sendto(fd, junk, sizeof(junk), 0, (sockaddr *)&from, fromLen);
+
+        for (int i = 0; i < FLOOR_SIZE; ++i) {
+            MdnsServiceRecord rec = simulated_device(i);
+            uint32_t ip = rec.ipv4;
+            if (i == 1) rec.ipv4 = 0;  // A record comes in a separate packet
+            size_t len = mdns_build_service_response(buf, sizeof(buf), BIOSHAKER_SERVICE, rec);
+            sendto(fd, buf, len, 0, (sockaddr *)&from, fromLen);
+            if (i == 1) {
+                // Minimal answer with just the A record.
+                size_t pos = 0;
+                using namespace mdns_wire;
+                put16(buf, sizeof(buf), pos, 0);
+                put16(buf, sizeof(buf), pos, 0x8400);
+                put16(buf, sizeof(buf), pos, 0);
+                put16(buf, sizeof(buf), pos, 1);
+                put16(buf, sizeof(buf), pos, 0);
+                put16(buf, sizeof(buf), pos, 0);
+                putRecord(buf, sizeof(buf), pos, rec.host, DNS_TYPE_A, DNS_CLASS_IN, 120,
+                          [&](size_t &p) { return put32(buf, sizeof(buf), p, ip); });
+                sendto(fd, buf, pos, 0, (sockaddr *)&from, fromLen);
+            }
+        }
+    }
+}
+
+int main() {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    if (fd < 0 || bind(fd, (sockaddr *)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "cannot bind loopback responder\n");
+        return 1;
+    }
+    socklen_t addrLen = sizeof(addr);
+    getsockname(fd, (sockaddr *)&addr, &addrLen);
+
+    std::atomic<bool> stop(false);
+    std::atomic<int> queries(0);
+    std::thread thread(responder, fd, &stop, &queries);
+
+    BrowseOptions opt;
+    opt.target = "127.0.0.1";
+    opt.port = ntohs(addr.sin_port);
+    opt.timeoutMs = 500;
+    std::vector<MdnsServiceRecord> found;
+    std::string error;
+    bool ok = bioshaker_browse(opt, found, error);
+
+    stop = true;
+    thread.join();
+    close(fd);
+
+    CHECK(ok);
+    CHECK(queries == 1);
+    CHECK(found.size() == (size_t)FLOOR_SIZE);
+    for (int i = 0; i < FLOOR_SIZE; ++i) {
+        MdnsServiceRecord want = simulated_device(i);
+        bool seen = false;
+        for (const MdnsServiceRecord &r : found) {
+            if (r.instance != want.instance) continue;
+            seen = true;
+            CHECK(r.host == want.host);
+            CHECK(r.port == 80);
+            CHECK(r.ipv4 == want.ipv4);
+            CHECK(r.txtValue("fw") == "1.2.3-Refactored");
+            CHECK(r.txtValue("ch") == "1");
+            CHECK(r.txtValue("state") == want.txtValue("state"));
+        }
+        CHECK(seen);
+    }
+
+    if (g_failures) {
+        fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("discovered %zu simulated devices with one query\n", found.size());
+    return 0;
+}
@@ -0,0 +1,216 @@
+#ifndef JITTER_CLIENT_H
+#define JITTER_CLIENT_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ============================
+// Cliente HTTP mínimo (POSIX)
+// ============================
+
+/**
+ * @brief Status and body of one HTTP exchange.
+ */
+struct HttpResult {
+    int status = 0;  ///< 0 if the request failed before a status line arrived.
+    std::string body;
+};
+
+/**
+ * @brief GET @p path over a fresh HTTP/1.0 connection, as a browser tab polling the device would.
+ *
+ * @param ip IPv4 address in dotted form.
+ * @param error Set to a description when the function returns false.
+ */
+inline bool http_get(const std::string &ip, uint16_t port, const std::string &path, uint32_t timeoutMs,
+                     HttpResult &out, std::string &error) {
+    out = HttpResult();
+    sockaddr_in dst = {};
+    dst.sin_family = AF_INET;
+    dst.sin_port = htons(port);
+    if (inet_pton(AF_INET, ip.c_str(), &dst.sin_addr) != 1) {
+        error = "invalid address: " + ip;
+        return false;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        error = "socket() failed";
+        return false;
+    }
+    timeval tv = {(time_t)(timeoutMs / 1000), (suseconds_t)(timeoutMs % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    if (connect(fd, (const sockaddr *)&dst, sizeof(dst)) != 0) {
+        close(fd);
+        error = "connect() failed";
+        return false;
+    }
+    std::string request = "GET " + path + " HTTP/1.0\r\nHost: " + ip + "\r\nConnection: close\r\n\r\n";
+    if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != (ssize_t)request.size()) {
+        close(fd);
+        error = "send() failed";
+        return false;
+    }
+    std::string response;
+    char buf[1024];
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) response.append(buf, (size_t)n);
+    close(fd);
+
+    int major = 0, minor = 0;
+    if (sscanf(response.c_str(), "HTTP/%d.%d %d", &major, &minor, &out.status) != 3) {
+        error = "no HTTP status line";
+        return false;
+    }
+    size_t bodyAt = response.find("\r\n\r\n");
+    if (bodyAt != std::string::npos) out.body = response.substr(bodyAt + 4);
+    return true;
+}
+
+// ============================
+// Sesión de medida
+// ============================
+
+/**
+ * @brief One row of /debug/jitter.
+ */
+struct JitterRow {
+    std::string placement;
+    int core = 0;
+    int prio = 0;
+    unsigned long samples = 0;
+    double meanUs = 0;
+    unsigned long p99Us = 0;
+    unsigned long maxUs = 0;
+};
+
+/**
+ * @brief Number after "key": in @p object; 0 if missing. Enough for the flat JSON the device renders.
+ */
+inline double json_number(const std::string &object, const char *key) {
+    std::string needle = std::string("\"") + key + "\":";
+    size_t at = object.find(needle);
+    return at == std::string::npos ? 0 : strtod(object.c_str() + at + needle.size(), NULL);
+}
+
+/**
+ * @brief Splits the "results" array of a /debug/jitter body into rows.
+ */
+inline std::vector<JitterRow> jitter_parse_rows(const std::string &body) {
+    std::vector<JitterRow> rows;
+    const std::string marker = "{\"placement\":\"";
+    size_t at = 0;
+    while ((at = body.find(marker, at)) != std::string::npos) {
+        size_t end = body.find('}', at);
+        if (end == std::string::npos) break;
+        std::string object = body.substr(at, end - at);
+        JitterRow row;
+        size_t nameEnd = object.find('"', marker.size());
+        row.placement = object.substr(marker.size(), nameEnd - marker.size());
+        row.core = (int)json_number(object, "core");
+        row.prio = (int)json_number(object, "prio");
+        row.samples = (unsigned long)json_number(object, "samples");
+        row.meanUs = json_number(object, "mean_us");
+        row.p99Us = (unsigned long)json_number(object, "p99_us");
+        row.maxUs = (unsigned long)json_number(object, "max_us");
+        rows.push_back(row);
+        at = end;
+    }
+    return rows;
+}
+
+/**
+ * @brief What to measure and how hard to load the server meanwhile.
+ */
+struct JitterOptions {
+    std::string ip;
+    uint16_t port = 80;
+    uint32_t seconds = 10;          ///< Per placement; the device tries each in turn.
+    int loadThreads = 4;            ///< Clients requesting loadPath back to back; 0 measures idle.
+    std::string loadPath = "/status";
+    uint32_t pollMs = 500;          ///< Interval between /debug/jitter polls.
+    uint32_t timeoutMs = 2000;      ///< Per HTTP request.
+};
+
+/**
+ * @brief Outcome of a session: the device's report and the load actually applied.
+ */
+struct JitterSession {
+    std::string body;  ///< Final /debug/jitter JSON.
+    std::vector<JitterRow> rows;
+    unsigned long loadRequests = 0;
+    unsigned long loadErrors = 0;  ///< Failed connections and non-2xx answers (429 under admission control).
+    double elapsedS = 0;
+};
+
+/**
+ * @brief Starts a measurement, loads the server until it finishes and collects the report.
+ *
+ * @param placements How many placements the device measures, to bound the wait.
+ * @param error Set to a description when the function returns false.
+ */
+inline bool jitter_run_session(const JitterOptions &opt, size_t placements, JitterSession &out,
+                               std::string &error) {
+    HttpResult res;
+    if (!http_get(opt.ip, opt.port, "/debug/jitter?run=" + std::to_string(opt.seconds), opt.timeoutMs, res, error)) {
+        return false;
+    }
+    if (res.status != 202) {
+        error = "device refused the run (HTTP " + std::to_string(res.status) + "): " + res.body;
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<bool> stop(false);
+    std::atomic<unsigned long> requests(0), errors(0);
+    std::vector<std::thread> load;
+    for (int i = 0; i < opt.loadThreads; ++i) {
+        load.emplace_back([&]() {
+            while (!stop) {
+                HttpResult r;
+                std::string e;
+                bool ok = http_get(opt.ip, opt.port, opt.loadPath, opt.timeoutMs, r, e);
+                requests++;
+                if (!ok || r.status < 200 || r.status >= 300) errors++;
+            }
+        });
+    }
+
+    auto deadline = start + std::chrono::seconds(opt.seconds * placements + 10);
+    bool done = false;
+    while (!done && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(opt.pollMs));
+        std::string e;
+        if (http_get(opt.ip, opt.port, "/debug/jitter", opt.timeoutMs, res, e) && res.status == 200) {
+            done = res.body.find("\"running\":false") != std::string::npos;
+        }
+    }
+    stop = true;
+    for (std::thread &t : load) t.join();
+
+    out.elapsedS = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    out.loadRequests = requests;
+    out.loadErrors = errors;
+    if (!done) {
+        error = "measurement did not finish in time";
+        return false;
+    }
+    out.body = res.body;
+    out.rows = jitter_parse_rows(res.body);
+    return true;
+}
+
+#endif // JITTER_CLIENT_H
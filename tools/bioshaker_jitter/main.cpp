@@ -0,0 +1,81 @@
+/**
+ * @file main.cpp
+ * @brief bioshaker_jitter: measures control-loop jitter on a device under HTTP load.
+ *
+ * Starts the on-device jitter measurement (/debug/jitter?run=N), keeps the
+ * web server busy with back-to-back requests from several clients while it
+ * runs, and prints the jitter of the probe task in each placement the
+ * firmware tries: on the control core, on the network core, and unpinned.
+ *
+ * Build:  cmake -S tools/bioshaker_jitter -B build/jitter && cmake --build build/jitter
+ * Usage:  bioshaker_jitter <ip> [--port n] [--seconds s] [--threads k] [--path p] [--json]
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "jitter_client.h"
+
+/// Placements the firmware measures (JITTER_PLACEMENTS in task_plan.h).
+static const size_t DEVICE_PLACEMENTS = 3;
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s <ip> [--port n] [--seconds s] [--threads k] [--path p] [--json]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    JitterOptions opt;
+    bool json = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            opt.port = (uint16_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            opt.seconds = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            opt.loadThreads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--path") == 0 && i + 1 < argc) {
+            opt.loadPath = argv[++i];
+        } else if (argv[i][0] != '-' && opt.ip.empty()) {
+            opt.ip = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (opt.ip.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    JitterSession session;
+    std::string error;
+    if (!jitter_run_session(opt, DEVICE_PLACEMENTS, session, error)) {
+        fprintf(stderr, "bioshaker_jitter: %s\n", error.c_str());
+        return 1;
+    }
+
+    double rate = session.elapsedS > 0 ? session.loadRequests / session.elapsedS : 0;
+    if (json) {
+        printf("{\"load\":{\"threads\":%d,\"path\":\"%s\",\"requests\":%lu,\"errors\":%lu,\"rate\":%.1f},\"device\":%s}\n",
+               opt.loadThreads, opt.loadPath.c_str(), session.loadRequests, session.loadErrors, rate,
+               session.body.c_str());
+        return 0;
+    }
+    printf("load: %d client(s) on %s, %lu requests (%.1f/s), %lu errors\n", opt.loadThreads, opt.loadPath.c_str(),
+           session.loadRequests, rate, session.loadErrors);
+    printf("%-10s %-4s %-4s %8s %9s %8s %8s\n", "PLACEMENT", "CORE", "PRIO", "SAMPLES", "MEAN_US", "P99_US",
+           "MAX_US");
+    for (const JitterRow &r : session.rows) {
+        char core[8];
+        if (r.core < 0) {
+            snprintf(core, sizeof(core), "-");
+        } else {
+            snprintf(core, sizeof(core), "%d", r.core);
+        }
+        printf("%-10s %-4s %-4d %8lu %9.1f %8lu %8lu\n", r.placement.c_str(), core, r.prio, r.samples, r.meanUs,
+               r.p99Us, r.maxUs);
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+/**
+ * @file test_jitter.cpp
+ * @brief Runs a jitter session against a local HTTP responder that plays the device.
+ *
+ * The responder binds an ephemeral loopback port, accepts the run, reports
+ * "running" for a while and then the three placements the firmware
+ * measures, while counting the /status requests the load clients send.
+ */
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+#include "jitter_client.h"
+
+static int g_failures = 0;
+
+#define CHECK(cond)                                                   \
+    do {                                                              \
+        if (!(cond)) {                                                \
+            fprintf(stderr, "%s:%d: CHECK(%s)\n", __FILE__, __LINE__, #cond); \
+            g_failures++;                                             \
+        }                                                             \
+    } while (0)
+
+static const char *const DONE_BODY =
+    "{\"running\":false,\"period_ms\":1,\"seconds\":1,\"results\":["
+    "{\"placement\":\"control\",\"core\":1,\"prio\":5,\"samples\":999,\"mean_us\":2.5,\"p99_us\":10,\"max_us\":14},"
+    "{\"placement\":\"system\",\"core\":0,\"prio\":1,\"samples\":998,\"mean_us\":40.1,\"p99_us\":1000,\"max_us\":2870},"
+    "{\"placement\":\"unpinned\",\"core\":-1,\"prio\":1,\"samples\":997,\"mean_us\":21.0,\"p99_us\":500,\"max_us\":1900}]}";
+
+struct Device {
+    std::atomic<bool> stop{false};
+    std::atomic<int> runs{0};
+    std::atomic<int> statusRequests{0};
+    std::chrono::steady_clock::time_point runStart;
+};
+
+static void reply(int fd, int status, const std::string &body) {
+    std::string head = "HTTP/1.1 " + std::to_string(status) + " X\r\nContent-Type: application/json\r\n"
+                       "Content-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n";
+    std::string all = head + body;
+    send(fd, all.data(), all.size(), MSG_NOSIGNAL);
+}
+
+/**
+ * @brief Serves connections on @p listener until the device is stopped.
+ */
+static void responder(int listener, Device *dev) {
+    while (!dev->stop) {
+        pollfd pfd = {listener, POLLIN, 0};
+        if (poll(&pfd, 1, 50) <= 0) continue;
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0) continue;
+        char buf[1024];
+        ssize_t n = recv(fd, buf, sizeof(buf) - 1, 0);
+        buf[n > 0 ? n : 0] = '\0';
+        char path[256] = "";
+        sscanf(buf, "GET %255s", path);
+        std::string p = path;
+        if (p == "/debug/jitter?run=1") {
+            dev->runs++;
+            dev->runStart = std::chrono::steady_clock::now();
+            reply(fd, 202, "{\"status\":\"started\"}");
+        } else if (p == "/debug/jitter") {
+            bool done = std::chrono::steady_clock::now() - dev->runStart > std::chrono::milliseconds(300);
+            reply(fd, 200, done ? DONE_BODY : "{\"running\":true,\"period_ms\":1,\"seconds\":1,\"results\":[]}");
+        } else if (p == "/status") {
+            dev->statusRequests++;
+            reply(fd, 200, "{\"rpm\":0}");
+        } else {
+            reply(fd, 404, "");
+        }
+        close(fd);
+    }
+}
+
+int main() {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int yes = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    if (listener < 0 || bind(listener, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(listener, 16) != 0) {
+        fprintf(stderr, "cannot bind loopback responder\n");
+        return 1;
+    }
+    socklen_t addrLen = sizeof(addr);
+    getsockname(listener, (sockaddr *)&addr, &addrLen);
+
+    Device dev;
+    std::thread thread(responder, listener, &dev);
+
+    JitterOptions opt;
+    opt.ip = "127.0.0.1";
+    opt.port = ntohs(addr.sin_port);
+    opt.seconds = 1;
+    opt.loadThreads = 3;
+    opt.pollMs = 50;
+    JitterSession session;
+    std::string error;
+    bool ok = jitter_run_session(opt, 3, session, error);
+
+    dev.stop = true;
+    thread.join();
+    close(listener);
+
+    CHECK(ok);
+    CHECK(dev.runs == 1);
+    CHECK(session.loadRequests > 0);
+    CHECK(session.loadErrors == 0);
+    CHECK((int)session.loadRequests == dev.statusRequests);
+    CHECK(session.rows.size() == 3);
+    if (session.rows.size() == 3) {
+        CHECK(session.rows[0].placement == "control");
+        CHECK(session.rows[0].core == 1);
+        CHECK(session.rows[0].prio == 5);
+        CHECK(session.rows[0].p99Us == 10);
+        CHECK(session.rows[1].placement == "system");
+        CHECK(session.rows[1].maxUs == 2870);
+        CHECK(session.rows[2].placement == "unpinned");
+        CHECK(session.rows[2].core == -1);
+        CHECK(session.rows[2].meanUs > 20.9 && session.rows[2].meanUs < 21.1);
+    }
+
+    if (g_failures) {
+        fprintf(stderr, "%d check(s) failed%s%s\n", g_failures, error.empty() ? "" : ": ", error.c_str());
+        return 1;
+    }
+    printf("jitter session: %zu placements, %lu load requests\n", session.rows.size(), session.loadRequests);
+    return 0;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file main.cpp
+ * @brief bioshaker_modbus: reads and commands a device over Modbus TCP, as a SCADA master would.
+ *
+ * Build:  cmake -S tools/bioshaker_modbus -B build/modbus && cmake --build build/modbus
+ * Usage:  bioshaker_modbus <ip> [--port n] [--uid u] status | run <rpm> | stop [graceful|hard]
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "modbus_client.h"
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s <ip> [--port n] [--uid u] status | run <rpm> | stop [graceful|hard]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    std::string ip;
+    uint16_t port = MODBUS_DEFAULT_PORT;
+    uint8_t uid = 1;
+    std::vector<const char *> command;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = (uint16_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--uid") == 0 && i + 1 < argc) {
+            uid = (uint8_t)strtoul(argv[++i], NULL, 10);
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else if (ip.empty()) {
+            ip = argv[i];
+        } else {
+            command.push_back(argv[i]);
+        }
+    }
+    if (ip.empty() || command.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    ModbusTcpMaster master;
+    std::string error;
+    if (!master.connectTo(ip, port, uid, 2000, error)) {
+        fprintf(stderr, "bioshaker_modbus: %s\n", error.c_str());
+        return 1;
+    }
+
+    bool ok;
+    if (strcmp(command[0], "status") == 0 && command.size() == 1) {
+        ModbusDeviceStatus s;
+        ok = master.readStatus(s, error);
+        if (ok) {
+            printf("setpoint %.1f rpm, actual %.1f rpm, %s, steps %u, errors 0x%04x, version %u\n", s.setpointRpm,
+                   s.actualRpm, s.runState == MOTOR_RUNNING ? "running" : "stopped", s.steps, s.errorFlags,
+                   s.version);
+        }
+    } else if (strcmp(command[0], "run") == 0 && command.size() == 2) {
+        ok = master.run(strtof(command[1], NULL), error);
+    } else if (strcmp(command[0], "stop") == 0 && command.size() <= 2) {
+        StopMode mode = STOP_MODE_GRACEFUL;
+        if (command.size() == 2 && !stop_mode_parse(command[1], mode)) {
+            usage(argv[0]);
+            return 2;
+        }
+        ok = master.stop(mode, error);
+    } else {
+        usage(argv[0]);
+        return 2;
+    }
+    if (!ok) {
+        fprintf(stderr, "bioshaker_modbus: %s\n", error.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,234 @@
+#ifndef MODBUS_CLIENT_H
+#define MODBUS_CLIENT_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "modbus_map.h"
+
+// ============================
+// Maestro Modbus TCP mínimo (POSIX)
+// ============================
+//
+// Just the functions the device serves: 04 (read input registers), 03 (read
+// holding registers) and 16 (write multiple registers). One request in
+// flight at a time on one connection, as the esp-modbus slave expects.
+
+const uint16_t MODBUS_DEFAULT_PORT = 502;
+const size_t MODBUS_MBAP_LEN = 7;  ///< Transaction id, protocol id, length, unit id.
+
+enum ModbusFunction : uint8_t {
+    MB_FC_READ_HOLDING = 0x03,
+    MB_FC_READ_INPUT = 0x04,
+    MB_FC_WRITE_MULTIPLE = 0x10
+};
+
+/** @brief Appends @p value big-endian, the byte order of every Modbus field. */
+inline void modbus_put_u16(std::vector<uint8_t> &out, uint16_t value) {
+    out.push_back((uint8_t)(value >> 8));
+    out.push_back((uint8_t)value);
+}
+
+inline uint16_t modbus_get_u16(const uint8_t *p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+/**
+ * @brief Wraps @p pdu (function code first) in an MBAP header.
+ */
+inline std::vector<uint8_t> modbus_frame(uint16_t transaction, uint8_t unit, const std::vector<uint8_t> &pdu) {
+    std::vector<uint8_t> adu;
+    modbus_put_u16(adu, transaction);
+    modbus_put_u16(adu, 0);  // protocol id: Modbus
+    modbus_put_u16(adu, (uint16_t)(pdu.size() + 1));
+    adu.push_back(unit);
+    adu.insert(adu.end(), pdu.begin(), pdu.end());
+    return adu;
+}
+
+/**
+ * @brief Decoded input registers of one device (see modbus_map.h).
+ */
+struct ModbusDeviceStatus {
+    float setpointRpm = 0;
+    float actualRpm = 0;
+    uint16_t runState = 0;
+    uint32_t steps = 0;
+    uint16_t errorFlags = 0;
+    uint16_t version = 0;
+};
+
+inline ModbusDeviceStatus modbus_decode_status(const uint16_t *regs) {
+    ModbusDeviceStatus s;
+    s.setpointRpm = regs[MB_IR_SETPOINT_X10] / 10.0f;
+    s.actualRpm = regs[MB_IR_ACTUAL_X10] / 10.0f;
+    s.runState = regs[MB_IR_RUN_STATE];
+    s.steps = ((uint32_t)regs[MB_IR_STEPS_HI] << 16) | regs[MB_IR_STEPS_LO];
+    s.errorFlags = regs[MB_IR_ERROR_FLAGS];
+    s.version = regs[MB_IR_VERSION];
+    return s;
+}
+
+/**
+ * @brief Blocking Modbus TCP master over one connection.
+ */
+class ModbusTcpMaster {
+public:
+    ~ModbusTcpMaster() { disconnect(); }
+
+    /**
+     * @param error Set to a description when the function returns false.
+     */
+    bool connectTo(const std::string &ip, uint16_t port, uint8_t unit, uint32_t timeoutMs, std::string &error) {
+        disconnect();
+        _unit = unit;
+        sockaddr_in dst = {};
+        dst.sin_family = AF_INET;
+        dst.sin_port = htons(port);
+        if (inet_pton(AF_INET, ip.c_str(), &dst.sin_addr) != 1) {
+            error = "invalid address: " + ip;
+            return false;
+        }
+        _fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (_fd < 0) {
+            error = "socket() failed";
+            return false;
+        }
+        timeval tv = {(time_t)(timeoutMs / 1000), (suseconds_t)(timeoutMs % 1000) * 1000};
+        setsockopt(_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(_fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        if (connect(_fd, (const sockaddr *)&dst, sizeof(dst)) != 0) {
+            disconnect();
+            error = "connect() failed";
+            return false;
+        }
+        return true;
+    }
+
+    void disconnect() {
+        if (_fd >= 0) close(_fd);
+        _fd = -1;
+    }
+
+    /**
+     * @brief Function 04 or 03: reads @p count registers from @p start into @p out.
+     */
+    bool readRegisters(ModbusFunction function, uint16_t start, uint16_t count, uint16_t *out, std::string &error) {
+        std::vector<uint8_t> pdu = {(uint8_t)function};
+        modbus_put_u16(pdu, start);
+        modbus_put_u16(pdu, count);
+        std::vector<uint8_t> reply;
+        if (!transact(pdu, reply, error)) return false;
+        if (reply.size() != 2u + 2u * count || reply[1] != 2u * count) {
+            error = "malformed read reply";
+            return false;
+        }
+        for (uint16_t i = 0; i < count; ++i) out[i] = modbus_get_u16(&reply[2 + 2 * i]);
+        return true;
+    }
+
+    /**
+     * @brief Function 16: writes @p count holding registers from @p start in one request.
+     */
+    bool writeRegisters(uint16_t start, const uint16_t *values, uint16_t count, std::string &error) {
+        std::vector<uint8_t> pdu = {MB_FC_WRITE_MULTIPLE};
+        modbus_put_u16(pdu, start);
+        modbus_put_u16(pdu, count);
+        pdu.push_back((uint8_t)(2 * count));
+        for (uint16_t i = 0; i < count; ++i) modbus_put_u16(pdu, values[i]);
+        std::vector<uint8_t> reply;
+        if (!transact(pdu, reply, error)) return false;
+        if (reply.size() != 5 || modbus_get_u16(&reply[1]) != start || modbus_get_u16(&reply[3]) != count) {
+            error = "malformed write reply";
+            return false;
+        }
+        return true;
+    }
+
+    /** @brief Reads and decodes every input register. */
+    bool readStatus(ModbusDeviceStatus &out, std::string &error) {
+        uint16_t regs[MB_INPUT_REGISTER_COUNT];
+        if (!readRegisters(MB_FC_READ_INPUT, 0, MB_INPUT_REGISTER_COUNT, regs, error)) return false;
+        out = modbus_decode_status(regs);
+        return true;
+    }
+
+    /** @brief Setpoint and MB_RUN_START in one write, so the device sees a single command. */
+    bool run(float rpm, std::string &error) {
+        uint16_t regs[MB_HOLDING_REGISTER_COUNT];
+        regs[MB_HR_SETPOINT_X10] = modbus_rpm_to_reg(rpm);
+        regs[MB_HR_RUN] = MB_RUN_START;
+        return writeRegisters(0, regs, MB_HOLDING_REGISTER_COUNT, error);
+    }
+
+    bool stop(StopMode mode, std::string &error) {
+        uint16_t run = mode == STOP_MODE_HARD ? MB_RUN_HARD_STOP : MB_RUN_STOP;
+        return writeRegisters(MB_HR_RUN, &run, 1, error);
+    }
+
+private:
+    /**
+     * @brief Sends @p pdu and returns the reply PDU, function code first.
+     *
+     * An exception reply (function code | 0x80) fails with "exception <code>".
+     */
+    bool transact(const std::vector<uint8_t> &pdu, std::vector<uint8_t> &reply, std::string &error) {
+        if (_fd < 0) {
+            error = "not connected";
+            return false;
+        }
+        uint16_t transaction = ++_transaction;
+        std::vector<uint8_t> adu = modbus_frame(transaction, _unit, pdu);
+        if (send(_fd, adu.data(), adu.size(), MSG_NOSIGNAL) != (ssize_t)adu.size()) {
+            error = "send() failed";
+            return false;
+        }
+        uint8_t header[MODBUS_MBAP_LEN];
+        if (!receive(header, sizeof(header))) {
+            error = "no reply";
+            return false;
+        }
+        uint16_t length = modbus_get_u16(&header[4]);
+        if (modbus_get_u16(&header[0]) != transaction || modbus_get_u16(&header[2]) != 0 || length < 2 ||
+            length > 254 || header[6] != _unit) {
+            error = "bad MBAP header";
+            return false;
+        }
+        reply.resize(length - 1u);
+        if (!receive(reply.data(), reply.size())) {
+            error = "truncated reply";
+            return false;
+        }
+        if (reply[0] == (pdu[0] | 0x80)) {
+            error = "exception " + std::to_string(reply.size() > 1 ? reply[1] : 0);
+            return false;
+        }
+        if (reply[0] != pdu[0]) {
+            error = "unexpected function code";
+            return false;
+        }
+        return true;
+    }
+
+    bool receive(uint8_t *buf, size_t n) {
+        size_t got = 0;
+        while (got < n) {
+            ssize_t r = recv(_fd, buf + got, n - got, 0);
+            if (r <= 0) return false;
+            got += (size_t)r;
+        }
+        return true;
+    }
+
+    int _fd = -1;
+    uint8_t _unit = 1;
+    uint16_t _transaction = 0;
+};
+
+#endif // MODBUS_CLIENT_H
@@ -0,0 +1,215 @@
+/**
+ * @file test_modbus.cpp
+ * @brief Drives a loopback Modbus TCP slave that plays the device with the master.
+ *
+ * The slave binds an ephemeral loopback port and serves functions 03, 04
+ * and 16 from two register images. Holding writes go through the same
+ * modbus_map.h decoding modbus_task applies, and the input registers are
+ * re-encoded from the resulting motor state, so the test covers the master,
+ * the wire format and the register map end to end.
+ */
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <poll.h>
+#include <thread>
+
+#include "modbus_client.h"
+
+static int g_failures = 0;
+
+#define CHECK(cond)                                                   \
+    do {                                                              \
+        if (!(cond)) {                                                \
+            fprintf(stderr, "%s:%d: CHECK(%s)\n", __FILE__, __LINE__, #cond); \
+            g_failures++;                                             \
+        }                                                             \
+    } while (0)
+
+static const uint8_t DEVICE_UID = 1;
+static const float DEVICE_MAX_RPM = 300.0f;
+
+struct Device {
+    std::atomic<bool> stop{false};
+    std::mutex mutex;
+    uint16_t input[MB_INPUT_REGISTER_COUNT] = {};
+    uint16_t holding[MB_HOLDING_REGISTER_COUNT] = {};
+    MotorStateSnapshot motor = {};
+    uint32_t version = 0;
+    int commands = 0;
+    StopMode lastStop = STOP_MODE_COUNT;
+};
+
+/**
+ * @brief What modbus_task does after a holding write, minus the motor.
+ */
+static void apply_holding_write(Device *dev) {
+    dev->commands++;
+    if (dev->holding[MB_HR_RUN] == MB_RUN_START) {
+        dev->motor.targetRpm = modbus_decode_command(dev->holding, DEVICE_MAX_RPM);
+        dev->motor.runState = MOTOR_RUNNING;
+    } else {
+        dev->lastStop = modbus_decode_stop_mode(dev->holding);
+        dev->motor.targetRpm = 0.0f;
+        dev->motor.runState = MOTOR_STOPPED;
+    }
+    dev->motor.currentRpm = dev->motor.targetRpm;
+    dev->motor.stepCount += 70000;  // crosses the 16-bit word boundary
+    modbus_encode_inputs(dev->motor, ++dev->version, dev->input);
+}
+
+static std::vector<uint8_t> exception_pdu(uint8_t function, uint8_t code) {
+    return {(uint8_t)(function | 0x80), code};
+}
+
+/**
+ * @brief Answers one request PDU the way the esp-modbus slave does.
+ */
+static std::vector<uint8_t> serve_pdu(const std::vector<uint8_t> &req, Device *dev) {
+    std::lock_guard<std::mutex> lock(dev->mutex);
+    uint8_t function = req[0];
+    if (function != MB_FC_READ_INPUT && function != MB_FC_READ_HOLDING && function != MB_FC_WRITE_MULTIPLE) {
+        return exception_pdu(function, 0x01);  // illegal function
+    }
+    if (req.size() < 5) return exception_pdu(function, 0x03);
+    uint16_t start = modbus_get_u16(&req[1]);
+    uint16_t count = modbus_get_u16(&req[3]);
+    bool input = function == MB_FC_READ_INPUT;
+    uint16_t *regs = input ? dev->input : dev->holding;
+    size_t size = input ? (size_t)MB_INPUT_REGISTER_COUNT : (size_t)MB_HOLDING_REGISTER_COUNT;
+    if (count == 0 || start + count > size) return exception_pdu(function, 0x02);  // illegal address
+
+    std::vector<uint8_t> reply = {function};
+    if (function == MB_FC_WRITE_MULTIPLE) {
+        if (req.size() != 6u + 2u * count || req[5] != 2u * count) return exception_pdu(function, 0x03);
+        for (uint16_t i = 0; i < count; ++i) regs[start + i] = modbus_get_u16(&req[6 + 2 * i]);
+        apply_holding_write(dev);
+        modbus_put_u16(reply, start);
+        modbus_put_u16(reply, count);
+    } else {
+        reply.push_back((uint8_t)(2 * count));
+        for (uint16_t i = 0; i < count; ++i) modbus_put_u16(reply, regs[start + i]);
+    }
+    return reply;
+}
+
+static bool read_exact(int fd, uint8_t *buf, size_t n) {
+    size_t got = 0;
+    while (got < n) {
+        ssize_t r = recv(fd, buf + got, n - got, 0);
+        if (r <= 0) return false;
+        got += (size_t)r;
+    }
+    return true;
+}
+
+/**
+ * @brief Serves one master until it disconnects.
+ */
+static void serve_connection(int fd, Device *dev) {
+    uint8_t header[MODBUS_MBAP_LEN];
+    while (read_exact(fd, header, sizeof(header))) {
+        uint16_t length = modbus_get_u16(&header[4]);
+        if (length < 2 || length > 254) break;
+        std::vector<uint8_t> pdu(length - 1u);
+        if (!read_exact(fd, pdu.data(), pdu.size())) break;
+        if (header[6] != DEVICE_UID) continue;  // another unit: no answer
+        std::vector<uint8_t> adu = modbus_frame(modbus_get_u16(&header[0]), header[6], serve_pdu(pdu, dev));
+        if (send(fd, adu.data(), adu.size(), MSG_NOSIGNAL) != (ssize_t)adu.size()) break;
+    }
+    close(fd);
+}
+
+static void slave(int listener, Device *dev) {
+    std::vector<std::thread> connections;
+    while (!dev->stop) {
+        pollfd pfd = {listener, POLLIN, 0};
+        if (poll(&pfd, 1, 50) <= 0) continue;
+        int fd = accept(listener, NULL, NULL);
+        if (fd >= 0) connections.emplace_back(serve_connection, fd, dev);
+    }
+    for (std::thread &t : connections) t.join();
+}
+
+int main() {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int yes = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    if (listener < 0 || bind(listener, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(listener, 4) != 0) {
+        fprintf(stderr, "cannot bind loopback slave\n");
+        return 1;
+    }
+    socklen_t addrLen = sizeof(addr);
+    getsockname(listener, (sockaddr *)&addr, &addrLen);
+    uint16_t port = ntohs(addr.sin_port);
+
+    Device dev;
+    modbus_encode_inputs(dev.motor, dev.version, dev.input);
+    std::thread thread(slave, listener, &dev);
+
+    std::string error;
+    ModbusTcpMaster master;
+    CHECK(master.connectTo("127.0.0.1", port, DEVICE_UID, 2000, error));
+
+    ModbusDeviceStatus s;
+    CHECK(master.readStatus(s, error));
+    CHECK(s.runState == MOTOR_STOPPED);
+    CHECK(s.setpointRpm == 0.0f);
+
+    // Setpoint and run flag arrive as one write, so the device sees one command.
+    CHECK(master.run(123.4f, error));
+    CHECK(master.readStatus(s, error));
+    CHECK(s.runState == MOTOR_RUNNING);
+    CHECK(s.setpointRpm > 123.3f && s.setpointRpm < 123.5f);
+    CHECK(s.steps == 70000);
+    CHECK(s.version == 1);
+    uint16_t holding[MB_HOLDING_REGISTER_COUNT] = {};
+    CHECK(master.readRegisters(MB_FC_READ_HOLDING, 0, MB_HOLDING_REGISTER_COUNT, holding, error));
+    CHECK(holding[MB_HR_SETPOINT_X10] == 1234);
+    CHECK(holding[MB_HR_RUN] == MB_RUN_START);
+
+    // Above maxRpm the device clamps, as modbus_task does.
+    CHECK(master.run(1000.0f, error));
+    CHECK(master.readStatus(s, error));
+    CHECK(s.setpointRpm == DEVICE_MAX_RPM);
+
+    CHECK(master.stop(STOP_MODE_HARD, error));
+    CHECK(master.readStatus(s, error));
+    CHECK(s.runState == MOTOR_STOPPED);
+    CHECK(s.setpointRpm == 0.0f);
+    CHECK(dev.lastStop == STOP_MODE_HARD);
+    CHECK(master.stop(STOP_MODE_GRACEFUL, error));
+    CHECK(dev.lastStop == STOP_MODE_GRACEFUL);
+    CHECK(s.steps == 3u * 70000u);
+
+    // Past the end of the map: exception 2, and the connection stays usable.
+    uint16_t scratch[4];
+    CHECK(!master.readRegisters(MB_FC_READ_INPUT, MB_INPUT_REGISTER_COUNT - 1, 2, scratch, error));
+    CHECK(error == "exception 2");
+    CHECK(master.readStatus(s, error));
+    CHECK(dev.commands == 4);
+
+    // A second master on its own connection sees the same state.
+    ModbusTcpMaster second;
+    CHECK(second.connectTo("127.0.0.1", port, DEVICE_UID, 2000, error));
+    ModbusDeviceStatus s2;
+    CHECK(second.readStatus(s2, error));
+    CHECK(s2.version == s.version);
+
+    master.disconnect();
+    second.disconnect();
+    dev.stop = true;
+    thread.join();
+    close(listener);
+
+    if (g_failures) {
+        fprintf(stderr, "%d check(s) failed%s%s\n", g_failures, error.empty() ? "" : ": ", error.c_str());
+        return 1;
+    }
+    printf("modbus loopback: %d commands, version %u\n", dev.commands, (unsigned)dev.version);
+    return 0;
+}